@@ -0,0 +1,359 @@
+/*
+ * Copyright (c) 2015, 2016, Oracle and/or its affiliates. All rights reserved.
+ *
+ * The MySQL Connector/C++ is licensed under the terms of the GPLv2
+ * <http://www.gnu.org/licenses/old-licenses/gpl-2.0.html>, like most
+ * MySQL Connectors. There are special exceptions to the terms and
+ * conditions of the GPLv2 as it is applied to this software, see the
+ * FLOSS License Exception
+ * <http://www.mysql.com/about/legal/licensing/foss-exception.html>.
+ *
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published
+ * by the Free Software Foundation; version 2 of the License.
+ *
+ * This program is distributed in the hope that it will be useful, but
+ * WITHOUT ANY WARRANTY; without even the implied warranty of MERCHANTABILITY
+ * or FITNESS FOR A PARTICULAR PURPOSE. See the GNU General Public License
+ * for more details.
+ *
+ * You should have received a copy of the GNU General Public License along
+ * with this program; if not, write to the Free Software Foundation, Inc.,
+ * 51 Franklin St, Fifth Floor, Boston, MA 02110-1301  USA
+ */
+
+/*
+  Connector benchmarks
+  ====================
+
+  Benchmarks of session setup, SQL round trips, iterating over row and
+  document results and bulk document inserts, run against the mock server
+  (see mock_server.h) started by this program. Results of X DevAPI for C
+  are measured in bench_xapi.cc.
+
+  Usage: bench_concpp [options] [filter ...]
+
+  --time=SEC    - run each benchmark for at least SEC seconds (default 1),
+  --socket=PATH - connect to the mock server via Unix domain socket PATH
+                  instead of TCP,
+  --server=PORT - only run the mock server on the given TCP port (and
+                  Unix socket, if given) until the program is killed.
+
+  If filters are given, only benchmarks whose name contains one of them
+  are run.
+
+  Allocations are counted by replacing global operator new. Only
+  allocations done by the benchmark thread are counted, which excludes
+  the mock server threads. Note that on Windows allocations done inside
+  the connector DLL are not seen by this program.
+*/
+
+#include "bench.h"
+#include "mock_server.h"
+
+#include <mysql_devapi.h>
+
+#include <iostream>
+#include <iomanip>
+#include <chrono>
+#include <vector>
+#include <cstdlib>
+#include <cstring>
+#include <new>
+#include <thread>
+#include <algorithm>
+
+
+/*
+  Allocation counting
+  -------------------
+*/
+
+static thread_local uint64_t allocs = 0;
+
+void* operator new(size_t size)
+{
+  ++allocs;
+  void *ptr = malloc(size ? size : 1);
+  if (!ptr)
+    throw std::bad_alloc();
+  return ptr;
+}
+
+void* operator new[](size_t size)
+{
+  return operator new(size);
+}
+
+void operator delete(void *ptr) noexcept
+{
+  free(ptr);
+}
+
+void operator delete[](void *ptr) noexcept
+{
+  free(ptr);
+}
+
+
+namespace bench {
+
+Target target = { 0, std::string() };
+
+static double min_time = 1.0;
+static std::vector<std::string> filters;
+
+
+void run(const char *name, const char *items, std::function<uint64_t()> op)
+{
+  if (!filters.empty())
+  {
+    bool match = false;
+    for (const std::string &f : filters)
+      if (std::string(name).find(f) != std::string::npos)
+        match = true;
+    if (!match)
+      return;
+  }
+
+  typedef std::chrono::steady_clock clock;
+
+  try {
+    op();
+
+    uint64_t ops = 0;
+    uint64_t count = 0;
+    uint64_t allocs_start = allocs;
+    clock::time_point start = clock::now();
+    double time;
+
+    do {
+      count += op();
+      ++ops;
+      time = std::chrono::duration<double>(clock::now() - start).count();
+    }
+    while (time < min_time);
+
+    double alloc_count = double(allocs - allocs_start);
+
+    std::cout << std::left << std::setw(32) << name << std::right
+              << std::fixed << std::setprecision(0)
+              << std::setw(12) << ops / time
+              << std::setw(14) << count / time << " " << std::left
+              << std::setw(6) << items << std::right << std::setprecision(1)
+              << std::setw(12) << alloc_count / ops
+              << std::setprecision(2)
+              << std::setw(12) << (count ? alloc_count / count : 0.0)
+              << std::endl;
+  }
+  catch (const mysqlx::Error &err)
+  {
+    std::cout << std::left << std::setw(32) << name
+              << "ERROR: " << err << std::endl;
+  }
+  catch (const std::exception &err)
+  {
+    std::cout << std::left << std::setw(32) << name
+              << "ERROR: " << err.what() << std::endl;
+  }
+}
+
+
+/*
+  X DevAPI benchmarks
+  -------------------
+*/
+
+using namespace ::mysqlx;
+
+
+static SessionSettings settings()
+{
+#ifndef _WIN32
+  if (!target.m_socket.empty())
+    return SessionSettings(
+      SessionOption::SOCKET, target.m_socket,
+      SessionOption::USER, "bench"
+    );
+#endif
+
+  return SessionSettings(
+    SessionOption::HOST, "127.0.0.1",
+    SessionOption::PORT, target.m_port,
+    SessionOption::USER, "bench",
+    SessionOption::SSL_MODE, SSLMode::DISABLED
+  );
+}
+
+
+static uint64_t iterate_rows(Session &sess, const char *spec)
+{
+  RowResult res = sess.sql(spec).execute();
+  uint64_t rows = 0;
+  col_count_t cols = res.getColumnCount();
+
+  for (Row row : res)
+  {
+    for (col_count_t col = 0; col < cols; ++col)
+      row[col].getType();
+    ++rows;
+  }
+
+  return rows;
+}
+
+
+static void devapi_benchmarks()
+{
+  run("session open/close", "sess", []() -> uint64_t {
+    Session sess(settings());
+    sess.close();
+    return 1;
+  });
+
+  Session sess(settings());
+
+  run("sql round trip", "stmt", [&sess]() -> uint64_t {
+    sess.sql("SELECT rows=1 cols=1 type=int").execute().fetchOne();
+    return 1;
+  });
+
+  run("sql no result", "stmt", [&sess]() -> uint64_t {
+    sess.sql("DO 1").execute();
+    return 1;
+  });
+
+  run("rows int x8", "rows", [&sess]() {
+    return iterate_rows(sess, "rows=10000 cols=8 type=int");
+  });
+
+  run("rows mixed x8", "rows", [&sess]() {
+    return iterate_rows(sess,
+      "rows=10000 cols=8 type=int,uint,double,decimal,string");
+  });
+
+  run("rows string 256B x4", "rows", [&sess]() {
+    return iterate_rows(sess, "rows=2000 cols=4 type=string size=256");
+  });
+
+  run("rows json", "rows", [&sess]() {
+    return iterate_rows(sess, "rows=2000 cols=1 type=json size=64");
+  });
+
+  run("rows blob 1MB", "rows", [&sess]() {
+    return iterate_rows(sess, "rows=16 cols=1 type=blob size=1048576");
+  });
+
+  // Typed access which decodes fields without creating Value objects.
+
+  run("rows get<T> mixed x8", "rows", [&sess]() -> uint64_t {
+    RowResult res
+      = sess.sql("SELECT rows=10000 cols=8 type=int,uint,double,string")
+            .execute();
+    uint64_t rows = 0;
+
+    for (Row row : res)
+    {
+      for (col_count_t col = 0; col < 8; col += 4)
+      {
+        row.get<int64_t>(col);
+        row.get<uint64_t>(col + 1);
+        row.get<double>(col + 2);
+        row.get<std::string>(col + 3);
+      }
+      ++rows;
+    }
+
+    return rows;
+  });
+
+  Schema schema = sess.getSchema("bench");
+
+  run("docs find 10 fields", "docs", [&schema]() -> uint64_t {
+    Collection coll = schema.getCollection("rows=5000 cols=10 size=16");
+    DocResult res = coll.find().execute();
+    uint64_t docs = 0;
+
+    for (DbDoc doc : res)
+    {
+      doc["f0"].getType();
+      ++docs;
+    }
+
+    return docs;
+  });
+
+  std::vector<std::string> docs;
+  for (unsigned i = 0; i < 1000; ++i)
+    docs.push_back(
+      "{\"name\": \"document " + std::to_string(i) + "\", \"n\": "
+      + std::to_string(i) + ", \"tags\": [\"a\", \"b\"], \"o\": {\"x\": 1}}"
+    );
+
+  run("docs add bulk 1000", "docs", [&schema, &docs]() -> uint64_t {
+    Collection coll = schema.getCollection("bench");
+    Result res = coll.add(docs).execute();
+    return res.getAffectedItemsCount();
+  });
+}
+
+}  // bench
+
+
+int main(int argc, char **argv)
+try {
+  int server_port = -1;
+
+  for (int i = 1; i < argc; ++i)
+  {
+    const char *arg = argv[i];
+
+    if (0 == strncmp(arg, "--time=", 7))
+      bench::min_time = atof(arg + 7);
+    else if (0 == strncmp(arg, "--socket=", 9))
+      bench::target.m_socket = arg + 9;
+    else if (0 == strncmp(arg, "--server=", 9))
+      server_port = atoi(arg + 9);
+    else
+      bench::filters.push_back(arg);
+  }
+
+  std::unique_ptr<mysqlx::test::Mock_server> server;
+  std::unique_ptr<mysqlx::test::Mock_server> tcp_server(
+    new mysqlx::test::Mock_server((unsigned short)std::max(server_port, 0)));
+  bench::target.m_port = tcp_server->port();
+
+#ifndef _WIN32
+  if (!bench::target.m_socket.empty())
+    server.reset(new mysqlx::test::Mock_server(bench::target.m_socket));
+#endif
+
+  if (server_port >= 0)
+  {
+    std::cout << "Mock server listening on port " << bench::target.m_port;
+    if (!bench::target.m_socket.empty())
+      std::cout << " and socket " << bench::target.m_socket;
+    std::cout << std::endl;
+    for (;;)
+      std::this_thread::sleep_for(std::chrono::seconds(60));
+  }
+
+  std::cout << std::left << std::setw(32) << "benchmark" << std::right
+            << std::setw(12) << "ops/s"
+            << std::setw(21) << "items/s"
+            << std::setw(12) << "allocs/op"
+            << std::setw(12) << "allocs/item" << std::endl;
+
+  bench::devapi_benchmarks();
+  bench::xapi_benchmarks();
+}
+catch (const mysqlx::Error &err)
+{
+  std::cout << "ERROR: " << err << std::endl;
+  return 1;
+}
+catch (const std::exception &err)
+{
+  std::cout << "ERROR: " << err.what() << std::endl;
+  return 1;
+}
@@ -0,0 +1,67 @@
+/*
+ * Copyright (c) 2015, 2016, Oracle and/or its affiliates. All rights reserved.
+ *
+ * The MySQL Connector/C++ is licensed under the terms of the GPLv2
+ * <http://www.gnu.org/licenses/old-licenses/gpl-2.0.html>, like most
+ * MySQL Connectors. There are special exceptions to the terms and
+ * conditions of the GPLv2 as it is applied to this software, see the
+ * FLOSS License Exception
+ * <http://www.mysql.com/about/legal/licensing/foss-exception.html>.
+ *
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published
+ * by the Free Software Foundation; version 2 of the License.
+ *
+ * This program is distributed in the hope that it will be useful, but
+ * WITHOUT ANY WARRANTY; without even the implied warranty of MERCHANTABILITY
+ * or FITNESS FOR A PARTICULAR PURPOSE. See the GNU General Public License
+ * for more details.
+ *
+ * You should have received a copy of the GNU General Public License along
+ * with this program; if not, write to the Free Software Foundation, Inc.,
+ * 51 Franklin St, Fifth Floor, Boston, MA 02110-1301  USA
+ */
+
+#ifndef BENCH_BENCH_H
+#define BENCH_BENCH_H
+
+#include <string>
+#include <functional>
+#include <stdint.h>
+
+
+namespace bench {
+
+/*
+  Where benchmarks connect to: either loopback TCP port or Unix domain
+  socket (if m_socket is not empty).
+*/
+
+struct Target
+{
+  unsigned short m_port;
+  std::string    m_socket;
+};
+
+extern Target target;
+
+
+/*
+  Run benchmark with given name, unless it is excluded by name filters
+  given on the command line.
+
+  Function `op` performs one operation and returns the number of items
+  (rows, documents, ...) it has processed. It is called once to warm up
+  and then repeatedly, until the configured run time passes. The reported
+  figures are operations and items per second and the number of memory
+  allocations done by the benchmark thread per operation and per item.
+*/
+
+void run(const char *name, const char *items, std::function<uint64_t()> op);
+
+
+void xapi_benchmarks();
+
+}  // bench
+
+#endif
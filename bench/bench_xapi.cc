@@ -0,0 +1,147 @@
+/*
+ * Copyright (c) 2015, 2016, Oracle and/or its affiliates. All rights reserved.
+ *
+ * The MySQL Connector/C++ is licensed under the terms of the GPLv2
+ * <http://www.gnu.org/licenses/old-licenses/gpl-2.0.html>, like most
+ * MySQL Connectors. There are special exceptions to the terms and
+ * conditions of the GPLv2 as it is applied to this software, see the
+ * FLOSS License Exception
+ * <http://www.mysql.com/about/legal/licensing/foss-exception.html>.
+ *
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published
+ * by the Free Software Foundation; version 2 of the License.
+ *
+ * This program is distributed in the hope that it will be useful, but
+ * WITHOUT ANY WARRANTY; without even the implied warranty of MERCHANTABILITY
+ * or FITNESS FOR A PARTICULAR PURPOSE. See the GNU General Public License
+ * for more details.
+ *
+ * You should have received a copy of the GNU General Public License along
+ * with this program; if not, write to the Free Software Foundation, Inc.,
+ * 51 Franklin St, Fifth Floor, Boston, MA 02110-1301  USA
+ */
+
+/*
+  Benchmarks of X DevAPI for C
+  ============================
+
+  These are kept separate from X DevAPI benchmarks because the two APIs
+  can not be used in the same translation unit.
+*/
+
+#include "bench.h"
+
+#include <mysql_xapi.h>
+
+#include <stdexcept>
+
+
+namespace bench {
+
+static mysqlx_session_t* xapi_session()
+{
+  mysqlx_session_options_t *opt = mysqlx_session_options_new();
+  int rc;
+
+#ifndef _WIN32
+  if (!target.m_socket.empty())
+    rc = mysqlx_session_option_set(opt,
+      OPT_SOCKET(target.m_socket.c_str()), OPT_USER("bench"), PARAM_END);
+  else
+#endif
+    rc = mysqlx_session_option_set(opt,
+      OPT_HOST("127.0.0.1"), OPT_PORT(target.m_port), OPT_USER("bench"),
+      OPT_SSL_MODE(SSL_MODE_DISABLED), PARAM_END);
+
+  char err[MYSQLX_MAX_ERROR_LEN];
+  int  code = 0;
+  mysqlx_session_t *sess = RESULT_OK == rc
+    ? mysqlx_get_session_from_options(opt, err, &code) : NULL;
+
+  mysqlx_free_options(opt);
+
+  if (!sess)
+    throw std::runtime_error(code ? err : "Could not set session options");
+  return sess;
+}
+
+
+/*
+  Fetch all rows of the result described by `spec` (see mock_server.h),
+  reading each field with the getter matching its type.
+*/
+
+static uint64_t fetch_rows(mysqlx_session_t *sess, const char *spec)
+{
+  mysqlx_result_t *res = mysqlx_sql(sess, spec, MYSQLX_NULL_TERMINATED);
+  if (!res)
+    throw std::runtime_error(mysqlx_error_message(sess));
+
+  uint32_t cols = mysqlx_column_get_count(res);
+  uint64_t rows = 0;
+  mysqlx_row_t *row;
+  char buf[256];
+
+  while ((row = mysqlx_row_fetch_one(res)))
+  {
+    for (uint32_t col = 0; col < cols; ++col)
+    {
+      switch (mysqlx_column_get_type(res, col))
+      {
+      case MYSQLX_TYPE_SINT:
+      {
+        int64_t val;
+        mysqlx_get_sint(row, col, &val);
+        break;
+      }
+      case MYSQLX_TYPE_UINT:
+      {
+        uint64_t val;
+        mysqlx_get_uint(row, col, &val);
+        break;
+      }
+      case MYSQLX_TYPE_DOUBLE:
+      {
+        double val;
+        mysqlx_get_double(row, col, &val);
+        break;
+      }
+      default:
+      {
+        size_t len = sizeof(buf);
+        mysqlx_get_bytes(row, col, 0, buf, &len);
+        break;
+      }
+      }
+    }
+    ++rows;
+  }
+
+  mysqlx_result_free(res);
+  return rows;
+}
+
+
+void xapi_benchmarks()
+{
+  run("xapi session open/close", "sess", []() -> uint64_t {
+    mysqlx_session_close(xapi_session());
+    return 1;
+  });
+
+  mysqlx_session_t *sess = xapi_session();
+
+  run("xapi fetch_one int x8", "rows", [sess]() {
+    return fetch_rows(sess, "rows=10000 cols=8 type=int");
+  });
+
+  run("xapi fetch_one mixed x8", "rows", [sess]() {
+    return fetch_rows(sess,
+      "rows=10000 cols=8 type=int,uint,double,string");
+  });
+
+  mysqlx_session_close(sess);
+}
+
+}  // bench
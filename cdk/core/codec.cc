@@ -25,6 +25,7 @@
 
 #include <mysql/cdk/codec.h>
 #include <sstream>
+#include <locale>
 #include "../parser/json_parser.h"
 
 PUSH_SYS_WARNINGS
@@ -353,63 +354,166 @@ size_t Codec<TYPE_INTEGER>::to_bytes(uint64_t val, bytes buf)
   return internal_to_bytes(val, buf);
 }
 
-std::string Codec<TYPE_FLOAT>::internal_decimal_to_string(bytes buf)
+/*
+  Decoding DECIMAL values
+  -----------------------
+
+  The first byte of the encoding is the scale, that is, number of digits
+  after the decimal point. It is followed by the digits, 2 per byte. The last
+  half-byte is the sign: 0xC for positive and 0xD for negative value. If
+  the number of digits is odd, the sign shares the last byte with the last
+  digit, otherwise the last byte contains only the sign (in its high bits).
+
+  Class Decimal_digits checks the encoding and gives access to the digits
+  without copying them.
+*/
+
+namespace {
+
+class Decimal_digits
 {
-  if (buf.size() < 2)
-    THROW("Invalid DECIMAL buffer");
-  byte scale_digits = *buf.begin();
-  byte sign_byte = *(buf.end() - 1);
-  int last_digit = -1;
-  bool is_negative;
+  const byte *m_data;
+  unsigned    m_count;
+  unsigned    m_scale;
+  bool        m_negative;
 
-  /*
-    Last 4 bits of DECIMAL should always be 1100 (0xC) for positive
-    or 1101 (0xD) for negative value
-  */
-  if ((sign_byte & 0x0C) == 0x0C)
+public:
+
+  Decimal_digits(bytes buf)
   {
-    /* A digit must be retrieved from the first 4 bits of the sign byte */
-    last_digit = (int)(sign_byte >> 4);
-    is_negative = (sign_byte & 0x0D) == 0x0D;
+    if (buf.size() < 2)
+      THROW("Invalid DECIMAL buffer");
+
+    byte sign_byte = *(buf.end() - 1);
+
+    m_data = buf.begin() + 1;
+    m_scale = *buf.begin();
+    m_count = 2 * (unsigned)(buf.size() - 2);
+
+    if (0x0C == (sign_byte & 0x0E))
+    {
+      m_count++;  // last digit is in the sign byte
+      m_negative = (0x0D == (sign_byte & 0x0F));
+    }
+    else if (0xC0 == (sign_byte & 0xE0))
+      m_negative = (0xD0 == (sign_byte & 0xF0));
+    else
+      THROW("Invalid DECIMAL buffer");
+
+    if (m_count < m_scale)
+      THROW("Invalid DECIMAL buffer");
   }
-  else if ((sign_byte & 0xC0) == 0xC0)
+
+  unsigned count() const { return m_count; }
+  unsigned scale() const { return m_scale; }
+  bool negative() const { return m_negative; }
+
+  unsigned operator[](unsigned pos) const
   {
-    /* No digit in the sign byte */
-    is_negative = (sign_byte & 0xD0) == 0xD0;
+    byte b = m_data[pos / 2];
+    unsigned digit = (pos % 2) ? (b & 0x0F) : (b >> 4);
+    if (digit > 9)
+      THROW("Invalid DECIMAL buffer");
+    return digit;
   }
-  else
-    THROW("Invalid DECIMAL buffer");
+};
+
+}  // anonymous namespace
+
+
+size_t Codec<TYPE_FLOAT>::decimal_to_string(bytes buf, char *out, size_t size)
+{
+  Decimal_digits digits(buf);
+
+  unsigned int_digits = digits.count() - digits.scale();
+  unsigned pos = 0;
+
+  // Skip leading zeros of the integral part, keeping at least one digit.
+
+  while (pos + 1 < int_digits && 0 == digits[pos])
+    ++pos;
 
-  int total_digits = ((int)buf.size() - 2) * 2 + (last_digit + 1 ? 1 : 0);
-  if (total_digits <= scale_digits)
-    THROW("Invalid DECIMAL buffer");
+  size_t len = (digits.negative() ? 1 : 0)
+               + (int_digits > 0 ? int_digits - pos : 1)
+               + (digits.scale() > 0 ? 1 + digits.scale() : 0);
 
-  std::stringstream sstream;
+  if (len > size)
+    return len;
 
-  if (is_negative)
-    sstream << "-";
+  char *p = out;
 
-  int pos = 0;
-  for (byte *b = buf.begin() + 1; b < buf.end() - 1; ++b)
+  if (digits.negative())
+    *p++ = '-';
+
+  if (0 == int_digits)
+    *p++ = '0';
+
+  for (; pos < digits.count(); ++pos)
   {
-    do
-    {
-      if (total_digits - scale_digits == pos)
-        /* Getting the locale decimal point */
-        sstream << std::use_facet< std::numpunct<char> >(sstream.getloc()).decimal_point();;
-
-      if (pos % 2)
-        sstream << (int)(*b & 0x0F);
-      else
-        sstream << (int)(*b >> 4);
-      ++pos;
-    } while (pos % 2);
+    if (pos == int_digits)
+      *p++ = '.';
+    *p++ = (char)('0' + digits[pos]);
   }
 
-  if (last_digit + 1)
-    sstream << last_digit;
+  assert((size_t)(p - out) == len);
+  return len;
+}
+
 
-  return sstream.str();
+bool Codec<TYPE_FLOAT>::decimal_to_int(bytes buf, int64_t &unscaled,
+                                       unsigned &scale)
+{
+  Decimal_digits digits(buf);
+
+  const uint64_t max_val = (uint64_t)std::numeric_limits<int64_t>::max()
+                           + (digits.negative() ? 1 : 0);
+  uint64_t val = 0;
+
+  for (unsigned pos = 0; pos < digits.count(); ++pos)
+  {
+    unsigned digit = digits[pos];
+    if (val > (max_val - digit) / 10)
+      return false;
+    val = 10 * val + digit;
+  }
+
+  // Note: negating in unsigned arithmetic avoids overflow for INT64_MIN.
+
+  unscaled = digits.negative() ? (int64_t)(0 - val) : (int64_t)val;
+  scale = digits.scale();
+  return true;
+}
+
+
+/*
+  Exact powers of 10 used to convert small DECIMAL values to float/double
+  with a single, correctly rounded, division.
+*/
+
+static const double pow10_dbl[] = {
+  1e0, 1e1, 1e2, 1e3, 1e4, 1e5, 1e6, 1e7, 1e8, 1e9, 1e10, 1e11,
+  1e12, 1e13, 1e14, 1e15, 1e16, 1e17, 1e18, 1e19, 1e20, 1e21, 1e22
+};
+
+static const float pow10_flt[] = {
+  1e0F, 1e1F, 1e2F, 1e3F, 1e4F, 1e5F, 1e6F, 1e7F, 1e8F, 1e9F, 1e10F
+};
+
+
+/*
+  Parse decimal string produced by decimal_to_string(). It is parsed using
+  "C" locale, where decimal point is '.', regardless of the global locale
+  (which strtod() would use). Returns false if the string could not be
+  parsed entirely or the value is out of range for type T.
+*/
+
+template <typename T>
+static bool parse_decimal(const char *str, size_t len, T &val)
+{
+  std::istringstream in(std::string(str, len));
+  in.imbue(std::locale::classic());
+  in >> val;
+  return !in.fail() && in.eof();
 }
 
 
@@ -417,14 +521,24 @@ size_t Codec<TYPE_FLOAT>::from_bytes(bytes buf, float &val)
 {
   if (m_fmt.type() == cdk::Format<cdk::TYPE_FLOAT>::DECIMAL)
   {
-    std::string s = internal_decimal_to_string(buf);
-    const char *data = s.c_str();
-    char *str_end;
-    float f = strtof(data, &str_end);
+    int64_t  unscaled;
+    unsigned scale;
 
-    if (*str_end != '\0' || f == std::numeric_limits<float>::infinity())
+    if (decimal_to_int(buf, unscaled, scale)
+        && scale < sizeof(pow10_flt)/sizeof(float)
+        && unscaled <= (1 << 24) && unscaled >= -(1 << 24))
+    {
+      val = (float)unscaled / pow10_flt[scale];
+      return buf.size();
+    }
+
+    char str[decimal_str_size];
+    size_t len = decimal_to_string(buf, str, decimal_str_size);
+    if (len > decimal_str_size)
+      THROW("Codec<TYPE_FLOAT>: conversion overflow");
+
+    if (!parse_decimal(str, len, val))
       THROW("Codec<TYPE_FLOAT>: conversion overflow");
-    val = f;
     return buf.size();
   }
 
@@ -449,15 +563,25 @@ size_t Codec<TYPE_FLOAT>::from_bytes(bytes buf, double &val)
 {
   if (m_fmt.type() == cdk::Format<cdk::TYPE_FLOAT>::DECIMAL)
   {
-    std::string s = internal_decimal_to_string(buf);
-    const char *data = s.c_str();
-    char *str_end;
-    double d = strtod(data, &str_end);
+    int64_t  unscaled;
+    unsigned scale;
+    const int64_t max_exact = (int64_t)1 << 53;
+
+    if (decimal_to_int(buf, unscaled, scale)
+        && scale < sizeof(pow10_dbl)/sizeof(double)
+        && unscaled <= max_exact && unscaled >= -max_exact)
+    {
+      val = (double)unscaled / pow10_dbl[scale];
+      return buf.size();
+    }
+
+    char str[decimal_str_size];
+    size_t len = decimal_to_string(buf, str, decimal_str_size);
+    if (len > decimal_str_size)
+      THROW("Codec<TYPE_FLOAT>: conversion overflow");
 
-    /* No need to check for value overflow from DECIMAL to double */
-    if (*str_end != '\0')
+    if (!parse_decimal(str, len, val))
       THROW("Codec<TYPE_FLOAT>: conversion overflow");
-    val = d;
     return buf.size();
   }
 
@@ -503,8 +627,7 @@ size_t Codec<TYPE_FLOAT>::to_bytes(double val, bytes buf)
 
 size_t Codec<TYPE_DOCUMENT>::from_bytes(bytes data, JSON::Processor &jp)
 {
-  std::string json_string(data.begin(), data.end());
-  JSON_parser parser(json_string);
+  JSON_utf8_parser parser(data);
   parser.process(jp);
   return 0; // FIXME
 }
@@ -43,6 +43,7 @@ struct Session_builder
 
   cdk::api::Connection *m_conn = NULL;
   mysqlx::Session      *m_sess = NULL;
+  bool                  m_tls = false;
   const mysqlx::string *m_database = NULL;
   bool m_throw_errors = false;
   scoped_ptr<Error>     m_error;
@@ -141,6 +142,7 @@ Session_builder::operator() (
   {
     m_conn = tls_conn;
     m_sess = new mysqlx::Session(*tls_conn, options);
+    m_tls = true;
   }
   else
 #endif
@@ -272,6 +274,7 @@ Session::Session(ds::TCPIP &ds, const ds::TCPIP::Options &options)
   : m_session(NULL)
   , m_connection(NULL)
   , m_trans(false)
+  , m_tls(false)
 {
   Session_builder sb(true);  // throw errors if detected
 
@@ -281,6 +284,7 @@ Session::Session(ds::TCPIP &ds, const ds::TCPIP::Options &options)
 
   m_session = sb.m_sess;
   m_connection = sb.m_conn;
+  m_tls = sb.m_tls;
 }
 
 
@@ -296,6 +300,7 @@ Session::Session(ds::Multi_source &ds)
   : m_session(NULL)
   , m_connection(NULL)
   , m_trans(false)
+  , m_tls(false)
 {
   Session_builder sb;
 
@@ -316,6 +321,7 @@ Session::Session(ds::Multi_source &ds)
   m_session = sb.m_sess;
   m_database = sb.m_database;
   m_connection = sb.m_conn;
+  m_tls = sb.m_tls;
 }
 
 
@@ -324,6 +330,7 @@ Session::Session(ds::Unix_socket &ds, const ds::Unix_socket::Options &options)
   : m_session(NULL)
   , m_connection(NULL)
   , m_trans(false)
+  , m_tls(false)
 {
   Session_builder sb(true);  // throw errors if detected
 
@@ -19,6 +19,7 @@
 #define _UUID_GEN_H_
 
 #include <stdint.h>
+#include <stddef.h>
 
 #define UUID_LENGTH_BIN 16
 
@@ -33,9 +34,15 @@ void set_seed(uint16_t seed);
    process id */
 void set_seed_from_time_pid();
 
-/* UUID generator */
+/*
+  UUID generator. It does not use any locks shared between threads
+  (after the first use in a given thread).
+*/
 void generate_uuid(uuid_type &uuid);
 
+/* Generate `count` UUIDs at once, reading the system clock only once. */
+void generate_uuids(uuid_type *uuids, size_t count);
+
 } // namespace uuid
 
 #endif
\ No newline at end of file
@@ -25,6 +25,7 @@
 #endif
 #include <algorithm>
 #include <stdexcept>
+#include <atomic>
 
 #ifdef _WIN32
 
@@ -74,12 +75,6 @@ static pthread_mutex_t LOCK_uuid_generator;
 /* The seed and the random value are stored in uuid_seed */
 static uint16_t uuid_seed = 0;
 
-/* Needed for the time counting */
-static unsigned int nanoseq = 0;
-
-/* The last used time value is stored here */
-static unsigned long long uuid_time2 = 0;
-
 #if defined(_WIN32)
 static unsigned long long query_performance_frequency = 0;
 static unsigned long long query_performance_offset = 0;
@@ -94,6 +89,15 @@ static uint16_t time_seq_global = 0;
 */
 unsigned char node_global[6];
 
+/*
+  Incremented each time the seed is changed, so that thread generators
+  know that they must pick up the new node and clock sequence values.
+*/
+static std::atomic<unsigned> seed_version(0);
+
+/* Number of thread generators created so far. */
+static uint32_t thread_count = 0;
+
 /**
   number of 100-nanosecond intervals between
   1582-10-15 00:00:00.00 and 1970-01-01 00:00:00.00.
@@ -257,84 +261,108 @@ void generate_node()
 }
 
 
-namespace uuid
-{
+/*
+  UUID generator local to a single thread
+  =======================================
+
+  Each thread uses its own generator whose state is not shared with other
+  threads, so that generating UUIDs does not need any locking. The node part
+  of UUIDs generated by a thread is the process-wide random node combined
+  with a sequence number of the thread. Thus UUIDs generated by different
+  threads of the same process differ in their node part and a thread only
+  needs to ensure that its own timestamps are increasing.
+
+  The global mutex is taken only when a thread generator is initialized or
+  when the seed was changed since the last initialization.
+*/
 
-void generate_uuid(uuid_type &uuid)
+namespace {
+
+struct Thread_generator
 {
-  if (!uuid_seed)
-    throw std::logic_error("The seed must be set for random numbers generator");
+  unsigned char m_node[6];
+  uint16_t m_clock_seq;
+  unsigned long long m_time;
+  unsigned m_version;
+  bool m_init;
 
-  uuid_internal_st uuid_internal;
+  Thread_generator()
+    : m_time(0), m_init(false)
+  {}
 
-  Uuid_guard guard;
+  void init()
+  {
+    Uuid_guard guard;
 
-  unsigned long long tv = my_getsystime() + UUID_TIME_OFFSET + nanoseq;
+    if (!uuid_seed)
+      throw std::logic_error(
+        "The seed must be set for random numbers generator"
+      );
 
-  if (likely(tv > uuid_time2))
-  {
-    /*
-      Current time is ahead of last timestamp, as it should be.
-      If we "borrowed time", give it back, just as long as we
-      stay ahead of the previous timestamp.
-    */
-    if (nanoseq)
-    {
-      /*
-        -1 so we won't make tv= uuid_time for nanoseq >= (tv - uuid_time)
-      */
-      unsigned long delta = std::min<unsigned long>(nanoseq, (unsigned long)(tv - uuid_time2 - 1));
-      tv -= delta;
-      nanoseq -= delta;
-    }
+    m_version = seed_version.load();
+    memcpy(m_node, node_global, sizeof(m_node));
+    m_clock_seq = time_seq_global;
+
+    uint32_t thread_id = thread_count++;
+    for (unsigned i = 0; i < 4; ++i)
+      m_node[2 + i] ^= (unsigned char)(thread_id >> (8*i));
+
+    m_init = true;
   }
-  else
+
+  /*
+    Generate `count` UUIDs using a single reading of the system clock.
+    Consecutive UUIDs get consecutive timestamps, starting at the current
+    time or right after the last timestamp used by this thread, if the
+    clock did not advance (or went back) since then.
+  */
+
+  void generate(uuid::uuid_type *uuids, size_t count)
   {
-    if (unlikely(tv == uuid_time2))
-    {
-      /*
-        For low-res system clocks. If several requests for UUIDs
-        end up on the same tick, we add a nano-second to make them
-        different.
-        ( current_timestamp + nanoseq * calls_in_this_period )
-        may end up > next_timestamp; this is OK. Nonetheless, we'll
-        try to unwind nanoseq when we get a chance to.
-        If nanoseq overflows, we'll start over with a new numberspace
-        (so the if() below is needed so we can avoid the ++tv and thus
-        match the follow-up if() if nanoseq overflows!).
-      */
-      if (likely(++nanoseq))
-        ++tv;
-    }
+    if (unlikely(!m_init ||
+                 m_version != seed_version.load(std::memory_order_relaxed)))
+      init();
+
+    unsigned long long tv = my_getsystime() + UUID_TIME_OFFSET;
 
-    if (unlikely(tv <= uuid_time2))
+    if (unlikely(tv <= m_time))
+      tv = m_time + 1;
+
+    uuid_internal_st uuid_internal;
+
+    uuid_internal.clock_seq = m_clock_seq;
+    memcpy(uuid_internal.node, m_node, sizeof(m_node));
+
+    for (size_t i = 0; i < count; ++i, ++tv)
     {
-      /*
-        If the admin changes the system clock (or due to Daylight
-        Saving Time), the system clock may be turned *back* so we
-        go through a period once more for which we already gave out
-        UUIDs.  To avoid duplicate UUIDs despite potentially identical
-        times, we make a new random component.
-        We also come here if the nanoseq "borrowing" overflows.
-        In either case, we throw away any nanoseq borrowing since it's
-        irrelevant in the new numberspace.
-      */
-      tv = my_getsystime() + UUID_TIME_OFFSET;
-      time_seq_global = rand_fibonacci() | UUID_VARIANT;
-
-      nanoseq = 0;
+      uuid_internal.time_low = (uint32_t)(tv & 0xFFFFFFFF);
+      uuid_internal.time_mid = (uint16_t)((tv >> 32) & 0xFFFF);
+      uuid_internal.time_hi_and_version = (uint16_t)((tv >> 48) | UUID_VERSION);
+      memcpy(uuids[i], &uuid_internal, sizeof(uuid_internal));
     }
+
+    m_time = tv - 1;
   }
+};
 
-  uuid_time2 = tv;
+}  // anonymous namespace
 
-  uuid_internal.time_low = (uint32_t)(tv & 0xFFFFFFFF);
-  uuid_internal.time_mid = (uint16_t)((tv >> 32) & 0xFFFF);
-  uuid_internal.time_hi_and_version = (uint16_t)((tv >> 48) | UUID_VERSION);
-  uuid_internal.clock_seq = time_seq_global;
 
-  memcpy(uuid_internal.node, node_global, sizeof(node_global));
-  memcpy(uuid, &uuid_internal, sizeof(uuid_internal));
+namespace uuid
+{
+
+void generate_uuid(uuid_type &uuid)
+{
+  generate_uuids(&uuid, 1);
+}
+
+
+void generate_uuids(uuid_type *uuids, size_t count)
+{
+  static thread_local Thread_generator generator;
+
+  if (0 < count)
+    generator.generate(uuids, count);
 }
 
 
@@ -343,6 +371,7 @@ void set_seed(uint16_t seed)
   Uuid_guard guard;
   uuid_seed ^= seed;
   generate_node();
+  ++seed_version;
 }
 
 
@@ -0,0 +1,115 @@
+/*
+  Copyright (c) 2016, Oracle and/or its affiliates. All rights reserved.
+
+  This program is free software; you can redistribute it and/or modify
+  it under the terms of the GNU General Public License as published by
+  the Free Software Foundation; version 2 of the License.
+
+  This program is distributed in the hope that it will be useful,
+  but WITHOUT ANY WARRANTY; without even the implied warranty of
+  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+  GNU General Public License for more details.
+
+  You should have received a copy of the GNU General Public License
+  along with this program; if not, write to the Free Software
+  Foundation, Inc., 51 Franklin St, Fifth Floor, Boston, MA  02110-1301 USA
+*/
+
+#include <uuid_gen.h>
+#include <iostream>
+#include <iomanip>
+#include <cstring>
+#include <cstdlib>
+#include <vector>
+#include <string>
+#include <thread>
+#include <chrono>
+#include <algorithm>
+
+/*
+  Multi-threaded benchmark of UUID generator.
+
+  For 1, 2, 4, ... threads (up to the number given as the first argument,
+  32 by default) each thread generates the same number of UUIDs, either one
+  by one or in batches. The program reports the total throughput and checks
+  that all generated UUIDs are unique.
+
+  Usage: bench_uuid [max threads] [UUIDs per thread]
+*/
+
+using namespace uuid;
+
+typedef std::vector<std::string> Id_list;
+
+
+static void run_thread(Id_list &ids, size_t count, size_t batch)
+{
+  std::vector<uuid_type> buf(batch);
+  ids.reserve(count);
+
+  for (size_t done = 0; done < count; done += batch)
+  {
+    size_t n = std::min(batch, count - done);
+
+    if (1 == batch)
+      generate_uuid(buf[0]);
+    else
+      generate_uuids(buf.data(), n);
+
+    for (size_t i = 0; i < n; ++i)
+      ids.emplace_back((const char*)buf[i], sizeof(uuid_type));
+  }
+}
+
+
+static bool run(unsigned threads, size_t count, size_t batch)
+{
+  std::vector<Id_list> ids(threads);
+  std::vector<std::thread> workers;
+
+  auto start = std::chrono::steady_clock::now();
+
+  for (unsigned i = 0; i < threads; ++i)
+    workers.emplace_back(run_thread, std::ref(ids[i]), count, batch);
+  for (auto &t : workers)
+    t.join();
+
+  auto time = std::chrono::duration_cast<std::chrono::microseconds>(
+    std::chrono::steady_clock::now() - start
+  ).count();
+
+  Id_list all;
+  for (auto &list : ids)
+    all.insert(all.end(), list.begin(), list.end());
+  std::sort(all.begin(), all.end());
+  bool unique = all.end() == std::adjacent_find(all.begin(), all.end());
+
+  double total = (double)threads * count;
+
+  std::cout << std::setw(8) << threads
+            << std::setw(8) << batch
+            << std::setw(14) << std::fixed << std::setprecision(2)
+            << (time ? total / time : 0.0)
+            << (unique ? "" : "   DUPLICATES!") << std::endl;
+
+  return unique;
+}
+
+
+int main(int argc, char **argv)
+{
+  unsigned max_threads = argc > 1 ? (unsigned)atoi(argv[1]) : 32;
+  size_t count = argc > 2 ? (size_t)atol(argv[2]) : 100000;
+
+  set_seed_from_time_pid();
+
+  std::cout << " threads   batch   Mids/second" << std::endl;
+
+  bool ok = true;
+
+  for (size_t batch : { 1, 64 })
+    for (unsigned threads = 1; threads <= max_threads; threads *= 2)
+      ok = run(threads, count, batch) && ok;
+
+  return ok ? 0 : 1;
+}
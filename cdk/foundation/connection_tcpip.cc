@@ -144,9 +144,8 @@ void Socket_base::IO_op::do_cancel()
 
 
 Socket_base::Read_op::Read_op(Socket_base &conn, const buffers &bufs, time_t deadline)
-  : IO_op(conn, bufs, deadline)
-  , m_currentBufferIdx(0)
-  , m_currentBufferOffset(0)
+  : IO_op(conn, bufs, deadline, api::Event_info::SOCKET_RD)
+  , m_currentOffset(0)
 {
   Impl &impl = conn.get_base_impl();
 
@@ -162,21 +161,12 @@ bool Socket_base::Read_op::do_cont()
 
   Impl& impl = m_conn.get_base_impl();
 
-  const bytes& buffer = m_bufs.get_buffer(m_currentBufferIdx);
-  byte* data =buffer.begin() + m_currentBufferOffset;
-  size_t buffer_size = buffer.size() - m_currentBufferOffset;
+  m_currentOffset += detail::recv_some(impl.m_sock, m_bufs, m_currentOffset, false);
 
-  m_currentBufferOffset += detail::recv_some(impl.m_sock, data, buffer_size, 0);
-
-  if (m_currentBufferOffset == buffer.size())
+  if (m_currentOffset == m_bufs.length())
   {
-    ++m_currentBufferIdx;
-
-    if (m_currentBufferIdx == m_bufs.buf_count())
-    {
-      set_completed(m_bufs.length());
-      return true;
-    }
+    set_completed(m_currentOffset);
+    return true;
   }
 
   return false;
@@ -189,24 +179,18 @@ void Socket_base::Read_op::do_wait()
     return;
 
   Impl& impl = m_conn.get_base_impl();
+  size_t length = m_bufs.length();
 
-  for (unsigned int end = m_bufs.buf_count(); m_currentBufferIdx != end; ++m_currentBufferIdx)
-  {
-    const bytes& buffer = m_bufs.get_buffer(m_currentBufferIdx);
-    byte* data = buffer.begin() + m_currentBufferOffset;
-    size_t buffer_size = buffer.size() - m_currentBufferOffset;
-
-    detail::recv(impl.m_sock, data, buffer_size); // TODO: Implement operation deadline.
-
-    m_currentBufferOffset = 0;
-  }
+  // TODO: Implement operation deadline.
+  while (m_currentOffset != length)
+    m_currentOffset += detail::recv_some(impl.m_sock, m_bufs, m_currentOffset, true);
 
-  set_completed(m_bufs.length());
+  set_completed(length);
 }
 
 
 Socket_base::Read_some_op::Read_some_op(Socket_base &conn, const buffers &bufs, time_t deadline)
-  : IO_op(conn, bufs, deadline)
+  : IO_op(conn, bufs, deadline, api::Event_info::SOCKET_RD)
 {
   Impl &impl = conn.get_base_impl();
 
@@ -236,17 +220,14 @@ void Socket_base::Read_some_op::common_read(bool wait)
 
   Impl& impl = m_conn.get_base_impl();
 
-  const bytes& buffer = m_bufs.get_buffer(0);
-
   // TODO: Add timeout support.
-  set_completed(detail::recv_some(impl.m_sock, buffer.begin(), buffer.size(), wait));
+  set_completed(detail::recv_some(impl.m_sock, m_bufs, 0, wait));
 }
 
 
 Socket_base::Write_op::Write_op(Socket_base &conn, const buffers &bufs, time_t deadline)
-  : IO_op(conn, bufs, deadline)
-  , m_currentBufferIdx(0)
-  , m_currentBufferOffset(0)
+  : IO_op(conn, bufs, deadline, api::Event_info::SOCKET_WR)
+  , m_currentOffset(0)
 {
   Impl &impl = conn.get_base_impl();
 
@@ -262,21 +243,12 @@ bool Socket_base::Write_op::do_cont()
 
   Impl& impl = m_conn.get_base_impl();
 
-  const bytes& buffer = m_bufs.get_buffer(m_currentBufferIdx);
-  byte* data = buffer.begin() + m_currentBufferOffset;
-  size_t buffer_size = buffer.size() - m_currentBufferOffset;
+  m_currentOffset += detail::send_some(impl.m_sock, m_bufs, m_currentOffset, false);
 
-  m_currentBufferOffset += detail::send_some(impl.m_sock, data, buffer_size, 0);
-
-  if (m_currentBufferOffset == buffer.size())
+  if (m_currentOffset == m_bufs.length())
   {
-    ++m_currentBufferIdx;
-
-    if (m_currentBufferIdx == m_bufs.buf_count())
-    {
-      set_completed(m_bufs.length());
-      return true;
-    }
+    set_completed(m_currentOffset);
+    return true;
   }
 
   return false;
@@ -289,24 +261,18 @@ void Socket_base::Write_op::do_wait()
     return;
 
   Impl& impl = m_conn.get_base_impl();
+  size_t length = m_bufs.length();
 
-  for (unsigned int end = m_bufs.buf_count(); m_currentBufferIdx != end; ++m_currentBufferIdx)
-  {
-    const bytes& buffer = m_bufs.get_buffer(m_currentBufferIdx);
-    byte* data = buffer.begin() + m_currentBufferOffset;
-    size_t buffer_size = buffer.size() - m_currentBufferOffset;
-
-    detail::send(impl.m_sock, data, buffer_size); // TODO: Implement operation deadline.
-
-    m_currentBufferOffset = 0;
-  }
+  // TODO: Implement operation deadline.
+  while (m_currentOffset != length)
+    m_currentOffset += detail::send_some(impl.m_sock, m_bufs, m_currentOffset, true);
 
-  set_completed(m_bufs.length());
+  set_completed(length);
 }
 
 
 Socket_base::Write_some_op::Write_some_op(Socket_base &conn, const buffers &bufs, time_t deadline)
-  : IO_op(conn, bufs, deadline)
+  : IO_op(conn, bufs, deadline, api::Event_info::SOCKET_WR)
 {
   Impl &impl = conn.get_base_impl();
 
@@ -336,10 +302,8 @@ void Socket_base::Write_some_op::common_write(bool wait)
 
   Impl& impl = m_conn.get_base_impl();
 
-  const bytes& buffer = m_bufs.get_buffer(0);
-
   // TODO: Add timeout support.
-  set_completed(detail::send_some(impl.m_sock, buffer.begin(), buffer.size(), wait));
+  set_completed(detail::send_some(impl.m_sock, m_bufs, 0, wait));
 }
 
 
@@ -0,0 +1,390 @@
+/*
+ * Copyright (c) 2017, Oracle and/or its affiliates. All rights reserved.
+ *
+ * This code is licensed under the terms of the GPLv2
+ * <http://www.gnu.org/licenses/old-licenses/gpl-2.0.html>, like most
+ * MySQL Connectors. There are special exceptions to the terms and
+ * conditions of the GPLv2 as it is applied to this software, see the
+ * FLOSS License Exception
+ * <http://www.mysql.com/about/legal/licensing/foss-exception.html>.
+ *
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published
+ * by the Free Software Foundation; version 2 of the License.
+ *
+ * This program is distributed in the hope that it will be useful, but
+ * WITHOUT ANY WARRANTY; without even the implied warranty of MERCHANTABILITY
+ * or FITNESS FOR A PARTICULAR PURPOSE. See the GNU General Public License
+ * for more details.
+ *
+ * You should have received a copy of the GNU General Public License along
+ * with this program; if not, write to the Free Software Foundation, Inc.,
+ * 51 Franklin St, Fifth Floor, Boston, MA 02110-1301  USA
+ */
+
+
+#include <mysql/cdk/foundation/poller.h>
+#include <mysql/cdk/foundation/error.h>
+#include <mysql/cdk/foundation/opaque_impl.i>
+#include "socket_detail.h"
+
+PUSH_SYS_WARNINGS
+#ifdef HAVE_EPOLL
+#include <sys/epoll.h>
+#endif
+#include <errno.h>
+#include <map>
+#include <vector>
+POP_SYS_WARNINGS
+
+
+using namespace ::cdk::foundation;
+using connection::Poller;
+using connection::detail::Socket;
+
+
+/*
+  Internal implementation of Poller
+  =================================
+
+  Registered operations are stored in m_ops map together with information
+  about the socket event each operation waited for when last checked.
+  Before waiting, wait() looks at all registered operations and if some
+  of them does not wait for a socket event, it is returned immediately.
+  Otherwise information about awaited events is updated and then we wait
+  for one of them using platform specific code.
+
+  With epoll, the socket of each operation is registered with the epoll
+  instance and this registration is modified only when operation starts
+  waiting for a different event. Otherwise the array of awaited events is
+  built from m_ops before each wait.
+*/
+
+class Poller_impl
+  : nocopy
+{
+public:
+
+  typedef api::Event_info::event_type event_type;
+
+  struct Entry
+  {
+    Socket      m_sock;
+    event_type  m_type;
+
+    Entry()
+      : m_sock(connection::detail::NULL_SOCKET), m_type(api::Event_info::OTHER)
+    {}
+
+    bool is_set() const
+    {
+      return connection::detail::NULL_SOCKET != m_sock;
+    }
+  };
+
+  typedef std::map<api::Async_op_base*, Entry> Op_map;
+
+  Op_map m_ops;
+
+  Poller_impl();
+  ~Poller_impl();
+
+  void add(api::Async_op_base &op)
+  {
+    m_ops.insert(Op_map::value_type(&op, Entry()));
+  }
+
+  void remove(api::Async_op_base &op)
+  {
+    Op_map::iterator it = m_ops.find(&op);
+    if (it == m_ops.end())
+      return;
+    unset(it->second);
+    m_ops.erase(it);
+  }
+
+  api::Async_op_base* wait(int timeout);
+
+private:
+
+  void set(Entry&, Socket, event_type, api::Async_op_base*);
+  void unset(Entry&);
+  api::Async_op_base* do_wait(int timeout);
+
+#ifdef HAVE_EPOLL
+  int m_epoll;
+#else
+  size_t m_next;  // used to pick ready operations in round-robin fashion
+#endif
+};
+
+
+IMPL_TYPE(Poller, Poller_impl);
+IMPL_DEFAULT(Poller);
+
+
+api::Async_op_base* Poller_impl::wait(int timeout)
+{
+  for (Op_map::iterator it = m_ops.begin(); it != m_ops.end(); ++it)
+  {
+    api::Async_op_base *op = it->first;
+    const api::Event_info *info = op->waits_for();
+
+    if (!info)
+      return op;
+
+    event_type type = info->type();
+
+    if (api::Event_info::SOCKET_RD != type
+        && api::Event_info::SOCKET_WR != type)
+      return op;
+
+    Socket sock
+      = (Socket)static_cast<const api::Socket_event_info*>(info)->get_fd();
+
+    set(it->second, sock, type, op);
+  }
+
+  if (m_ops.empty())
+    return NULL;
+
+  return do_wait(timeout);
+}
+
+
+#ifdef HAVE_EPOLL
+
+Poller_impl::Poller_impl()
+{
+  m_epoll = ::epoll_create1(EPOLL_CLOEXEC);
+  if (m_epoll < 0)
+    throw_system_error("Poller: ");
+}
+
+
+Poller_impl::~Poller_impl()
+{
+  ::close(m_epoll);
+}
+
+
+void Poller_impl::set(Entry &entry, Socket sock, event_type type,
+                      api::Async_op_base *op)
+{
+  if (entry.m_sock == sock && entry.m_type == type)
+    return;
+
+  epoll_event ev = {};
+  ev.events = api::Event_info::SOCKET_RD == type ? EPOLLIN : EPOLLOUT;
+  ev.data.ptr = op;
+
+  int ctl = EPOLL_CTL_ADD;
+
+  if (entry.m_sock == sock)
+    ctl = EPOLL_CTL_MOD;
+  else
+    unset(entry);
+
+  if (0 != ::epoll_ctl(m_epoll, ctl, sock, &ev))
+  {
+    if (EEXIST == errno)
+      throw_error("Poller: another operation waits for the same socket");
+    throw_system_error("Poller: ");
+  }
+
+  entry.m_sock = sock;
+  entry.m_type = type;
+}
+
+
+void Poller_impl::unset(Entry &entry)
+{
+  if (!entry.is_set())
+    return;
+
+  /*
+    Note: Errors are ignored here - if socket was already closed, it
+    was removed from the epoll set automatically.
+  */
+
+  epoll_event ev = {};
+  ::epoll_ctl(m_epoll, EPOLL_CTL_DEL, entry.m_sock, &ev);
+  entry = Entry();
+}
+
+
+api::Async_op_base* Poller_impl::do_wait(int timeout)
+{
+  epoll_event ev;
+  int res;
+
+  do {
+    res = ::epoll_wait(m_epoll, &ev, 1, timeout);
+  } while (res < 0 && EINTR == errno && timeout < 0);
+
+  if (res < 0 && EINTR != errno)
+    throw_system_error("Poller: ");
+
+  if (res <= 0)
+    return NULL;
+
+  return static_cast<api::Async_op_base*>(ev.data.ptr);
+}
+
+
+#else
+
+Poller_impl::Poller_impl()
+  : m_next(0)
+{}
+
+
+Poller_impl::~Poller_impl()
+{}
+
+
+void Poller_impl::set(Entry &entry, Socket sock, event_type type,
+                      api::Async_op_base*)
+{
+  entry.m_sock = sock;
+  entry.m_type = type;
+}
+
+
+void Poller_impl::unset(Entry &entry)
+{
+  entry = Entry();
+}
+
+
+api::Async_op_base* Poller_impl::do_wait(int timeout)
+{
+  std::vector<api::Async_op_base*> ops;
+  ops.reserve(m_ops.size());
+
+#ifdef _WIN32
+
+  /*
+    Note: On Windows FD_SETSIZE limits the number of sockets in a set,
+    not the values of socket descriptors.
+  */
+
+  if (m_ops.size() > FD_SETSIZE)
+    throw_error("Poller: too many operations");
+
+DIAGNOSTIC_PUSH
+  // 4548 = expression has no effect
+  // This warning is generated by FD_SET
+  DISABLE_WARNING(4548)
+
+  fd_set rd_set, wr_set;
+  FD_ZERO(&rd_set);
+  FD_ZERO(&wr_set);
+
+  for (Op_map::iterator it = m_ops.begin(); it != m_ops.end(); ++it)
+  {
+    ops.push_back(it->first);
+    FD_SET(it->second.m_sock,
+           api::Event_info::SOCKET_RD == it->second.m_type ? &rd_set : &wr_set);
+  }
+
+DIAGNOSTIC_POP
+
+  timeval tv = { timeout / 1000, (timeout % 1000) * 1000 };
+
+  int res = ::select(0, &rd_set, &wr_set, NULL, timeout < 0 ? NULL : &tv);
+
+  if (res < 0)
+    connection::detail::throw_socket_error();
+
+#else
+
+  std::vector<pollfd> fds;
+  fds.reserve(m_ops.size());
+
+  for (Op_map::iterator it = m_ops.begin(); it != m_ops.end(); ++it)
+  {
+    pollfd fd;
+    fd.fd = it->second.m_sock;
+    fd.events
+      = api::Event_info::SOCKET_RD == it->second.m_type ? POLLIN : POLLOUT;
+    fd.revents = 0;
+    fds.push_back(fd);
+    ops.push_back(it->first);
+  }
+
+  int res;
+
+  do {
+    res = ::poll(&fds[0], (nfds_t)fds.size(), timeout);
+  } while (res < 0 && EINTR == errno && timeout < 0);
+
+  if (res < 0 && EINTR != errno)
+    connection::detail::throw_socket_error();
+
+#endif
+
+  if (res <= 0)
+    return NULL;
+
+  // Pick the first ready operation, starting after the last one returned.
+
+  for (size_t i = 0; i < ops.size(); ++i)
+  {
+    size_t pos = (m_next + i) % ops.size();
+    Entry &entry = m_ops[ops[pos]];
+
+#ifdef _WIN32
+    bool ready = FD_ISSET(entry.m_sock, &rd_set)
+                 || FD_ISSET(entry.m_sock, &wr_set);
+#else
+    bool ready = 0 != fds[pos].revents;
+    (void)entry;
+#endif
+
+    if (ready)
+    {
+      m_next = pos + 1;
+      return ops[pos];
+    }
+  }
+
+  return NULL;
+}
+
+#endif
+
+
+/*
+  Poller public interface implemented using internal implementation.
+*/
+
+namespace cdk {
+namespace foundation {
+namespace connection {
+
+
+Poller::Poller()
+{}
+
+void Poller::add(api::Async_op_base &op)
+{
+  get_impl().add(op);
+}
+
+void Poller::remove(api::Async_op_base &op)
+{
+  get_impl().remove(op);
+}
+
+bool Poller::empty() const
+{
+  return get_impl().m_ops.empty();
+}
+
+api::Async_op_base* Poller::wait(int timeout)
+{
+  return get_impl().wait(timeout);
+}
+
+}}}  // cdk::foundation::connection
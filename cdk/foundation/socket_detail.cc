@@ -266,7 +266,7 @@ const error_category& resolve_error_category()
 /**
   Throws thread specific socket error.
 */
-static void throw_socket_error()
+void throw_socket_error()
 {
 #ifdef _WIN32
   throw_error(WSAGetLastError(), winsock_error_category());
@@ -709,6 +709,8 @@ Socket listen_and_accept(unsigned short port)
 
 int select_one(Socket socket, Select_mode mode, bool wait)
 {
+#ifdef _WIN32
+
   timeval zero_timeout = {};
 
 DIAGNOSTIC_PUSH
@@ -738,23 +740,49 @@ DIAGNOSTIC_POP
     check_socket_error(socket);
 
   return result;
+
+#else
+
+  /*
+    Note: poll() is used instead of select() because select() can not
+    handle descriptors with values >= FD_SETSIZE, which is quite possible
+    for applications that keep many sockets or files open.
+  */
+
+  pollfd fds;
+  fds.fd = socket;
+  fds.events = mode == SELECT_MODE_READ ? POLLIN : POLLOUT;
+  fds.revents = 0;
+
+  int result = ::poll(&fds, 1, wait ? -1 : 0);
+
+  if (result > 0 && (fds.revents & (POLLERR | POLLNVAL)))
+    check_socket_error(socket);
+
+  return result;
+
+#endif
 }
 
 
 size_t bytes_available(Socket socket)
 {
-  unsigned long bytes_available;
+  // Note: FIONREAD stores an int on POSIX systems, not a long.
 
 #ifdef _WIN32
+  u_long bytes_available = 0;
+
   if (::ioctlsocket(socket, FIONREAD, &bytes_available) != 0)
 #else
+  int bytes_available = 0;
+
   if (::ioctl(socket, FIONREAD, &bytes_available) == -1)
 #endif
   {
     throw_socket_error();
   }
 
-  return bytes_available;
+  return static_cast<size_t>(bytes_available);
 }
 
 
@@ -898,4 +926,185 @@ size_t send_some(Socket socket, const byte *buffer, size_t buffer_size, bool wai
 }
 
 
+/*
+  Vectored I/O
+  ============
+
+  Functions recv_some() and send_some() which work with a sequence of
+  buffers pass (the remaining part of) these buffers to a single recvmsg()
+  or sendmsg() call (WSARecv() or WSASend() on Windows) instead of reading
+  or writing each buffer separately.
+*/
+
+#ifdef _WIN32
+typedef WSABUF  io_vec;
+#else
+typedef iovec   io_vec;
+#endif
+
+/*
+  Maximal number of buffers passed to a single system call. Remaining
+  buffers are transferred in subsequent calls.
+*/
+
+static const unsigned max_io_vec = 64;
+
+
+/*
+  Fill io_vec array with buffers from bufs, skipping the first offset bytes.
+  Returns number of filled entries and stores the total size of these
+  buffers in size.
+*/
+
+static
+unsigned fill_io_vec(io_vec *vec, const buffers &bufs, size_t offset,
+                     size_t &size)
+{
+  unsigned cnt = 0;
+  size = 0;
+
+  for (unsigned pos = 0, end = bufs.buf_count();
+       pos < end && cnt < max_io_vec; ++pos)
+  {
+    bytes buf = bufs.get_buffer(pos);
+    size_t len = buf.size();
+
+    if (offset >= len)
+    {
+      offset -= len;
+      continue;
+    }
+
+    byte *data = buf.begin() + offset;
+    len -= offset;
+    offset = 0;
+
+    /*
+      Note: The size of a single buffer is checked against the same limit
+      as in the single-buffer variants of recv_some() and send_some().
+    */
+    assert(len < (size_t)std::numeric_limits<int>::max());
+
+#ifdef _WIN32
+    vec[cnt].buf = reinterpret_cast<CHAR*>(data);
+    vec[cnt].len = static_cast<ULONG>(len);
+#else
+    vec[cnt].iov_base = data;
+    vec[cnt].iov_len = len;
+#endif
+
+    size += len;
+    ++cnt;
+  }
+
+  return cnt;
+}
+
+
+size_t recv_some(Socket socket, const buffers &bufs, size_t offset, bool wait)
+{
+  io_vec vec[max_io_vec];
+  size_t size;
+  unsigned cnt = fill_io_vec(vec, bufs, offset, size);
+
+  if (0 == size)
+    return 0;
+
+  int select_result = select_one(socket, SELECT_MODE_READ, wait);
+
+  if (select_result == 0)
+    return 0;
+
+  if (select_result < 0)
+    throw_socket_error();
+
+#ifdef _WIN32
+
+  DWORD bytes_received = 0;
+  DWORD flags = 0;
+
+  if (SOCKET_ERROR == ::WSARecv(socket, vec, cnt, &bytes_received, &flags,
+                                NULL, NULL))
+  {
+    if (WSAGetLastError() == WSAEWOULDBLOCK)
+      return 0;
+    throw_socket_error();
+  }
+
+#else
+
+  msghdr msg;
+  memset(&msg, 0, sizeof(msg));
+  msg.msg_iov = vec;
+  msg.msg_iovlen = cnt;
+
+  ssize_t bytes_received = ::recvmsg(socket, &msg, 0);
+
+  if (bytes_received < 0)
+  {
+    if (errno == EAGAIN || errno == EWOULDBLOCK)
+      return 0;
+    throw_socket_error();
+  }
+
+#endif
+
+  if (bytes_received == 0)
+    throw connection::Error_eos();
+
+  return static_cast<size_t>(bytes_received);
+}
+
+
+size_t send_some(Socket socket, const buffers &bufs, size_t offset, bool wait)
+{
+  io_vec vec[max_io_vec];
+  size_t size;
+  unsigned cnt = fill_io_vec(vec, bufs, offset, size);
+
+  if (0 == size)
+    return 0;
+
+  int select_result = select_one(socket, SELECT_MODE_WRITE, wait);
+
+  if (select_result == 0)
+    return 0;
+
+  if (select_result < 0)
+    throw_socket_error();
+
+#ifdef _WIN32
+
+  DWORD bytes_sent = 0;
+
+  if (SOCKET_ERROR == ::WSASend(socket, vec, cnt, &bytes_sent, 0,
+                                NULL, NULL))
+  {
+    if (WSAGetLastError() == WSAEWOULDBLOCK)
+      return 0;
+    throw_socket_error();
+  }
+
+#else
+
+  msghdr msg;
+  memset(&msg, 0, sizeof(msg));
+  msg.msg_iov = vec;
+  msg.msg_iovlen = cnt;
+
+  ssize_t bytes_sent = ::sendmsg(socket, &msg, 0);
+
+  if (bytes_sent < 0)
+  {
+    if (errno == EAGAIN || errno == EWOULDBLOCK)
+      return 0;
+    throw_socket_error();
+  }
+
+#endif
+
+  return static_cast<size_t>(bytes_sent);
+}
+
+
 }}}} // cdk::foundation::connection::detail
@@ -40,6 +40,8 @@ PUSH_SYS_WARNINGS
 #include <sys/socket.h>
 #include <sys/ioctl.h>
 #include <sys/select.h>
+#include <poll.h>
+#include <sys/uio.h>
 #include <sys/time.h>
 #include <sys/types.h>
 #include <netinet/in.h>
@@ -87,6 +89,13 @@ enum Select_mode
 };
 
 
+/**
+  Throws error reported by the last failed socket function call
+  in the current thread.
+*/
+void throw_socket_error();
+
+
 /**
   Changes socket's blocking mode.
 
@@ -301,7 +310,9 @@ Socket listen_and_accept(unsigned short port);
     If `true`, function will block. Otherwise, it will return immediately.
 
   @return
-    Same as POSIX `select` function.
+    1 if socket is ready, 0 if it is not ready (only when not waiting) and
+    negative value on error. This is implemented with `poll` on POSIX
+    platforms and with `select` on Windows.
 
   @throw cdk::foundation::Error
     If after testing socket is in an erroneous state, function throws.
@@ -430,6 +441,60 @@ size_t recv_some(Socket socket, byte *buffer, size_t buffer_size, bool wait);
 size_t send_some(Socket socket, const byte *buffer, size_t buffer_size, bool wait);
 
 
+/**
+  Receives some data from a socket into a sequence of buffers.
+
+  Performs a single vectored read (scatter read) which fills consecutive
+  buffers from `bufs`, skipping the first `offset` bytes which are assumed
+  to be already filled.
+
+  @param[in] socket
+    Socket used for reading.
+  @param[in] bufs
+    Buffers to be filled with data.
+  @param[in] offset
+    Number of bytes at the beginning of `bufs` which should not be touched.
+  @param[in] wait
+    If `true`, operation will block. Otherwise, data is immediately available.
+
+  @return
+    The number of bytes read from a socket.
+
+  @throw cdk::foundation::connection::Error_eos
+    End-of-stream encountered.
+  @throw cdk::foundation::Error
+    Socket read failed.
+*/
+
+size_t recv_some(Socket socket, const buffers &bufs, size_t offset, bool wait);
+
+
+/**
+  Sends some data from a sequence of buffers to a socket.
+
+  Performs a single vectored write (gather write) of the data stored in
+  consecutive buffers from `bufs`, skipping the first `offset` bytes which
+  are assumed to be already sent.
+
+  @param[in] socket
+    Socket used for sending.
+  @param[in] bufs
+    Buffers with data to be sent.
+  @param[in] offset
+    Number of bytes at the beginning of `bufs` which should be skipped.
+  @param[in] wait
+    If `true`, operation will block. Otherwise, it will return immediately.
+
+  @return
+    The number of bytes sent to a socket.
+
+  @throw cdk::foundation::Error
+    Socket write failed.
+*/
+
+size_t send_some(Socket socket, const buffers &bufs, size_t offset, bool wait);
+
+
 }}}} // cdk::foundation::connection::detail
 
 
@@ -38,6 +38,7 @@
 #include <exception.h>
 #include <iostream>
 #include <mysql/cdk/foundation/connection_tcpip.h>
+#include <mysql/cdk/foundation/poller.h>
 #include <mysql/cdk/foundation/error.h>
 
 #define PORT 9876
@@ -309,6 +310,141 @@ TEST_F(Foundation_connection_tcpip, DISABLED_basic_async)
 }
 
 
+/*
+  Test that uses Poller to wait for socket operations. It sends a message
+  to the test server and waits for its reply.
+
+  Note: Test server should be started before running this test.
+*/
+
+
+TEST_F(Foundation_connection_tcpip, poller)
+{
+  using cdk::foundation::byte;
+  using connection::TCPIP;
+  using connection::Poller;
+
+  char inbuf_raw[13];
+  buffers inbuf((byte*)inbuf_raw, sizeof(inbuf_raw) - 1);
+
+  TCPIP conn("localhost", PORT);
+
+  try {
+    conn.connect();
+  }
+  catch (Error &e)
+  {
+    FAIL() << "Connection error: " << e << endl;
+  }
+
+  Poller poller;
+  EXPECT_TRUE(poller.empty());
+
+  byte output[]= "Hello World!";
+  buffers bufs(output, sizeof(output));
+  TCPIP::Write_op write_op(conn, bufs);
+
+  const api::Event_info *info = write_op.waits_for();
+  ASSERT_TRUE(info);
+  EXPECT_EQ(api::Event_info::SOCKET_WR, info->type());
+  EXPECT_EQ(conn.get_fd(),
+            static_cast<const api::Socket_event_info*>(info)->get_fd());
+
+  poller.add(write_op);
+  EXPECT_FALSE(poller.empty());
+
+  do {
+    EXPECT_EQ(&write_op, poller.wait());
+  } while (!write_op.cont());
+
+  /*
+    Completed operation does not wait for any event and poller should
+    return it without waiting.
+  */
+
+  EXPECT_EQ(NULL, write_op.waits_for());
+  EXPECT_EQ(&write_op, poller.wait());
+  poller.remove(write_op);
+  EXPECT_TRUE(poller.empty());
+
+  cout << "Wrote " << write_op.get_result() << " bytes, waiting for reply ..."
+    << endl;
+
+  TCPIP::Read_op read_op(conn, inbuf);
+  poller.add(read_op);
+
+  do {
+    api::Async_op_base *op = poller.wait(10000);
+    ASSERT_EQ(&read_op, op) << "Timeout waiting for reply from server";
+  } while (!read_op.cont());
+
+  poller.remove(read_op);
+
+  inbuf_raw[read_op.get_result()]= 0;
+  cout << "Read " << read_op.get_result() << " bytes: " << inbuf_raw << endl;
+  EXPECT_EQ(std::string("Hello World!"), std::string(inbuf_raw));
+
+  cout << "Done!" << endl;
+}
+
+
+/*
+  Test that writes a message stored in several buffers and reads server's
+  reply into several buffers. Each buffer sequence is transferred with
+  a single vectored system call, so the test server (which does a single
+  read) should see the whole message.
+
+  Note: Test server should be started before running this test.
+*/
+
+TEST_F(Foundation_connection_tcpip, scatter_gather)
+{
+  using cdk::foundation::byte;
+  using connection::TCPIP;
+
+  TCPIP conn("localhost", PORT);
+
+  try {
+    conn.connect();
+  }
+  catch (Error &e)
+  {
+    FAIL() << "Connection error: " << e << endl;
+  }
+
+  byte hello[] = { 'H', 'e', 'l', 'l', 'o', ' ' };
+  byte world[] = { 'W', 'o', 'r', 'l', 'd', '!' };
+
+  buffers out_rest(world, sizeof(world));
+  buffers out(bytes(hello, sizeof(hello)), out_rest);
+
+  EXPECT_EQ(2U, out.buf_count());
+
+  TCPIP::Write_op write_op(conn, out);
+  write_op.wait();
+
+  EXPECT_EQ(sizeof(hello) + sizeof(world), write_op.get_result());
+
+  char in1[5];
+  char in2[7];
+
+  buffers in_rest((byte*)in2, sizeof(in2));
+  buffers in(bytes((byte*)in1, sizeof(in1)), in_rest);
+
+  TCPIP::Read_op read_op(conn, in);
+  read_op.wait();
+
+  EXPECT_EQ(sizeof(in1) + sizeof(in2), read_op.get_result());
+
+  std::string reply(in1, sizeof(in1));
+  reply.append(in2, sizeof(in2));
+  cout << "Read " << read_op.get_result() << " bytes: " << reply << endl;
+  EXPECT_EQ(std::string("Hello World!"), reply);
+
+  cout << "Done!" << endl;
+}
+
+
 /*
   Test that connects to the test server, sends a message and
   reads server's reply. But server closes connection before all
@@ -358,8 +358,6 @@ class Codec<TYPE_FLOAT>
 
   foundation::Codec<foundation::Type::NUMBER> m_cvt;
 
-  std::string internal_decimal_to_string(bytes buf);
-
 public:
 
   Codec(const Format_info &fi) : Codec_base<TYPE_FLOAT>(fi) {}
@@ -372,6 +370,26 @@ public:
   virtual size_t to_bytes(float val, bytes buf);
   virtual size_t to_bytes(double val, bytes buf);
 
+  /*
+    Exact decoding of DECIMAL values, which are sent as packed BCD digits
+    preceded by a byte with the number of digits after the decimal point.
+
+    Method decimal_to_string() writes the value as text "[-]ddd[.ddd]",
+    always using '.' as the decimal point, into the given buffer. It returns
+    length of the text which is written only if it fits in the buffer
+    (the text is not null-terminated). Buffer of decimal_str_size bytes is
+    enough for any DECIMAL value supported by the server.
+
+    Method decimal_to_int() returns the value as integer `unscaled` such
+    that value = unscaled / 10^scale. It returns false if unscaled value
+    does not fit into int64_t.
+  */
+
+  static const size_t decimal_str_size = 80;
+
+  size_t decimal_to_string(bytes buf, char *out, size_t size);
+  bool   decimal_to_int(bytes buf, int64_t &unscaled, unsigned &scale);
+
 };
 
 
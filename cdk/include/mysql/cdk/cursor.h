@@ -57,6 +57,13 @@ public:
   bool get_row(Row_processor& rp) { return m_impl.get_row(rp); }
   void close() { m_impl.close(); }
 
+  /*
+    Number of rows fetched in one batch from a server-side cursor (if
+    the result is read using one).
+  */
+
+  void set_fetch_size(row_count_t rows) { m_impl.set_fetch_size(rows); }
+
   // Meta_data interface
 
   col_count_t col_count() const
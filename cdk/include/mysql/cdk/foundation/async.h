@@ -40,6 +40,29 @@ public:
 };
 
 
+/*
+  Event info returned by operations which wait for a socket to become
+  readable (type SOCKET_RD) or writable (type SOCKET_WR). An object returned
+  by waits_for() with one of these types is always of this class and
+  get_fd() tells which socket the operation is waiting for.
+*/
+
+class Socket_event_info : public Event_info
+{
+  event_type   m_type;
+  unsigned int m_fd;
+
+public:
+
+  Socket_event_info(event_type type, unsigned int fd)
+    : m_type(type), m_fd(fd)
+  {}
+
+  event_type type() const { return m_type; }
+  unsigned int get_fd() const { return m_fd; }
+};
+
+
 class Async_op_base : nocopy
 {
 public:
@@ -185,8 +185,16 @@ protected:
 
   typedef Socket_base::Impl Impl;
 
-  IO_op(Socket_base &str, const buffers &bufs, time_t deadline =0)
+  /*
+    Operations which read or write the socket directly report the socket
+    event they wait for (SOCKET_RD or SOCKET_WR). Operations created with
+    event type OTHER (the default) report no event info.
+  */
+
+  IO_op(Socket_base &str, const buffers &bufs, time_t deadline =0,
+        api::Event_info::event_type event = api::Event_info::OTHER)
     :  Base::IO_op(str, bufs, deadline)
+    , m_event(event, str.get_fd())
   {}
 
   // Async_op interface
@@ -197,7 +205,14 @@ protected:
   virtual void do_cancel();
   virtual void do_wait() = 0;
 
-  const api::Event_info* get_event_info() const { return  NULL; }
+  const api::Event_info* get_event_info() const
+  {
+    return api::Event_info::OTHER == m_event.type() ? NULL : &m_event;
+  }
+
+private:
+
+  api::Socket_event_info m_event;
 };
 
 
@@ -210,8 +225,8 @@ public:
   virtual void do_wait();
 
 private:
-  unsigned int m_currentBufferIdx;
-  size_t m_currentBufferOffset;
+  // Number of bytes transferred so far.
+  size_t m_currentOffset;
 };
 
 
@@ -237,8 +252,8 @@ public:
   virtual void do_wait();
 
 private:
-  unsigned int m_currentBufferIdx;
-  size_t m_currentBufferOffset;
+  // Number of bytes transferred so far.
+  size_t m_currentOffset;
 };
 
 
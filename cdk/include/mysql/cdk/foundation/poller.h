@@ -0,0 +1,97 @@
+/*
+ * Copyright (c) 2017, Oracle and/or its affiliates. All rights reserved.
+ *
+ * This code is licensed under the terms of the GPLv2
+ * <http://www.gnu.org/licenses/old-licenses/gpl-2.0.html>, like most
+ * MySQL Connectors. There are special exceptions to the terms and
+ * conditions of the GPLv2 as it is applied to this software, see the
+ * FLOSS License Exception
+ * <http://www.mysql.com/about/legal/licensing/foss-exception.html>.
+ *
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published
+ * by the Free Software Foundation; version 2 of the License.
+ *
+ * This program is distributed in the hope that it will be useful, but
+ * WITHOUT ANY WARRANTY; without even the implied warranty of MERCHANTABILITY
+ * or FITNESS FOR A PARTICULAR PURPOSE. See the GNU General Public License
+ * for more details.
+ *
+ * You should have received a copy of the GNU General Public License along
+ * with this program; if not, write to the Free Software Foundation, Inc.,
+ * 51 Franklin St, Fifth Floor, Boston, MA 02110-1301  USA
+ */
+
+
+#ifndef CDK_FOUNDATION_POLLER_H
+#define CDK_FOUNDATION_POLLER_H
+
+#include "async.h"
+#include "opaque_impl.h"
+
+
+namespace cdk {
+namespace foundation {
+namespace connection {
+
+
+/*
+  Waiting for many socket operations
+  ==================================
+
+  Poller object waits for several asynchronous operations at once. An
+  operation can make progress without blocking when the socket reported by
+  its waits_for() method (see api::Socket_event_info) becomes readable or
+  writable. This way a single thread can drive many operations on different
+  connections.
+
+  Method wait() waits until one of the registered operations is ready and
+  returns it - the caller should then call cont() on it. Operations that do
+  not wait for socket events (waits_for() returns NULL or event info of other
+  type) are considered ready and are returned without waiting. An operation
+  is registered with add() and should be unregistered with remove() before
+  it is destroyed. Only one operation per socket can be registered at a time.
+
+  On Linux the poller is implemented using epoll, on Windows select() is
+  used (limiting the number of registered operations to FD_SETSIZE) and on
+  other platforms poll().
+
+  Example usage:
+
+    Poller poller;
+    poller.add(op1);
+    poller.add(op2);
+
+    while (!poller.empty())
+    {
+      api::Async_op_base *op = poller.wait();
+      if (op->cont())
+        poller.remove(*op);
+    }
+*/
+
+class Poller
+  : opaque_impl<Poller>
+  , nocopy
+{
+public:
+
+  Poller();
+
+  void add(api::Async_op_base&);
+  void remove(api::Async_op_base&);
+  bool empty() const;
+
+  /*
+    Return one of the registered operations that is ready to make progress.
+    If timeout (in milliseconds) is not negative and it expires before any
+    operation is ready, NULL is returned.
+  */
+
+  api::Async_op_base* wait(int timeout = -1);
+};
+
+
+}}}  // cdk::foundation::connection
+
+#endif
@@ -68,6 +68,9 @@ using protocol::mysqlx::row_count_t;
 using protocol::mysqlx::col_count_t;
 using protocol::mysqlx::collation_id_t;
 using protocol::mysqlx::insert_id_t;
+using protocol::mysqlx::stmt_id_t;
+using protocol::mysqlx::Cmd_cache;
+using protocol::mysqlx::cursor_id_t;
 
 typedef api::Async_op<void>   Async_op;
 typedef api::Async_op<size_t> Proto_op;
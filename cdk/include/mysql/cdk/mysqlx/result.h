@@ -50,6 +50,11 @@ protected:
   Diagnostic_arena m_da;
   bool             m_error;
 
+  // Server-side cursor opened by the command (if m_cursor_id is not 0)
+
+  cursor_id_t      m_cursor_id;
+  row_count_t      m_fetch_rows;
+
   Session& get_session()
   {
     if (!m_session)
@@ -62,6 +67,8 @@ public:
   Reply()
     : m_session(NULL)
     , m_error(false)
+    , m_cursor_id(0)
+    , m_fetch_rows(0)
   {}
 
   Reply(Reply_init& _init)
@@ -119,6 +126,18 @@ protected:
 
   void close_cursor();
 
+  /*
+    If this is a reply to a pipelined command which is queued in the
+    session, make it the current reply (see Session::pipeline()).
+  */
+
+  void activate();
+
+  bool is_pending() const
+  {
+    return m_session && this != m_session->m_current_reply;
+  }
+
 private:
 
   //  Initialize class instance from Reply_init. Used on operator=()
@@ -156,6 +175,16 @@ protected:
   bool m_limited;
   bool m_more_rows;
 
+  /*
+    If result is read from a server-side cursor, m_suspended is true when
+    server has sent all rows from the current batch and the next batch
+    of m_fetch_rows rows must be requested from it.
+  */
+
+  cursor_id_t  m_cursor_id;
+  row_count_t  m_fetch_rows;
+  bool m_suspended;
+
 
 public:
 
@@ -168,6 +197,17 @@ public:
 
   void close();
 
+  /*
+    Change number of rows requested from server-side cursor in the following
+    fetches (no effect if result is not read from a cursor).
+  */
+
+  void set_fetch_size(row_count_t rows)
+  {
+    if (rows)
+      m_fetch_rows = rows;
+  }
+
 
   /*
       Metadata Interface
@@ -207,6 +247,9 @@ private:
   const Col_metadata& get_metadata(col_count_t pos) const;
   void internal_get_rows(mysqlx::Row_processor& rp);
 
+  bool fetch_pending() const;
+  void fetch_next();
+
   /*
       Async (cdk::api::Async_op)
   */
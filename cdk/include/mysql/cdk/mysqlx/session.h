@@ -33,6 +33,7 @@
 
 PUSH_SYS_WARNINGS
 #include <deque>
+#include <vector>
 POP_SYS_WARNINGS
 
 #undef max
@@ -380,9 +381,27 @@ typedef Session Reply_init;
 class Reply;
 class Cursor;
 class SessionAuthInterface;
+class Proto_delayed_op;
 
 
 typedef protocol::mysqlx::api::Protocol_fields Protocol_fields;
+using protocol::mysqlx::Stat_counter;
+
+
+/*
+  Statistics of a session (see Session::get_stats()): statistics of its
+  protocol instance and counts of commands executed in different ways.
+*/
+
+struct Session_stats : public protocol::mysqlx::Protocol_stats
+{
+  uint64_t commands = 0;        // commands executed (including pipelined)
+  uint64_t pipelined = 0;       // commands sent without waiting for replies
+  uint64_t prepares = 0;        // statements prepared on the server
+  uint64_t prepared_execs = 0;  // commands executed as prepared statements
+  uint64_t cursor_fetches = 0;  // batches of rows requested from cursors
+  uint64_t errors = 0;          // errors reported by the server
+};
 
 class Session
     : public api::Diagnostics
@@ -406,7 +425,7 @@ protected:
 
   SessionAuthInterface* m_auth_interface;
 
-  shared_ptr<Proto_op> m_cmd;
+  shared_ptr<Proto_delayed_op> m_cmd;
   enum { CMD_SQL, CMD_ADMIN, CMD_COLL_ADD } m_cmd_type;
 
   string m_stmt;
@@ -439,10 +458,48 @@ protected:
   std::deque< shared_ptr<Proto_op> > m_reply_op_queue;
   Cursor*                 m_current_cursor;
 
+  /*
+    Pipelined commands (see pipeline()): m_pending_replies holds replies
+    to commands which were already sent, in the order in which they were
+    sent. These replies are read after the current one. Member m_last_cmd
+    is the last command that was sent or scheduled to be sent.
+  */
+
+  std::deque<Reply*>             m_pending_replies;
+  shared_ptr<Proto_delayed_op>   m_last_cmd;
+  bool                           m_pipeline;
+
   bool m_executed;
   bool m_has_results;
   bool m_discard;
 
+  // Prepared statements
+
+  bool m_prepare_supported;
+  option_t m_reset_supported;
+  stmt_id_t m_last_stmt_id;
+  std::vector<stmt_id_t> m_free_stmt_ids;
+  std::vector<stmt_id_t> m_stmts_to_deallocate;
+
+  // Statistics (see get_stats())
+
+  struct
+  {
+    Stat_counter commands;
+    Stat_counter pipelined;
+    Stat_counter prepares;
+    Stat_counter prepared_execs;
+    Stat_counter cursor_fetches;
+    Stat_counter errors;
+  }
+  m_stats;
+
+  // Cursor to be opened by the pending command (see use_cursor())
+
+  cursor_id_t m_last_cursor_id;
+  cursor_id_t m_cursor_id;
+  row_count_t m_fetch_rows;
+
 public:
 
   //cdk::api::Connection* get_connection();
@@ -460,12 +517,19 @@ public:
     , m_id(0)
     , m_expired(false)
     , m_current_cursor(NULL)
+    , m_pipeline(false)
     , m_executed(false)
     , m_has_results(false)
     , m_discard(false)
+    , m_prepare_supported(true)
+    , m_last_stmt_id(0)
+    , m_last_cursor_id(0)
+    , m_cursor_id(0)
+    , m_fetch_rows(0)
     , m_nr_cols(0)
   {
     m_stmt_stats.clear();
+    negotiate_compression(options);
     authenticate(options, conn.is_secure());
     check_protocol_fields();
   }
@@ -499,6 +563,29 @@ public:
   void clear_errors()
   { m_da.clear(); }
 
+  /*
+    Store current values of session statistics. Counters are never reset
+    and updating them does not take any locks, so this can be called from
+    a thread other than the one which uses the session.
+  */
+
+  void get_stats(Session_stats&) const;
+
+  /*
+    Bring the session back to the state it had right after authentication,
+    for example before it is re-used by a session pool. Replies to earlier
+    commands are discarded and all prepared statements are released, so
+    that their ids can be used again.
+
+    If the server can reset a session without closing it (this is checked
+    on the first reset), the session is reset on the server: this rolls
+    back any open transaction and clears session variables, temporary
+    tables etc. Otherwise any open transaction is rolled back and prepared
+    statements are deallocated one by one.
+  */
+
+  void reset();
+
   void close();
 
   /*
@@ -575,6 +662,65 @@ public:
 
   Reply_init &view_drop(const api::Table_ref&, bool check_existence = false);
 
+  /*
+    Prepared statements
+    -------------------
+
+    Method prepare() prepares on the server the command that was set up
+    by one of the methods above and is not yet executed. It returns id of
+    the prepared statement or 0 if the command could not be prepared (in which
+    case it will be executed in the normal way). If prepare() succeeds,
+    executing the command sends only Execute request with parameter values
+    for the prepared statement.
+
+    Method use_prepared() informs session that the pending command is the same
+    as the one prepared earlier with the given id, so that it can be executed
+    by sending Execute request.
+
+    Method deallocate() releases given prepared statement. Deallocate requests
+    are sent to the server together with the next command.
+
+    Method use_cursor() requests that the pending command, which must be
+    prepared, opens a server-side cursor. Rows of the result are then sent
+    by the server in batches of `fetch_rows` rows and the next batch is
+    requested by the cursor when all rows of the previous one were consumed.
+    Returns false if the command can not be executed using a cursor.
+
+    Method use_cmd_cache() requests that the pending command, if it is not
+    prepared, is sent using the given cache of the serialized command (see
+    protocol::mysqlx::Cmd_cache). The cache must exist until the command is
+    sent. It is ignored by commands other than CRUD find, update and delete.
+  */
+
+  stmt_id_t prepare();
+  void use_prepared(stmt_id_t);
+  void deallocate(stmt_id_t);
+  bool use_cursor(row_count_t fetch_rows);
+  void use_cmd_cache(Cmd_cache&);
+
+  /*
+    Pipelining
+    ----------
+
+    Normally, when a Reply object for a new command is created, the reply
+    to the previous command is completed first, discarding any of its
+    data that was not read yet. Then the new command is sent.
+
+    Method pipeline() requests that the pending command is sent right away,
+    without touching the replies to earlier commands. The Reply object
+    created for such command is queued and replies are read in the order
+    in which commands were sent. Using a queued reply discards all replies
+    before it (so their data must be read beforehand if it is needed).
+    Creating a reply for a command that is not pipelined discards all
+    earlier replies.
+
+    Returns false if the pending command can not be pipelined, which is
+    the case if it uses a server-side cursor, if the current reply is read
+    from a cursor or if Deallocate requests are waiting to be sent.
+  */
+
+  bool pipeline();
+
 
   /*
       Async (cdk::api::Async_op)
@@ -603,7 +749,23 @@ public:
 
 private:
 
-  Reply_init &set_command(Proto_op *cmd);
+  Reply_init &set_command(Proto_delayed_op *cmd);
+  void send_deallocate();
+
+  // Pipelining (see pipeline())
+
+  void send_pipelined(Reply*);
+  void activate_reply(Reply*);
+  void activate_next();
+  void discard_replies();
+
+  // Server-side cursors (used by Cursor class)
+
+  void cursor_fetch(cursor_id_t, row_count_t);
+  void cursor_close(cursor_id_t);
+
+  // Compression of protocol messages (before authentication)
+  void negotiate_compression(const Options &options);
 
   // Authentication (cdk::protocol::mysqlx::Auth_processor)
   void authenticate(const Options &options, bool secure = false);
@@ -40,6 +40,10 @@
 #include "mysqlx/traits.h"
 #include "mysqlx/expr.h"
 
+PUSH_SYS_WARNINGS
+#include <atomic>
+POP_SYS_WARNINGS
+
 
 namespace cdk {
 namespace protocol {
@@ -79,7 +83,14 @@ enum ClientMessages_Type {
   ClientMessages_Type_EXPECT_CLOSE = 25,
   ClientMessages_Type_CRUD_CREATE_VIEW = 30,
   ClientMessages_Type_CRUD_MODIFY_VIEW = 31,
-  ClientMessages_Type_CRUD_DROP_VIEW = 32
+  ClientMessages_Type_CRUD_DROP_VIEW = 32,
+  ClientMessages_Type_PREPARE_PREPARE = 40,
+  ClientMessages_Type_PREPARE_EXECUTE = 41,
+  ClientMessages_Type_PREPARE_DEALLOCATE = 42,
+  ClientMessages_Type_CURSOR_OPEN = 43,
+  ClientMessages_Type_CURSOR_CLOSE = 44,
+  ClientMessages_Type_CURSOR_FETCH = 45,
+  ClientMessages_Type_COMPRESSION = 46
 };
 
 enum ServerMessages_Type {
@@ -95,7 +106,8 @@ enum ServerMessages_Type {
   ServerMessages_Type_RESULTSET_FETCH_SUSPENDED = 15,
   ServerMessages_Type_RESULTSET_FETCH_DONE_MORE_RESULTSETS = 16,
   ServerMessages_Type_SQL_STMT_EXECUTE_OK = 17,
-  ServerMessages_Type_RESULTSET_FETCH_DONE_MORE_OUT_PARAMS = 18
+  ServerMessages_Type_RESULTSET_FETCH_DONE_MORE_OUT_PARAMS = 18,
+  ServerMessages_Type_COMPRESSION = 19
 };
 
 
@@ -153,6 +165,20 @@ enum ServerMessages_Type {
     MSG_CLIENT(X, Mysqlx::Crud::CreateView, CreateView, CRUD_CREATE_VIEW) \
     MSG_CLIENT(X, Mysqlx::Crud::ModifyView, ModifyView, CRUD_MODIFY_VIEW) \
     MSG_CLIENT(X, Mysqlx::Crud::DropView, DropView, CRUD_DROP_VIEW) \
+    MSG_CLIENT(X, Mysqlx::Prepare::Prepare, \
+               PreparePrepare, PREPARE_PREPARE) \
+    MSG_CLIENT(X, Mysqlx::Prepare::Execute, \
+               PrepareExecute, PREPARE_EXECUTE) \
+    MSG_CLIENT(X, Mysqlx::Prepare::Deallocate, \
+               PrepareDeallocate, PREPARE_DEALLOCATE) \
+    MSG_CLIENT(X, Mysqlx::Cursor::Open, \
+               CursorOpen, CURSOR_OPEN) \
+    MSG_CLIENT(X, Mysqlx::Cursor::Close, \
+               CursorClose, CURSOR_CLOSE) \
+    MSG_CLIENT(X, Mysqlx::Cursor::Fetch, \
+               CursorFetch, CURSOR_FETCH) \
+    MSG_CLIENT(X, Mysqlx::Connection::Compression, \
+               Compression, COMPRESSION) \
 \
     MSG_SERVER(X, Mysqlx::Ok, \
                Ok, OK) \
@@ -173,8 +199,8 @@ enum ServerMessages_Type {
                Row, RESULTSET_ROW) \
     MSG_SERVER(X, Mysqlx::Resultset::FetchDone, \
                FetchDone, RESULTSET_FETCH_DONE) \
-/*    MSG_SERVER(X, Mysqlx::Resultset::FetchSuspended, */ \
-/*               SqlFetchSuspended, RESULTSET_FETCH_SUSPENDED)  */ \
+    MSG_SERVER(X, Mysqlx::Resultset::FetchSuspended, \
+               FetchSuspended, RESULTSET_FETCH_SUSPENDED) \
     MSG_SERVER(X, Mysqlx::Resultset::FetchDoneMoreResultsets, \
                FetchDoneMoreResultsets, \
                RESULTSET_FETCH_DONE_MORE_RESULTSETS) \
@@ -183,6 +209,8 @@ enum ServerMessages_Type {
                RESULTSET_FETCH_DONE_MORE_OUT_PARAMS) \
     MSG_SERVER(X, Mysqlx::Sql::StmtExecuteOk, \
                StmtExecuteOk, SQL_STMT_EXECUTE_OK) \
+    MSG_SERVER(X, Mysqlx::Connection::Compression, \
+               Compression, COMPRESSION) \
 
 
 #define MSG_CLIENT(X,MSG,N,C)  MSG_CLIENT_##X(MSG,N,C)
@@ -318,6 +346,30 @@ struct notice_scope
 };
 
 
+/*
+  Compression algorithms which can be used for message frames (see
+  Protocol::set_compression()). Function compression_name() returns the name
+  of the algorithm used in the "compression" capability. An algorithm can be
+  used only if compression_supported() returns true for it, which depends on
+  the libraries that were available when building CDK.
+*/
+
+struct compression_type
+{
+  enum value { NONE = 0, DEFLATE = 1, LZ4 = 2, ZSTD = 3 };
+};
+
+const char* compression_name(compression_type::value);
+bool compression_supported(compression_type::value);
+
+/*
+  Default size below which messages are sent uncompressed, even if
+  compression is enabled (see Protocol::set_compression()).
+*/
+
+const size_t default_compression_threshold = 1024;
+
+
 /*
   A class to store SQL state values.
 */
@@ -440,7 +492,7 @@ struct Protocol_fields
     Enum values will be used as binary flags,
     so they must be as 2^N
   */
-  enum value { ROW_LOCKING = 1 , UPSERT = 2 };
+  enum value { ROW_LOCKING = 1 , UPSERT = 2, SESSION_RESET_KEEP_OPEN = 4 };
 };
 
 }  // api namespace
@@ -492,6 +544,139 @@ public:
 */
 enum Data_model { DEFAULT= 0, DOCUMENT = 1, TABLE = 2 };
 
+
+/*
+  Storage for serialized CRUD command which can be sent again with different
+  values of named parameters (see Protocol::snd_Find()).
+
+  When a command is sent with an empty cache, the cache stores the command
+  serialized without parameter values, together with names of its named
+  parameters. When the same command is sent again with this cache, only the
+  parameter values are serialized and appended to the stored bytes. This
+  relies on protobuf wire format, where fields of a message can be sent in
+  any order and repeated fields can be split.
+
+  It is the responsibility of the owner of the cache to clear it whenever
+  the command changes in a way other than values of its parameters.
+  The cache is not used if parameters have different names than when it
+  was filled.
+*/
+
+class Cmd_cache
+{
+  std::string  m_msg;
+  std::vector<string> m_params;
+
+public:
+
+  bool empty() const
+  {
+    return m_msg.empty();
+  }
+
+  void clear()
+  {
+    m_msg.clear();
+    m_params.clear();
+  }
+
+  friend class Protocol;
+};
+
+
+/*
+  Statistics
+  ==========
+
+  Counter which is updated only by the thread that uses the object owning
+  it, but can be read at any time from other threads. Since there is only
+  one writer, an update is a relaxed load followed by a relaxed store, which
+  compiles to plain memory accesses -- no locks or locked instructions are
+  used.
+*/
+
+class Stat_counter
+{
+  std::atomic<uint64_t> m_val;
+
+public:
+
+  Stat_counter() : m_val(0)
+  {}
+
+  void add(uint64_t val = 1)
+  {
+    m_val.store(m_val.load(std::memory_order_relaxed) + val,
+                std::memory_order_relaxed);
+  }
+
+  uint64_t get() const
+  {
+    return m_val.load(std::memory_order_relaxed);
+  }
+};
+
+
+/*
+  Kinds of commands for which protocol keeps latency histograms. Client
+  messages are classified as follows:
+
+  SQL     - StmtExecute,
+  FIND, INSERT, UPDATE, REMOVE - CRUD operations,
+  PREPARE - Prepare and Deallocate,
+  EXECUTE - Execute of a prepared statement,
+  CURSOR  - Cursor Open, Fetch and Close,
+  SESSION - capabilities, authentication, session reset and close,
+  OTHER   - expectation blocks and view DDL.
+*/
+
+#define STATS_CMD_LIST(X) \
+  X(SQL) X(FIND) X(INSERT) X(UPDATE) X(REMOVE) \
+  X(PREPARE) X(EXECUTE) X(CURSOR) X(SESSION) X(OTHER)
+
+#define STATS_CMD_enum(N) N,
+
+struct stats_cmd
+{
+  enum value {
+    STATS_CMD_LIST(STATS_CMD_enum)
+    COUNT
+  };
+};
+
+
+/*
+  Snapshot of protocol statistics, see Protocol::get_stats().
+
+  Command latency is the time from sending a client message until
+  the server message which completes the reply to it (Ok, Error,
+  StmtExecuteOk, FetchSuspended or the final authentication message) is
+  received. It is recorded in a histogram for the command kind, where
+  bucket 0 counts latencies below 1us and bucket i > 0 counts latencies
+  in the range [2^(i-1), 2^i) us. The last bucket counts all latencies
+  longer than that. Messages of a pipeline are matched with replies in
+  the order in which they were sent.
+*/
+
+struct Protocol_stats
+{
+  enum { latency_buckets = 24 };
+
+  uint64_t bytes_sent = 0;
+  uint64_t bytes_received = 0;
+  uint64_t msgs_sent = 0;
+  uint64_t msgs_received = 0;
+  uint64_t round_trips = 0;       // writes followed by waiting for a reply
+  uint64_t rows = 0;              // rows passed to a row processor
+  uint64_t fields = 0;
+  uint64_t rd_buf_reallocs = 0;
+  uint64_t wr_buf_reallocs = 0;
+  uint64_t rd_wait_ns = 0;        // time blocked waiting for incoming data
+
+  uint64_t latency[stats_cmd::COUNT][latency_buckets] = {};
+};
+
+
 class Protocol
   : foundation::opaque_impl<Protocol>
   , foundation::nocopy
@@ -509,6 +694,14 @@ public:
   Op& snd_AuthenticateContinue(bytes data);
   Op& snd_Close();
 
+  /*
+    Reset session state on the server. If keep_open is false, server
+    requires the client to authenticate again after the reset. Server
+    replies with Ok message.
+  */
+
+  Op& snd_SessionReset(bool keep_open);
+
 
   /**
     Send protocol command which executes a statement.
@@ -542,10 +735,15 @@ public:
 
     @param args  if expressions used in the specification use named parameters,
       this argument map provides values of these parameters
+
+    @param cache  optional cache of the serialized command (@see Cmd_cache);
+      it is not used if the command is sent to be prepared on the server
+      (the same for snd_Update() and snd_Delete())
   */
 
   Op& snd_Find(Data_model dm, const Find_spec &spec,
-               const api::Args_map *args = NULL);
+               const api::Args_map *args = NULL,
+               Cmd_cache *cache = NULL);
 
   /**
     Send CRUD Insert command.
@@ -601,7 +799,8 @@ public:
   Op& snd_Update(Data_model dm,
                  const Select_spec &select,
                  Update_spec &update,
-                 const api::Args_map *args = NULL);
+                 const api::Args_map *args = NULL,
+                 Cmd_cache *cache = NULL);
 
   /**
     Send CRUD Delete command.
@@ -619,7 +818,98 @@ public:
   */
 
   Op& snd_Delete(Data_model dm, const Select_spec &select,
-                 const api::Args_map *args = NULL);
+                 const api::Args_map *args = NULL,
+                 Cmd_cache *cache = NULL);
+
+
+  /**
+    Prepare the next statement on the server.
+
+    After calling this method with non-zero statement id, the next
+    statement sent with snd_StmtExecute(), snd_Find(), snd_Insert(),
+    snd_Update() or snd_Delete() is not executed. Instead, it is sent inside
+    Prepare command which prepares it on the server under the given id.
+    Values of parameters passed to these methods are not sent with Prepare
+    command -- they should be passed to snd_PrepareExecute() when executing
+    the prepared statement.
+
+    Server replies to Prepare command with Ok or Error message
+    (use rcv_Reply() to process it).
+
+    @param id  client assigned id of the prepared statement (must not be 0)
+  */
+
+  void set_prepare_id(stmt_id_t id);
+
+  /**
+    Send command which executes statement prepared earlier under given id.
+
+    Server replies in the same way as if the original statement was sent.
+
+    @param id    id of the prepared statement
+    @param args  values of named parameters of a prepared CRUD statement
+      -- they must be given in the same order as when the statement was
+      prepared
+  */
+
+  Op& snd_PrepareExecute(stmt_id_t id, const api::Args_map *args);
+
+  /**
+    Send command which executes statement prepared earlier under given id.
+
+    @param id    id of the prepared statement
+    @param args  values of placeholders of a prepared SQL statement
+  */
+
+  Op& snd_PrepareExecute(stmt_id_t id, const api::Any_list *args);
+
+  /**
+    Send command which releases statement prepared under given id.
+
+    Server replies with Ok or Error message (use rcv_Reply() to process it).
+  */
+
+  Op& snd_PrepareDeallocate(stmt_id_t id);
+
+
+  /**
+    Open a cursor for the next prepared statement execution.
+
+    After calling this method with non-zero cursor id, the next command
+    sent with snd_PrepareExecute() is sent inside Cursor.Open command which
+    executes the prepared statement and opens a cursor with the given id
+    over its result. Server sends result meta-data followed by at most
+    `fetch_rows` rows. If there are more rows in the result, the row set is
+    terminated by FetchSuspended message instead of FetchDone. When this
+    message is processed by rcv_Rows(), the row processor is informed that
+    not all rows were sent (Row_processor::done() is called with first
+    argument set to false). More rows can be then requested with
+    snd_CursorFetch() and read with rcv_Rows().
+
+    @param cid         client assigned id of the cursor (must not be 0)
+    @param fetch_rows  number of rows sent by server in one batch
+  */
+
+  void set_cursor(cursor_id_t cid, row_count_t fetch_rows);
+
+  /**
+    Send command which requests next `fetch_rows` rows from a cursor.
+
+    Should be used only after rows from the previous batch were read
+    with rcv_Rows().
+  */
+
+  Op& snd_CursorFetch(cursor_id_t cid, row_count_t fetch_rows);
+
+  /**
+    Send command which closes a cursor before all rows from its result were
+    fetched.
+
+    This discards the state of the suspended rcv_Rows() operation. Server
+    replies with Ok or Error message (use rcv_Reply() to process it).
+  */
+
+  Op& snd_CursorClose(cursor_id_t cid);
 
 
   Op& snd_CreateView(Data_model dm, const api::Db_obj &obj,
@@ -642,6 +932,53 @@ public:
   Op& rcv_Rows(Row_processor &);
   Op& rcv_MetaData(Mdata_processor &);
 
+  /**
+    Set size of the read-ahead buffer used when reading incoming messages.
+    Many small messages can be read from the stream with a single read
+    operation when they fit into this buffer.
+  */
+
+  void set_rd_ahead_size(size_t);
+
+  /**
+    Return number of read operations performed on the underlying stream
+    since the protocol instance was created. For socket connections each
+    operation corresponds to a single receive system call.
+  */
+
+  uint64_t get_rd_count() const;
+
+  /**
+    Store current values of protocol statistics (see Protocol_stats).
+    Statistics are collected all the time and are not reset. This method
+    can be called from a thread other than the one which uses the protocol.
+  */
+
+  void get_stats(Protocol_stats&) const;
+
+  /**
+    Enable compression of message frames using the given algorithm. This
+    should be called after the algorithm was accepted by the other side
+    (for client, after successful snd_CapabilitiesSet() which sets the
+    "compression" capability). Compressed frames received from the other
+    side are recognized and uncompressed only after this call.
+
+    Outgoing messages are sent inside Compression frames, but a frame
+    (or group of frames) smaller than `threshold` bytes is sent
+    uncompressed. If `max_combine` is greater than 1, up to that many
+    consecutive messages are combined and compressed together. Combined
+    messages are sent when the limit is reached, when they grow larger
+    than 64KB or before reading the next incoming message.
+
+    Calling it with compression_type::NONE disables compression: outgoing
+    messages are sent uncompressed and Compression frames are no longer
+    recognized.
+  */
+
+  void set_compression(compression_type::value,
+                       size_t threshold = default_compression_threshold,
+                       unsigned max_combine = 1);
+
 private:
 
   class Impl;
@@ -684,6 +1021,12 @@ public:
   Op& rcv_InitMessage(Init_processor&);
   Op& rcv_Command(Cmd_processor&);
 
+  // See Protocol::set_compression().
+
+  void set_compression(compression_type::value,
+                       size_t threshold = default_compression_threshold,
+                       unsigned max_combine = 1);
+
 private:
 
   class Impl;
@@ -698,7 +1041,9 @@ private:
   implementations. If C is a connection class then an object of class
   Protocol::Stream::Impl<C> implements methods read() and write() which
   create read or write operation, respectively, using appropriate operation
-  type C::Read_op or C::Write_op. This operation is allocated dynamically
+  type C::Read_op or C::Write_op. Method read_some() creates C::Read_some_op
+  operation which completes after reading any number of bytes, up to the
+  size of the given buffer. These operations are allocated dynamically
   and should be deleted by the caller of the method.
 */
 
@@ -714,6 +1059,7 @@ public:
   {}
 
   virtual Op* read(const buffers&) =0;
+  virtual Op* read_some(const buffers&) =0;
   virtual Op* write(const buffers&) =0;
 
 private:
@@ -734,6 +1080,7 @@ template <class C>
 class Protocol::Stream::Impl : public Stream
 {
   typedef typename C::Read_op  Rd_op;
+  typedef typename C::Read_some_op  Rd_some_op;
   typedef typename C::Write_op Wr_op;
 
   C &m_conn;
@@ -743,6 +1090,9 @@ class Protocol::Stream::Impl : public Stream
   Op* read(const buffers &buf)
   { return new Rd_op(m_conn, buf); }
 
+  Op* read_some(const buffers &buf)
+  { return new Rd_some_op(m_conn, buf); }
+
   Op* write(const buffers &buf)
   { return new Wr_op(m_conn, buf); }
 
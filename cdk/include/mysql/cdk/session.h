@@ -51,11 +51,16 @@ protected:
   const mysqlx::string *m_database;
   api::Connection      *m_connection;
   bool                  m_trans;
+  bool                  m_tls;
 
   typedef Reply::Initializer Reply_init;
 
 public:
 
+  typedef mysqlx::stmt_id_t stmt_id_t;
+  typedef mysqlx::Cmd_cache Cmd_cache;
+  typedef mysqlx::Session_stats Stats;
+
   typedef api::Session::Diagnostics Diagnostics;
 
   /// Create session to a data store represented by `ds` object.
@@ -77,6 +82,45 @@ public:
   option_t is_valid() { return m_session->is_valid(); }
   option_t check_valid() { return m_session->check_valid(); }
 
+  /*
+    Cheap check if an idle session can be used for the next command. It
+    does not contact the server: the session is considered broken if it is
+    not valid, its connection was closed or there is unread data on the
+    connection. An idle session should not receive anything, so such data
+    means that the server has sent a notice before closing the connection
+    (for example, because of a timeout).
+  */
+
+  bool check_idle()
+  {
+    if (!is_valid() || m_connection->is_closed())
+      return false;
+    return !m_connection->has_bytes();
+  }
+
+  /*
+    Reset the session to the state it had right after it was created
+    (see mysqlx::Session::reset()). Open transaction, if any, is rolled
+    back.
+  */
+
+  void reset()
+  {
+    m_trans = false;
+    m_session->reset();
+  }
+
+  /*
+    Check if session uses TLS connection. Reads and writes on such
+    connection block until completed, also when driven with cont().
+  */
+
+  bool is_tls() const { return m_tls; }
+
+  /// Check if a transaction is open in this session.
+
+  bool in_transaction() const { return m_trans; }
+
   void close() {
     if (m_trans)
       rollback();
@@ -419,6 +463,91 @@ public:
   }
 
 
+  // Prepared statements
+  // -------------------
+
+  /**
+    Prepare on the server the command created by one of the methods above,
+    before it is used to initialize a Reply instance.
+
+    Returns id of the prepared statement or 0 if the command could not be
+    prepared. In the latter case the command is executed as usual.
+  */
+
+  stmt_id_t prepare()
+  {
+    return m_session->prepare();
+  }
+
+  /**
+    Execute the pending command using statement with given id which was
+    prepared earlier for identical command.
+  */
+
+  void use_prepared(stmt_id_t id)
+  {
+    m_session->use_prepared(id);
+  }
+
+  /// Release prepared statement with given id.
+
+  void deallocate(stmt_id_t id)
+  {
+    m_session->deallocate(id);
+  }
+
+  /**
+    Execute the pending prepared command using a server-side cursor which
+    sends rows of the result in batches of the given size.
+
+    Returns false if the command can not be executed using a cursor (for
+    example, because it was not prepared).
+  */
+
+  bool use_cursor(row_count_t fetch_rows)
+  {
+    return m_session->use_cursor(fetch_rows);
+  }
+
+  /**
+    Send the pending command, if it is not prepared, using the given cache
+    of the serialized command. When the same command is sent again with
+    the same cache, only values of its parameters are serialized.
+
+    The cache must be cleared if the command changes in any other way.
+  */
+
+  void use_cmd_cache(Cmd_cache &cache)
+  {
+    m_session->use_cmd_cache(cache);
+  }
+
+  /**
+    Send the pending command without completing replies to earlier
+    commands. Replies are read in the order in which commands were sent
+    and using a reply discards all replies before it.
+
+    Returns false if the command can not be pipelined (for example, because
+    it uses a server-side cursor).
+  */
+
+  bool pipeline()
+  {
+    return m_session->pipeline();
+  }
+
+  /**
+    Store current values of session statistics: bytes, messages and rows
+    transferred, command latency histograms etc. (see mysqlx::Session_stats).
+    Can be called from any thread.
+  */
+
+  void get_stats(Stats &stats) const
+  {
+    m_session->get_stats(stats);
+  }
+
+
   // Async_op interface
 
 public:
@@ -112,6 +112,17 @@ struct Scalar_prc_converter
       break;
     case cdk::TYPE_STRING:
       {
+        // UTF-8 strings are passed to the protocol layer as they are.
+
+        cdk::Format<cdk::TYPE_STRING> fmt(fi);
+
+        if (cdk::Charset::utf8 == fmt.charset()
+            || cdk::Charset::utf8mb4 == fmt.charset())
+        {
+          m_proc->str(data);
+          break;
+        }
+
         cdk::Codec<cdk::TYPE_STRING> codec(fi);
 
         string val;
@@ -31,6 +31,7 @@
 #include "converters.h"
 
 #include <list>
+#include <string.h>  // strcmp
 
 
 namespace cdk {
@@ -44,6 +45,16 @@ namespace mysqlx {
   Delayed operations are created by session an put into a queue for later
   execution. When it is time to execute delayed operation, its start() method
   is called which should start corresponding protocol operation.
+
+  Operations which can be prepared on the server (can_prepare() returns true)
+  can also be sent as Prepare request using prepare() method. After
+  set_prepared() is called, executing the operation sends Execute request
+  for the given prepared statement, created by execute() method, instead
+  of the full command. If also set_cursor() was called, the Execute request
+  opens a server-side cursor which sends rows of the result in batches.
+
+  CRUD operations which are not prepared can be sent using Cmd_cache set
+  with set_cmd_cache() (see Protocol::snd_Find()).
 */
 
 
@@ -55,10 +66,27 @@ protected:
 
   Protocol& m_protocol;
   Proto_op* op;
+  stmt_id_t m_stmt_id;
+  cursor_id_t m_cursor_id;
+  row_count_t m_fetch_rows;
+  Cmd_cache  *m_cmd_cache;
+
+  /*
+    Set when the operation has completed. After that the protocol operation
+    pointed by `op` is not accessed any more, as protocol can delete it
+    when next message is sent.
+  */
+
+  bool m_done;
 
   Proto_delayed_op(Protocol& protocol)
     : m_protocol(protocol)
     , op(NULL)
+    , m_stmt_id(0)
+    , m_cursor_id(0)
+    , m_fetch_rows(0)
+    , m_cmd_cache(NULL)
+    , m_done(false)
   {}
 
 public:
@@ -69,40 +97,109 @@ public:
 
   bool is_completed() const
   {
-    return NULL != op && op->is_completed();
+    return m_done || (NULL != op && op->is_completed());
+  }
+
+  virtual bool can_prepare() const
+  {
+    return false;
+  }
+
+  /*
+    Send the command as a request to prepare statement with the given id
+    (which must not be 0). Parameter values, if any, are not sent at this
+    point - they are sent by Execute requests.
+  */
+
+  void prepare(stmt_id_t id)
+  {
+    assert(id && can_prepare());
+    m_protocol.set_prepare_id(id);
+    try {
+      start()->wait();
+    }
+    catch (...)
+    {
+      m_protocol.set_prepare_id(0);
+      throw;
+    }
+  }
+
+  void set_prepared(stmt_id_t id)
+  {
+    m_stmt_id = id;
+  }
+
+  bool is_prepared() const
+  {
+    return 0 != m_stmt_id;
+  }
+
+  void set_cmd_cache(Cmd_cache &cache)
+  {
+    m_cmd_cache = &cache;
+  }
+
+  void set_cursor(cursor_id_t cid, row_count_t fetch_rows)
+  {
+    assert(is_prepared());
+    m_cursor_id = cid;
+    m_fetch_rows = fetch_rows;
   }
 
 protected:
 
   virtual Proto_op* start() = 0;
 
+  virtual Proto_op* execute(stmt_id_t)
+  {
+    THROW("Delayed operation can not be prepared");
+  }
+
+  Proto_op* begin()
+  {
+    if (!m_stmt_id)
+      return start();
+    if (m_cursor_id)
+      m_protocol.set_cursor(m_cursor_id, m_fetch_rows);
+    return execute(m_stmt_id);
+  }
+
   virtual bool do_cont()
   {
+    if (m_done)
+      return true;
     if (NULL == op)
-      op = start();
-    return op->cont();
+      op = begin();
+    m_done = op->cont();
+    return m_done;
   }
 
   virtual void do_wait()
   {
+    if (m_done)
+      return;
+
     if (op == NULL)
-      op = start();
+      op = begin();
 
     if (op)
       op->wait();
     else
       THROW("Invalid delayed operation.");
+
+    m_done = true;
   }
 
   virtual void do_cancel()
   {
-    if (op)
+    if (op && !m_done)
       op->cancel();
   }
 
   virtual const api::Event_info* get_event_info() const
   {
-    if (op)
+    if (op && !m_done)
       return op->waits_for();
     return NULL;
   }
@@ -168,8 +265,23 @@ protected:
     return &m_protocol.snd_StmtExecute(m_ns, m_stmt, m_args ? &conv : NULL);
   }
 
+  Proto_op* execute(stmt_id_t id)
+  {
+    Any_list_converter conv;
+    if (m_args)
+      conv.reset(*m_args);
+    return &m_protocol.snd_PrepareExecute(id, m_args ? &conv : NULL);
+  }
+
 public:
 
+  // Note: admin commands in "xplugin" namespace are not prepared.
+
+  bool can_prepare() const
+  {
+    return 0 == strcmp("sql", m_ns);
+  }
+
   SndStmt(Protocol& protocol, const char *ns,
           const string& stmt, Any_list *args)
     : Proto_delayed_op(protocol), m_ns(ns)
@@ -412,6 +524,18 @@ protected:
     return m_limit;
   }
 
+  Proto_op* execute(stmt_id_t id)
+  {
+    return &m_protocol.snd_PrepareExecute(id, m_param_conv.get());
+  }
+
+public:
+
+  bool can_prepare() const
+  {
+    return true;
+  }
+
 };
 
 
@@ -426,7 +550,8 @@ protected:
 
   Proto_op* start()
   {
-    return &m_protocol.snd_Delete(DM, *this, m_param_conv.get());
+    return &m_protocol.snd_Delete(DM, *this, m_param_conv.get(),
+                                 m_cmd_cache);
   }
 
 public:
@@ -575,7 +700,7 @@ protected:
 
   Proto_op* start()
   {
-    return &m_protocol.snd_Find(DM, *this, m_param_conv.get());
+    return &m_protocol.snd_Find(DM, *this, m_param_conv.get(), m_cmd_cache);
   }
 
 public:
@@ -1053,7 +1178,8 @@ protected:
 
   Proto_op* start()
   {
-    return &m_protocol.snd_Update(DM, *this, m_upd_conv, m_param_conv.get());
+    return &m_protocol.snd_Update(DM, *this, m_upd_conv, m_param_conv.get(),
+                                 m_cmd_cache);
   }
 
 public:
@@ -1099,6 +1225,73 @@ public:
 };
 
 
+/*
+  Delayed operation which deallocates prepared statement with given id.
+  Server reply to this request is read by RcvCheckReply operation.
+*/
+
+class SndDeallocate
+    : public Proto_delayed_op
+{
+protected:
+
+  stmt_id_t m_id;
+
+  Proto_op* start()
+  {
+    return &m_protocol.snd_PrepareDeallocate(m_id);
+  }
+
+public:
+
+  SndDeallocate(Protocol& protocol, stmt_id_t id)
+    : Proto_delayed_op(protocol)
+    , m_id(id)
+  {}
+};
+
+
+/*
+  Reads Ok or Error reply to a request such as Prepare or Deallocate.
+  Error is not reported to the session, instead its code is stored in
+  m_code member (which is 0 if server replied with Ok).
+*/
+
+class RcvCheckReply
+    : public Proto_delayed_op
+    , public protocol::mysqlx::Reply_processor
+{
+protected:
+
+  Proto_op* start()
+  {
+    return &m_protocol.rcv_Reply(*this);
+  }
+
+public:
+
+  unsigned int m_code;
+
+  RcvCheckReply(Protocol& protocol)
+    : Proto_delayed_op(protocol)
+    , m_code(0)
+  {}
+
+  // Reply_processor
+
+  void error(unsigned int code, short int,
+             protocol::mysqlx::sql_state_t, const string &)
+  {
+    m_code = code;
+  }
+
+  void ok(string)
+  {
+    m_code = 0;
+  }
+};
+
+
 class RcvStmtReply
     : public Proto_delayed_op
 {
@@ -60,6 +60,27 @@ void Reply::init(Reply_init &init)
   m_da.clear();
   m_session = &init;
 
+  m_cursor_id = init.m_cursor_id;
+  m_fetch_rows = init.m_fetch_rows;
+
+  /*
+    Pipelined command is sent right away and this reply waits in the
+    session queue until replies to earlier commands are completed.
+  */
+
+  if (init.m_pipeline)
+  {
+    try {
+      init.send_pipelined(this);
+    }
+    catch (...)
+    {
+      m_session = NULL;
+      throw;
+    }
+    return;
+  }
+
   init.register_reply(this);
 
   m_session->send_cmd();
@@ -67,9 +88,16 @@ void Reply::init(Reply_init &init)
 }
 
 
+void Reply::activate()
+{
+  if (is_pending())
+    m_session->activate_reply(this);
+}
+
+
 void Reply::close_cursor()
 {
-  if (NULL == m_session)
+  if (NULL == m_session || is_pending())
     return;
 
   assert(this == m_session->m_current_reply);
@@ -86,6 +114,7 @@ void Reply::discard()
   if (NULL == m_session)
     return;
 
+  activate();
   assert(this == m_session->m_current_reply);
 
   if (m_session->m_current_cursor)
@@ -109,6 +138,7 @@ bool Reply::has_results()
   if (NULL == m_session)
     return false;
 
+  activate();
   assert(this == m_session->m_current_reply);
 
   // If we hit error, do not continue.
@@ -132,6 +162,7 @@ void Reply::skip_result()
   if (NULL == m_session)
     throw_error("Session not initialized");
 
+  activate();
   assert(this == m_session->m_current_reply);
 
   if (entry_count() > 0)
@@ -160,7 +191,10 @@ bool Reply::is_completed() const
   if (!m_session)
     return true;
 
-  assert(this == m_session->m_current_reply);
+  // Reading reply to pipelined command has not started yet.
+
+  if (is_pending())
+    return false;
 
   if (!m_session->m_reply_op_queue.empty())
     return false;
@@ -174,6 +208,7 @@ bool Reply::do_cont()
   if (!m_session)
     return true;
 
+  activate();
   assert(this == m_session->m_current_reply);
 
   if (m_session->m_reply_op_queue.empty())
@@ -206,6 +241,8 @@ bool Reply::do_cont()
 
 void Reply::do_wait()
 {
+  activate();
+
   while (m_session && !m_session->m_reply_op_queue.empty())
   {
     assert(this == m_session->m_current_reply);
@@ -240,6 +277,9 @@ void Reply::do_cancel()
 
 const cdk::api::Event_info* Reply::get_event_info() const
 {
+  if (!m_session || is_pending())
+    return NULL;
+
   if (!m_session->m_reply_op_queue.empty())
     return m_session->m_reply_op_queue.front()->waits_for();
 
@@ -260,6 +300,9 @@ Cursor::Cursor(Reply &reply)
   , m_rows_limit(0)
   , m_limited(false)
   , m_more_rows(false)
+  , m_cursor_id(reply.m_cursor_id)
+  , m_fetch_rows(reply.m_fetch_rows)
+  , m_suspended(false)
 {
 
   if (m_session.m_current_cursor)
@@ -311,11 +354,34 @@ void Cursor::internal_get_rows(mysqlx::Row_processor& rp)
     return;
   }
 
-  m_rows_op = m_session.start_reading_row_data(*this);
+  if (m_suspended)
+    fetch_next();
+  else
+    m_rows_op = m_session.start_reading_row_data(*this);
   m_row_prc = &rp;
 
 }
 
+
+/*
+  Next batch of rows is fetched from a suspended cursor only when there is
+  a row processor which can accept more rows.
+*/
+
+bool Cursor::fetch_pending() const
+{
+  return m_suspended && m_row_prc && (!m_limited || 0 < m_rows_limit);
+}
+
+
+void Cursor::fetch_next()
+{
+  assert(m_suspended);
+  m_suspended = false;
+  m_session.cursor_fetch(m_cursor_id, m_fetch_rows);
+  m_rows_op = m_session.start_reading_row_data(*this);
+}
+
 void Cursor::get_rows(mysqlx::Row_processor& rp)
 {
   internal_get_rows(rp);
@@ -356,6 +422,15 @@ void Cursor::close()
         m_session.m_discard = false;
       }
 
+      // Do not fetch remaining rows from a cursor - close it instead.
+
+      if (m_suspended)
+      {
+        m_suspended = false;
+        m_more_rows = false;
+        m_session.cursor_close(m_cursor_id);
+      }
+
       if (m_more_rows)
       {
         m_rows_op = m_session.start_reading_row_data(*this);
@@ -444,7 +519,7 @@ const Col_metadata& Cursor::get_metadata(col_count_t pos) const
 bool Cursor::is_completed() const
 {
   if (NULL == m_rows_op)
-    return true;
+    return !fetch_pending();
 
   return m_rows_op->is_completed();
 }
@@ -455,6 +530,9 @@ bool Cursor::do_cont()
   if (m_closed)
     throw_error("do_cont: Closed cursor");
 
+  if (!m_rows_op && fetch_pending())
+    fetch_next();
+
   if (m_rows_op)
     m_rows_op->cont();
 
@@ -470,10 +548,13 @@ void Cursor::do_wait()
   if (m_closed)
     throw_error("wait: Closed cursor");
 
-  if (m_rows_op)
+  // Rows processor can consume several batches of rows from a cursor.
+
+  while (!is_completed())
   {
+    if (!m_rows_op)
+      fetch_next();
     m_rows_op->wait();
-    assert(is_completed());
   }
 }
 
@@ -556,6 +637,18 @@ void Cursor::col_end(col_count_t pos, size_t /*data_len*/)
 
 void Cursor::done(bool eod, bool more)
 {
+  /*
+    Server sent all rows from the current batch of a cursor - the row
+    processor will get more rows after fetching the next batch.
+  */
+
+  if (!eod && !more)
+  {
+    m_suspended = true;
+    m_rows_op = NULL;
+    return;
+  }
+
   if (m_row_prc)
     m_row_prc->end_of_data();
 
@@ -28,6 +28,7 @@
 
 PUSH_SYS_WARNINGS
 #include <iostream>
+#include <algorithm>
 #include "auth_mysql41.h"
 POP_SYS_WARNINGS
 
@@ -88,6 +89,10 @@ struct Proto_field_checker : public cdk::protocol::mysqlx::api::Expectations
         // Insert(18) upsert(6)
         m_data = bytes("18.6");
         break;
+      case Protocol_fields::SESSION_RESET_KEEP_OPEN:
+        // Reset(6) keep_open(1)
+        m_data = bytes("6.1");
+        break;
       default:
         return 0;
     }
@@ -347,6 +352,81 @@ void Session::authenticate(const Session::Options &options,
 }
 
 
+/*
+  Try compression algorithms supported by this build, in order of
+  preference, until server accepts one of them. Server replies with error
+  to capabilities it does not know or does not support.
+*/
+
+void Session::negotiate_compression(const Session::Options &options)
+{
+  using cdk::ds::mysqlx::Protocol_options;
+  using cdk::protocol::mysqlx::compression_type;
+
+  auto mode = options.compression();
+
+  if (Protocol_options::COMPRESSION_DISABLED == mode)
+    return;
+
+  static const compression_type::value algorithms[] = {
+    compression_type::ZSTD,
+    compression_type::LZ4,
+    compression_type::DEFLATE
+  };
+
+  struct Caps : cdk::protocol::mysqlx::api::Any::Document
+  {
+    const char *m_algorithm;
+
+    void process(Processor &prc) const
+    {
+      prc.doc_begin();
+      auto cmp = safe_prc(prc)->key_val("compression")->doc();
+      cmp->doc_begin();
+      cmp->key_val("algorithm")->scalar()->str(m_algorithm);
+      cmp->key_val("server_combine_mixed_messages")->scalar()->yesno(true);
+      cmp->doc_end();
+      prc.doc_end();
+    }
+  }
+  caps;
+
+  struct : cdk::protocol::mysqlx::Reply_processor
+  {
+    bool m_ok;
+
+    void error(unsigned int, short int, sql_state_t, const string&)
+    {
+      m_ok = false;
+    }
+  }
+  prc;
+
+  for (compression_type::value type : algorithms)
+  {
+    if (!cdk::protocol::mysqlx::compression_supported(type))
+      continue;
+
+    caps.m_algorithm = cdk::protocol::mysqlx::compression_name(type);
+    m_protocol.snd_CapabilitiesSet(caps).wait();
+
+    prc.m_ok = true;
+    m_protocol.rcv_Reply(prc).wait();
+
+    if (prc.m_ok)
+    {
+      m_protocol.set_compression(type);
+      return;
+    }
+  }
+
+  if (Protocol_options::COMPRESSION_REQUIRED == mode)
+    throw_error(cdkerrc::compression_error,
+                "Server does not support any of the compression algorithms"
+                " requested by client");
+}
+
+
 Session::~Session()
 {
   //TODO: add timeout to close session!
@@ -397,10 +477,98 @@ option_t Session::check_valid()
 }
 
 
+void Session::get_stats(Session_stats &stats) const
+{
+  m_protocol.get_stats(stats);
+
+  stats.commands       = m_stats.commands.get();
+  stats.pipelined      = m_stats.pipelined.get();
+  stats.prepares       = m_stats.prepares.get();
+  stats.prepared_execs = m_stats.prepared_execs.get();
+  stats.cursor_fetches = m_stats.cursor_fetches.get();
+  stats.errors         = m_stats.errors.get();
+}
+
+
+void Session::reset()
+{
+  if (!is_valid())
+    throw_error("reset: invalid session");
+
+  discard_replies();
+  m_cmd.reset();
+  m_cursor_id = 0;
+
+  if (option_t::UNKNOWN == m_reset_supported.state())
+  {
+    Proto_field_checker field_checker(m_protocol);
+    m_reset_supported = 0 != field_checker.is_supported(
+      Protocol_fields::SESSION_RESET_KEEP_OPEN
+    );
+  }
+
+  if (m_reset_supported)
+  {
+    // Server releases prepared statements when session is reset.
+
+    m_stmts_to_deallocate.clear();
+    m_reply_op_queue.clear();
+
+    RcvCheckReply reply(m_protocol);
+    m_protocol.snd_SessionReset(true).wait();
+    reply.wait();
+
+    if (0 != reply.m_code)
+      throw_error("reset: server could not reset session");
+  }
+  else
+  {
+    for (stmt_id_t id = 1; id <= m_last_stmt_id; ++id)
+    {
+      if (m_free_stmt_ids.end() == std::find(
+            m_free_stmt_ids.begin(), m_free_stmt_ids.end(), id)
+          && m_stmts_to_deallocate.end() == std::find(
+            m_stmts_to_deallocate.begin(), m_stmts_to_deallocate.end(), id))
+        m_stmts_to_deallocate.push_back(id);
+    }
+
+    send_deallocate();
+
+    while (!m_reply_op_queue.empty())
+    {
+      m_reply_op_queue.front()->wait();
+      m_reply_op_queue.pop_front();
+    }
+
+    rollback();
+  }
+
+  m_last_stmt_id = 0;
+  m_free_stmt_ids.clear();
+  m_stmt_stats.clear();
+}
+
+
 void Session::close()
 {
   m_reply_op_queue.clear();
 
+  // Replies to pipelined commands will not be read any more.
+
+  for (Reply *reply : m_pending_replies)
+    reply->m_session = NULL;
+  m_pending_replies.clear();
+  m_last_cmd.reset();
+  m_pipeline = false;
+
+  // Prepared statements are released by the server when session ends.
+
+  m_cmd.reset();
+  m_last_stmt_id = 0;
+  m_free_stmt_ids.clear();
+  m_stmts_to_deallocate.clear();
+  m_cursor_id = 0;
+
   if (is_valid())
   {
     m_protocol.snd_Close().wait();
@@ -413,13 +581,9 @@ void Session::close()
 
 void Session::register_reply(Reply *reply)
 {
-  // Complete previous reply
+  // Complete previous replies, including the pipelined ones.
 
-  if (m_current_reply)
-  {
-    m_current_reply->close_cursor();
-    m_current_reply->discard();
-  }
+  discard_replies();
   m_current_reply = reply;
 }
 
@@ -613,12 +777,300 @@ Reply_init& Session::view_drop(const api::Table_ref &view, bool check_existence)
 
 
 
-Reply_init &Session::set_command(Proto_op *cmd)
+/*
+  Server error reported when it does not understand Prepare request.
+*/
+
+#define ER_UNKNOWN_COM_ERROR 1047
+
+stmt_id_t Session::prepare()
+{
+  if (!m_cmd || !m_cmd->can_prepare() || !m_prepare_supported)
+    return 0;
+
+  // Complete previous replies before sending Prepare request.
+
+  discard_replies();
+
+  stmt_id_t id;
+
+  if (m_free_stmt_ids.empty())
+    id = ++m_last_stmt_id;
+  else
+  {
+    id = m_free_stmt_ids.back();
+    m_free_stmt_ids.pop_back();
+  }
+
+  send_deallocate();
+
+  RcvCheckReply reply(m_protocol);
+
+  try {
+    while (!m_reply_op_queue.empty())
+    {
+      m_reply_op_queue.front()->wait();
+      m_reply_op_queue.pop_front();
+    }
+    m_cmd->prepare(id);
+    reply.wait();
+  }
+  catch (...)
+  {
+    m_reply_op_queue.clear();
+    m_free_stmt_ids.push_back(id);
+    throw;
+  }
+
+  if (0 != reply.m_code)
+  {
+    /*
+      If server could not prepare the statement, the command is executed
+      in the normal way and reports the error, if any.
+    */
+    m_free_stmt_ids.push_back(id);
+    if (ER_UNKNOWN_COM_ERROR == reply.m_code)
+      m_prepare_supported = false;
+    return 0;
+  }
+
+  m_cmd->set_prepared(id);
+  m_stats.prepares.add();
+  return id;
+}
+
+
+void Session::use_prepared(stmt_id_t id)
+{
+  if (m_cmd && m_cmd->can_prepare())
+    m_cmd->set_prepared(id);
+}
+
+
+void Session::use_cmd_cache(Cmd_cache &cache)
+{
+  if (m_cmd && m_cmd->can_prepare())
+    m_cmd->set_cmd_cache(cache);
+}
+
+
+void Session::deallocate(stmt_id_t id)
+{
+  if (!id || !is_valid())
+    return;
+  m_stmts_to_deallocate.push_back(id);
+}
+
+
+/*
+  Cursor id and batch size are stored in the session until the pending
+  command is executed. Then they are passed to the Reply object and from
+  there to the Cursor which reads rows of the result (see Reply::init()).
+*/
+
+bool Session::use_cursor(row_count_t fetch_rows)
+{
+  if (!fetch_rows || !m_cmd || !m_cmd->is_prepared())
+    return false;
+
+  m_cursor_id = ++m_last_cursor_id;
+  m_fetch_rows = fetch_rows;
+  m_cmd->set_cursor(m_cursor_id, m_fetch_rows);
+  return true;
+}
+
+
+void Session::cursor_fetch(cursor_id_t cid, row_count_t fetch_rows)
+{
+  m_stats.cursor_fetches.add();
+  m_protocol.snd_CursorFetch(cid, fetch_rows).wait();
+}
+
+
+/*
+  Close cursor whose result was not completely fetched. Server replies
+  to Cursor.Close request with Ok, which is read and ignored here.
+*/
+
+void Session::cursor_close(cursor_id_t cid)
+{
+  m_protocol.snd_CursorClose(cid).wait();
+  RcvCheckReply reply(m_protocol);
+  reply.wait();
+  m_executed = true;
+}
+
+
+/*
+  Pipelined commands
+  ------------------
+  A pipelined command is sent immediately and its reply is added to
+  m_pending_replies. When the current reply is completed and discarded,
+  the next one from m_pending_replies can become the current one.
+  Reading of its result is started only then.
+*/
+
+bool Session::pipeline()
+{
+  if (!m_cmd || m_cursor_id || !m_stmts_to_deallocate.empty())
+    return false;
+
+  /*
+    If current reply is read from a server-side cursor, requests to fetch
+    further rows would be sent after the pipelined command.
+  */
+
+  if (m_current_reply && m_current_reply->m_cursor_id)
+    return false;
+
+  m_pipeline = true;
+  return true;
+}
+
+
+void Session::send_pipelined(Reply *reply)
+{
+  /*
+    If there are no earlier replies, the reply becomes the current one
+    right away. Normally such command is sent only when reply operations
+    are executed, but a pipelined command is sent immediately, so that
+    the caller does not need to keep command data alive.
+  */
+
+  m_stats.pipelined.add();
+
+  if (!m_current_reply && m_pending_replies.empty())
+  {
+    m_current_reply = reply;
+    send_cmd();
+    start_reading_result();
+
+    try {
+      m_last_cmd->wait();
+    }
+    catch (...)
+    {
+      m_reply_op_queue.clear();
+      m_current_reply = NULL;
+      throw;
+    }
+    return;
+  }
+
+  /*
+    Commands must be sent in order. Command sent without pipelining is
+    sent only when operations of its reply are executed. If it was not
+    sent yet, execute these operations until it is.
+  */
+
+  try {
+    while (m_last_cmd && !m_last_cmd->is_completed()
+           && !m_reply_op_queue.empty())
+    {
+      m_reply_op_queue.front()->wait();
+      m_reply_op_queue.pop_front();
+    }
+  }
+  catch (...)
+  {
+    m_reply_op_queue.clear();
+    throw;
+  }
+
+  m_stats.commands.add();
+  if (m_cmd->is_prepared())
+    m_stats.prepared_execs.add();
+
+  m_pipeline = false;
+  m_last_cmd = m_cmd;
+  m_cmd.reset();
+  m_cursor_id = 0;
+
+  m_last_cmd->wait();
+  m_pending_replies.push_back(reply);
+}
+
+
+void Session::activate_next()
+{
+  assert(!m_current_reply && !m_pending_replies.empty());
+
+  m_current_reply = m_pending_replies.front();
+  m_pending_replies.pop_front();
+
+  m_executed = false;
+  m_stmt_stats.clear();
+  start_reading_result();
+}
+
+
+/*
+  Make given reply to a pipelined command the current one. All replies
+  before it are discarded.
+*/
+
+void Session::activate_reply(Reply *reply)
+{
+  while (reply != m_current_reply)
+  {
+    if (m_current_reply)
+    {
+      m_current_reply->close_cursor();
+      m_current_reply->discard();
+      continue;
+    }
+
+    if (m_pending_replies.empty())
+      throw_error("Reply is not registered with the session");
+
+    activate_next();
+  }
+}
+
+
+void Session::discard_replies()
+{
+  while (m_current_reply || !m_pending_replies.empty())
+  {
+    if (!m_current_reply)
+      activate_next();
+    m_current_reply->close_cursor();
+    m_current_reply->discard();
+  }
+}
+
+
+/*
+  Queue Deallocate requests for prepared statements released with
+  deallocate(). Replies to these requests are read and ignored before reading
+  the reply to the following command. Ids of deallocated statements can be
+  used again.
+*/
+
+void Session::send_deallocate()
+{
+  for (stmt_id_t id : m_stmts_to_deallocate)
+  {
+    m_reply_op_queue.push_back(
+      shared_ptr<Proto_op>(new SndDeallocate(m_protocol, id))
+    );
+    m_reply_op_queue.push_back(
+      shared_ptr<Proto_op>(new RcvCheckReply(m_protocol))
+    );
+    m_free_stmt_ids.push_back(id);
+  }
+  m_stmts_to_deallocate.clear();
+}
+
+
+Reply_init &Session::set_command(Proto_delayed_op *cmd)
 {
   if (!is_valid())
     throw_error("set_command: invalid session");
 
   m_cmd.reset(cmd);
+  m_cursor_id = 0;
+  m_pipeline = false;
 
   return *this;
 }
@@ -683,7 +1135,9 @@ void Session::error(unsigned int code, short int severity,
   case 1: level = Severity::WARNING; break;
   case 2:
   default:
-    level = Severity::ERROR; break;
+    level = Severity::ERROR;
+    m_stats.errors.add();
+    break;
   }
   add_diagnostics(level, code, sql_state, msg);
 }
@@ -879,9 +1333,17 @@ void Session::row_stats(row_stats_t stats, row_count_t val)
 
 void Session::send_cmd()
 {
+  m_stats.commands.add();
+  if (m_cmd->is_prepared())
+    m_stats.prepared_execs.add();
+
   m_executed = false;
+  send_deallocate();
   m_reply_op_queue.push_back(m_cmd);
+  m_last_cmd = m_cmd;
+  m_pipeline = false;
   m_cmd.reset();
+  m_cursor_id = 0;
   m_stmt_stats.clear();
 }
 
@@ -0,0 +1,649 @@
+/*
+ * Copyright (c) 2015, 2016, Oracle and/or its affiliates. All rights reserved.
+ *
+ * The MySQL Connector/C++ is licensed under the terms of the GPLv2
+ * <http://www.gnu.org/licenses/old-licenses/gpl-2.0.html>, like most
+ * MySQL Connectors. There are special exceptions to the terms and
+ * conditions of the GPLv2 as it is applied to this software, see the
+ * FLOSS License Exception
+ * <http://www.mysql.com/about/legal/licensing/foss-exception.html>.
+ *
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published
+ * by the Free Software Foundation; version 2 of the License.
+ *
+ * This program is distributed in the hope that it will be useful, but
+ * WITHOUT ANY WARRANTY; without even the implied warranty of MERCHANTABILITY
+ * or FITNESS FOR A PARTICULAR PURPOSE. See the GNU General Public License
+ * for more details.
+ *
+ * You should have received a copy of the GNU General Public License along
+ * with this program; if not, write to the Free Software Foundation, Inc.,
+ * 51 Franklin St, Fifth Floor, Boston, MA 02110-1301  USA
+ */
+
+
+#include "expr_cache.h"
+
+PUSH_SYS_WARNINGS
+#include <deque>
+#include <list>
+#include <unordered_map>
+#include <mutex>
+POP_SYS_WARNINGS
+
+
+using namespace parser;
+
+
+uint32_t Compiled_expr::add_node(Code code)
+{
+  Node node;
+  node.m_code = code;
+  node.m_count = 0;
+  node.m_arg = NONE;
+  node.m_num.m_uint = 0;
+  m_nodes.push_back(node);
+  return (uint32_t)(m_nodes.size() - 1);
+}
+
+
+/*
+  Recorder stores expression reported to it in the node of compiled
+  expression at position m_pos. It acts as processor for any kind of
+  expression, its scalar value and its elements. When an element of a list
+  or a document is reported, a new node is added for it and a new recorder
+  is created to store the element in that node.
+
+  Note: Compiled_expr::m_nodes can grow while expression is reported, which
+  is why recorders refer to their nodes by position, not by pointer.
+*/
+
+struct Compiled_expr::Recorder
+  : public Compiled_expr::Expr_prc
+  , public Compiled_expr::Expr_prc::Scalar_prc
+  , public cdk::Value_processor
+  , public Compiled_expr::Expr_prc::List_prc
+  , public Compiled_expr::Expr_prc::Doc_prc
+{
+  typedef Compiled_expr::Expr_prc::Scalar_prc Scalar_prc;
+  typedef Compiled_expr::Expr_prc::List_prc   List_prc;
+  typedef Compiled_expr::Expr_prc::Doc_prc    Doc_prc;
+  typedef Scalar_prc::Args_prc                Args_prc;
+  typedef Scalar_prc::Value_prc               Value_prc;
+  typedef cdk::string                         string;
+
+  Compiled_expr         &m_expr;
+  std::deque<Recorder>  &m_recorders;
+  uint32_t               m_pos;
+
+  Recorder(Compiled_expr &expr, std::deque<Recorder> &recorders,
+           uint32_t pos)
+    : m_expr(expr), m_recorders(recorders), m_pos(pos)
+  {}
+
+  Node& node()
+  {
+    return m_expr.m_nodes[m_pos];
+  }
+
+  Node& set(Code code)
+  {
+    Node &n = node();
+    n.m_code = code;
+    return n;
+  }
+
+  // Add a new element node and return recorder which stores it.
+
+  Recorder* add_element()
+  {
+    node().m_count++;
+    return add_recorder();
+  }
+
+  Recorder* add_recorder()
+  {
+    uint32_t pos = m_expr.add_node(EMPTY);
+    m_recorders.emplace_back(m_expr, m_recorders, pos);
+    return &m_recorders.back();
+  }
+
+  uint32_t add_string(const string &str)
+  {
+    m_expr.m_strings.push_back(str);
+    return (uint32_t)(m_expr.m_strings.size() - 1);
+  }
+
+  uint32_t add_bytes(const std::string &data)
+  {
+    m_expr.m_bytes.push_back(data);
+    return (uint32_t)(m_expr.m_bytes.size() - 1);
+  }
+
+  uint32_t add_path(const cdk::Doc_path &path)
+  {
+    m_expr.m_paths.push_back(cdk::Doc_path_storage());
+    path.process(m_expr.m_paths.back());
+    return (uint32_t)(m_expr.m_paths.size() - 1);
+  }
+
+  // Any processor
+
+  Scalar_prc* scalar() { return this; }
+  List_prc*   arr()    { set(ARR); return this; }
+  Doc_prc*    doc()    { set(DOC); return this; }
+
+  // List processor (array elements and arguments of a call)
+
+  void list_begin() {}
+  void list_end()   {}
+
+  Element_prc* list_el()
+  {
+    return add_element();
+  }
+
+  // Document processor
+
+  Any_prc* key_val(const string &key)
+  {
+    node().m_count++;
+    uint32_t key_pos = add_string(key);
+    m_expr.m_nodes[m_expr.add_node(KEY)].m_arg = key_pos;
+    return add_recorder();
+  }
+
+  // Scalar processor
+
+  Value_prc* val() { return this; }
+
+  Args_prc* op(const char *name)
+  {
+    set(OP).m_arg = add_bytes(name);
+    return this;
+  }
+
+  Args_prc* call(const Object_ref &func)
+  {
+    m_expr.m_funcs.push_back(Table_ref());
+    Table_ref &ref = m_expr.m_funcs.back();
+
+    if (func.schema())
+      ref.set(func.name(), func.schema()->name());
+    else
+      ref.set(func.name());
+
+    set(CALL).m_arg = (uint32_t)(m_expr.m_funcs.size() - 1);
+    return this;
+  }
+
+  void ref(const Column_ref &col, const Doc_path *path)
+  {
+    m_expr.m_refs.push_back(parser::Column_ref());
+    m_expr.m_refs.back() = col;
+
+    uint32_t path_pos = path ? add_path(*path) : NONE;
+    Node &n = set(COL_REF);
+    n.m_arg = (uint32_t)(m_expr.m_refs.size() - 1);
+    n.m_count = path_pos;
+  }
+
+  void ref(const Doc_path &path)
+  {
+    uint32_t path_pos = add_path(path);
+    set(PATH).m_arg = path_pos;
+  }
+
+  void param(const string &name)
+  {
+    uint32_t str_pos = add_string(name);
+    set(PARAM).m_arg = str_pos;
+  }
+
+  void param(uint16_t pos)
+  {
+    set(PARAM_POS).m_num.m_uint = pos;
+  }
+
+  void var(const string &name)
+  {
+    uint32_t str_pos = add_string(name);
+    set(VAR).m_arg = str_pos;
+  }
+
+  // Value processor
+
+  void null() { set(V_NULL); }
+
+  void value(cdk::Type_info type, const cdk::Format_info&, cdk::bytes data)
+  {
+    // Note: as in Stored_scalar, format information is not stored and
+    // values are reported as opaque blobs when re-played.
+
+    uint32_t data_pos = add_bytes(std::string(data.begin(), data.end()));
+    Node &n = set(V_OCTETS);
+    n.m_arg = data_pos;
+    n.m_num.m_uint = type;
+  }
+
+  void str(const string &val)
+  {
+    uint32_t str_pos = add_string(val);
+    set(V_STR).m_arg = str_pos;
+  }
+
+  void num(int64_t val)   { set(V_INT).m_num.m_int = val; }
+  void num(uint64_t val)  { set(V_UINT).m_num.m_uint = val; }
+  void num(float val)     { set(V_FLOAT).m_num.m_float = val; }
+  void num(double val)    { set(V_DOUBLE).m_num.m_double = val; }
+  void yesno(bool val)    { set(V_BOOL).m_num.m_bool = val; }
+};
+
+
+/*
+  Recorder for the top-level node of order and projection specifications.
+  The node is followed by the recorded expression.
+*/
+
+struct Compiled_expr::Top_recorder
+  : public Compiled_expr::Order_prc
+  , public Compiled_expr::Proj_prc
+  , public Compiled_expr::Doc_prc
+{
+  Compiled_expr         &m_expr;
+  std::deque<Recorder>  &m_recorders;
+
+  Top_recorder(Compiled_expr &expr, std::deque<Recorder> &recorders)
+    : m_expr(expr), m_recorders(recorders)
+  {}
+
+  Recorder* start(Code code, uint32_t arg)
+  {
+    assert(m_expr.m_nodes.empty());
+    m_expr.m_nodes[m_expr.add_node(code)].m_arg = arg;
+    m_recorders.emplace_back(m_expr, m_recorders, m_expr.add_node(EMPTY));
+    return &m_recorders.back();
+  }
+
+  // Order_expr processor
+
+  Order_prc::Expr_prc* sort_key(cdk::api::Sort_direction::value dir)
+  {
+    return start(ORDER, (uint32_t)dir);
+  }
+
+  // Projection processor
+
+  Proj_prc::Expr_prc* expr()
+  {
+    return start(ALIAS, NONE);
+  }
+
+  void alias(const cdk::string &name)
+  {
+    m_expr.m_strings.push_back(name);
+    m_expr.m_nodes.at(0).m_arg = (uint32_t)(m_expr.m_strings.size() - 1);
+  }
+
+  // Document processor
+
+  Any_prc* key_val(const cdk::string &key)
+  {
+    m_expr.m_strings.push_back(key);
+    return start(KEY, (uint32_t)(m_expr.m_strings.size() - 1));
+  }
+};
+
+
+Compiled_expr* Compiled_expr::compile(
+  Expr_kind::value kind, Parser_mode::value mode, const cdk::string &expr
+)
+{
+  cdk::scoped_ptr<Compiled_expr> compiled(new Compiled_expr(kind));
+  std::deque<Recorder> recorders;
+  Top_recorder top(*compiled, recorders);
+
+  switch (kind)
+  {
+  case Expr_kind::EXPR:
+    {
+      Expression_parser parser(mode, expr);
+      recorders.emplace_back(*compiled, recorders, compiled->add_node(EMPTY));
+      parser.process(recorders.back());
+    }
+    break;
+
+  case Expr_kind::ORDER:
+    {
+      Order_parser parser(mode, expr);
+      parser.process(top);
+    }
+    break;
+
+  case Expr_kind::PROJECTION:
+    {
+      Projection_parser parser(mode, expr);
+      parser.process(static_cast<Proj_prc&>(top));
+    }
+    break;
+
+  case Expr_kind::DOC_PROJECTION:
+    {
+      Projection_parser parser(mode, expr);
+      parser.process(static_cast<Doc_prc&>(top));
+    }
+    break;
+  }
+
+  return compiled.release();
+}
+
+
+// --------------------------------------------------------------------------
+
+/*
+  Re-playing compiled expression.
+
+  Methods replay_xxx() report expression stored at the given position to
+  the processor and return position of the node which follows it. If the
+  processor is NULL, nested nodes are skipped without reporting them.
+*/
+
+size_t Compiled_expr::replay_any(size_t pos, Expr_prc *prc) const
+{
+  const Node &node = m_nodes[pos++];
+
+  switch (node.m_code)
+  {
+  case EMPTY:
+    return pos;
+
+  case ARR:
+    {
+      Expr_prc::List_prc *lprc = prc ? prc->arr() : NULL;
+
+      if (lprc)
+        lprc->list_begin();
+      for (uint32_t i = 0; i < node.m_count; ++i)
+        pos = replay_any(pos, lprc ? lprc->list_el() : NULL);
+      if (lprc)
+        lprc->list_end();
+      return pos;
+    }
+
+  case DOC:
+    {
+      Expr_prc::Doc_prc *dprc = prc ? prc->doc() : NULL;
+
+      if (dprc)
+        dprc->doc_begin();
+      for (uint32_t i = 0; i < node.m_count; ++i)
+      {
+        const cdk::string &key = m_strings[m_nodes[pos++].m_arg];
+        pos = replay_any(pos, dprc ? dprc->key_val(key) : NULL);
+      }
+      if (dprc)
+        dprc->doc_end();
+      return pos;
+    }
+
+  default:
+    return replay_scalar(pos - 1, prc ? prc->scalar() : NULL);
+  }
+}
+
+
+size_t Compiled_expr::replay_scalar(size_t pos, Expr_prc::Scalar_prc *prc) const
+{
+  typedef Expr_prc::Scalar_prc::Args_prc  Args_prc;
+  typedef Expr_prc::Scalar_prc::Value_prc Value_prc;
+
+  const Node &node = m_nodes[pos++];
+
+  switch (node.m_code)
+  {
+  case OP:
+  case CALL:
+    {
+      Args_prc *aprc = NULL;
+
+      if (prc)
+        aprc = (OP == node.m_code ? prc->op(m_bytes[node.m_arg].c_str())
+                                  : prc->call(m_funcs[node.m_arg]));
+      if (aprc)
+        aprc->list_begin();
+      for (uint32_t i = 0; i < node.m_count; ++i)
+        pos = replay_any(pos, aprc ? aprc->list_el() : NULL);
+      if (aprc)
+        aprc->list_end();
+      return pos;
+    }
+
+  default:
+    break;
+  }
+
+  if (!prc)
+    return pos;
+
+  switch (node.m_code)
+  {
+  case COL_REF:
+    prc->ref(m_refs[node.m_arg],
+             NONE == node.m_count ? NULL : &m_paths[node.m_count]);
+    return pos;
+
+  case PATH:      prc->ref(m_paths[node.m_arg]); return pos;
+  case PARAM:     prc->param(m_strings[node.m_arg]); return pos;
+  case PARAM_POS: prc->param((uint16_t)node.m_num.m_uint); return pos;
+  case VAR:       prc->var(m_strings[node.m_arg]); return pos;
+
+  default:
+    break;
+  }
+
+  // literal values
+
+  Value_prc *vprc = prc->val();
+
+  if (!vprc)
+    return pos;
+
+  switch (node.m_code)
+  {
+  case V_NULL:   vprc->null(); break;
+  case V_STR:    vprc->str(m_strings[node.m_arg]); break;
+  case V_INT:    vprc->num(node.m_num.m_int); break;
+  case V_UINT:   vprc->num(node.m_num.m_uint); break;
+  case V_FLOAT:  vprc->num(node.m_num.m_float); break;
+  case V_DOUBLE: vprc->num(node.m_num.m_double); break;
+  case V_BOOL:   vprc->yesno(node.m_num.m_bool); break;
+
+  case V_OCTETS:
+    vprc->value((cdk::Type_info)node.m_num.m_uint, Format_info(),
+                cdk::bytes(m_bytes[node.m_arg]));
+    break;
+
+  default:
+    assert(false && "Invalid compiled expression");
+  }
+
+  return pos;
+}
+
+
+void Compiled_expr::process(Expr_prc &prc) const
+{
+  assert(Expr_kind::EXPR == m_kind);
+  replay_any(0, &prc);
+}
+
+
+void Compiled_expr::process(Order_prc &prc) const
+{
+  assert(Expr_kind::ORDER == m_kind && ORDER == m_nodes[0].m_code);
+  replay_any(1,
+    prc.sort_key((cdk::api::Sort_direction::value)m_nodes[0].m_arg));
+}
+
+
+void Compiled_expr::process(Proj_prc &prc) const
+{
+  assert(Expr_kind::PROJECTION == m_kind && ALIAS == m_nodes[0].m_code);
+  replay_any(1, prc.expr());
+  if (NONE != m_nodes[0].m_arg)
+    prc.alias(m_strings[m_nodes[0].m_arg]);
+}
+
+
+void Compiled_expr::process(Doc_prc &prc) const
+{
+  assert(Expr_kind::DOC_PROJECTION == m_kind && KEY == m_nodes[0].m_code);
+  replay_any(1, prc.key_val(m_strings[m_nodes[0].m_arg]));
+}
+
+
+// --------------------------------------------------------------------------
+
+/*
+  Implementation of the expression cache.
+
+  There is a separate map for each combination of expression kind and
+  parser mode so that lookups can use expression string directly as the
+  key. All entries are kept on a single LRU list, with most recently used
+  ones at the front. List elements point back at their map and the key of
+  the entry.
+*/
+
+namespace {
+
+class Cache
+{
+  struct Entry;
+  typedef std::unordered_map<std::wstring, Entry>  Map;
+  typedef std::list< std::pair<Map*, const std::wstring*> > Lru;
+
+  struct Entry
+  {
+    Compiled_expr_ptr m_expr;
+    Lru::iterator     m_pos;
+  };
+
+  std::mutex  m_mutex;
+  Map         m_maps[Expr_kind::DOC_PROJECTION + 1][Parser_mode::TABLE + 1];
+  Lru         m_lru;
+  size_t      m_capacity;
+
+  Cache() : m_capacity(Expr_cache::default_capacity)
+  {}
+
+  void trim()
+  {
+    while (m_lru.size() > m_capacity)
+    {
+      Map *map = m_lru.back().first;
+      Map::iterator it = map->find(*m_lru.back().second);
+      m_lru.pop_back();
+      map->erase(it);
+    }
+  }
+
+public:
+
+  static Cache& instance()
+  {
+    static Cache cache;
+    return cache;
+  }
+
+  Compiled_expr_ptr get(Expr_kind::value kind, Parser_mode::value mode,
+                        const cdk::string &expr)
+  {
+    Map &map = m_maps[kind][mode];
+
+    {
+      std::lock_guard<std::mutex> guard(m_mutex);
+      Map::iterator it = map.find(expr);
+      if (it != map.end())
+      {
+        m_lru.splice(m_lru.begin(), m_lru, it->second.m_pos);
+        return it->second.m_expr;
+      }
+    }
+
+    // Note: Parsing is done without holding the lock.
+
+    Compiled_expr_ptr compiled(Compiled_expr::compile(kind, mode, expr));
+
+    std::lock_guard<std::mutex> guard(m_mutex);
+
+    if (0 == m_capacity)
+      return compiled;
+
+    std::pair<Map::iterator, bool> res = map.emplace(expr, Entry());
+    Entry &entry = res.first->second;
+
+    // If other thread has stored the same expression meanwhile, use it.
+
+    if (!res.second)
+    {
+      m_lru.splice(m_lru.begin(), m_lru, entry.m_pos);
+      return entry.m_expr;
+    }
+
+    entry.m_expr = compiled;
+    m_lru.push_front(std::make_pair(&map, &res.first->first));
+    entry.m_pos = m_lru.begin();
+    trim();
+
+    return compiled;
+  }
+
+  void set_capacity(size_t capacity)
+  {
+    std::lock_guard<std::mutex> guard(m_mutex);
+    m_capacity = capacity;
+    trim();
+  }
+
+  size_t size()
+  {
+    std::lock_guard<std::mutex> guard(m_mutex);
+    return m_lru.size();
+  }
+
+  void clear()
+  {
+    std::lock_guard<std::mutex> guard(m_mutex);
+    m_lru.clear();
+    for (auto &maps : m_maps)
+      for (Map &map : maps)
+        map.clear();
+  }
+};
+
+}
+
+
+Compiled_expr_ptr Expr_cache::get(
+  Expr_kind::value kind, Parser_mode::value mode, const cdk::string &expr
+)
+{
+  return Cache::instance().get(kind, mode, expr);
+}
+
+void Expr_cache::set_capacity(size_t capacity)
+{
+  Cache::instance().set_capacity(capacity);
+}
+
+size_t Expr_cache::size()
+{
+  return Cache::instance().size();
+}
+
+void Expr_cache::clear()
+{
+  Cache::instance().clear();
+}
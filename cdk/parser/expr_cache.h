@@ -0,0 +1,229 @@
+/*
+ * Copyright (c) 2015, 2016, Oracle and/or its affiliates. All rights reserved.
+ *
+ * The MySQL Connector/C++ is licensed under the terms of the GPLv2
+ * <http://www.gnu.org/licenses/old-licenses/gpl-2.0.html>, like most
+ * MySQL Connectors. There are special exceptions to the terms and
+ * conditions of the GPLv2 as it is applied to this software, see the
+ * FLOSS License Exception
+ * <http://www.mysql.com/about/legal/licensing/foss-exception.html>.
+ *
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published
+ * by the Free Software Foundation; version 2 of the License.
+ *
+ * This program is distributed in the hope that it will be useful, but
+ * WITHOUT ANY WARRANTY; without even the implied warranty of MERCHANTABILITY
+ * or FITNESS FOR A PARTICULAR PURPOSE. See the GNU General Public License
+ * for more details.
+ *
+ * You should have received a copy of the GNU General Public License along
+ * with this program; if not, write to the Free Software Foundation, Inc.,
+ * 51 Franklin St, Fifth Floor, Boston, MA 02110-1301  USA
+ */
+
+#ifndef _EXPR_CACHE_H_
+#define _EXPR_CACHE_H_
+
+#include "expr_parser.h"
+
+PUSH_SYS_WARNINGS
+#include <memory>
+POP_SYS_WARNINGS
+
+
+namespace parser {
+
+/*
+  Compiled expressions
+  ====================
+
+  A Compiled_expr is the result of parsing expression string once. It stores
+  everything that the parser reported to its processor in a flat form and
+  can re-play it to any number of processors, from any number of threads,
+  without tokenizing or parsing the string again.
+
+  The stored form is a vector of nodes in the order in which they were
+  reported by the parser. Composite nodes (arrays, documents, operator and
+  function calls) store the number of their elements which follow them.
+  Strings, column references and document paths are kept in separate pools
+  and nodes refer to them by index. Re-playing an expression does not
+  allocate memory.
+
+  Expression strings can be compiled in one of the following forms:
+
+  EXPR           - plain expression (as parsed by Expression_parser),
+  ORDER          - "<expr> [ASC|DESC]" specification (as parsed by
+                   Order_parser),
+  PROJECTION     - "<expr> [AS <alias>]" specification reported to
+                   a projection processor (as with Projection_parser),
+  DOC_PROJECTION - "<expr> AS <alias>" specification reported as a key
+                   of a document (as with Projection_parser).
+*/
+
+struct Expr_kind
+{
+  enum value { EXPR, ORDER, PROJECTION, DOC_PROJECTION };
+};
+
+
+class Compiled_expr
+  : public Expression
+  , public cdk::api::Order_expr<Expression>
+  , public cdk::api::Projection_expr<Expression>
+  , public Expression::Document
+{
+public:
+
+  typedef Expression::Processor                               Expr_prc;
+  typedef cdk::api::Order_expr<Expression>::Processor         Order_prc;
+  typedef cdk::api::Projection_expr<Expression>::Processor    Proj_prc;
+  typedef Expression::Document::Processor                     Doc_prc;
+
+  /*
+    Parse given string and return its compiled form. Throws parser errors
+    if the string is not valid.
+  */
+
+  static Compiled_expr* compile(Expr_kind::value, Parser_mode::value,
+                                const cdk::string&);
+
+  Expr_kind::value kind() const { return m_kind; }
+
+  void process(Expr_prc&) const;
+  void process(Order_prc&) const;
+  void process(Proj_prc&) const;
+  void process(Doc_prc&) const;
+
+private:
+
+  enum Code {
+    EMPTY, ARR, DOC, KEY,
+    OP, CALL, COL_REF, PATH, PARAM, PARAM_POS, VAR,
+    V_NULL, V_OCTETS, V_STR, V_INT, V_UINT, V_FLOAT, V_DOUBLE, V_BOOL,
+    ORDER, ALIAS
+  };
+
+  static const uint32_t NONE = (uint32_t)-1;
+
+  struct Node
+  {
+    Code      m_code;
+
+    /*
+      For composite nodes m_count is the number of elements that follow.
+      Member m_arg is the index of the stored item (string, column
+      reference, document path etc.) used by the node, if any. Column
+      reference nodes store index of the document path in m_count.
+    */
+
+    uint32_t  m_count;
+    uint32_t  m_arg;
+
+    union {
+      int64_t   m_int;
+      uint64_t  m_uint;
+      float     m_float;
+      double    m_double;
+      bool      m_bool;
+    }
+    m_num;
+  };
+
+  Expr_kind::value  m_kind;
+
+  std::vector<Node>              m_nodes;
+  std::vector<cdk::string>       m_strings;
+  std::vector<std::string>       m_bytes;
+  std::vector<Column_ref>        m_refs;
+  std::vector<Table_ref>         m_funcs;
+  std::vector<cdk::Doc_path_storage>  m_paths;
+
+  Compiled_expr(Expr_kind::value kind) : m_kind(kind)
+  {}
+
+  uint32_t add_node(Code);
+
+  size_t replay_any(size_t, Expr_prc*) const;
+  size_t replay_scalar(size_t, Expr_prc::Scalar_prc*) const;
+
+  struct Recorder;
+  struct Top_recorder;
+};
+
+
+typedef std::shared_ptr<const Compiled_expr> Compiled_expr_ptr;
+
+
+/*
+  Process-wide cache of compiled expressions, shared by all sessions and
+  threads. Expressions are keyed by their kind, parser mode and text. When
+  the cache is full, the least recently used expression is removed from it.
+
+  Strings that fail to parse are not stored in the cache. Setting capacity
+  to 0 disables caching (each get() compiles the string again).
+*/
+
+struct Expr_cache
+{
+  static const size_t default_capacity = 1024;
+
+  static Compiled_expr_ptr get(Expr_kind::value, Parser_mode::value,
+                               const cdk::string&);
+
+  static void   set_capacity(size_t);
+  static size_t size();
+  static void   clear();
+};
+
+
+/*
+  Expression object which takes compiled expression from Expr_cache.
+
+  This can be used in place of Expression_parser, Order_parser or
+  Projection_parser. The form in which the string is compiled depends on
+  the processor type. The string is parsed (or compiled expression looked
+  up in the cache) only when the expression is processed so that, as with
+  the parsers, errors are reported at that time.
+*/
+
+class Cached_expr
+  : public Expression
+  , public cdk::api::Order_expr<Expression>
+  , public cdk::api::Projection_expr<Expression>
+  , public Expression::Document
+{
+  Parser_mode::value m_mode;
+  cdk::string        m_expr;
+
+  mutable Compiled_expr_ptr m_compiled;
+
+  const Compiled_expr& get(Expr_kind::value kind) const
+  {
+    if (!m_compiled || kind != m_compiled->kind())
+      m_compiled = Expr_cache::get(kind, m_mode, m_expr);
+    return *m_compiled;
+  }
+
+public:
+
+  Cached_expr(Parser_mode::value mode, const cdk::string &expr)
+    : m_mode(mode), m_expr(expr)
+  {}
+
+  void process(Compiled_expr::Expr_prc &prc) const
+  { get(Expr_kind::EXPR).process(prc); }
+
+  void process(Compiled_expr::Order_prc &prc) const
+  { get(Expr_kind::ORDER).process(prc); }
+
+  void process(Compiled_expr::Proj_prc &prc) const
+  { get(Expr_kind::PROJECTION).process(prc); }
+
+  void process(Compiled_expr::Doc_prc &prc) const
+  { get(Expr_kind::DOC_PROJECTION).process(prc); }
+};
+
+}  // parser
+
+#endif
@@ -44,14 +44,13 @@ using cdk::safe_prc;
 
 
 /*
-  Set up keyword and operator maps.
+  Set up operator tables.
 */
 
-Keyword::map_t  Keyword::kw_map;
-Keyword         Keyword::init;
-
-Op::tok_map_t   Op::unary_tok_map, Op::binary_tok_map;
-Op::kw_map_t    Op::unary_kw_map, Op::binary_kw_map;
+Op::Type        Op::unary_tok_map[Op::tok_count];
+Op::Type        Op::binary_tok_map[Op::tok_count];
+Op::Type        Op::unary_kw_map[Keyword::count];
+Op::Type        Op::binary_kw_map[Keyword::count];
 Op              Op::init;
 
 
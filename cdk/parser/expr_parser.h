@@ -31,7 +31,6 @@
 PUSH_SYS_WARNINGS
 #include <vector>
 #include <map>
-#include <locale>
 #include <algorithm>  // for_each()
 POP_SYS_WARNINGS
 
@@ -227,60 +226,64 @@ public:
 
   /*
     Case insensitive string comparison function which is used to match
-    keywords.
+    keywords. Only ASCII letters are folded, which is sufficient because
+    keywords consist of ASCII characters only.
   */
 
   static bool equal(const string &a, const string &b)
   {
-    static kw_cmp  cmp;
+    if (a.length() != b.length())
+      return false;
+
+    for (size_t pos = 0; pos < a.length(); ++pos)
+      if (fold(a[pos]) != fold(b[pos]))
+        return false;
 
-    return (!cmp(a, b) && !cmp(b, a));
+    return true;
   }
 
-private:
+  // Number of enum constants, including NONE.
 
-  struct kw_cmp
-  {
-    struct char_cmp
-    {
-      bool operator()(cdk::char_t, cdk::char_t) const;
-    };
+#define kw_count(A,B)  +1
 
-    bool operator()(const string &a, const string &b) const
-    {
-      static char_cmp cmp;
-      return std::lexicographical_compare(
-        a.begin(), a.end(),
-        b.begin(), b.end(), cmp
-      );
-    }
-  };
+  static const unsigned count = 1 KEYWORD_LIST(kw_count);
 
-  /*
-    Map which maps words to keyword ids. Case insensitive comparison is
-    used to locate words in this map.
-  */
-
-  typedef std::map<string, Type, kw_cmp> map_t;
-
-  static map_t kw_map;
+private:
 
   /*
-    Default ctor builds the keyword map based on keyword declarartions given
-    by KEYWORD_LIST() macro.
+    Keywords are recognized using a perfect hash of their (case folded)
+    characters. Values of the hash, modulo hash_size, are distinct for all
+    the keywords declared by KEYWORD_LIST(). This is checked by the compiler
+    which would report duplicate case values in the switch statement of
+    Keyword::get(). Compilers translate this switch into a jump table so
+    that a word is checked against at most one keyword.
+
+    If adding a new keyword leads to a collision, hash_seed must be changed
+    so that the hash is perfect again.
   */
 
-  Keyword()
-  {
-
-#define kw_add(A,B)  kw_map[B] = A;
+  static const uint32_t hash_seed  = 2166136263U;
+  static const uint32_t hash_prime = 16777619U;
+  static const uint32_t hash_size  = 256;
 
-    KEYWORD_LIST(kw_add);
+  static constexpr uint32_t fold(uint32_t c)
+  {
+    return ('A' <= c && c <= 'Z') ? c + ('a' - 'A') : c;
   }
 
-  // This initializer instance makes sure that the keyowrd map is built.
+  static constexpr uint32_t hash(const char *kw, uint32_t h = hash_seed)
+  {
+    return *kw ? hash(kw + 1, (h ^ fold((uint32_t)*kw)) * hash_prime) : h;
+  }
 
-  static Keyword init;
+  static bool match(const string &word, const char *kw)
+  {
+    size_t pos = 0;
+    for (; pos < word.length() && kw[pos]; ++pos)
+      if (fold(word[pos]) != (uint32_t)kw[pos])
+        return false;
+    return pos == word.length() && !kw[pos];
+  }
 };
 
 
@@ -292,36 +295,32 @@ Keyword::Type Keyword::get(const Token &t)
   if (Token::WORD != t.get_type())
     return NONE;
 
-  // Locate WORD in the keyword map.
+  const string &word = t.get_text();
+  uint32_t h = hash_seed;
 
-  auto x = kw_map.find(t.get_text());
+  for (cdk::char_t c : word)
+  {
+    // Keywords contain only ASCII characters.
 
-  return (x == kw_map.end() ? NONE : x->second);
-}
+    if ((uint32_t)c > 0x7F)
+      return NONE;
+    h = (h ^ fold((uint32_t)c)) * hash_prime;
+  }
 
+#define kw_case(A,B)  case hash(B) % hash_size: return match(word, B) ? A : NONE;
 
-inline
-bool operator==(Keyword::Type type, const Token &tok)
-{
-  return type == Keyword::get(tok);
+  switch (h % hash_size)
+  {
+    KEYWORD_LIST(kw_case)
+  default: return NONE;
+  }
 }
 
 
 inline
-bool Keyword::kw_cmp::char_cmp::operator()(cdk::char_t a, cdk::char_t b) const
+bool operator==(Keyword::Type type, const Token &tok)
 {
-  /*
-    Since we operate on wide characters, "C" locale's ctype facet is used
-    to make lowercase conversion. "C" locale is sufficent because we care about
-    correct results only for ASCII characters (only these characters are used
-    in keywords).
-  */
-
-  static std::locale c_loc("C");
-  static const std::ctype<wchar_t> &ctf
-    = std::use_facet<std::ctype<wchar_t>>(c_loc);
-
-  return ctf.tolower(a) < ctf.tolower(b);
+  return type == Keyword::get(tok);
 }
 
 
@@ -386,23 +385,25 @@ public:
 private:
 
   /*
-    Maps used to recognize operators.
+    Tables used to recognize operators.
 
     Operator can be a keyword or other token. For each kind of operator (unary
-    or binary) we have two maps. One map maps keyword ids to operators. The
-    other map maps other token types to operators. These maps are filled based
-    on the information given by UNARY/BINARY_OP() macros that declare
-    operators.
+    or binary) we have two tables. One table maps keyword ids to operators.
+    The other table maps other token types to operators. Tables are indexed
+    by token type or keyword id and are filled based on the information given
+    by UNARY/BINARY_OP() macros that declare operators. Entries for tokens
+    which are not operators are NONE.
   */
 
-  typedef std::map<Token::Type, Type>   tok_map_t;
-  typedef std::map<Keyword::Type, Type> kw_map_t;
+#define op_tok_count(T,X)  +1
+
+  static const unsigned tok_count = 0 TOKEN_LIST(op_tok_count);
 
-  static tok_map_t  unary_tok_map;
-  static kw_map_t   unary_kw_map;
+  static Type unary_tok_map[tok_count];
+  static Type unary_kw_map[Keyword::count];
 
-  static tok_map_t  binary_tok_map;
-  static kw_map_t   binary_kw_map;
+  static Type binary_tok_map[tok_count];
+  static Type binary_kw_map[Keyword::count];
 
   Op()
   {
@@ -427,33 +428,25 @@ private:
 inline
 Op::Type Op::get_unary(const Token &tok)
 {
-  // First check the token map.
+  // First check the token table.
 
-  auto find = unary_tok_map.find(tok.get_type());
-  if (find != unary_tok_map.end())
-    return find->second;
+  Type op = unary_tok_map[tok.get_type()];
+  if (NONE != op)
+    return op;
 
-  // If operator not found, try keyword map.
+  // If operator not found, try keyword table.
 
-  Keyword::Type kw = Keyword::get(tok);
-  if (Keyword::NONE == kw)
-    return NONE;
-  auto find1 = unary_kw_map.find(kw);
-  return find1 == unary_kw_map.end() ? NONE : find1->second;
+  return unary_kw_map[Keyword::get(tok)];
 }
 
 
 inline
 Op::Type Op::get_binary(const Token &tok)
 {
-  auto find = binary_tok_map.find(tok.get_type());
-  if (find != binary_tok_map.end())
-    return find->second;
-  Keyword::Type kw = Keyword::get(tok);
-  if (Keyword::NONE == kw)
-    return NONE;
-  auto find1 = binary_kw_map.find(kw);
-  return find1 == binary_kw_map.end() ? NONE : find1->second;
+  Type op = binary_tok_map[tok.get_type()];
+  if (NONE != op)
+    return op;
+  return binary_kw_map[Keyword::get(tok)];
 }
 
 
@@ -27,6 +27,17 @@
 
 PUSH_SYS_WARNINGS
 #include <stdlib.h>
+
+/*
+  On platforms with SSE2 instructions strings are scanned in blocks
+  of 16 bytes (see Sax_parser::parse_string()).
+*/
+
+#if defined(__SSE2__) || defined(_M_X64) \
+    || (defined(_M_IX86_FP) && _M_IX86_FP >= 2)
+#define JSON_USE_SSE2
+#include <emmintrin.h>
+#endif
 POP_SYS_WARNINGS
 
 
@@ -41,6 +52,7 @@ POP_SYS_WARNINGS
 using namespace parser;
 using cdk::string;
 using cdk::JSON;
+using cdk::byte;
 typedef  cdk::JSON::Processor Processor;
 
 
@@ -51,136 +63,759 @@ void json_parse(const string &json, Processor &dp)
 }
 
 
+namespace {
+
+typedef Processor                   Doc_prc;
+typedef Doc_prc::Any_prc            Any_prc;
+typedef Any_prc::List_prc           List_prc;
+typedef Any_prc::Scalar_prc         Scalar_prc;
 
-//  Clasify a token as a JSON token.
 
-JSON_token_base::Token_type JSON_token_base::get_jtype(const Token &tok)
+/*
+  Implementation of JSON_utf8_parser.
+
+  This is a recursive descent parser which reads input bytes between
+  m_pos and m_end. Processors passed to parse_xxx() methods can be NULL,
+  in which case the value is parsed but not reported.
+*/
+
+class Sax_parser
 {
-  switch (tok.get_type())
-  {
-  case Token::PLUS:
-    return JSON_token_base::PLUS;
-  case Token::MINUS:
-    return JSON_token_base::MINUS;
-  case Token::NUMBER:
-    return JSON_token_base::NUMBER;
-  case Token::INTEGER:
-    return JSON_token_base::INTEGER;
+  const byte *m_beg;
+  const byte *m_pos;
+  const byte *m_end;
 
-  // TODO: According to JSON specs only double-quote strings are allowed?
-  case Token::QQSTRING:
-  case Token::QSTRING:
-    return JSON_token_base::STRING;
+  // Buffer for decoded keys and string values.
 
-  case Token::WORD:
+  string m_str;
+
+  // Key of the field reported by scan_doc().
+
+  string m_key;
+
+public:
+
+  Sax_parser(bytes json)
+    : m_beg(json.begin()), m_pos(json.begin()), m_end(json.end())
+  {}
+
+  void parse_doc(Doc_prc *prc);
+  void parse_any(Any_prc *prc);
+  void scan_doc(JSON_utf8_parser::Field_processor &prc);
+  void finish();
+
+private:
+
+  void parse_arr(List_prc *prc);
+  void parse_scalar(Scalar_prc *prc);
+  bool parse_key();
+  void parse_string();
+  void skip_string();
+  void parse_escape();
+  void parse_utf8();
+  void parse_number(Scalar_prc *prc);
+  size_t parse_word();
+
+  void put_char(uint32_t c)
+  {
+    // Code points outside BMP are stored as surrogate pairs in 16-bit strings
+
+    if (sizeof(wchar_t) < 4 && c > 0xFFFF)
     {
-      // TODO: Are these JSON literals case sensitivie?
-      const string &id = tok.get_text();
-      if (id == L"null") return JSON_token_base::T_NULL;
-      if (id == L"true") return JSON_token_base::T_TRUE;
-      if (id == L"false") return JSON_token_base::T_FALSE;
+      c -= 0x10000;
+      m_str.push_back((wchar_t)(0xD800 + (c >> 10)));
+      m_str.push_back((wchar_t)(0xDC00 + (c & 0x3FF)));
+      return;
     }
+    m_str.push_back((wchar_t)c);
+  }
 
-  default:
-    return JSON_token_base::OTHER;
+  static bool is_space(byte c)
+  {
+    return ' ' == c || '\n' == c || '\r' == c || '\t' == c;
+  }
+
+  static bool is_digit(byte c)
+  {
+    return '0' <= c && c <= '9';
+  }
+
+  static bool is_word(byte c)
+  {
+    return is_digit(c) || '_' == c
+           || ('a' <= c && c <= 'z') || ('A' <= c && c <= 'Z');
+  }
+
+  void skip_ws()
+  {
+    while (m_pos < m_end && is_space(*m_pos))
+      ++m_pos;
+  }
+
+  bool at(char c) const
+  {
+    return m_pos < m_end && (byte)c == *m_pos;
+  }
+
+  bool consume(char c)
+  {
+    skip_ws();
+    if (!at(c))
+      return false;
+    ++m_pos;
+    return true;
+  }
+
+  /*
+    Note: Error description shows fragments of the input which are cut at
+    byte positions and thus can contain incomplete (or invalid) UTF-8
+    sequences. To avoid conversion errors, non-ASCII bytes are replaced
+    by '?' in the copy of the input stored in the error.
+  */
+
+  void parse_error(const string &msg) const
+  {
+    std::string ctx(m_beg, m_end);
+
+    for (char &c : ctx)
+      if (0 != (c & 0x80))
+        c = '?';
+
+    throw JSON_utf8_parser::Error(ctx, (size_t)(m_pos - m_beg), msg);
   }
+};
+
+
+void Sax_parser::parse_doc(Doc_prc *prc)
+{
+  if (!consume('{'))
+    parse_error(L"Expected JSON document");
+
+  if (prc)
+    prc->doc_begin();
+
+  if (!consume('}'))
+  {
+    do {
+
+      if (!parse_key())
+        parse_error(L"Expected a key-value pair in a document");
+
+      if (!consume(':'))
+        parse_error(L"Expected ':' after key name in a document");
+
+      parse_any(prc ? prc->key_val(m_str) : NULL);
+
+    } while (consume(','));
+
+    if (!consume('}'))
+      parse_error(L"Expected '}' closing a document");
+  }
+
+  if (prc)
+    prc->doc_end();
 }
 
 
+/*
+  Scan document fields reporting positions of their values. The values
+  are parsed only to find where they end.
+*/
 
-bool JSON_scalar_parser::do_parse(Processor *vp)
+void Sax_parser::scan_doc(JSON_utf8_parser::Field_processor &prc)
 {
-  if (!tokens_available())
-    return false;
+  if (!consume('{'))
+    parse_error(L"Expected JSON document");
 
-  bool neg = false;
+  if (consume('}'))
+    return;
+
+  do {
+
+    if (!parse_key())
+      parse_error(L"Expected a key-value pair in a document");
+
+    // Note: m_str is overwritten when parsing a sub-document value.
 
-  Token tok = *consume_token();
-  Token_type tt = get_jtype(tok);
+    m_key.swap(m_str);
+
+    if (!consume(':'))
+      parse_error(L"Expected ':' after key name in a document");
+
+    skip_ws();
+    const byte *val = m_pos;
+    parse_any(NULL);
+
+    prc.field(m_key, (size_t)(val - m_beg), (size_t)(m_pos - val));
+
+  } while (consume(','));
+
+  if (!consume('}'))
+    parse_error(L"Expected '}' closing a document");
+}
+
+
+void Sax_parser::parse_arr(List_prc *prc)
+{
+  if (!consume('['))
+    parse_error(L"Expected JSON array");
 
-  switch (tt)
+  if (prc)
+    prc->list_begin();
+
+  if (!consume(']'))
   {
-  case STRING:
-    if(vp)
-      vp->str(tok.get_text());
-    return true;
+    do {
+      parse_any(prc ? prc->list_el() : NULL);
+    } while (consume(','));
 
-  case MINUS:
-  case PLUS:
-    neg = (MINUS == tt);
-    if (!tokens_available())
-      parse_error(L"Expected number after +/- sign");
-    tok = *consume_token();
-    tt = get_jtype(tok);
-    break;
+    if (!consume(']'))
+      parse_error(L"Expected ']' to close array");
+  }
 
-  case T_NULL:
-    if (vp)
-      vp->null();
-    return true;
+  if (prc)
+    prc->list_end();
+}
 
-  case T_TRUE:
-  case T_FALSE:
-    if (vp)
-      vp->yesno(T_TRUE == tt);
-    return true;
 
-  default:
-    // if none of the above, then it should be a number
-    break;
+void Sax_parser::parse_any(Any_prc *prc)
+{
+  skip_ws();
+
+  if (at('{'))
+    return parse_doc(prc ? prc->doc() : NULL);
+
+  if (at('['))
+    return parse_arr(prc ? prc->arr() : NULL);
+
+  parse_scalar(prc ? prc->scalar() : NULL);
+}
+
+
+/*
+  After parsing a value, only white-space and trailing 0x00 bytes can
+  remain in the input.
+*/
+
+void Sax_parser::finish()
+{
+  while (m_pos < m_end && (is_space(*m_pos) || 0 == *m_pos))
+    ++m_pos;
+
+  if (m_pos < m_end)
+    parse_error(L"Unexpected characters after parsing JSON string");
+}
+
+
+void Sax_parser::parse_scalar(Scalar_prc *prc)
+{
+  if (m_pos >= m_end)
+    parse_error(L"Expected JSON value");
+
+  byte c = *m_pos;
+
+  if ('"' == c || '\'' == c)
+  {
+    if (!prc)
+      return skip_string();
+    parse_string();
+    prc->str(m_str);
+    return;
+  }
+
+  if (is_digit(c) || '-' == c || '+' == c || '.' == c)
+    return parse_number(prc);
+
+  // Otherwise it must be one of the literals.
+
+  const byte *word = m_pos;
+  size_t len = parse_word();
+
+  if (4 == len && 0 == memcmp(word, "null", 4))
+  {
+    if (prc)
+      prc->null();
+    return;
   }
 
-  // Numeric value
+  if (4 == len && 0 == memcmp(word, "true", 4))
+  {
+    if (prc)
+      prc->yesno(true);
+    return;
+  }
 
-  switch (tt)
+  if (5 == len && 0 == memcmp(word, "false", 5))
   {
-  case NUMBER:
+    if (prc)
+      prc->yesno(false);
+    return;
+  }
+
+  m_pos = word;
+  parse_error(L"Invalid JSON value");
+}
+
+
+size_t Sax_parser::parse_word()
+{
+  const byte *start = m_pos;
+  while (m_pos < m_end && is_word(*m_pos))
+    ++m_pos;
+  return (size_t)(m_pos - start);
+}
+
+
+/*
+  Parse document key into m_str. Returns false if there is no key at
+  the current position.
+
+  Note: official JSON specs do not allow plain word as key name.
+*/
+
+bool Sax_parser::parse_key()
+{
+  skip_ws();
+
+  if (at('"') || at('\''))
+  {
+    parse_string();
+    return true;
+  }
+
+  const byte *word = m_pos;
+  size_t len = parse_word();
+
+  if (0 == len)
+    return false;
+
+  m_str.assign(word, word + len);
+  return true;
+}
+
+
+/*
+  Parse quoted string into m_str. Runs of plain ASCII characters are
+  copied to m_str in one go. Escape sequences and multi-byte UTF-8
+  characters are decoded one by one.
+*/
+
+void Sax_parser::parse_string()
+{
+  const byte quote = *(m_pos++);
+
+  m_str.clear();
+
+  for (;;)
+  {
+#ifdef JSON_USE_SSE2
+
+    const __m128i v_quote = _mm_set1_epi8((char)quote);
+    const __m128i v_bslash = _mm_set1_epi8('\\');
+
+    while (m_end - m_pos >= 16)
     {
-      if(vp)
+      __m128i blk = _mm_loadu_si128((const __m128i*)m_pos);
+
+      /*
+        Note: bytes of multi-byte UTF-8 characters have the highest
+        bit set, which is detected by _mm_movemask_epi8().
+      */
+
+      __m128i special = _mm_or_si128(
+        _mm_or_si128(
+          _mm_cmpeq_epi8(blk, v_quote),
+          _mm_cmpeq_epi8(blk, v_bslash)
+        ),
+        blk
+      );
+
+      if (0 != _mm_movemask_epi8(special))
+        break;
+
+      m_str.append(m_pos, m_pos + 16);
+      m_pos += 16;
+    }
+
+#endif
+
+    const byte *run = m_pos;
+
+    while (run < m_end && *run < 0x80 && quote != *run && '\\' != *run)
+      ++run;
+
+    m_str.append(m_pos, run);
+    m_pos = run;
+
+    if (m_pos >= m_end)
+      parse_error(L"Unterminated quoted string");
+
+    if (quote == *m_pos)
+    {
+      ++m_pos;
+
+      // If quote char is repeated, then it does not terminate string.
+
+      if (m_pos < m_end && quote == *m_pos)
       {
-        double val = strtod(tok.get_text());
-        vp->num(neg ? -val : val);
+        m_str.push_back(quote);
+        ++m_pos;
+        continue;
       }
-      return true;
+
+      return;
     }
 
-  case INTEGER:
-    try {
+    if ('\\' == *m_pos)
+      parse_escape();
+    else
+      parse_utf8();
+  }
+}
 
-      if(vp)
-      {
-        // TODO: Is this logic right? Should we report only negative values
-        // as signed integers?
 
-        uint64_t val = strtoui(tok.get_text());
-        if (val > INTEGER_ABS_MAX)
-        {
-          if (neg)
-            parse_error(L"Numeric value is too large for a signed type");
-          // Unsigned type is only returned for large values
-          vp->num(val);
-        }
+/*
+  Move past quoted string without decoding it. The string contents is
+  not validated in this case.
+*/
+
+void Sax_parser::skip_string()
+{
+  const byte quote = *(m_pos++);
+
+  for (;;)
+  {
+    const byte *end = (const byte*)memchr(m_pos, quote, m_end - m_pos);
+
+    if (!end)
+    {
+      m_pos = m_end;
+      parse_error(L"Unterminated quoted string");
+    }
+
+    // Check if the quote is escaped by an odd number of backslashes.
+
+    const byte *bs = end;
+    while (bs > m_pos && '\\' == bs[-1])
+      --bs;
+
+    m_pos = end + 1;
+
+    if (0 != (end - bs) % 2)
+      continue;
+
+    // Repeated quote char does not terminate string.
+
+    if (m_pos < m_end && quote == *m_pos)
+    {
+      ++m_pos;
+      continue;
+    }
+
+    return;
+  }
+}
+
+
+void Sax_parser::parse_escape()
+{
+  ++m_pos;
+
+  if (m_pos >= m_end)
+    parse_error(L"Unterminated quoted string");
+
+  switch (*m_pos)
+  {
+  case 'b': put_char('\b'); break;
+  case 'f': put_char('\f'); break;
+  case 'n': put_char('\n'); break;
+  case 'r': put_char('\r'); break;
+  case 't': put_char('\t'); break;
+
+  case 'u':
+    {
+      uint32_t c = 0;
+
+      for (unsigned i = 0; i < 4; ++i)
+      {
+        if (++m_pos >= m_end)
+          parse_error(L"Invalid \\u escape sequence");
+
+        byte h = *m_pos;
+        c <<= 4;
+
+        if (is_digit(h))
+          c |= (uint32_t)(h - '0');
+        else if ('a' <= h && h <= 'f')
+          c |= (uint32_t)(h - 'a' + 10);
+        else if ('A' <= h && h <= 'F')
+          c |= (uint32_t)(h - 'A' + 10);
         else
+          parse_error(L"Invalid \\u escape sequence");
+      }
+
+      /*
+        Characters outside BMP are encoded as a pair of surrogates, each
+        in its own \u escape sequence.
+      */
+
+      if (0xD800 <= c && c < 0xDC00
+          && m_end - m_pos > 6 && '\\' == m_pos[1] && 'u' == m_pos[2])
+      {
+        const byte *save = m_pos;
+        ++m_pos;
+        uint32_t hi = c;
+        parse_escape();
+
+        wchar_t lo = m_str.back();
+
+        if (0xDC00 <= (uint32_t)lo && (uint32_t)lo < 0xE000)
         {
-          // Absolute values of 9223372036854775808UL can only be negative
-          if (!neg && val == INTEGER_ABS_MAX)
-            parse_error(L"Numeric value is too large for a signed type");
-          // All values ABS(val) < 9223372036854775808UL are treated as signed
-          vp->num(neg ? -(int64_t)val : (int64_t)val);
+          m_str.pop_back();
+          put_char(0x10000 + ((hi - 0xD800) << 10) + ((uint32_t)lo - 0xDC00));
+          return;
         }
+
+        m_str.pop_back();
+        m_pos = save;
+      }
+
+      put_char(c);
+      break;
+    }
+
+  default:
+
+    // Other escaped characters (such as quotes) are taken literally.
+
+    if (*m_pos >= 0x80)
+      return parse_utf8();
+
+    put_char(*m_pos);
+  }
+
+  ++m_pos;
+}
+
+
+void Sax_parser::parse_utf8()
+{
+  byte c = *m_pos;
+  uint32_t cp;
+  unsigned len;
+
+  if (c < 0x80)
+  {
+    put_char(c);
+    ++m_pos;
+    return;
+  }
+  else if (0xC2 <= c && c < 0xE0)
+  {
+    len = 2;
+    cp = c & 0x1F;
+  }
+  else if (0xE0 <= c && c < 0xF0)
+  {
+    len = 3;
+    cp = c & 0x0F;
+  }
+  else if (0xF0 <= c && c < 0xF5)
+  {
+    len = 4;
+    cp = c & 0x07;
+  }
+  else
+    parse_error(L"Invalid UTF-8 string");
+
+  if (m_end - m_pos < (ptrdiff_t)len)
+    parse_error(L"Invalid UTF-8 string");
+
+  for (unsigned i = 1; i < len; ++i)
+  {
+    byte b = m_pos[i];
+    if (0x80 != (b & 0xC0))
+      parse_error(L"Invalid UTF-8 string");
+    cp = (cp << 6) | (b & 0x3F);
+  }
+
+  // Reject overlong encodings, surrogates and too large code points.
+
+  if ((3 == len && cp < 0x800)
+      || (4 == len && (cp < 0x10000 || cp > 0x10FFFF))
+      || (0xD800 <= cp && cp < 0xE000))
+    parse_error(L"Invalid UTF-8 string");
+
+  m_pos += len;
+  put_char(cp);
+}
+
+
+/*
+  Parse a number. Integer values are reported as signed integers unless
+  they are too big for int64_t. Floating point values are computed exactly
+  from the decimal mantissa and exponent if these are small enough (then
+  only one multiplication or division is needed). Otherwise the conversion
+  is done by the generic locale independent strtod().
+*/
+
+void Sax_parser::parse_number(Scalar_prc *prc)
+{
+  static const double pow10[] = {
+    1e0,  1e1,  1e2,  1e3,  1e4,  1e5,  1e6,  1e7,  1e8,  1e9,  1e10, 1e11,
+    1e12, 1e13, 1e14, 1e15, 1e16, 1e17, 1e18, 1e19, 1e20, 1e21, 1e22
+  };
+
+  bool neg = false;
+
+  if (at('-') || at('+'))
+  {
+    neg = at('-');
+    ++m_pos;
+    if (m_pos >= m_end || !(is_digit(*m_pos) || '.' == *m_pos))
+      parse_error(L"Expected number after +/- sign");
+  }
+
+  const byte *start = m_pos;
+  uint64_t mant = 0;
+  bool     overflow = false;
+  int      exp = 0;
+  bool     is_float = false;
+
+  for (; m_pos < m_end && is_digit(*m_pos); ++m_pos)
+  {
+    unsigned d = *m_pos - '0';
+    if (mant > (UINT64_MAX - d) / 10)
+    {
+      overflow = true;
+      exp++;
+      continue;
+    }
+    mant = 10*mant + d;
+  }
+
+  if (at('.'))
+  {
+    is_float = true;
+    ++m_pos;
+
+    if (m_pos >= m_end || !is_digit(*m_pos))
+      parse_error(L"No digits after decimal point");
+
+    for (; m_pos < m_end && is_digit(*m_pos); ++m_pos)
+    {
+      unsigned d = *m_pos - '0';
+      if (mant > (UINT64_MAX - d) / 10)
+      {
+        overflow = true;
+        continue;
       }
+      mant = 10*mant + d;
+      exp--;
+    }
+  }
+
+  if (at('e') || at('E'))
+  {
+    is_float = true;
+    ++m_pos;
+
+    bool exp_neg = at('-');
+    if (at('-') || at('+'))
+      ++m_pos;
 
-      return true;
+    if (m_pos >= m_end || !is_digit(*m_pos))
+      parse_error(L"No digits in the exponent");
+
+    int e = 0;
+    for (; m_pos < m_end && is_digit(*m_pos); ++m_pos)
+      if (e < 100000)
+        e = 10*e + (*m_pos - '0');
+
+    exp += exp_neg ? -e : e;
+  }
+
+  if (!is_float)
+  {
+    if (overflow)
+      parse_error(L"Numeric value is too large");
+
+    if (!prc)
+      return;
+
+    if (mant > INTEGER_ABS_MAX)
+    {
+      if (neg)
+        parse_error(L"Numeric value is too large for a signed type");
+      // Unsigned type is only returned for large values
+      prc->num(mant);
+    }
+    else
+    {
+      // Absolute values of 9223372036854775808UL can only be negative
+      if (!neg && mant == INTEGER_ABS_MAX)
+        parse_error(L"Numeric value is too large for a signed type");
+      // All values ABS(val) < 9223372036854775808UL are treated as signed
+      prc->num(neg ? -(int64_t)mant : (int64_t)mant);
+    }
+    return;
+  }
+
+  if (!prc)
+    return;
+
+  double val;
+
+  if (!overflow && mant < (1ULL << 53) && -22 <= exp && exp <= 22)
+  {
+    val = (double)mant;
+    val = exp < 0 ? val / pow10[-exp] : val * pow10[exp];
+  }
+  else
+  {
+    try {
+      val = strtod(std::string(start, m_pos));
     }
     catch (const Numeric_conversion_error &e)
     {
       parse_error(e.msg());
     }
-
-  default:
-    parse_error(L"Invalid JSON value");
-    return false; // quiet compile warnings
   }
+
+  prc->num(neg ? -val : val);
+}
+
+}  // anonymous namespace
+
+
+void JSON_utf8_parser::process(Processor &prc) const
+{
+  if (0 == m_json.size())
+    throw Error(std::string(), 0, L"Expecting JSON document string");
+
+  Sax_parser parser(m_json);
+  parser.parse_doc(&prc);
+  parser.finish();
 }
 
 
+void JSON_utf8_parser::process_any(Any_prc &prc) const
+{
+  if (0 == m_json.size())
+    throw Error(std::string(), 0, L"Expecting JSON value");
+
+  Sax_parser parser(m_json);
+  parser.parse_any(&prc);
+  parser.finish();
+}
+
+
+void JSON_utf8_parser::scan_fields(Field_processor &prc) const
+{
+  if (0 == m_json.size())
+    throw Error(std::string(), 0, L"Expecting JSON document string");
+
+  Sax_parser parser(m_json);
+  parser.scan_doc(prc);
+  parser.finish();
+}
@@ -31,91 +31,98 @@
 namespace parser {
 
 using cdk::JSON;
-class JSON_parser;
+using cdk::bytes;
+
 
 /*
-  Specialization of Token_base, which can clasify base tokens as JSON tokens.
+  Single pass JSON parser which works directly on UTF-8 encoded input.
+
+  The parser does not build any intermediate representation of the input.
+  Instead, it drives JSON processor callbacks while scanning the input bytes.
+  Only string values and keys are decoded into a cdk::string buffer which is
+  re-used for all strings in the document. The input bytes are not copied
+  and must exist while the parser is used.
+
+  Apart from standard JSON, the parser accepts strings in single quotes,
+  keys which are plain words, numbers with leading '+' sign or '.'
+  and trailing 0x00 bytes after the document (which are appended to JSON
+  values sent by the server).
 */
 
-class JSON_token_base
-  : public Token_base
+class JSON_utf8_parser
+  : public JSON
 {
-protected:
-
-  using Token_base::Error;
+  bytes m_json;
 
 public:
 
-  enum Token_type {
-    OTHER,
-    STRING, NUMBER, INTEGER,
-    PLUS, MINUS, T_NULL, T_TRUE, T_FALSE,
-  };
+  class Error;
 
-  static Token_type get_jtype(const Token&);
+  typedef JSON::Processor::Any_prc  Any_prc;
 
-  friend JSON_parser;
-};
+  JSON_utf8_parser(bytes json)
+    : m_json(json)
+  {}
 
+  // Parse JSON document and report it to the given processor.
 
+  void process(Processor &prc) const;
 
-/*
-  JSON_parser is build using generic Doc_parser<> template and base
-  JSON_sclar_parser which parses scalar values (numbers, strings, Booleans).
-  Parsing of arrays and sub-documents is handled by Doc_parser<> logic.
-*/
+  // Parse any JSON value: a document, an array or a scalar.
+
+  void process_any(Any_prc &prc) const;
 
+  class Field_processor;
 
-class JSON_scalar_parser
-  : public Expr_parser<cdk::JSON_processor, JSON_token_base>
+  /*
+    Scan top-level fields of JSON document without decoding their values.
+    For each field the processor is given its key and the position and
+    length of the value's JSON text within the input.
+  */
+
+  void scan_fields(Field_processor &prc) const;
+};
+
+
+class JSON_utf8_parser::Field_processor
 {
 public:
 
-  JSON_scalar_parser(It &first, const It &last)
-    : Expr_parser<cdk::JSON_processor, JSON_token_base>(first, last)
-  {}
+  virtual void field(const cdk::string &key, size_t pos, size_t len) =0;
+};
 
-  static Processor *get_base_prc(JSON::Processor::Any_prc *prc)
-  { return prc->scalar(); }
 
-private:
+class JSON_utf8_parser::Error
+  : public parser::Error_base<std::string>
+{
+public:
 
-  bool do_parse(Processor*);
+  Error(const std::string &json, size_t pos,
+        const cdk::string &descr = cdk::string())
+    : Error_base<std::string>(json, pos, descr)
+  {}
 };
 
 
+/*
+  JSON parser for a document given as cdk string. The string is converted
+  to UTF-8 and parsed with JSON_utf8_parser.
+*/
 
 class JSON_parser
   : public JSON
 {
-  Tokenizer m_toks;
+  std::string m_json;
 
 public:
 
   JSON_parser(const cdk::string &json)
-    : m_toks(json)
+    : m_json(json)
   {}
 
   void process(Processor &prc) const
   {
-    It first = m_toks.begin();
-    It last  = m_toks.end();
-
-    if (m_toks.empty())
-      throw JSON_token_base::Error(first, L"Expectiong JSON document string");
-
-    /*
-      Note: passing m_toks.end() directly as constructor argument results
-      in "incompatible iterators" exception when comparing iterators (at
-      least on win, VS2010). Problem with passing temporary object?
-    */
-
-    Doc_parser<JSON_scalar_parser> parser(first, last);
-    if (!parser.parse(prc) || first != last)
-      throw JSON_token_base::Error(
-              first,
-              L"Unexpected characters after parsing JSON string"
-            );
+    JSON_utf8_parser(m_json).process(prc);
   }
 
 };
@@ -26,8 +26,10 @@
 #include "../json_parser.h"
 #include "../expr_parser.h"
 #include "../uri_parser.h"
+#include "../expr_cache.h"
 
 #include <cstdarg>  // va_arg()
+#include <chrono>
 
 /*
   TODO:
@@ -313,6 +315,246 @@ TEST(Parser, json)
 }
 
 
+/*
+  Processor which collects all scalar values of a JSON document (in
+  document order) as strings. It is used to check results of parsing
+  UTF-8 encoded documents.
+*/
+
+struct JSON_collector
+  : public JSON::Processor
+  , public JSON::Processor::Any_prc
+  , public JSON::Processor::Any_prc::List_prc
+  , public JSON::Processor::Any_prc::Scalar_prc
+{
+  std::vector<cdk::string> m_vals;
+  size_t m_docs = 0;
+  size_t m_arrs = 0;
+
+  // Scalar processor
+
+  void null() { m_vals.push_back(L"null"); }
+  void str(const cdk::string &val) { m_vals.push_back(val); }
+  void num(uint64_t val) { m_vals.push_back(std::to_wstring(val)); }
+  void num(int64_t val) { m_vals.push_back(std::to_wstring(val)); }
+  void num(float val) { m_vals.push_back(std::to_wstring(val)); }
+  void num(double val) { m_vals.push_back(std::to_wstring(val)); }
+  void yesno(bool val) { m_vals.push_back(val ? L"true" : L"false"); }
+
+  // Any processor
+
+  Scalar_prc* scalar() { return this; }
+  Doc_prc* doc() { return this; }
+  List_prc* arr() { return this; }
+
+  // List processor
+
+  void list_begin() { m_arrs++; }
+  void list_end() {}
+  Any_prc* list_el() { return this; }
+
+  // Document processor
+
+  void doc_begin() { m_docs++; }
+  void doc_end() {}
+  Any_prc* key_val(const cdk::string &key)
+  {
+    m_vals.push_back(key);
+    return this;
+  }
+};
+
+
+TEST(Parser, json_utf8)
+{
+  // Strings with escape sequences and non-ASCII characters.
+
+  {
+    const char *json =
+      "{\"esc\": \"a\\\"b\\\\c\\/d\\n\\t\","
+      " \"uni\": \"\\u0041\\u00e9\\u20AC\","
+      " \"pair\": \"\\ud83d\\ude00\","
+      " \"utf8\": \"z\xC3\xA9\xE2\x82\xAC\xF0\x9F\x98\x80\","
+      " \"long\": \"0123456789abcdef0123456789abcdef-\xC3\xA9-0123456789abcdef\","
+      " 'q': 'it''s'}\0\0";
+
+    JSON_collector col;
+    JSON_utf8_parser parser(cdk::bytes((cdk::byte*)json, strlen(json) + 2));
+    parser.process(col);
+
+    cdk::string emoji;
+    emoji.set_utf8("\xF0\x9F\x98\x80");
+
+    ASSERT_EQ(12U, col.m_vals.size());
+    EXPECT_EQ(cdk::string(L"a\"b\\c/d\n\t"), col.m_vals[1]);
+    EXPECT_EQ(cdk::string(L"A\u00e9\u20ac"), col.m_vals[3]);
+    EXPECT_EQ(emoji, col.m_vals[5]);
+    EXPECT_EQ(cdk::string(L"z\u00e9\u20ac") + emoji, col.m_vals[7]);
+    EXPECT_EQ(
+      cdk::string(L"0123456789abcdef0123456789abcdef-\u00e9-0123456789abcdef"),
+      col.m_vals[9]
+    );
+    EXPECT_EQ(cdk::string(L"it's"), col.m_vals[11]);
+  }
+
+  // Numbers and literals
+
+  {
+    const char *json =
+      "[1, -2, 18446744073709551615, 0.5, 1e3, -1.25E-2, true, false, null,"
+      " [], {}]";
+
+    JSON_collector col;
+    cdk::bytes data(json);
+    JSON_utf8_parser parser(data);
+    parser.process_any(col);
+
+    ASSERT_EQ(9U, col.m_vals.size());
+    EXPECT_EQ(cdk::string(L"1"), col.m_vals[0]);
+    EXPECT_EQ(cdk::string(L"-2"), col.m_vals[1]);
+    EXPECT_EQ(cdk::string(L"18446744073709551615"), col.m_vals[2]);
+    EXPECT_EQ(std::to_wstring(0.5), col.m_vals[3]);
+    EXPECT_EQ(std::to_wstring(1000.0), col.m_vals[4]);
+    EXPECT_EQ(std::to_wstring(-0.0125), col.m_vals[5]);
+    EXPECT_EQ(cdk::string(L"null"), col.m_vals[8]);
+    EXPECT_EQ(2U, col.m_arrs);
+    EXPECT_EQ(1U, col.m_docs);
+  }
+
+  // negative tests
+
+  const char *invalid[] =
+  {
+    "{\"a\": \"unterminated}",
+    "{\"a\": \"\xC3\x28\"}",
+    "{\"a\": \"\xC0\xAF\"}",
+    "{\"a\": 5.}",
+    "{\"a\": 1e}",
+    "{\"a\": [1, 2}",
+    "{\"a\": 1 \"b\": 2}",
+    "{\"a\": 99999999999999999999}",
+    "{\"a\": -9223372036854775809}",
+    "{\"a\": nul}",
+    "{\"a\": 1} x",
+  };
+
+  for (const char *json : invalid)
+  {
+    JSON_collector col;
+    cdk::bytes data(json);
+    JSON_utf8_parser parser(data);
+    EXPECT_ERROR(parser.process(col));
+  }
+}
+
+
+/*
+  Benchmark of JSON parsing. Parses a set of representative documents
+  several times and reports the throughput. For comparison, it also reports
+  time needed to convert the same documents to wide strings and tokenize
+  them, which was the first step done by the previous token based parser.
+*/
+
+TEST(Parser, json_perf)
+{
+  std::vector<std::string> docs;
+
+  // Small flat document with short keys and values.
+
+  docs.push_back(
+    "{\"_id\": \"00005a640a530000000000000001\", \"name\": \"foo\","
+    " \"age\": 42, \"active\": true, \"score\": 12.5, \"tag\": null}"
+  );
+
+  // Nested document with arrays.
+
+  docs.push_back(
+    "{\"_id\": \"00005a640a530000000000000002\","
+    " \"address\": {\"street\": \"Main Street 1\", \"city\": \"Springfield\","
+    " \"zip\": \"12345\", \"geo\": [52.2297, 21.0122]},"
+    " \"orders\": [{\"id\": 1, \"items\": [1, 2, 3], \"total\": 99.95},"
+    " {\"id\": 2, \"items\": [4, 5], \"total\": 15.5}]}"
+  );
+
+  // Document with long text values (mostly ASCII, some UTF-8).
+
+  {
+    std::string text;
+    for (unsigned i = 0; i < 20; ++i)
+      text += "Lorem ipsum dolor sit amet, consectetur adipiscing elit. ";
+    text += "Za\xC5\xBC\xC3\xB3\xC5\x82\xC4\x87 g\xC4\x99\xC5\x9Bl\xC4\x85 ja\xC5\xBA\xC5\x84";
+
+    docs.push_back(
+      "{\"title\": \"" + text + "\", \"body\": \"" + text + text + "\"}"
+    );
+  }
+
+  // Document with a large array of numbers.
+
+  {
+    std::string arr;
+    for (unsigned i = 0; i < 500; ++i)
+    {
+      if (i > 0)
+        arr += ", ";
+      arr += std::to_string(i * 7919) + ", " + std::to_string(i) + ".25";
+    }
+    docs.push_back("{\"values\": [" + arr + "]}");
+  }
+
+  const unsigned rounds = 200;
+  size_t total_bytes = 0;
+  size_t total_vals = 0;
+
+  for (const std::string &doc : docs)
+    total_bytes += doc.length();
+  total_bytes *= rounds;
+
+  typedef std::chrono::steady_clock clock;
+
+  auto start = clock::now();
+
+  for (unsigned i = 0; i < rounds; ++i)
+    for (const std::string &doc : docs)
+    {
+      JSON_collector col;
+      cdk::bytes data(doc);
+      JSON_utf8_parser parser(data);
+      parser.process(col);
+      total_vals += col.m_vals.size();
+    }
+
+  auto parse_time = clock::now() - start;
+
+  start = clock::now();
+  size_t total_toks = 0;
+
+  for (unsigned i = 0; i < rounds; ++i)
+    for (const std::string &doc : docs)
+    {
+      cdk::string wdoc(doc);
+      Tokenizer toks(wdoc);
+      total_toks += toks.empty() ? 0 : 1;
+    }
+
+  auto tok_time = clock::now() - start;
+
+  EXPECT_EQ(docs.size()*rounds, total_toks);
+  EXPECT_LT(0U, total_vals);
+
+  using std::chrono::microseconds;
+  using std::chrono::duration_cast;
+
+  auto parse_us = duration_cast<microseconds>(parse_time).count() + 1;
+  auto tok_us = duration_cast<microseconds>(tok_time).count() + 1;
+
+  cout << "Parsed " << total_bytes << " bytes of JSON in "
+       << parse_us << "us (" << total_bytes / parse_us << " MB/s)" << endl;
+  cout << "Tokenizing the same input took " << tok_us << "us ("
+       << total_bytes / tok_us << " MB/s)" << endl;
+}
+
+
 
 class Expr_printer
   : public cdk::Expression::Processor
@@ -1050,6 +1292,304 @@ TEST(Parser, projection_expr)
 }
 
 
+/*
+  Compiled expressions should report exactly the same as the parsers
+  from which they were compiled.
+*/
+
+const Expr_Test compiled_exprs[] =
+{
+  { parser::Parser_mode::DOCUMENT, L"[1, 'a', {\"x\": :p, \"y\": [true, null]}]"},
+  { parser::Parser_mode::DOCUMENT, L"$.a.b[2] not in ('x', 'y') and :p > 1"},
+  { parser::Parser_mode::DOCUMENT, L"cast(a as signed) = sch.func(b, 'x', [c, d])"},
+  { parser::Parser_mode::TABLE,    L"`tbl`.`col`->$.a[*] like :p or x is not null"},
+  { parser::Parser_mode::TABLE,    L"concat(a, -.5e-2) between 1 and 2 and !false"},
+};
+
+
+TEST(Parser, compiled_expr)
+{
+  std::vector<Expr_Test> tests(exprs, exprs + sizeof(exprs)/sizeof(Expr_Test));
+  tests.insert(tests.end(), compiled_exprs,
+               compiled_exprs + sizeof(compiled_exprs)/sizeof(Expr_Test));
+
+  for (const Expr_Test &test : tests)
+  {
+    cdk::string expr(test.txt);
+
+    std::ostringstream parsed, replayed;
+    Expr_printer parsed_printer(parsed, 0);
+    Expr_printer replayed_printer(replayed, 0);
+
+    Expression_parser(test.mode, expr).process(parsed_printer);
+
+    cdk::scoped_ptr<Compiled_expr> compiled(
+      Compiled_expr::compile(Expr_kind::EXPR, test.mode, expr)
+    );
+    compiled->process(replayed_printer);
+    EXPECT_EQ(parsed.str(), replayed.str());
+
+    // Compiled expression can be re-played many times.
+
+    std::ostringstream replayed1;
+    Expr_printer replayed1_printer(replayed1, 0);
+    Cached_expr(test.mode, expr).process(replayed1_printer);
+    EXPECT_EQ(parsed.str(), replayed1.str());
+  }
+
+  for (unsigned i=0; i < sizeof(order_exprs)/sizeof(Expr_Test); i++)
+  {
+    const Expr_Test &test = order_exprs[i];
+    cdk::string expr(test.txt);
+
+    std::ostringstream parsed, replayed;
+    Order_printer parsed_printer(parsed, 0);
+    Order_printer replayed_printer(replayed, 0);
+
+    Order_parser(test.mode, expr).process(parsed_printer);
+    Cached_expr(test.mode, expr).process(
+      static_cast<Compiled_expr::Order_prc&>(replayed_printer)
+    );
+    EXPECT_EQ(parsed.str(), replayed.str());
+  }
+
+  for (unsigned i=0; i < sizeof(proj_exprs)/sizeof(Expr_Test); i++)
+  {
+    const Expr_Test &test = proj_exprs[i];
+    cdk::string expr(test.txt);
+
+    std::ostringstream parsed, replayed;
+
+    if (test.mode == parser::Parser_mode::DOCUMENT)
+    {
+      Proj_Document_printer parsed_printer(parsed, 0);
+      Proj_Document_printer replayed_printer(replayed, 0);
+
+      Projection_parser(test.mode, expr).process(
+        static_cast<Compiled_expr::Doc_prc&>(parsed_printer)
+      );
+      Cached_expr(test.mode, expr).process(
+        static_cast<Compiled_expr::Doc_prc&>(replayed_printer)
+      );
+    }
+    else
+    {
+      Proj_Table_printer parsed_printer(parsed, 0);
+      Proj_Table_printer replayed_printer(replayed, 0);
+
+      Projection_parser(test.mode, expr).process(
+        static_cast<Compiled_expr::Proj_prc&>(parsed_printer)
+      );
+      Cached_expr(test.mode, expr).process(
+        static_cast<Compiled_expr::Proj_prc&>(replayed_printer)
+      );
+    }
+
+    EXPECT_EQ(parsed.str(), replayed.str());
+  }
+
+  // Invalid expressions are reported when processed and are not cached.
+
+  Expr_cache::clear();
+
+  {
+    Expr_printer printer(cout, 0);
+    Cached_expr expr(parser::Parser_mode::DOCUMENT, L"1 +");
+    EXPECT_ERROR(expr.process(printer));
+    EXPECT_EQ(0U, Expr_cache::size());
+  }
+}
+
+
+TEST(Parser, expr_cache)
+{
+  Expr_cache::clear();
+
+  Compiled_expr_ptr e1
+    = Expr_cache::get(Expr_kind::EXPR, parser::Parser_mode::DOCUMENT, L"a > 1");
+  Compiled_expr_ptr e2
+    = Expr_cache::get(Expr_kind::EXPR, parser::Parser_mode::DOCUMENT, L"a > 1");
+  Compiled_expr_ptr e3
+    = Expr_cache::get(Expr_kind::EXPR, parser::Parser_mode::TABLE, L"a > 1");
+
+  // The same expression is compiled only once, parser mode is part of the key.
+
+  EXPECT_EQ(e1.get(), e2.get());
+  EXPECT_NE(e1.get(), e3.get());
+  EXPECT_EQ(2U, Expr_cache::size());
+
+  // When capacity is exceeded, least recently used entries are removed.
+
+  Expr_cache::set_capacity(2);
+
+  Expr_cache::get(Expr_kind::EXPR, parser::Parser_mode::DOCUMENT, L"a > 1");
+  Expr_cache::get(Expr_kind::EXPR, parser::Parser_mode::DOCUMENT, L"b > 1");
+  EXPECT_EQ(2U, Expr_cache::size());
+
+  EXPECT_EQ(e1.get(),
+    Expr_cache::get(Expr_kind::EXPR, parser::Parser_mode::DOCUMENT, L"a > 1")
+    .get());
+  EXPECT_NE(e3.get(),
+    Expr_cache::get(Expr_kind::EXPR, parser::Parser_mode::TABLE, L"a > 1")
+    .get());
+
+  // Entries removed from the cache are still valid.
+
+  std::ostringstream out;
+  Expr_printer printer(out, 0);
+  e3->process(printer);
+  EXPECT_FALSE(out.str().empty());
+
+  Expr_cache::set_capacity(Expr_cache::default_capacity);
+  Expr_cache::clear();
+}
+
+
+/*
+  Keywords are recognized case insensitively, words which only start with
+  a keyword or contain non-ASCII characters are not keywords.
+*/
+
+TEST(Parser, keywords)
+{
+  using parser::Keyword;
+  using parser::Op;
+
+  auto word = [](const cdk::string &txt) {
+    return Token(Token::WORD, txt, 0, txt.length());
+  };
+
+#define kw_check(A,B) \
+  { \
+    cdk::string kw(B); \
+    EXPECT_EQ(Keyword::A, Keyword::get(word(kw))) << kw; \
+    std::transform(kw.begin(), kw.end(), kw.begin(), ::towupper); \
+    EXPECT_EQ(Keyword::A, Keyword::get(word(kw))) << kw; \
+    EXPECT_EQ(Keyword::NONE, Keyword::get(word(kw + L"x"))) << kw; \
+  }
+
+  KEYWORD_LIST(kw_check)
+
+  EXPECT_EQ(Keyword::LIKE, Keyword::get(word(L"LiKe")));
+  EXPECT_EQ(Keyword::NONE, Keyword::get(word(L"")));
+  EXPECT_EQ(Keyword::NONE, Keyword::get(word(L"foo")));
+  EXPECT_EQ(Keyword::NONE, Keyword::get(word(L"n\x00F3t")));
+  EXPECT_EQ(Keyword::NONE, Keyword::get(Token(Token::QWORD, L"not", 0, 3)));
+
+  EXPECT_TRUE(Keyword::equal(L"Position", L"pOSITION"));
+  EXPECT_FALSE(Keyword::equal(L"trim", L"trims"));
+  EXPECT_FALSE(Keyword::equal(L"\x00C4", L"\x00E4"));
+
+  // Operators are recognized by token type or keyword.
+
+  Token plus(Token::PLUS, L"+", 0, 1);
+  EXPECT_EQ(Op::PLUS, Op::get_unary(plus));
+  EXPECT_EQ(Op::ADD, Op::get_binary(plus));
+  EXPECT_EQ(Op::NE, Op::get_binary(Token(Token::DF, L"<>", 0, 2)));
+  EXPECT_EQ(Op::NOT, Op::get_unary(word(L"NOT")));
+  EXPECT_EQ(Op::NONE, Op::get_binary(word(L"not")));
+  EXPECT_EQ(Op::AND, Op::get_binary(word(L"And")));
+  EXPECT_EQ(Op::NONE, Op::get_binary(word(L"xor")));
+  EXPECT_EQ(Op::NONE, Op::get_binary(word(L"foo")));
+  EXPECT_EQ(Op::NONE, Op::get_unary(Token(Token::COMMA, L",", 0, 1)));
+}
+
+
+/*
+  Benchmark of expression parsing. Parses a set of typical CRUD
+  expressions several times and reports the number of expressions parsed
+  per second. For comparison, it also reports time needed to only tokenize
+  the same expressions.
+
+  Parsed expressions are reported to Expr_counter which only counts
+  the nodes, so that the time is spent mostly in the parser.
+*/
+
+struct Expr_counter
+  : public cdk::Expression::Processor
+  , public cdk::Expr_processor
+  , public cdk::Expr_list::Processor
+{
+  size_t m_nodes = 0;
+
+  Scalar_prc* scalar() { m_nodes++; return this; }
+  List_prc*   arr()    { m_nodes++; return this; }
+  Doc_prc*    doc()    { m_nodes++; return NULL; }
+
+  Value_prc* val() { return NULL; }
+  Args_prc* op(const char*) { return this; }
+  Args_prc* call(const Object_ref&) { return this; }
+
+  void list_begin() {}
+  void list_end() {}
+  Element_prc* list_el() { return this; }
+
+  void ref(const Column_ref&, const Doc_path*) {}
+  void ref(const Doc_path&) {}
+  void param(const cdk::string&) {}
+  void param(uint16_t) {}
+  void var(const cdk::string&) {}
+};
+
+
+TEST(Parser, expr_perf)
+{
+  const Expr_Test perf_exprs[] =
+  {
+    { parser::Parser_mode::DOCUMENT, L"name LIKE :name AND age BETWEEN :lo AND :hi"},
+    { parser::Parser_mode::DOCUMENT, L"$.address.city IN ('Oslo', 'Bergen') OR active IS NOT NULL"},
+    { parser::Parser_mode::DOCUMENT, L"CAST(score AS DECIMAL) > 10 and tags[0] not like 'x%'"},
+    { parser::Parser_mode::DOCUMENT, L"created < now() or Flag = TRUE and x MOD 2 = 1 and y Between 1 And 9"},
+    { parser::Parser_mode::TABLE,    L"`id` = :id and (price * qty) % 7 != 0 or name regexp '^a'"},
+    { parser::Parser_mode::TABLE,    L"doc->'$.a.b' is null or Count_total >= 100 and not deleted"},
+  };
+
+  const unsigned rounds = 2000;
+  const size_t count = sizeof(perf_exprs)/sizeof(Expr_Test);
+
+  std::vector<cdk::string> texts;
+  for (const Expr_Test &test : perf_exprs)
+    texts.push_back(test.txt);
+
+  typedef std::chrono::steady_clock clock;
+  Expr_counter counter;
+
+  auto start = clock::now();
+
+  for (unsigned i = 0; i < rounds; ++i)
+    for (size_t j = 0; j < count; ++j)
+      Expression_parser(perf_exprs[j].mode, texts[j]).process(counter);
+
+  auto parse_time = clock::now() - start;
+
+  start = clock::now();
+  size_t total_toks = 0;
+
+  for (unsigned i = 0; i < rounds; ++i)
+    for (const cdk::string &txt : texts)
+    {
+      Tokenizer toks(txt);
+      total_toks += toks.empty() ? 0 : 1;
+    }
+
+  auto tok_time = clock::now() - start;
+
+  EXPECT_EQ(count*rounds, total_toks);
+  EXPECT_LT(count*rounds, counter.m_nodes);
+
+  using std::chrono::microseconds;
+  using std::chrono::duration_cast;
+
+  auto parse_us = duration_cast<microseconds>(parse_time).count() + 1;
+  auto tok_us = duration_cast<microseconds>(tok_time).count() + 1;
+
+  cout << "Parsed " << count*rounds << " expressions in " << parse_us
+       << "us (" << count*rounds*1000000 / parse_us << " expr/s)" << endl;
+  cout << "Tokenizing the same input took " << tok_us << "us ("
+       << count*rounds*1000000 / tok_us << " expr/s)" << endl;
+}
+
+
 TEST(Parser, doc_path)
 {
   {
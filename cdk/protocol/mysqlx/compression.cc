@@ -0,0 +1,372 @@
+/*
+ * Copyright (c) 2015, 2016, Oracle and/or its affiliates. All rights reserved.
+ *
+ * This code is licensed under the terms of the GPLv2
+ * <http://www.gnu.org/licenses/old-licenses/gpl-2.0.html>, like most
+ * MySQL Connectors. There are special exceptions to the terms and
+ * conditions of the GPLv2 as it is applied to this software, see the
+ * FLOSS License Exception
+ * <http://www.mysql.com/about/legal/licensing/foss-exception.html>.
+ *
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published
+ * by the Free Software Foundation; version 2 of the License.
+ *
+ * This program is distributed in the hope that it will be useful, but
+ * WITHOUT ANY WARRANTY; without even the implied warranty of MERCHANTABILITY
+ * or FITNESS FOR A PARTICULAR PURPOSE. See the GNU General Public License
+ * for more details.
+ *
+ * You should have received a copy of the GNU General Public License along
+ * with this program; if not, write to the Free Software Foundation, Inc.,
+ * 51 Franklin St, Fifth Floor, Boston, MA 02110-1301  USA
+ */
+
+/*
+  Implementation of mysqlx protocol API: compression algorithms
+  =============================================================
+
+  Algorithms are named as in the X Protocol:
+
+  - "deflate_stream" - zlib deflate stream shared by all frames sent in one
+    direction, each frame ends with a sync flush,
+  - "lz4_message" - each frame is a separate LZ4 frame,
+  - "zstd_stream" - zstd stream shared by all frames sent in one direction,
+    each frame ends with a flush.
+
+  An algorithm is available only if the corresponding library was found
+  when building CDK.
+*/
+
+#include <mysql/cdk/foundation/common.h>
+#include <mysql/cdk/config.h>
+#include "compression.h"
+
+PUSH_SYS_WARNINGS
+#include <string.h>
+#ifdef HAVE_COMPRESSION_ZLIB
+#include <zlib.h>
+#endif
+#ifdef HAVE_COMPRESSION_LZ4
+#include <lz4frame.h>
+#endif
+#ifdef HAVE_COMPRESSION_ZSTD
+#include <zstd.h>
+#endif
+POP_SYS_WARNINGS
+
+
+namespace cdk {
+namespace protocol {
+namespace mysqlx {
+
+
+const char* compression_name(compression_type::value type)
+{
+  switch (type)
+  {
+  case compression_type::DEFLATE: return "deflate_stream";
+  case compression_type::LZ4:     return "lz4_message";
+  case compression_type::ZSTD:    return "zstd_stream";
+  default:                        return NULL;
+  }
+}
+
+
+bool compression_supported(compression_type::value type)
+{
+  switch (type)
+  {
+#ifdef HAVE_COMPRESSION_ZLIB
+  case compression_type::DEFLATE: return true;
+#endif
+#ifdef HAVE_COMPRESSION_LZ4
+  case compression_type::LZ4:     return true;
+#endif
+#ifdef HAVE_COMPRESSION_ZSTD
+  case compression_type::ZSTD:    return true;
+#endif
+  default:                        return false;
+  }
+}
+
+
+static
+void compression_error(const char *msg)
+{
+  throw_error(cdkerrc::compression_error, msg);
+}
+
+
+// Size of the chunks in which compressed output is produced.
+
+const size_t out_chunk_size = 16*1024;
+
+
+#ifdef HAVE_COMPRESSION_ZLIB
+
+class Compression_deflate : public Compression
+{
+  z_stream m_def;
+  z_stream m_inf;
+
+public:
+
+  Compression_deflate()
+  {
+    memset(&m_def, 0, sizeof(m_def));
+    memset(&m_inf, 0, sizeof(m_inf));
+
+    if (Z_OK != deflateInit(&m_def, 3))
+      compression_error("Could not initialize deflate stream");
+
+    if (Z_OK != inflateInit(&m_inf))
+    {
+      deflateEnd(&m_def);
+      compression_error("Could not initialize inflate stream");
+    }
+  }
+
+  ~Compression_deflate()
+  {
+    deflateEnd(&m_def);
+    inflateEnd(&m_inf);
+  }
+
+  void compress(bytes data, std::string &out)
+  {
+    m_def.next_in = (Bytef*)data.begin();
+    m_def.avail_in = (uInt)data.size();
+
+    /*
+      With Z_SYNC_FLUSH all pending output is produced, so that the other
+      side can uncompress it without waiting for the next frame. Deflate is
+      done when it does not fill the whole output chunk.
+    */
+
+    do {
+      size_t pos = out.size();
+      out.resize(pos + out_chunk_size);
+      m_def.next_out = (Bytef*)&out[pos];
+      m_def.avail_out = (uInt)out_chunk_size;
+
+      int rc = deflate(&m_def, Z_SYNC_FLUSH);
+      if (Z_OK != rc && Z_BUF_ERROR != rc)
+        compression_error("Deflate failed");
+
+      out.resize(pos + out_chunk_size - m_def.avail_out);
+    }
+    while (0 == m_def.avail_out);
+  }
+
+  void uncompress(bytes data, byte *buf, size_t size)
+  {
+    m_inf.next_in = (Bytef*)data.begin();
+    m_inf.avail_in = (uInt)data.size();
+    m_inf.next_out = (Bytef*)buf;
+    m_inf.avail_out = (uInt)size;
+
+    /*
+      Note: After producing all output, inflate() still has to consume
+      the empty block which ends the sync flush.
+    */
+
+    while (0 < m_inf.avail_in)
+    {
+      int rc = inflate(&m_inf, Z_SYNC_FLUSH);
+      if (Z_BUF_ERROR == rc || Z_STREAM_END == rc)
+        break;
+      if (Z_OK != rc)
+        compression_error("Invalid deflate compressed data");
+    }
+
+    if (0 != m_inf.avail_out || 0 != m_inf.avail_in)
+      compression_error("Invalid deflate compressed data");
+  }
+};
+
+#endif
+
+
+#ifdef HAVE_COMPRESSION_LZ4
+
+class Compression_lz4 : public Compression
+{
+  LZ4F_dctx *m_dctx;
+  LZ4F_preferences_t m_prefs;
+
+public:
+
+  Compression_lz4()
+    : m_dctx(NULL)
+  {
+    if (LZ4F_isError(LZ4F_createDecompressionContext(&m_dctx, LZ4F_VERSION)))
+      compression_error("Could not initialize lz4 decompression");
+    memset(&m_prefs, 0, sizeof(m_prefs));
+    m_prefs.compressionLevel = 2;
+  }
+
+  ~Compression_lz4()
+  {
+    LZ4F_freeDecompressionContext(m_dctx);
+  }
+
+  void compress(bytes data, std::string &out)
+  {
+    m_prefs.frameInfo.contentSize = data.size();
+
+    size_t pos = out.size();
+    out.resize(pos + LZ4F_compressFrameBound(data.size(), &m_prefs));
+
+    size_t len = LZ4F_compressFrame(&out[pos], out.size() - pos,
+                                    data.begin(), data.size(), &m_prefs);
+    if (LZ4F_isError(len))
+      compression_error("LZ4 compression failed");
+
+    out.resize(pos + len);
+  }
+
+  void uncompress(bytes data, byte *buf, size_t size)
+  {
+    const byte *in = data.begin();
+    size_t in_left = data.size();
+    size_t done = 0;
+    size_t rc = 1;
+
+    while (0 != rc && in_left > 0)
+    {
+      size_t in_len = in_left;
+      size_t out_len = size - done;
+
+      rc = LZ4F_decompress(m_dctx, buf + done, &out_len, in, &in_len, NULL);
+      if (LZ4F_isError(rc))
+      {
+        LZ4F_resetDecompressionContext(m_dctx);
+        compression_error("Invalid lz4 compressed data");
+      }
+
+      in += in_len;
+      in_left -= in_len;
+      done += out_len;
+
+      if (0 == in_len && 0 == out_len)
+        break;
+    }
+
+    if (0 != rc || 0 != in_left || done != size)
+    {
+      LZ4F_resetDecompressionContext(m_dctx);
+      compression_error("Invalid lz4 compressed data");
+    }
+  }
+};
+
+#endif
+
+
+#ifdef HAVE_COMPRESSION_ZSTD
+
+class Compression_zstd : public Compression
+{
+  ZSTD_CStream *m_cstr;
+  ZSTD_DStream *m_dstr;
+
+public:
+
+  Compression_zstd()
+    : m_cstr(ZSTD_createCStream())
+    , m_dstr(ZSTD_createDStream())
+  {
+    if (!m_cstr || !m_dstr
+        || ZSTD_isError(ZSTD_initCStream(m_cstr, 3))
+        || ZSTD_isError(ZSTD_initDStream(m_dstr)))
+    {
+      ZSTD_freeCStream(m_cstr);
+      ZSTD_freeDStream(m_dstr);
+      compression_error("Could not initialize zstd stream");
+    }
+  }
+
+  ~Compression_zstd()
+  {
+    ZSTD_freeCStream(m_cstr);
+    ZSTD_freeDStream(m_dstr);
+  }
+
+  void compress(bytes data, std::string &out)
+  {
+    ZSTD_inBuffer in = { data.begin(), data.size(), 0 };
+
+    while (in.pos < in.size)
+    {
+      size_t pos = out.size();
+      out.resize(pos + out_chunk_size);
+      ZSTD_outBuffer buf = { &out[pos], out_chunk_size, 0 };
+
+      if (ZSTD_isError(ZSTD_compressStream(m_cstr, &buf, &in)))
+        compression_error("Zstd compression failed");
+
+      out.resize(pos + buf.pos);
+    }
+
+    /*
+      Flush after consuming all input, so that the other side can uncompress
+      the frame without waiting for more data. Flush is complete when
+      ZSTD_flushStream() returns 0.
+    */
+
+    size_t left;
+
+    do {
+      size_t pos = out.size();
+      out.resize(pos + out_chunk_size);
+      ZSTD_outBuffer buf = { &out[pos], out_chunk_size, 0 };
+
+      left = ZSTD_flushStream(m_cstr, &buf);
+      if (ZSTD_isError(left))
+        compression_error("Zstd compression failed");
+
+      out.resize(pos + buf.pos);
+    }
+    while (0 != left);
+  }
+
+  void uncompress(bytes data, byte *buf, size_t size)
+  {
+    ZSTD_inBuffer in = { data.begin(), data.size(), 0 };
+    ZSTD_outBuffer out = { buf, size, 0 };
+
+    while (in.pos < in.size)
+    {
+      size_t pos = in.pos;
+      size_t rc = ZSTD_decompressStream(m_dstr, &out, &in);
+      if (ZSTD_isError(rc) || (pos == in.pos && out.pos == out.size))
+        compression_error("Invalid zstd compressed data");
+    }
+
+    if (out.pos != size)
+      compression_error("Invalid zstd compressed data");
+  }
+};
+
+#endif
+
+
+Compression* mk_compression(compression_type::value type)
+{
+  switch (type)
+  {
+#ifdef HAVE_COMPRESSION_ZLIB
+  case compression_type::DEFLATE: return new Compression_deflate();
+#endif
+#ifdef HAVE_COMPRESSION_LZ4
+  case compression_type::LZ4:     return new Compression_lz4();
+#endif
+#ifdef HAVE_COMPRESSION_ZSTD
+  case compression_type::ZSTD:    return new Compression_zstd();
+#endif
+  default:                        return NULL;
+  }
+}
+
+}}}  // cdk::protocol::mysqlx
@@ -0,0 +1,75 @@
+/*
+ * Copyright (c) 2015, 2016, Oracle and/or its affiliates. All rights reserved.
+ *
+ * The MySQL Connector/C++ is licensed under the terms of the GPLv2
+ * <http://www.gnu.org/licenses/old-licenses/gpl-2.0.html>, like most
+ * MySQL Connectors. There are special exceptions to the terms and
+ * conditions of the GPLv2 as it is applied to this software, see the
+ * FLOSS License Exception
+ * <http://www.mysql.com/about/legal/licensing/foss-exception.html>.
+ *
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published
+ * by the Free Software Foundation; version 2 of the License.
+ *
+ * This program is distributed in the hope that it will be useful, but
+ * WITHOUT ANY WARRANTY; without even the implied warranty of MERCHANTABILITY
+ * or FITNESS FOR A PARTICULAR PURPOSE. See the GNU General Public License
+ * for more details.
+ *
+ * You should have received a copy of the GNU General Public License along
+ * with this program; if not, write to the Free Software Foundation, Inc.,
+ * 51 Franklin St, Fifth Floor, Boston, MA 02110-1301  USA
+ */
+
+
+#ifndef PROTOCOL_MYSQLX_COMPRESSION_H
+#define PROTOCOL_MYSQLX_COMPRESSION_H
+
+#include <mysql/cdk/protocol/mysqlx.h>
+
+PUSH_SYS_WARNINGS
+#include <string>
+POP_SYS_WARNINGS
+
+
+namespace cdk {
+namespace protocol {
+namespace mysqlx {
+
+/*
+  Interface of a compression algorithm used to compress message frames
+  (see Protocol_impl::set_compression()).
+
+  Method compress() appends compressed form of the given data to the output
+  string. Method uncompress() restores exactly `size` bytes of original data
+  into the given buffer and throws error if compressed data does not encode
+  that many bytes.
+
+  An object is used for a single connection and keeps separate compression
+  and decompression state. For stream algorithms this state is shared by all
+  frames sent (received) over the connection, so frames must be uncompressed
+  in the same order in which they were compressed.
+*/
+
+class Compression
+{
+public:
+
+  virtual ~Compression() {}
+
+  virtual void compress(bytes data, std::string &out) = 0;
+  virtual void uncompress(bytes data, byte *buf, size_t size) = 0;
+};
+
+
+/*
+  Create compression object for the given algorithm. Returns NULL if
+  the algorithm is not supported by this build.
+*/
+
+Compression* mk_compression(compression_type::value);
+
+}}}  // cdk::protocol::mysqlx
+
+#endif
@@ -410,6 +410,146 @@ void set_doc_path(Mysqlx::Expr::ColumnIdentifier *p_col_id,
 // -------------------------------------------------------------------------
 
 
+/*
+  Sending CRUD commands using Cmd_cache
+  -------------------------------------
+
+  Cmd_sender<MSG> sends a command of type MSG, possibly using bytes stored
+  in a Cmd_cache instance (passed as pointers to its members). Method
+  send_cached() checks if the cached command can be used for the given
+  arguments. If yes, it builds a message containing only these arguments and
+  sends it after the cached bytes. Otherwise it returns NULL and the full
+  command should be built and then sent with send(), which also stores it in
+  the cache.
+
+  Note: Commands that are being prepared on the server are not sent from
+  the cache, nor stored in it.
+*/
+
+class Arg_names
+  : public api::Args_map::Processor
+{
+  std::vector<string> &m_names;
+
+public:
+
+  Arg_names(std::vector<string> &names)
+    : m_names(names)
+  {}
+
+  Any_prc* key_val(const string &key)
+  {
+    m_names.push_back(key);
+    return NULL;
+  }
+};
+
+
+template <class MSG>
+class Cached_args_builder
+  : public api::Args_map::Processor
+{
+  MSG &m_msg;
+  const std::vector<string> &m_names;
+  Any_to_Scalar_builder m_builder;
+
+public:
+
+  size_t m_pos;
+  bool   m_match;
+
+  Cached_args_builder(MSG &msg, const std::vector<string> &names)
+    : m_msg(msg), m_names(names), m_pos(0), m_match(true)
+  {}
+
+  Any_prc* key_val(const string &key)
+  {
+    if (!m_match || m_pos >= m_names.size() || key != m_names[m_pos])
+    {
+      m_match = false;
+      return NULL;
+    }
+
+    m_pos++;
+    m_builder.reset(*m_msg.add_args());
+    return &m_builder;
+  }
+};
+
+
+template <class MSG>
+class Cmd_sender
+{
+  Protocol_impl &m_impl;
+  msg_type_t     m_type;
+  std::string   *m_bytes;
+  std::vector<string> *m_names;
+
+public:
+
+  Cmd_sender(Protocol_impl &impl, msg_type_t type,
+             std::string *msg, std::vector<string> *names)
+    : m_impl(impl), m_type(type), m_bytes(msg), m_names(names)
+  {
+    if (m_impl.is_preparing())
+      m_bytes = NULL;
+  }
+
+  Protocol::Op* send_cached(const api::Args_map *args)
+  {
+    if (!m_bytes || m_bytes->empty())
+      return NULL;
+
+    MSG msg;
+
+    if (args)
+    {
+      Cached_args_builder<MSG> prc(msg, *m_names);
+      args->process(prc);
+      if (!prc.m_match || prc.m_pos != m_names->size())
+      {
+        m_bytes->clear();
+        m_names->clear();
+        return NULL;
+      }
+    }
+    else if (!m_names->empty())
+    {
+      m_bytes->clear();
+      m_names->clear();
+      return NULL;
+    }
+
+    return &m_impl.snd_start(bytes(*m_bytes), msg, m_type);
+  }
+
+  Protocol::Op& send(MSG &msg, const api::Args_map *args)
+  {
+    if (m_bytes)
+    {
+      // Store the command without its arguments.
+
+      google::protobuf::RepeatedPtrField<Mysqlx::Datatypes::Scalar> vals;
+      vals.Swap(msg.mutable_args());
+      msg.SerializeToString(m_bytes);
+      vals.Swap(msg.mutable_args());
+
+      m_names->clear();
+      if (args)
+      {
+        Arg_names prc(*m_names);
+        args->process(prc);
+      }
+    }
+
+    return m_impl.snd_start(msg, m_type);
+  }
+};
+
+
+// -------------------------------------------------------------------------
+
+
 /*
   Storing Group_by information inside Find protocol command.
   This command has a repeated `grouping` field of type
@@ -484,13 +624,23 @@ void set_find(Mysqlx::Crud::Find &msg,
 
 
 Protocol::Op&
-Protocol::snd_Find(Data_model dm, const Find_spec &fs, const api::Args_map *args)
+Protocol::snd_Find(Data_model dm, const Find_spec &fs, const api::Args_map *args,
+                   Cmd_cache *cache)
 {
+  Cmd_sender<Mysqlx::Crud::Find> sender(
+    get_impl(), msg_type::cli_CrudFind,
+    cache ? &cache->m_msg : NULL, cache ? &cache->m_params : NULL
+  );
+
+  Protocol::Op *op = sender.send_cached(args);
+  if (op)
+    return *op;
+
   Mysqlx::Crud::Find find;
 
   set_find(find, dm, fs, args);
 
-  return get_impl().snd_start(find, msg_type::cli_CrudFind);
+  return sender.send(find, args);
 }
 
 
@@ -666,8 +816,18 @@ Protocol::Op& Protocol::snd_Update(
     Data_model dm,
     const Select_spec &sel,
     Update_spec &us,
-    const api::Args_map *args)
+    const api::Args_map *args,
+    Cmd_cache *cache)
 {
+  Cmd_sender<Mysqlx::Crud::Update> sender(
+    get_impl(), msg_type::cli_CrudUpdate,
+    cache ? &cache->m_msg : NULL, cache ? &cache->m_params : NULL
+  );
+
+  Protocol::Op *op = sender.send_cached(args);
+  if (op)
+    return *op;
+
   Mysqlx::Crud::Update update;
   Placeholder_conv_imp conv;
 
@@ -684,7 +844,7 @@ Protocol::Op& Protocol::snd_Update(
     us.process(prc);
   }
 
-  return get_impl().snd_start(update, msg_type::cli_CrudUpdate);
+  return sender.send(update, args);
 }
 
 
@@ -692,8 +852,18 @@ Protocol::Op& Protocol::snd_Update(
 
 
 Protocol::Op&
-Protocol::snd_Delete(Data_model dm, const Select_spec &sel, const api::Args_map *args)
+Protocol::snd_Delete(Data_model dm, const Select_spec &sel, const api::Args_map *args,
+                     Cmd_cache *cache)
 {
+  Cmd_sender<Mysqlx::Crud::Delete> sender(
+    get_impl(), msg_type::cli_CrudDelete,
+    cache ? &cache->m_msg : NULL, cache ? &cache->m_params : NULL
+  );
+
+  Protocol::Op *op = sender.send_cached(args);
+  if (op)
+    return *op;
+
   Mysqlx::Crud::Delete del;
   Placeholder_conv_imp conv;
 
@@ -704,7 +874,7 @@ Protocol::snd_Delete(Data_model dm, const Select_spec &sel, const api::Args_map
 
   set_select(sel, del, conv);
 
-  return get_impl().snd_start(del, msg_type::cli_CrudDelete);
+  return sender.send(del, args);
 }
 
 
@@ -47,6 +47,10 @@
 
 #include "protocol.h"
 
+PUSH_PB_WARNINGS
+#include "protobuf/mysqlx_connection.pb.h"
+POP_PB_WARNINGS
+
 PUSH_SYS_WARNINGS
 #include <memory.h> // for memcpy
 POP_SYS_WARNINGS
@@ -135,7 +139,21 @@ static void log_handler_init()
 Protocol_impl::Protocol_impl(Protocol::Stream *str, Protocol_side side)
   : m_str(str), m_side(side)
   , m_msg_state(PAYLOAD)
+  , m_ra_buf(NULL), m_ra_size(0), m_ra_pos(0), m_ra_end(0)
+  , m_msg_buf(NULL), m_rd_ready(true), m_rd_direct(false)
+  , m_rd_count(0)
+  , m_unc_buf(NULL), m_unc_size(0), m_unc_pos(0), m_unc_end(0)
+  , m_rd_unc(false)
   , m_msg_size(0)
+  , m_wr_pending(0), m_wr_pending_count(0)
+  , m_cmp_buf(NULL), m_cmp_size(0)
+  , m_cmp_threshold(default_compression_threshold)
+  , m_cmp_combine(1)
+  , m_prepare_id(0)
+  , m_cursor_id(0)
+  , m_fetch_rows(0)
+  , m_cmd_head(0), m_cmd_count(0), m_cmd_untimed(0)
+  , m_rt_pending(false)
 {
   EXECUTE_ONCE(&log_handler_once, &log_handler_init);
 
@@ -150,16 +168,78 @@ Protocol_impl::Protocol_impl(Protocol::Stream *str, Protocol_side side)
 
   if (!m_wr_buf)
     throw_error("Could not allocate initial output buffer");
+
+  set_rd_ahead_size(default_rd_ahead_size);
 }
 
 Protocol_impl::~Protocol_impl()
 {
   free(m_rd_buf);
   free(m_wr_buf);
+  free(m_ra_buf);
+  free(m_unc_buf);
+  free(m_cmp_buf);
   delete m_str;
 }
 
 
+void Protocol_impl::set_rd_ahead_size(size_t size)
+{
+  if (m_rd_op)
+    THROW("can't change read-ahead buffer size while reading");
+
+  // Buffer must be able to hold at least message header.
+
+  if (size < header_length)
+    size = header_length;
+
+  // Buffer must keep bytes which were already read but not consumed.
+
+  size_t avail = m_ra_end - m_ra_pos;
+
+  if (size < avail)
+    size = avail;
+
+  if (m_ra_pos > 0)
+  {
+    memmove(m_ra_buf, m_ra_buf + m_ra_pos, avail);
+    m_ra_pos = 0;
+    m_ra_end = avail;
+  }
+
+  byte *ptr = (byte*)realloc(m_ra_buf, size);
+
+  if (!ptr)
+    throw_error("Could not allocate read-ahead buffer");
+
+  m_ra_buf = ptr;
+  m_ra_size = size;
+}
+
+
+void Protocol_impl::set_compression(compression_type::value type,
+                                    size_t threshold, unsigned max_combine)
+{
+  if (m_wr_op || m_wr_pending)
+    THROW("can't change compression while writing");
+
+  if (compression_type::NONE == type)
+  {
+    m_compression.reset();
+    return;
+  }
+
+  m_compression.reset(mk_compression(type));
+
+  if (!m_compression)
+    throw_error(cdkerrc::compression_error,
+                "Compression algorithm not supported");
+
+  m_cmp_threshold = threshold;
+  m_cmp_combine = max_combine > 0 ? max_combine : 1;
+}
+
+
 class Invalid_msg_error : public Error_class<Invalid_msg_error>
 {
   unsigned m_state;
@@ -199,6 +279,12 @@ Protocol::Op& Protocol_impl::snd_start(Message &msg, msg_type_t msg_type)
 
 #endif
 
+  if (m_prepare_id)
+    return snd_prepare(msg, msg_type);
+
+  if (m_cursor_id && msg_type::cli_PrepareExecute == msg_type)
+    return snd_cursor_open(msg);
+
   //First delete completed OP, so that if Snd_op() throws exception m_snd_op
   //will not point to old OP.
   m_snd_op.reset();
@@ -207,6 +293,17 @@ Protocol::Op& Protocol_impl::snd_start(Message &msg, msg_type_t msg_type)
 }
 
 
+Protocol::Op& Protocol_impl::snd_start(bytes prefix, Message &msg,
+                                       msg_type_t msg_type)
+{
+  assert(!m_prepare_id);
+
+  m_snd_op.reset();
+  m_snd_op.reset(new Op_snd(*this, msg_type, msg, prefix));
+  return *m_snd_op;
+}
+
+
 /*
   Helper function which creates protobuf message object of type
   indicated by msg_type identifier. Interpretation of msg_type_t
@@ -252,6 +349,26 @@ Message* mk_message(Protocol_side side, msg_type_t msg_type)
 }
 
 
+Message& Protocol_impl::get_message(msg_type_t msg_type)
+{
+  assert(msg_type < msg_cache_size);
+
+  scoped_ptr<Message> &msg = m_msg_cache[msg_type];
+
+  if (!msg)
+    msg.reset(mk_message(m_side, msg_type));
+
+  return *msg;
+}
+
+
+void Protocol_impl::release_message(msg_type_t msg_type)
+{
+  assert(msg_type < msg_cache_size);
+  m_msg_cache[msg_type].reset();
+}
+
+
 
 /*
   Protobuf error logger
@@ -297,21 +414,43 @@ static void log_handler(LogLevel level, const char* filename, int line, const st
 */
 
 
-void Protocol_impl::write_msg(msg_type_t msg_type, Message &msg)
+/*
+  Type of Compression frames sent by the given side.
+*/
+
+static
+msg_type_t compression_msg_type(Protocol_side side)
 {
-  if (m_wr_op)
-    THROW("Can't write message while another one is written");
+  return SERVER == side ? (msg_type_t)msg_type::Compression
+                        : (msg_type_t)msg_type::cli_Compression;
+}
 
-  msg_size_t net_size = static_cast<unsigned>(msg.ByteSize()) + 1;
 
-  if (!resize_buf(CLIENT, header_length + net_size))
-    THROW("Not enough memory for output buffer");
+/*
+  Serialize message, wrapped in message frame, into given buffer which must
+  be big enough to hold it. The frame payload starts with the prefix bytes,
+  if any. Returns the size of the frame.
+
+  Note: If prefix is given, the message contains only the fields which
+  follow the prefix (see Cmd_sender in crud.cc) and its required fields are
+  in the prefix. Therefore such message is serialized without checking that
+  all required fields are set.
+*/
+
+static
+size_t write_frame(byte *buf, size_t size, msg_type_t msg_type, Message &msg,
+                   bytes prefix = bytes())
+{
+  msg_size_t net_size
+    = static_cast<unsigned>(prefix.size() + msg.ByteSize()) + 1;
+
+  assert(header_length + net_size <= size + 1);
 
   // Construct message header
 
   HTONSIZE(net_size);
-  memcpy((void*)m_wr_buf, (const void*)&net_size, sizeof(net_size));
-  m_wr_buf[header_length - 1] = (byte)msg_type;
+  memcpy((void*)buf, (const void*)&net_size, sizeof(net_size));
+  buf[header_length - 1] = (byte)msg_type;
 
   // Convert net_size back to original endian before using it later
 
@@ -319,15 +458,107 @@ void Protocol_impl::write_msg(msg_type_t msg_type, Message &msg)
 
   // Serialize message
 
-  assert(m_wr_size < (size_t)std::numeric_limits<int>::max());
+  assert(size < (size_t)std::numeric_limits<int>::max());
+
+  bool partial = false;
+
+  if (0 < prefix.size())
+  {
+    memcpy(buf + header_length, prefix.begin(), prefix.size());
+    buf += prefix.size();
+    size -= prefix.size();
+    partial = true;
+  }
+
+  bool ok = partial
+    ? msg.SerializePartialToArray((void*)(buf + header_length),
+                                  (int)(size - header_length))
+    : msg.SerializeToArray((void*)(buf + header_length),
+                           (int)(size - header_length));
 
-  if (!msg.SerializeToArray((void*)(m_wr_buf + header_length),
-                            (int)(m_wr_size - header_length)))
+  if (!ok)
     throw_error(cdkerrc::protobuf_error, "Serialization error!");
 
-  // Create write operation to send message payload
+  return net_size + header_length - 1;
+}
+
+
+void Protocol_impl::write_msg(msg_type_t msg_type, Message &msg,
+                              bytes prefix)
+{
+  if (m_wr_op)
+    THROW("Can't write message while another one is written");
+
+  /*
+    New frame is written after the frames which wait to be compressed
+    together with it, if any.
+  */
+
+  size_t pos = m_wr_pending;
+  size_t net_size = prefix.size() + static_cast<unsigned>(msg.ByteSize()) + 1;
 
-  m_wr_op.reset(m_str->write(buffers(m_wr_buf, net_size + header_length - 1)));
+  if (!resize_buf(CLIENT, pos + header_length + net_size))
+    THROW("Not enough memory for output buffer");
+
+  size_t len = write_frame(m_wr_buf + pos, m_wr_size - pos, msg_type, msg,
+                           prefix);
+
+  stats_sent(msg_type);
+
+  if (!m_compression)
+  {
+    // Create write operation to send message payload
+
+    m_wr_op.reset(m_str->write(buffers(m_wr_buf, len)));
+    m_stats.bytes_sent.add(len);
+    return;
+  }
+
+  m_wr_pending += len;
+  m_wr_pending_count++;
+
+  if (m_wr_pending_count < m_cmp_combine && m_wr_pending < max_combine_size)
+    return;
+
+  wr_flush();
+}
+
+
+void Protocol_impl::wr_flush()
+{
+  if (0 == m_wr_pending)
+    return;
+
+  assert(!m_wr_op);
+  assert(m_compression);
+
+  size_t len = m_wr_pending;
+  m_wr_pending = 0;
+  m_wr_pending_count = 0;
+
+  // Small messages are not worth compressing.
+
+  if (len < m_cmp_threshold)
+  {
+    m_wr_op.reset(m_str->write(buffers(m_wr_buf, len)));
+    m_stats.bytes_sent.add(len);
+    return;
+  }
+
+  Mysqlx::Connection::Compression cmp;
+  cmp.set_uncompressed_size(len);
+  m_compression->compress(bytes(m_wr_buf, len), *cmp.mutable_payload());
+
+  size_t net_size = static_cast<unsigned>(cmp.ByteSize()) + 1;
+
+  if (!resize_buf(m_cmp_buf, m_cmp_size, header_length + net_size))
+    THROW("Not enough memory for output buffer");
+
+  len = write_frame(m_cmp_buf, m_cmp_size,
+                    compression_msg_type(other_side(m_side)), cmp);
+
+  m_wr_op.reset(m_str->write(buffers(m_cmp_buf, len)));
+  m_stats.bytes_sent.add(len);
 }
 
 
@@ -356,14 +587,24 @@ void Protocol_impl::wr_wait()
 
 void Protocol_impl::read_header()
 {
+  // Send messages that are waiting to be combined with next ones.
+
+  if (m_wr_pending)
+  {
+    wr_flush();
+    wr_wait();
+  }
+
   if (HEADER == m_msg_state)
     return;
 
   if (m_rd_op)
     THROW("can't read header when reading payload is not completed");
 
-  m_rd_op.reset(m_str->read(buffers(m_rd_buf,4)));
   m_msg_state= HEADER;
+  m_rd_ready= false;
+  m_msg_buf= NULL;
+  rd_step();
 }
 
 void Protocol_impl::read_payload()
@@ -377,29 +618,246 @@ void Protocol_impl::read_payload()
   if (m_rd_op)
     THROW("can't read payload when reading header is not completed");
 
+  m_msg_state= PAYLOAD;
+  m_rd_ready= false;
+
+  if (m_rd_unc || m_msg_size <= m_ra_size)
+  {
+    rd_step();
+    return;
+  }
+
+  rd_direct();
+}
+
+
+/*
+  Start reading payload which does not fit into the read-ahead buffer. It is
+  read directly into m_rd_buf, starting with the bytes which are already in
+  the read-ahead buffer.
+*/
+
+void Protocol_impl::rd_direct()
+{
   if (!resize_buf(SERVER, m_msg_size))
       THROW("Not enough memory for input buffer");
 
-  if (m_msg_size > 0)
-    m_rd_op.reset(m_str->read(buffers(m_rd_buf, m_msg_size)));
-  m_msg_state= PAYLOAD;
+  size_t avail = m_ra_end - m_ra_pos;
+  assert(avail < m_msg_size);
+
+  memcpy(m_rd_buf, m_ra_buf + m_ra_pos, avail);
+  m_ra_pos = m_ra_end = 0;
+
+  m_msg_buf= m_rd_buf;
+  m_rd_direct= true;
+  m_rd_op.reset(m_str->read(buffers(m_rd_buf + avail, m_msg_size - avail)));
+  m_rd_count++;
 }
 
 
-bool Protocol_impl::rd_cont()
+/*
+  Check if data required at the current stage (message header or payload)
+  is available in the read-ahead buffer. If yes, consume it and set
+  m_rd_ready flag. Otherwise start read operation which reads more data
+  into the buffer.
+*/
+
+void Protocol_impl::rd_step()
 {
-  if (!m_rd_op)
-    return true;
+  assert(!m_rd_op);
+
+  while (!m_rd_ready)
+  {
+    size_t need = HEADER == m_msg_state ? header_length : m_msg_size;
+
+    // Take data from uncompressed frames, if there are any left.
+
+    if (HEADER == m_msg_state ? m_unc_pos < m_unc_end : m_rd_unc)
+    {
+      if (m_unc_end - m_unc_pos < need)
+        throw_error(cdkerrc::compression_error,
+                    "Invalid compressed message frame");
+
+      byte *pos = m_unc_buf + m_unc_pos;
+      m_unc_pos += need;
+
+      if (HEADER == m_msg_state)
+      {
+        rd_process(pos);
+        m_rd_unc = true;
+        if (m_msg_type == compression_msg_type(m_side))
+          throw_error(cdkerrc::compression_error,
+                      "Invalid compressed message frame");
+      }
+      else
+        m_msg_buf= pos;
 
-  if (!m_rd_op->cont())
+      m_rd_ready= true;
+      return;
+    }
+
+    if (HEADER == m_msg_state)
+      m_rd_unc = false;
+
+    size_t avail = m_ra_end - m_ra_pos;
+
+    if (avail >= need)
+    {
+      byte *pos = m_ra_buf + m_ra_pos;
+      m_ra_pos += need;
+
+      switch (m_msg_state)
+      {
+      case HEADER:
+        rd_process(pos);
+        if (rd_compressed())
+        {
+          if (m_rd_op)
+            return;
+          continue;
+        }
+        break;
+
+      case COMPRESSED:
+        rd_uncompress(pos);
+        continue;
+
+      case PAYLOAD:
+        m_msg_buf= pos;
+        break;
+      }
+
+      m_rd_ready= true;
+      return;
+    }
+
+    // Make room for the missing bytes, if needed.
+
+    if (m_ra_pos + need > m_ra_size)
+    {
+      memmove(m_ra_buf, m_ra_buf + m_ra_pos, avail);
+      m_ra_pos = 0;
+      m_ra_end = avail;
+    }
+
+    m_rd_op.reset(m_str->read_some(buffers(m_ra_buf + m_ra_end,
+                                           m_ra_size - m_ra_end)));
+    m_rd_count++;
+    return;
+  }
+}
+
+
+/*
+  Called after reading header of a frame. If it is a Compression frame,
+  start reading its payload in COMPRESSED state and return true.
+*/
+
+bool Protocol_impl::rd_compressed()
+{
+  if (!m_compression || m_msg_type != compression_msg_type(m_side))
     return false;
 
+  m_msg_state = COMPRESSED;
+
+  if (m_msg_size > m_ra_size)
+    rd_direct();
+
+  return true;
+}
+
+
+/*
+  Uncompress frames contained in the payload of a Compression frame and
+  switch back to reading frame headers, which are now taken from m_unc_buf.
+*/
+
+void Protocol_impl::rd_uncompress(const byte *data)
+{
+  assert(COMPRESSED == m_msg_state);
+
+  Mysqlx::Connection::Compression &cmp
+    = static_cast<Mysqlx::Connection::Compression&>(get_message(m_msg_type));
+
+  assert(m_msg_size < (size_t)std::numeric_limits<int>::max());
+
+  if (!cmp.ParseFromArray(data, (int)m_msg_size))
+    throw_error(cdkerrc::protobuf_error, "Message could not be parsed");
+
+  if (!cmp.has_uncompressed_size() || cmp.uncompressed_size() > max_rd_size)
+    throw_error(cdkerrc::compression_error,
+                "Invalid size of compressed message frame");
+
+  size_t size = (size_t)cmp.uncompressed_size();
+
+  if (!resize_buf(m_unc_buf, m_unc_size, size))
+    THROW("Not enough memory for input buffer");
+
+  m_compression->uncompress(
+    bytes((byte*)cmp.payload().data(), cmp.payload().size()),
+    m_unc_buf, size
+  );
+
+  m_unc_pos = 0;
+  m_unc_end = size;
+  m_msg_state = HEADER;
+
+  if (m_msg_size > max_cached_msg_size)
+    release_message(m_msg_type);
+}
+
+
+/*
+  Called after completing read operation to account for the bytes
+  that were read.
+*/
+
+void Protocol_impl::rd_done()
+{
+  assert(m_rd_op);
+
+  size_t howmuch = m_rd_op->get_result();
   m_rd_op.reset();
+  m_stats.bytes_received.add(howmuch);
 
-  if (PAYLOAD == m_msg_state)
-    return true;
+  if (m_rd_direct)
+  {
+    m_rd_direct= false;
+
+    // Next header is taken from the uncompressed frames by rd_step().
+
+    if (COMPRESSED == m_msg_state)
+      rd_uncompress(m_rd_buf);
+    else
+      m_rd_ready= true;
+
+    return;
+  }
+
+  m_ra_end += howmuch;
+  assert(m_ra_end <= m_ra_size);
+}
+
+
+bool Protocol_impl::rd_cont()
+{
+  while (!m_rd_ready)
+  {
+    assert(m_rd_op);
+
+    if (!m_rd_op->cont())
+      return false;
+
+    size_t howmuch = m_rd_op->get_result();
 
-  rd_process();
+    rd_done();
+    rd_step();
+
+    // Do not loop if last read did not bring any new data.
+
+    if (0 == howmuch && !m_rd_ready)
+      return false;
+  }
 
   return true;
 }
@@ -407,24 +865,42 @@ bool Protocol_impl::rd_cont()
 
 void Protocol_impl::rd_wait()
 {
-  if (m_rd_op)
+  while (!m_rd_ready)
   {
-    m_rd_op->wait();
-    m_rd_op.reset();
-
-    if (PAYLOAD == m_msg_state)
-      return;
+    assert(m_rd_op);
 
-    rd_process();
+    clock::time_point start = clock::now();
+    m_rd_op->wait();
+    m_stats.rd_wait_ns.add(
+      std::chrono::duration_cast<std::chrono::nanoseconds>(
+        clock::now() - start
+      ).count()
+    );
+
+    rd_done();
+    rd_step();
   }
 }
 
 
 bool Protocol_impl::resize_buf(Protocol_side side, size_t requested_size)
 {
-  byte*  &buf= (side == SERVER ? m_rd_buf : m_wr_buf);
-  size_t &buf_size= (side == SERVER ? m_rd_size : m_wr_size);
+  if (side == SERVER)
+  {
+    if (requested_size >= m_rd_size)
+      m_stats.rd_buf_reallocs.add();
+    return resize_buf(m_rd_buf, m_rd_size, requested_size);
+  }
+
+  if (requested_size >= m_wr_size)
+    m_stats.wr_buf_reallocs.add();
+  return resize_buf(m_wr_buf, m_wr_size, requested_size);
+}
 
+
+bool Protocol_impl::resize_buf(byte* &buf, size_t &buf_size,
+                               size_t requested_size)
+{
   if (requested_size < buf_size)
     return true;
 
@@ -453,17 +929,152 @@ bool Protocol_impl::resize_buf(Protocol_side side, size_t requested_size)
 }
 
 
-void Protocol_impl::rd_process()
+/*
+  Extract message size and type from message frame header.
+*/
+
+void Protocol_impl::rd_process(const byte *hdr)
 {
-  m_msg_size= *(msg_size_t*)m_rd_buf;
-  NTOHSIZE(m_msg_size);
-  assert(m_msg_size > 0);
-  m_msg_size--;
+  msg_size_t net_size;
+  memcpy(&net_size, hdr, sizeof(net_size));
+  NTOHSIZE(net_size);
 
-  m_rd_op.reset(m_str->read(buffers(m_rd_buf, 1)));
-  m_rd_op->wait();
-  m_rd_op.reset();
-  m_msg_type= m_rd_buf[0];
+  if (0 == net_size)
+    throw_error(cdkerrc::protobuf_error, "Invalid message frame header");
+
+  m_msg_size= net_size - 1;
+  m_msg_type= hdr[header_length - 1];
+
+  // Compression frames are not counted, only frames contained in them.
+
+  if (!m_compression || m_msg_type != compression_msg_type(m_side))
+    stats_received(m_msg_type);
+}
+
+
+/*
+  Statistics
+  ==========
+*/
+
+
+static stats_cmd::value stats_cmd_kind(msg_type_t type)
+{
+  switch (type)
+  {
+  case msg_type::cli_StmtExecute:       return stats_cmd::SQL;
+  case msg_type::cli_CrudFind:          return stats_cmd::FIND;
+  case msg_type::cli_CrudInsert:        return stats_cmd::INSERT;
+  case msg_type::cli_CrudUpdate:        return stats_cmd::UPDATE;
+  case msg_type::cli_CrudDelete:        return stats_cmd::REMOVE;
+  case msg_type::cli_PreparePrepare:
+  case msg_type::cli_PrepareDeallocate: return stats_cmd::PREPARE;
+  case msg_type::cli_PrepareExecute:    return stats_cmd::EXECUTE;
+  case msg_type::cli_CursorOpen:
+  case msg_type::cli_CursorFetch:
+  case msg_type::cli_CursorClose:       return stats_cmd::CURSOR;
+  case msg_type::cli_CapabilitiesGet:
+  case msg_type::cli_CapabilitiesSet:
+  case msg_type::cli_Close:
+  case msg_type::cli_AuthenticateStart:
+  case msg_type::cli_AuthenticateContinue:
+  case msg_type::cli_SessionReset:
+  case msg_type::cli_SessionClose:      return stats_cmd::SESSION;
+  default:                              return stats_cmd::OTHER;
+  }
+}
+
+
+void Protocol_impl::stats_sent(msg_type_t type)
+{
+  m_stats.msgs_sent.add();
+  m_rt_pending = true;
+
+  // Latency is measured only for commands sent by the client.
+
+  if (CLIENT == m_side)
+    return;
+
+  if (m_cmd_untimed || cmd_ring_size == m_cmd_count)
+  {
+    m_cmd_untimed++;
+    return;
+  }
+
+  unsigned pos = (m_cmd_head + m_cmd_count++) % cmd_ring_size;
+  m_cmd_ring[pos].kind = stats_cmd_kind(type);
+  m_cmd_ring[pos].time = clock::now();
+}
+
+
+void Protocol_impl::stats_received(msg_type_t type)
+{
+  m_stats.msgs_received.add();
+
+  if (m_rt_pending)
+  {
+    m_stats.round_trips.add();
+    m_rt_pending = false;
+  }
+
+  if (CLIENT == m_side)
+    return;
+
+  switch (type)
+  {
+  case msg_type::Ok:
+  case msg_type::Error:
+  case msg_type::Capabilities:
+  case msg_type::AuthenticateContinue:
+  case msg_type::AuthenticateOk:
+  case msg_type::FetchSuspended:
+  case msg_type::StmtExecuteOk:
+    break;
+
+  default: return;  // not the last message of a reply
+  }
+
+  if (0 == m_cmd_count)
+  {
+    if (m_cmd_untimed)
+      m_cmd_untimed--;
+    return;
+  }
+
+  uint64_t us = std::chrono::duration_cast<std::chrono::microseconds>(
+    clock::now() - m_cmd_ring[m_cmd_head].time
+  ).count();
+
+  unsigned bucket = 0;
+  while (us && bucket < Protocol_stats::latency_buckets - 1)
+  {
+    us >>= 1;
+    bucket++;
+  }
+
+  m_stats.latency[m_cmd_ring[m_cmd_head].kind][bucket].add();
+
+  m_cmd_head = (m_cmd_head + 1) % cmd_ring_size;
+  m_cmd_count--;
+}
+
+
+void Protocol_impl::get_stats(Protocol_stats &stats) const
+{
+  stats.bytes_sent      = m_stats.bytes_sent.get();
+  stats.bytes_received  = m_stats.bytes_received.get();
+  stats.msgs_sent       = m_stats.msgs_sent.get();
+  stats.msgs_received   = m_stats.msgs_received.get();
+  stats.round_trips     = m_stats.round_trips.get();
+  stats.rows            = m_stats.rows.get();
+  stats.fields          = m_stats.fields.get();
+  stats.rd_buf_reallocs = m_stats.rd_buf_reallocs.get();
+  stats.wr_buf_reallocs = m_stats.wr_buf_reallocs.get();
+  stats.rd_wait_ns      = m_stats.rd_wait_ns.get();
+
+  for (unsigned kind = 0; kind < stats_cmd::COUNT; ++kind)
+    for (unsigned i = 0; i < Protocol_stats::latency_buckets; ++i)
+      stats.latency[kind][i] = m_stats.latency[kind][i].get();
 }
 
 
@@ -661,16 +1272,9 @@ void Op_rcv::process_payload()
 
   try {
 
-    byte *cur_pos = m_proto.m_rd_buf;
+    byte *cur_pos = m_proto.m_msg_buf;
     byte *end_pos = cur_pos + m_msg_size;
 
-    /*
-      Note: read_header() checks if message fits into the buffer and
-      throws error if this is not the case.
-    */
-
-    assert(m_msg_size <= m_proto.m_rd_size);
-
     while (cur_pos < end_pos && m_read_window)
     {
       size_t new_window = m_prc->message_data(bytes(cur_pos,
@@ -692,25 +1296,37 @@ void Op_rcv::process_payload()
   if (m_skip)
     return;
 
-  // Parse message.
+#ifndef DEBUG_PROTOBUF
+
+  if (process_raw(m_msg_type, bytes(m_proto.m_msg_buf, m_msg_size)))
+    return;
+
+#endif
+
+  /*
+    Parse message. The message object is re-used from the previous message
+    of the same type (if any) - note that ParseFromArray() clears it before
+    parsing new payload.
+  */
 
-  scoped_ptr<Message> m_msg;
-  m_msg.reset(mk_message(m_proto.m_side, m_msg_type));
+  Message &msg = m_proto.get_message(m_msg_type);
 
   if (m_msg_size > 0)
   {
     try {
       assert(m_msg_size < (size_t)std::numeric_limits<int>::max());
-      if (!m_msg->ParseFromArray(m_proto.m_rd_buf, (int)m_msg_size))
+      if (!msg.ParseFromArray(m_proto.m_msg_buf, (int)m_msg_size))
         throw_error(cdkerrc::protobuf_error, "Message could not be parsed");
     }
     catch (...)
     {
       save_error();
-      m_msg.reset();
+      m_proto.release_message(m_msg_type);
       return;
     }
   }
+  else
+    msg.Clear();
 
 #ifdef DEBUG_PROTOBUF
 
@@ -721,14 +1337,19 @@ void Op_rcv::process_payload()
   cerr << "<<<< Received message <<<<" << endl;
   cerr << "of type " << m_msg_type <<": "
        << msg_type_name(SERVER, m_msg_type) << endl;
-  cerr << m_msg->DebugString();
+  cerr << msg.DebugString();
   cerr << "<<<<" << endl << endl;
 
 #endif
 
   // Pass data from parsed message to processor
 
-  process_msg(m_msg_type, *m_msg);
+  process_msg(m_msg_type, msg);
+
+  // Do not keep memory used by large messages.
+
+  if (m_msg_size > max_cached_msg_size)
+    m_proto.release_message(m_msg_type);
 }
 
 
@@ -818,6 +1439,28 @@ Protocol::Op& Protocol::rcv_Reply(Reply_processor &prc)
 }
 
 
+void Protocol::set_rd_ahead_size(size_t size)
+{
+  get_impl().set_rd_ahead_size(size);
+}
+
+void Protocol::set_compression(compression_type::value type,
+                               size_t threshold, unsigned max_combine)
+{
+  get_impl().set_compression(type, threshold, max_combine);
+}
+
+uint64_t Protocol::get_rd_count() const
+{
+  return get_impl().get_rd_count();
+}
+
+void Protocol::get_stats(Protocol_stats &stats) const
+{
+  get_impl().get_stats(stats);
+}
+
+
 // Server-side API
 // ===============
 // TODO: Complete and adapt to protocol changes.
@@ -885,6 +1528,12 @@ Protocol::Op& Protocol_server::rcv_Command(Cmd_processor &prc)
   return get_impl().rcv_start<Rcv_command>(prc);
 }
 
+void Protocol_server::set_compression(compression_type::value type,
+                                      size_t threshold, unsigned max_combine)
+{
+  get_impl().set_compression(type, threshold, max_combine);
+}
+
 
 // ------------------------------------------------------------
 
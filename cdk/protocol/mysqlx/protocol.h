@@ -35,6 +35,12 @@ PUSH_PB_WARNINGS
 #include "protobuf/mysqlx.pb.h"
 POP_PB_WARNINGS
 
+#include "compression.h"
+
+PUSH_SYS_WARNINGS
+#include <chrono>
+POP_SYS_WARNINGS
+
 
 namespace google {
 namespace protobuf {
@@ -89,6 +95,30 @@ const size_t header_length= 5;
 const size_t max_wr_size= 1024*1024*1024;  // 1GB
 const size_t max_rd_size= max_wr_size;
 
+/// Default size of the read-ahead buffer (see Protocol_impl::read_header()).
+const size_t default_rd_ahead_size= 64*1024;  // 64KB
+
+/*
+  Message objects used to parse incoming messages are cached and re-used
+  (see Protocol_impl::get_message()). After parsing a message with payload
+  larger than this limit, the cached object is deleted so that memory held
+  by it is not kept for the rest of the session.
+*/
+const size_t max_cached_msg_size= 64*1024;  // 64KB
+
+/*
+  Size of the message object cache - message type is stored in single byte
+  of message frame header.
+*/
+const size_t msg_cache_size= 256;
+
+/*
+  When messages are combined before compressing them (see
+  Protocol_impl::set_compression()), they are sent when their total size
+  exceeds this limit.
+*/
+const size_t max_combine_size= 64*1024;  // 64KB
+
 // TODO: use throw_error or any other appropriate method when the code is ready
 #define THROW_PROTOCOL_ERROR(ERR) throw ERR
 
@@ -140,6 +170,56 @@ public:
 
   virtual Protocol::Op& snd_start(Message &msg, msg_type_t msg_type);
 
+  /**
+    Start async op that sends message whose serialized form consists of
+    given bytes followed by serialized `msg` (used to send commands stored
+    in Cmd_cache). The message is always sent as is, it can not be prepared.
+  */
+
+  Protocol::Op& snd_start(bytes prefix, Message &msg, msg_type_t msg_type);
+
+  /**
+    Tell if the next statement sent with snd_start() is going to be
+    prepared (see set_prepare_id()).
+  */
+
+  bool is_preparing() const
+  {
+    return 0 != m_prepare_id;
+  }
+
+  /**
+    Set id under which the next statement sent with snd_start() should be
+    prepared (see Protocol::set_prepare_id()).
+  */
+
+  void set_prepare_id(stmt_id_t id)
+  {
+    m_prepare_id = id;
+  }
+
+  /**
+    Set cursor which should be opened by the next Execute message sent with
+    snd_start() (see Protocol::set_cursor()).
+  */
+
+  void set_cursor(cursor_id_t cid, row_count_t fetch_rows)
+  {
+    m_cursor_id = cid;
+    m_fetch_rows = fetch_rows;
+  }
+
+  /**
+    Abandon current (suspended) receive operation. This is used when
+    server will not send the remaining messages that the operation was
+    waiting for, such as after closing a cursor.
+  */
+
+  void rcv_reset()
+  {
+    m_rcv_op.reset();
+  }
+
   /**
     Start (next stage of) an async op that processes incoming message(s).
 
@@ -165,6 +245,39 @@ public:
   template <class RCV, class PRC>
   Protocol::Op& rcv_start(PRC&);
 
+  /**
+    Change size of the read-ahead buffer used when reading incoming messages
+    (see "Read-ahead buffer" below). Can not be changed while a read
+    operation is in progress.
+  */
+
+  void set_rd_ahead_size(size_t);
+
+  /**
+    Return number of read operations performed on the underlying stream
+    so far.
+  */
+
+  uint64_t get_rd_count() const
+  {
+    return m_rd_count;
+  }
+
+  /**
+    Store current values of statistics (see Protocol::get_stats()).
+  */
+
+  void get_stats(Protocol_stats&) const;
+
+  /**
+    Enable or disable compression of message frames (see
+    Protocol::set_compression()).
+  */
+
+  void set_compression(compression_type::value,
+                       size_t threshold = default_compression_threshold,
+                       unsigned max_combine = 1);
+
 protected:
 
   /*
@@ -177,15 +290,43 @@ protected:
     be called only at the beginning or after reading message payload.
 
     Method read_payload() starts asynchronous reading of message payload.
-    If payload has been already read, it does nothing. The payload is placed
-    in m_rd_buf buffer. This method can be called only after reading message
-    header.
+    If payload has been already read, it does nothing. After reading, member
+    m_msg_buf points at the payload bytes which stay valid until the next
+    message header is read. This method can be called only after reading
+    message header.
 
     To complete the asynchronous header/payload reading operation one has
     to call method rd_cont() until it returns true.
+
+    Read-ahead buffer
+    -----------------
+
+    Data is read from the stream into the read-ahead buffer m_ra_buf, using
+    "read some" operations that read as many bytes as are available, up to
+    the free space in the buffer. Headers and payloads of messages are then
+    taken from that buffer. This way a single read operation on the stream
+    (and a single system call for socket based streams) can serve many
+    consecutive small messages, such as result-set rows. Bytes between
+    m_ra_pos and m_ra_end are read from the stream but not yet consumed.
+
+    If message payload is larger than the read-ahead buffer, it is read
+    directly into m_rd_buf (after copying the part of it which is already
+    in the read-ahead buffer).
+
+    Member m_rd_count counts read operations performed on the stream.
+
+    Compressed frames
+    -----------------
+
+    If compression is enabled, a frame of type Compression is not passed
+    to the caller. After reading its header, its payload is read in
+    COMPRESSED state and uncompressed into m_unc_buf. Frames contained in
+    it are then returned by read_header() and read_payload() directly from
+    that buffer (m_rd_unc is true for such frames), until all bytes between
+    m_unc_pos and m_unc_end are consumed.
   */
 
-  enum { HEADER, PAYLOAD }   m_msg_state;
+  enum { HEADER, PAYLOAD, COMPRESSED }   m_msg_state;
 
   void read_header();
   void read_payload();
@@ -196,6 +337,23 @@ protected:
   size_t  m_rd_size;
   scoped_ptr<Protocol::Stream::Op> m_rd_op;
 
+  byte   *m_ra_buf;
+  size_t  m_ra_size;
+  size_t  m_ra_pos;
+  size_t  m_ra_end;
+
+  byte   *m_msg_buf;
+  bool    m_rd_ready;
+  bool    m_rd_direct;
+
+  uint64_t m_rd_count;
+
+  byte   *m_unc_buf;
+  size_t  m_unc_size;
+  size_t  m_unc_pos;
+  size_t  m_unc_end;
+  bool    m_rd_unc;
+
   // Info extracted from message header
 
   msg_type_t m_msg_type;
@@ -207,13 +365,22 @@ protected:
 
     Method write_msg() starts asynchronous operation which serializes given
     message and sends it to the other end after wrapping in correct message
-    frame.
+    frame. If prefix is not empty, it is placed in the frame before
+    the serialized message.
 
     To complete writing operation one has to call method wr_cont() until it
     returns true.
+
+    If compression is enabled, frames are collected in m_wr_buf, where
+    m_wr_pending bytes of m_wr_pending_count frames wait to be sent, until
+    the limit on the number of combined messages is reached. Then wr_flush()
+    sends them, compressed inside single Compression frame built in
+    m_cmp_buf, or as they are if they are smaller than the compression
+    threshold. Pending frames are also sent before reading the next message.
   */
 
-  void write_msg(msg_type_t, Message&);
+  void write_msg(msg_type_t, Message&, bytes prefix = bytes());
+  void wr_flush();
   bool wr_cont();
   void wr_wait();
 
@@ -221,7 +388,113 @@ protected:
   size_t  m_wr_size;
   scoped_ptr<Protocol::Stream::Op> m_wr_op;
 
+  size_t    m_wr_pending;
+  unsigned  m_wr_pending_count;
+  byte     *m_cmp_buf;
+  size_t    m_cmp_size;
+
+  scoped_ptr<Compression> m_compression;
+  size_t    m_cmp_threshold;
+  unsigned  m_cmp_combine;
+
   bool resize_buf(Protocol_side side, size_t new_size);
+  static bool resize_buf(byte* &buf, size_t &size, size_t new_size);
+
+  /*
+    Message objects used for parsing incoming messages
+    --------------------------------------------------
+
+    Method get_message() returns protobuf message object of the type
+    indicated by msg_type, as seen from the side from which we receive
+    messages. The object is created on first request and then kept in
+    m_msg_cache so that next message of the same type is parsed into the
+    same object. This way processing a long sequence of messages, such as
+    result-set rows, does not allocate and free a message object (and
+    strings inside it) for each received message.
+
+    Method release_message() deletes cached object of the given type, if any.
+  */
+
+  Message& get_message(msg_type_t msg_type);
+  void release_message(msg_type_t msg_type);
+
+  scoped_ptr<Message> m_msg_cache[msg_cache_size];
+
+  /*
+    Prepared statements
+    -------------------
+
+    If m_prepare_id is not zero, the next statement message passed to
+    snd_start() is not sent as is. Instead, snd_prepare() wraps it in
+    a Prepare message which prepares the statement under that id. Parameter
+    values are removed from the statement when it is wrapped.
+  */
+
+  stmt_id_t m_prepare_id;
+
+  Protocol::Op& snd_prepare(Message &msg, msg_type_t msg_type);
+
+  /*
+    Similar, if m_cursor_id is not zero, the next Execute message is sent
+    inside Cursor.Open message by snd_cursor_open().
+  */
+
+  cursor_id_t m_cursor_id;
+  row_count_t m_fetch_rows;
+
+  Protocol::Op& snd_cursor_open(Message &msg);
+
+  /*
+    Statistics
+    ----------
+
+    Counters in m_stats are updated by the thread which uses the protocol
+    and can be read by get_stats() from any thread (see Stat_counter).
+
+    To measure command latency, stats_sent() is called for each message
+    sent to the server and puts its kind and send time into the m_cmd_*
+    ring. When stats_received() sees a server message which completes
+    a reply, the oldest entry is removed and its latency recorded. If more
+    than cmd_ring_size commands are waiting for replies, the newest ones
+    are only counted in m_cmd_untimed and their latency is not measured.
+    Member m_rt_pending is set after sending a message and cleared when
+    the next message is received, which completes a round trip.
+  */
+
+  typedef std::chrono::steady_clock clock;
+
+  struct
+  {
+    Stat_counter bytes_sent;
+    Stat_counter bytes_received;
+    Stat_counter msgs_sent;
+    Stat_counter msgs_received;
+    Stat_counter round_trips;
+    Stat_counter rows;
+    Stat_counter fields;
+    Stat_counter rd_buf_reallocs;
+    Stat_counter wr_buf_reallocs;
+    Stat_counter rd_wait_ns;
+    Stat_counter latency[stats_cmd::COUNT][Protocol_stats::latency_buckets];
+  }
+  m_stats;
+
+  enum { cmd_ring_size = 256 };
+
+  struct
+  {
+    stats_cmd::value   kind;
+    clock::time_point  time;
+  }
+  m_cmd_ring[cmd_ring_size];
+
+  unsigned  m_cmd_head;
+  unsigned  m_cmd_count;
+  uint64_t  m_cmd_untimed;
+  bool      m_rt_pending;
+
+  void stats_sent(msg_type_t);
+  void stats_received(msg_type_t);
 
 public:
 
@@ -241,7 +514,12 @@ public:
   };
 
 private:
-  void rd_process();
+  void rd_step();
+  void rd_done();
+  void rd_direct();
+  void rd_process(const byte*);
+  bool rd_compressed();
+  void rd_uncompress(const byte*);
 
   // Pointers to the current send/receive operations
   scoped_ptr<Op> m_snd_op;
@@ -339,7 +617,7 @@ protected:
 
   void do_cancel() { THROW("not implemented"); }
 
-  cdk::api::Event_info* get_event_info() const { return NULL; }
+  const cdk::api::Event_info* get_event_info() const { return NULL; }
 
 protected:
 
@@ -380,10 +658,11 @@ class Op_snd : public Op_base
 {
 public:
 
-  Op_snd(Protocol_impl &proto, msg_type_t type, Message &msg)
+  Op_snd(Protocol_impl &proto, msg_type_t type, Message &msg,
+         bytes prefix = bytes())
     : Op_base(proto)
   {
-    m_proto.write_msg(type, msg);
+    m_proto.write_msg(type, msg, prefix);
   }
 
   bool do_cont()
@@ -400,6 +679,13 @@ public:
     m_completed = true;
   }
 
+  // Report the socket event that pending write operation waits for, if any.
+
+  const cdk::api::Event_info* get_event_info() const
+  {
+    return m_proto.m_wr_op ? m_proto.m_wr_op->waits_for() : NULL;
+  }
+
   size_t do_get_result()
   { THROW("not implemented"); }
 };
@@ -502,10 +788,29 @@ public:
     read_msg(*m_prc);
   }
 
+  /*
+    Report the socket event that pending read operation waits for. If no
+    read operation is pending (the data is already in the read-ahead buffer)
+    the operation can make progress right away and NULL is returned.
+  */
+
+  const cdk::api::Event_info* get_event_info() const
+  {
+    return m_proto.m_rd_op ? m_proto.m_rd_op->waits_for() : NULL;
+  }
+
 protected:
 
   msg_type_t  m_msg_type;
 
+  // Update protocol statistics after decoding a row with given fields.
+
+  void stats_row(col_count_t fields)
+  {
+    m_proto.m_stats.rows.add();
+    m_proto.m_stats.fields.add(fields);
+  }
+
   /*
     Methods controlling processing of messages that can be overridden
     by specializations.
@@ -545,6 +850,19 @@ protected:
   virtual void process_msg(msg_type_t, Message&);
   virtual void do_process_msg(msg_type_t, Message&) {}
 
+  /*
+    Process raw message payload, without parsing it into a protobuf message
+    object first. Specializations can override this method for message types
+    which can be processed directly from the bytes received on the wire.
+    If it returns true, the message is considered processed and process_msg()
+    is not called for it. By default all messages are parsed.
+
+    Note: This method is not used if DEBUG_PROTOBUF is defined, so that all
+    received messages are parsed and can be printed.
+  */
+
+  virtual bool process_raw(msg_type_t, bytes) { return false; }
+
   /**
     This method is called after processing each message to determine
     if operation should continue processing next message or stop.
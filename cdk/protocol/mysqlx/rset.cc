@@ -147,6 +147,17 @@ protected:
     throw_error("Invalid processor used to process server reply");
   }
 
+  /*
+    Row messages are processed directly from the payload bytes, without
+    parsing them into protobuf message objects (see Row_scanner below).
+    Method process_field() passes data of a single field of a row to the
+    row processor, it is used by both raw and protobuf processing paths.
+  */
+
+  bool process_raw(msg_type_t, bytes);
+  void process_row(bytes, Row_processor&);
+  void process_field(col_count_t, bytes, Row_processor&);
+
 };
 
 
@@ -273,8 +284,14 @@ bool Rcv_result_base::process_next()
   <reply> ::= (<rset> <more>)? StmtExecuteOk
   <more> ::= FetchDone
            | FetchDoneMoreResultsets <rset>? <more>
+           | FetchSuspended Row* <more>
   <rset> ::= MetaData+ Row*
 
+  FetchSuspended is sent when reading rows from a cursor (see
+  Protocol::set_cursor()). It ends the current row reading stage, but
+  the operation remains in ROWS state so that more rows can be read after
+  the client requests them with Cursor.Fetch.
+
   Below are few examples of valid message sequences in server reply and how
   they are distrbuted between different processing stages:
   A = reading meta-data, B = reading rows, C = reading final OK.
@@ -371,6 +388,14 @@ Op_rcv::Next_msg Rcv_result_base::do_next_msg(msg_type_t type)
         m_next_state = ROWS;
       break;
 
+    // Cursor opened with no rows in the first batch.
+
+    case msg_type::FetchSuspended:
+      if (0 == m_ccount)
+        return UNEXPECTED;
+      m_next_state = ROWS;
+      break;
+
     /*
       If we see StmtExecuteOk then the meta-data processing stage ends and we
       proceed to the final stage. The message will be part of the next stage.
@@ -435,6 +460,8 @@ Op_rcv::Next_msg Rcv_result_base::do_next_msg(msg_type_t type)
     case msg_type::FetchDoneMoreResultsets:
       m_next_state = MDATA;  // proceed to next result-set
       break;
+    case msg_type::FetchSuspended:
+      break;                 // more rows after next Cursor.Fetch
     default: return UNEXPECTED;
     };
 
@@ -555,6 +582,19 @@ void Rcv_result_base::process_msg_with(Mysqlx::Resultset::FetchDone &msg,
 
 
 
+template<>
+void Rcv_result_base::process_msg_with(Mysqlx::Resultset::FetchSuspended &msg,
+                                       Row_processor &rp)
+{
+  /*
+    Server sent all rows requested from a cursor, but there are more rows
+    in the result-set.
+  */
+  rp.done(false, false);
+}
+
+
+
 template<>
 void Rcv_result_base::process_msg_with(Mysqlx::Resultset::Row &row,
                                        Row_processor &rp)
@@ -569,27 +609,185 @@ void Rcv_result_base::process_msg_with(Mysqlx::Resultset::Row &row,
   for (RepeatedPtrField< ::std::string>::const_iterator it = row.field().begin();
         it != row.field().end(); ++it, ++ccount)
   {
+    process_field(ccount, bytes(*it), rp);
+  }
+
+  stats_row(ccount);
+  rp.row_end(rcount);
+}
+
+
+void Rcv_result_base::process_field(col_count_t ccount, bytes data,
+                                    Row_processor &rp)
+{
+  if (data.size() == 0)
+  {
+    rp.col_null(ccount);
+    return;
+  }
+
+  size_t read_window = rp.col_begin(ccount, data.size());
+  size_t pos= 0;
 
-    if (it->length() == 0)
+  while (data.size() > pos && read_window)
+  {
+    size_t bytes_to_feed = data.size() - pos > read_window ? read_window : data.size() - pos;
+    size_t read_window_new = rp.col_data(ccount, bytes(data.begin() + pos, bytes_to_feed));
+    pos += bytes_to_feed;
+    read_window = read_window_new;
+  }
+
+  rp.col_end(ccount, data.size());
+}
+
+
+/*
+  Scanner for Mysqlx::Resultset::Row messages in protobuf wire format.
+
+  Row message has single repeated field of type bytes (field number 1),
+  which is encoded on the wire as a sequence of key-length-value triples:
+  varint key (field number << 3 | wire type 2), varint length and the field
+  bytes. The scanner walks through the message payload and returns each
+  field as a slice of the payload buffer, so that no data is copied. Other
+  fields, if present, are skipped as the protobuf parser would do.
+
+  Method next() returns false at the end of the payload and throws error
+  if the payload is not a correctly encoded message.
+*/
+
+class Row_scanner
+{
+  byte *m_pos;
+  byte *m_end;
+
+public:
+
+  Row_scanner(bytes payload)
+    : m_pos(payload.begin()), m_end(payload.end())
+  {}
+
+  bool next(bytes &field)
+  {
+    while (m_pos < m_end)
     {
-      rp.col_null(ccount);
-      continue;
+      uint64_t key = read_varint();
+
+      switch (key & 0x07)
+      {
+      case 0: // varint
+        read_varint();
+        break;
+
+      case 1: // fixed64
+        skip(8);
+        break;
+
+      case 2: // length-delimited
+        {
+          uint64_t len = read_varint();
+          if (len > (uint64_t)(m_end - m_pos))
+            parse_error();
+          if (1 == (key >> 3))
+          {
+            field = bytes(m_pos, (size_t)len);
+            m_pos += len;
+            return true;
+          }
+          m_pos += len;
+        }
+        break;
+
+      case 5: // fixed32
+        skip(4);
+        break;
+
+      default:
+        // Note: groups are not used by X protocol messages.
+        parse_error();
+      }
     }
 
-    size_t read_window = rp.col_begin(ccount, it->length());
-    size_t pos= 0;
+    return false;
+  }
+
+private:
+
+  uint64_t read_varint()
+  {
+    uint64_t val = 0;
 
-    while (it->length() > pos && read_window)
+    for (unsigned shift = 0; shift < 64; shift += 7)
     {
-      size_t bytes_to_feed = it->length() - pos > read_window ? read_window : it->length() - pos;
-      size_t read_window_new = rp.col_data(ccount, bytes((byte*)(it->c_str() + pos), bytes_to_feed));
-      pos += read_window;
-      read_window = read_window_new;
+      if (m_pos >= m_end)
+        break;
+      byte b = *m_pos++;
+      val |= (uint64_t)(b & 0x7F) << shift;
+      if (!(b & 0x80))
+        return val;
     }
 
-    rp.col_end(ccount, it->length());
+    parse_error();
+    return 0;
   }
 
+  void skip(size_t len)
+  {
+    if (len > (size_t)(m_end - m_pos))
+      parse_error();
+    m_pos += len;
+  }
+
+  void parse_error()
+  {
+    throw_error(cdkerrc::protobuf_error, "Message could not be parsed");
+  }
+};
+
+
+/*
+  Process Row message directly from its payload. The payload is scanned
+  twice: first to check that it is correctly encoded (so that, as with
+  protobuf parser, nothing is reported to the processor for a bad message)
+  and then to pass fields to the processor.
+*/
+
+bool Rcv_result_base::process_raw(msg_type_t type, bytes payload)
+{
+  if (msg_type::Row != type || ROWS != m_result_state)
+    return false;
+
+  bytes field;
+
+  try {
+    Row_scanner check(payload);
+    while (check.next(field));
+  }
+  catch (...)
+  {
+    save_error();
+    return true;
+  }
+
+  process_row(payload, *static_cast<Row_processor*>(m_prc));
+  return true;
+}
+
+
+void Rcv_result_base::process_row(bytes payload, Row_processor &rp)
+{
+  row_count_t rcount= m_rcount++;
+
+  if(!rp.row_begin(rcount))
+    return; // skip this row if the processor doesn't want it
+
+  Row_scanner scanner(payload);
+  bytes field;
+  col_count_t ccount = 0;
+
+  for (; scanner.next(field); ++ccount)
+    process_field(ccount, field, rp);
+
+  stats_row(ccount);
   rp.row_end(rcount);
 }
 
@@ -171,6 +171,15 @@ Protocol::Op& Protocol::snd_Expect_Close()
 }
 
 
+Protocol::Op& Protocol::snd_SessionReset(bool keep_open)
+{
+  Mysqlx::Session::Reset reset;
+  if (keep_open)
+    reset.set_keep_open(true);
+  return get_impl().snd_start(reset, msg_type::cli_SessionReset);
+}
+
+
 class Rcv_auth_base : public Op_rcv
 {
 public:
@@ -33,6 +33,9 @@
 
 PUSH_PB_WARNINGS
 #include "protobuf/mysqlx_sql.pb.h"
+#include "protobuf/mysqlx_crud.pb.h"
+#include "protobuf/mysqlx_prepare.pb.h"
+#include "protobuf/mysqlx_cursor.pb.h"
 POP_PB_WARNINGS
 
 
@@ -98,82 +101,202 @@ Protocol::Op& Protocol_server::snd_StmtExecuteOk()
   return get_impl().snd_start(ok, msg_type::StmtExecuteOk);
 }
 
-#if 0
-
-Protocol::Op& Protocol::snd_PrepareStmt(stmt_id_t id, const string &stmt)
-{
 /*
-  Mysqlx::Sql::PrepareStmt prep_stmt;
+  Prepared statements
+  ===================
+*/
 
-  prep_stmt.set_stmt_id(id);
-  prep_stmt.set_stmt(stmt);
 
-  return get_impl().snd_message(prep_stmt, msg_type::cli_PrepareStmt);
+/*
+  Wrap statement message in Prepare message which prepares it under id
+  stored in m_prepare_id. Parameter values are removed from the statement
+  (they are sent with Execute message instead).
+
+  Note: The statement message is moved into the Prepare message with
+  Swap() to avoid copying it.
 */
 
-  // Code is commented out because of missing prepare statements in .proto files
-  throw_error("Not implemented");
+Protocol::Op& Protocol_impl::snd_prepare(Message &msg, msg_type_t msg_type)
+{
+  Mysqlx::Prepare::Prepare prepare;
+  Mysqlx::Prepare::Prepare::OneOfMessage &stmt = *prepare.mutable_stmt();
+
+  prepare.set_stmt_id(m_prepare_id);
+  m_prepare_id = 0;
 
-  // this is to keep the compiler happy
-  return get_impl().snd_message(Mysqlx::Sql::StmtExecute(), msg_type::cli_StmtExecute);
+  switch (msg_type)
+  {
+  case msg_type::cli_StmtExecute:
+    stmt.set_type(Mysqlx::Prepare::Prepare::OneOfMessage::STMT);
+    stmt.mutable_stmt_execute()->Swap(
+      static_cast<Mysqlx::Sql::StmtExecute*>(&msg)
+    );
+    stmt.mutable_stmt_execute()->clear_args();
+    break;
+
+  case msg_type::cli_CrudFind:
+    stmt.set_type(Mysqlx::Prepare::Prepare::OneOfMessage::FIND);
+    stmt.mutable_find()->Swap(static_cast<Mysqlx::Crud::Find*>(&msg));
+    stmt.mutable_find()->clear_args();
+    break;
+
+  case msg_type::cli_CrudInsert:
+    stmt.set_type(Mysqlx::Prepare::Prepare::OneOfMessage::INSERT);
+    stmt.mutable_insert()->Swap(static_cast<Mysqlx::Crud::Insert*>(&msg));
+    stmt.mutable_insert()->clear_args();
+    break;
+
+  case msg_type::cli_CrudUpdate:
+    stmt.set_type(Mysqlx::Prepare::Prepare::OneOfMessage::UPDATE);
+    stmt.mutable_update()->Swap(static_cast<Mysqlx::Crud::Update*>(&msg));
+    stmt.mutable_update()->clear_args();
+    break;
+
+  case msg_type::cli_CrudDelete:
+    stmt.set_type(Mysqlx::Prepare::Prepare::OneOfMessage::DELETE);
+    stmt.mutable_delete_()->Swap(static_cast<Mysqlx::Crud::Delete*>(&msg));
+    stmt.mutable_delete_()->clear_args();
+    break;
+
+  default:
+    THROW("Only statements and CRUD operations can be prepared");
+  }
+
+  return snd_start(prepare, msg_type::cli_PreparePrepare);
 }
 
 
-// TODO: param_row should be supplied as well
-Protocol::Op& Protocol::snd_PreparedStmtExecute(stmt_id_t id, cursor_id_t cid)
+void Protocol::set_prepare_id(stmt_id_t id)
 {
-/*
-  Mysqlx::Sql::PreparedStmtExecute prep_stmt_ex;
+  get_impl().set_prepare_id(id);
+}
 
-  prep_stmt_ex.set_stmt_id(id);
-  prep_stmt_ex.set_cursor_id(cid);
 
-  return get_impl().snd_message(prep_stmt_ex, msg_type::cli_PreparedStmtExecute);
+/*
+  Builder which stores values of named parameters of a CRUD operation
+  as arguments of Execute message. Values are stored in the order in which
+  they are reported by Args_map, which is also the order in which
+  placeholder positions were assigned when the operation was prepared
+  (see Placeholder_conv_imp in crud.cc).
 */
 
-  // Code is commented out because of missing prepare statements in .proto files
-  throw_error("Not implemented");
+class Exec_args_builder
+  : public api::Args_map::Processor
+{
+  Mysqlx::Prepare::Execute &m_msg;
+  Any_builder m_builder;
+
+public:
+
+  Exec_args_builder(Mysqlx::Prepare::Execute &msg)
+    : m_msg(msg)
+  {}
+
+  Any_prc* key_val(const string&)
+  {
+    m_builder.reset(*m_msg.add_args());
+    return &m_builder;
+  }
+};
+
+
+template<>
+struct Arr_msg_traits<Mysqlx::Prepare::Execute>
+{
+  typedef Mysqlx::Prepare::Execute Array;
+  typedef Mysqlx::Datatypes::Any   Msg;
+
+  static Msg& add_element(Array &arr)
+  {
+    return *arr.add_args();
+  }
+};
+
 
-  // this is to keep the compiler happy
-  return get_impl().snd_message(Mysqlx::Sql::StmtExecute(), msg_type::cli_StmtExecute);
+Protocol::Op& Protocol::snd_PrepareExecute(stmt_id_t id,
+                                           const api::Args_map *args)
+{
+  Mysqlx::Prepare::Execute execute;
+
+  execute.set_stmt_id(id);
+
+  if (args)
+  {
+    Exec_args_builder args_builder(execute);
+    args->process(args_builder);
+  }
+
+  return get_impl().snd_start(execute, msg_type::cli_PrepareExecute);
 }
 
 
-Protocol::Op& Protocol::snd_CursorClose(cursor_id_t cid)
+Protocol::Op& Protocol::snd_PrepareExecute(stmt_id_t id,
+                                           const api::Any_list *args)
 {
-/*
-  Mysqlx::Sql::CursorClose cur_close;
-  cur_close.set_cursor_id(cid);
+  Mysqlx::Prepare::Execute execute;
 
-  return get_impl().snd_message(cur_close, msg_type::cli_CursorClose);
-*/
+  execute.set_stmt_id(id);
 
-  // Code is commented out because of missing prepare statements in .proto files
-  throw_error("Not implemented");
+  if (args)
+  {
+    Array_builder<Any_builder, Mysqlx::Prepare::Execute> args_builder;
+    args_builder.reset(execute);
+    args->process(args_builder);
+  }
 
-  // this is to keep the compiler happy
-  return get_impl().snd_message(Mysqlx::Sql::StmtExecute(), msg_type::cli_StmtExecute);
+  return get_impl().snd_start(execute, msg_type::cli_PrepareExecute);
 }
 
 
-Protocol::Op& Protocol::snd_PreparedStmtClose(stmt_id_t id)
+Protocol::Op& Protocol::snd_PrepareDeallocate(stmt_id_t id)
 {
-/*
-  Mysqlx::Sql::PreparedStmtClose stmt_close;
-  stmt_close.set_stmt_id(id);
+  Mysqlx::Prepare::Deallocate deallocate;
+  deallocate.set_stmt_id(id);
+  return get_impl().snd_start(deallocate, msg_type::cli_PrepareDeallocate);
+}
 
-  return get_impl().snd_message(stmt_close, msg_type::cli_PreparedStmtClose);
-*/
 
-  // Code is commented out because of missing prepare statements in .proto files
-  throw_error("Not implemented");
+Protocol::Op& Protocol_impl::snd_cursor_open(Message &msg)
+{
+  Mysqlx::Cursor::Open open;
+  Mysqlx::Cursor::Open::OneOfMessage &stmt = *open.mutable_stmt();
+
+  open.set_cursor_id(m_cursor_id);
+  open.set_fetch_rows(m_fetch_rows);
+  m_cursor_id = 0;
 
-  // this is to keep the compiler happy
-  return get_impl().snd_message(Mysqlx::Sql::StmtExecute(), msg_type::cli_StmtExecute);
+  stmt.set_type(Mysqlx::Cursor::Open::OneOfMessage::PREPARE_EXECUTE);
+  stmt.mutable_prepare_execute()->Swap(
+    static_cast<Mysqlx::Prepare::Execute*>(&msg)
+  );
 
+  return snd_start(open, msg_type::cli_CursorOpen);
 }
 
-#endif
+
+void Protocol::set_cursor(cursor_id_t cid, row_count_t fetch_rows)
+{
+  get_impl().set_cursor(cid, fetch_rows);
+}
+
+
+Protocol::Op& Protocol::snd_CursorFetch(cursor_id_t cid,
+                                        row_count_t fetch_rows)
+{
+  Mysqlx::Cursor::Fetch fetch;
+  fetch.set_cursor_id(cid);
+  fetch.set_fetch_rows(fetch_rows);
+  return get_impl().snd_start(fetch, msg_type::cli_CursorFetch);
+}
+
+
+Protocol::Op& Protocol::snd_CursorClose(cursor_id_t cid)
+{
+  Mysqlx::Cursor::Close close;
+  close.set_cursor_id(cid);
+  get_impl().rcv_reset();
+  return get_impl().snd_start(close, msg_type::cli_CursorClose);
+}
 
 
 }}}  // cdk::protocol::mysqlx
@@ -26,13 +26,42 @@
 
 
 #include "test.h"
-//#include "expr.h"
+#include "expr.h"
 #include <list>
+#include <atomic>
+#include <chrono>
 
 
 #include "json_parser.h"
 #include "../../../mysqlx/converters.h"  // for mysqlx::JSON_converter
 
+/*
+  Counting memory allocations
+  ===========================
+
+  Global operator new is replaced by one which counts all allocations made
+  by the process. This is used to check how many allocations are done
+  when processing incoming rows.
+*/
+
+static std::atomic<size_t> alloc_count(0);
+
+void* operator new(size_t size)
+{
+  ++alloc_count;
+  void *ptr = malloc(size ? size : 1);
+  if (!ptr)
+    throw std::bad_alloc();
+  return ptr;
+}
+
+void operator delete(void *ptr) NOEXCEPT
+{
+  free(ptr);
+}
+
+
+
 namespace cdk {
 namespace test {
 
@@ -468,5 +497,795 @@ TEST(Protocol_mysqlx_msg, insert)
   CATCH_TEST_GENERIC;
 }
 
-}}  // cdk::test
+// -------------------------------------------------------------------------
+
+/*
+  Check messages sent when a statement is prepared and then executed. After
+  set_prepare_id() the next command is wrapped in a Prepare message without
+  its arguments. Each execution of the prepared statement sends only Execute
+  message with the arguments.
+*/
+
+struct Prepare_args : public protocol::mysqlx::api::Any_list
+{
+  void process(Processor &prc) const
+  {
+    prc.list_begin();
+    safe_prc(prc)->list_el()->scalar()->num((uint64_t)7);
+    prc.list_end();
+  }
+};
+
+
+struct Prepare_checker : public Msg_processor
+{
+  msg_type_t m_type;
+  Message   *m_msg;
+
+  Prepare_checker() : m_msg(NULL)
+  {}
+
+  ~Prepare_checker()
+  {
+    delete m_msg;
+  }
+
+  void process_msg(msg_type_t type, Message &msg)
+  {
+    m_type = type;
+    delete m_msg;
+    m_msg = msg.New();
+    m_msg->ParseFromString(msg.SerializeAsString());
+  }
+};
+
+
+TEST(Protocol_mysqlx_msg, prepare)
+{
+  TRY_TEST_GENERIC
+  {
+    Test_server<1024> srv;
+    Protocol proto(srv.get_connection());
+    Prepare_args args;
+    Prepare_checker checker;
+
+    cout <<"== Sending Prepare message" <<endl;
+
+    proto.set_prepare_id(1);
+    proto.snd_StmtExecute("sql", "SELECT ?", &args).wait();
+    srv.rcv_msg(checker);
+
+    ASSERT_EQ(msg_type::cli_PreparePrepare, checker.m_type);
+    {
+      Mysqlx::Prepare::Prepare &prep
+        = static_cast<Mysqlx::Prepare::Prepare&>(*checker.m_msg);
+      EXPECT_EQ(1U, prep.stmt_id());
+      EXPECT_EQ(Mysqlx::Prepare::Prepare::OneOfMessage::STMT, prep.stmt().type());
+      EXPECT_EQ("SELECT ?", prep.stmt().stmt_execute().stmt());
+      EXPECT_EQ(0, prep.stmt().stmt_execute().args_size());
+    }
+
+    cout <<"== Executing prepared statement" <<endl;
+
+    for (unsigned i = 0; i < 2; ++i)
+    {
+      proto.snd_PrepareExecute(1, &args).wait();
+      srv.rcv_msg(checker);
+
+      ASSERT_EQ(msg_type::cli_PrepareExecute, checker.m_type);
+      Mysqlx::Prepare::Execute &exec
+        = static_cast<Mysqlx::Prepare::Execute&>(*checker.m_msg);
+      EXPECT_EQ(1U, exec.stmt_id());
+      ASSERT_EQ(1, exec.args_size());
+      EXPECT_EQ(7U, exec.args(0).scalar().v_unsigned_int());
+    }
+
+    cout <<"== Next statement is not prepared" <<endl;
+
+    proto.snd_StmtExecute("sql", "SELECT ?", &args).wait();
+    srv.rcv_msg(checker);
+    EXPECT_EQ(msg_type::cli_StmtExecute, checker.m_type);
+
+    proto.snd_PrepareDeallocate(1).wait();
+    srv.rcv_msg(checker);
+    ASSERT_EQ(msg_type::cli_PrepareDeallocate, checker.m_type);
+    EXPECT_EQ(1U,
+      static_cast<Mysqlx::Prepare::Deallocate&>(*checker.m_msg).stmt_id());
+
+    cout <<"== Done!" <<endl;
+  }
+  CATCH_TEST_GENERIC;
+}
+
+// -------------------------------------------------------------------------
+
+/*
+  Benchmark which sends a result-set with many rows from the test server
+  and reports number of memory allocations and time per row on the client
+  side.
+*/
+
+struct Row_counter : public Row_handler
+{
+  row_count_t m_rows;
+  size_t      m_bytes;
+
+  Row_counter() : m_rows(0), m_bytes(0)
+  {}
+
+  void message_received(size_t)
+  {}
+
+  bool row_begin(row_count_t)
+  { return true; }
+
+  void row_end(row_count_t)
+  {
+    m_rows++;
+  }
+
+  void col_null(col_count_t)
+  {}
+
+  size_t col_begin(col_count_t, size_t data_len)
+  {
+    return data_len;
+  }
+
+  size_t col_data(col_count_t, bytes data)
+  {
+    m_bytes += data.size();
+    return 0;
+  }
+
+  void col_end(col_count_t, size_t)
+  {}
+
+  void done(bool, bool)
+  {}
+};
+
+
+TEST(Protocol_mysqlx_msg, rows_alloc)
+{
+  typedef Test_server<16*1024*1024> Server;
+
+  const unsigned row_count = 100000;
+  const unsigned col_count = 3;
+
+  TRY_TEST_GENERIC
+  {
+    /*
+      Note: objects of large size can not be allocated on stack.
+      Hence we use heap allocated objects.
+    */
+
+    scoped_ptr<Server> srv(new Server());
+    Protocol proto(srv->get_connection());
+
+    cout <<"== Sending result-set with " <<row_count <<" rows" <<endl;
+
+    for (unsigned col = 0; col < col_count; ++col)
+    {
+      Mysqlx::Resultset::ColumnMetaData md;
+      md.set_type(Mysqlx::Resultset::ColumnMetaData::BYTES);
+      md.set_name("col");
+      srv->snd_msg(msg_type::ColumnMetaData, md);
+    }
+
+    Mysqlx::Resultset::Row row;
+    row.add_field("1234567");
+    row.add_field("abcdefgh");
+    row.add_field("");
+
+    for (unsigned r = 0; r < row_count; ++r)
+      srv->snd_msg(msg_type::Row, row);
+
+    Mysqlx::Resultset::FetchDone done;
+    srv->snd_msg(msg_type::FetchDone, done);
+
+    Mysqlx::Sql::StmtExecuteOk ok;
+    srv->snd_msg(msg_type::StmtExecuteOk, ok);
+
+    cout <<"== Reading rows" <<endl;
+
+    Mdata_handler mdh;
+    proto.rcv_MetaData(mdh).wait();
+
+    Row_counter rc;
+
+    uint64_t reads = proto.get_rd_count();
+    size_t allocs = alloc_count;
+    std::chrono::steady_clock::time_point start
+      = std::chrono::steady_clock::now();
+
+    proto.rcv_Rows(rc).wait();
+
+    std::chrono::steady_clock::time_point end
+      = std::chrono::steady_clock::now();
+    allocs = alloc_count - allocs;
+    reads = proto.get_rd_count() - reads;
+
+    Stmt_handler sh;
+    proto.rcv_StmtReply(sh).wait();
+
+    EXPECT_EQ(row_count, rc.m_rows);
+    EXPECT_EQ(row_count * 15, rc.m_bytes);
+
+    double ns = (double)std::chrono::duration_cast<std::chrono::nanoseconds>(
+                  end - start).count();
+
+    cout <<"== Allocations per row: " <<(double)allocs / row_count <<endl;
+    cout <<"== Time per row: " <<ns / row_count <<" ns" <<endl;
+    cout <<"== Read operations: " <<reads <<endl;
+
+    /*
+      Message objects are re-used and many rows are read from the stream
+      with a single read operation, so there should be much less allocations
+      and read operations than rows.
+    */
+
+    EXPECT_GT((size_t)row_count / 10, allocs);
+    EXPECT_GT((uint64_t)row_count / 100, reads);
+  }
+  CATCH_TEST_GENERIC;
+}
+
+/*
+  Check that rows are correctly reported to the row processor, including
+  NULL values, long fields and unknown fields which should be skipped.
+*/
+
+struct Row_collector : public Row_counter
+{
+  std::vector<std::string> m_fields;
+  std::string m_buf;
+
+  void col_null(col_count_t)
+  {
+    m_fields.push_back("<null>");
+  }
+
+  size_t col_begin(col_count_t, size_t)
+  {
+    m_buf.clear();
+    return 16;
+  }
+
+  size_t col_data(col_count_t, bytes data)
+  {
+    m_buf.append((const char*)data.begin(), data.size());
+    return 16;
+  }
+
+  void col_end(col_count_t, size_t len)
+  {
+    EXPECT_EQ(len, m_buf.size());
+    m_fields.push_back(m_buf);
+  }
+};
+
+
+TEST(Protocol_mysqlx_msg, rows)
+{
+  TRY_TEST_GENERIC
+  {
+    Test_server<1024> srv;
+    Protocol proto(srv.get_connection());
+
+    /*
+      Use small read-ahead buffer so that some messages do not fit into it
+      and others are split between read operations.
+    */
+
+    proto.set_rd_ahead_size(16);
+
+    Mysqlx::Resultset::ColumnMetaData md;
+    md.set_type(Mysqlx::Resultset::ColumnMetaData::BYTES);
+    md.set_name("col");
+    srv.snd_msg(msg_type::ColumnMetaData, md);
+    srv.snd_msg(msg_type::ColumnMetaData, md);
+
+    const std::string long_field(300, 'x');
+
+    Mysqlx::Resultset::Row row;
+    row.add_field("foo");
+    row.add_field("");
+    srv.snd_msg(msg_type::Row, row);
+
+    row.Clear();
+    row.add_field(long_field);
+    row.mutable_unknown_fields()->AddVarint(7, 1234567);
+    row.mutable_unknown_fields()->AddLengthDelimited(8, "unknown");
+    row.mutable_unknown_fields()->AddFixed32(9, 7);
+    row.add_field("bar");
+    srv.snd_msg(msg_type::Row, row);
+
+    Mysqlx::Resultset::FetchDone done;
+    srv.snd_msg(msg_type::FetchDone, done);
+
+    Mysqlx::Sql::StmtExecuteOk ok;
+    srv.snd_msg(msg_type::StmtExecuteOk, ok);
+
+    Mdata_handler mdh;
+    proto.rcv_MetaData(mdh).wait();
+
+    Row_collector rc;
+    proto.rcv_Rows(rc).wait();
+
+    Stmt_handler sh;
+    proto.rcv_StmtReply(sh).wait();
+
+    EXPECT_EQ(2U, rc.m_rows);
+    ASSERT_EQ(4U, rc.m_fields.size());
+    EXPECT_EQ("foo", rc.m_fields[0]);
+    EXPECT_EQ("<null>", rc.m_fields[1]);
+    EXPECT_EQ(long_field, rc.m_fields[2]);
+    EXPECT_EQ("bar", rc.m_fields[3]);
+  }
+  CATCH_TEST_GENERIC;
+}
+
+
+/*
+  Check reading rows from a server-side cursor in batches. Server sends
+  FetchSuspended after each batch except the last one, for which rcv_Rows()
+  reports that not all rows were sent yet.
+*/
+
+struct Row_batch : public Row_collector
+{
+  bool m_eod;
+
+  Row_batch() : m_eod(false)
+  {}
+
+  void done(bool eod, bool)
+  {
+    m_eod = eod;
+  }
+};
+
+
+TEST(Protocol_mysqlx_msg, cursor)
+{
+  TRY_TEST_GENERIC
+  {
+    Test_server<4096> srv;
+    Protocol proto(srv.get_connection());
+    Prepare_args args;
+    Prepare_checker checker;
+
+    cout <<"== Opening cursor" <<endl;
+
+    proto.set_cursor(3, 2);
+    proto.snd_PrepareExecute(1, &args).wait();
+    srv.rcv_msg(checker);
+
+    ASSERT_EQ(msg_type::cli_CursorOpen, checker.m_type);
+    {
+      Mysqlx::Cursor::Open &open
+        = static_cast<Mysqlx::Cursor::Open&>(*checker.m_msg);
+      EXPECT_EQ(3U, open.cursor_id());
+      EXPECT_EQ(2U, open.fetch_rows());
+      EXPECT_EQ(Mysqlx::Cursor::Open::OneOfMessage::PREPARE_EXECUTE,
+                open.stmt().type());
+      EXPECT_EQ(1U, open.stmt().prepare_execute().stmt_id());
+      EXPECT_EQ(1, open.stmt().prepare_execute().args_size());
+    }
+
+    Mysqlx::Resultset::ColumnMetaData md;
+    md.set_type(Mysqlx::Resultset::ColumnMetaData::BYTES);
+    md.set_name("col");
+    srv.snd_msg(msg_type::ColumnMetaData, md);
+
+    Mysqlx::Resultset::Row row;
+    row.add_field("a");
+    srv.snd_msg(msg_type::Row, row);
+    srv.snd_msg(msg_type::Row, row);
+
+    Mysqlx::Resultset::FetchSuspended suspended;
+    srv.snd_msg(msg_type::FetchSuspended, suspended);
+
+    Mdata_handler mdh;
+    proto.rcv_MetaData(mdh).wait();
+
+    Row_batch rb;
+    proto.rcv_Rows(rb).wait();
+
+    EXPECT_EQ(2U, rb.m_rows);
+    EXPECT_FALSE(rb.m_eod);
+
+    cout <<"== Fetching next batch" <<endl;
+
+    proto.snd_CursorFetch(3, 5).wait();
+    srv.rcv_msg(checker);
+
+    ASSERT_EQ(msg_type::cli_CursorFetch, checker.m_type);
+    {
+      Mysqlx::Cursor::Fetch &fetch
+        = static_cast<Mysqlx::Cursor::Fetch&>(*checker.m_msg);
+      EXPECT_EQ(3U, fetch.cursor_id());
+      EXPECT_EQ(5U, fetch.fetch_rows());
+    }
+
+    row.Clear();
+    row.add_field("b");
+    srv.snd_msg(msg_type::Row, row);
+
+    Mysqlx::Resultset::FetchDone done;
+    srv.snd_msg(msg_type::FetchDone, done);
+
+    Mysqlx::Sql::StmtExecuteOk ok;
+    srv.snd_msg(msg_type::StmtExecuteOk, ok);
+
+    proto.rcv_Rows(rb).wait();
+
+    EXPECT_EQ(3U, rb.m_rows);
+    EXPECT_TRUE(rb.m_eod);
+    ASSERT_EQ(3U, rb.m_fields.size());
+    EXPECT_EQ("b", rb.m_fields[2]);
+
+    Stmt_handler sh;
+    proto.rcv_StmtReply(sh).wait();
+
+    cout <<"== Next execution does not open cursor" <<endl;
+
+    proto.snd_PrepareExecute(1, &args).wait();
+    srv.rcv_msg(checker);
+    EXPECT_EQ(msg_type::cli_PrepareExecute, checker.m_type);
+
+    cout <<"== Done!" <<endl;
+  }
+  CATCH_TEST_GENERIC;
+}
+
+
+/*
+  Check protocol statistics collected while executing a statement whose
+  result has a row which does not fit into the initial input buffer.
+*/
+
+TEST(Protocol_mysqlx_msg, stats)
+{
+  using protocol::mysqlx::Protocol_stats;
+  using protocol::mysqlx::stats_cmd;
+
+  TRY_TEST_GENERIC
+  {
+    Test_server<4096> srv;
+    Protocol proto(srv.get_connection());
+    proto.set_rd_ahead_size(16);
+
+    Protocol_stats stats;
+    proto.get_stats(stats);
+    EXPECT_EQ(0U, stats.msgs_sent);
+    EXPECT_EQ(0U, stats.msgs_received);
+
+    proto.snd_StmtExecute("sql", "SELECT 1", NULL).wait();
+
+    Prepare_checker checker;
+    srv.rcv_msg(checker);
+    ASSERT_EQ(msg_type::cli_StmtExecute, checker.m_type);
+
+    size_t bytes = 0;
+
+    Mysqlx::Resultset::ColumnMetaData md;
+    md.set_type(Mysqlx::Resultset::ColumnMetaData::BYTES);
+    md.set_name("col");
+    srv.snd_msg(msg_type::ColumnMetaData, md);
+    srv.snd_msg(msg_type::ColumnMetaData, md);
+    bytes += 2 * (5 + md.ByteSize());
+
+    Mysqlx::Resultset::Row row;
+    row.add_field("foo");
+    row.add_field("");
+    srv.snd_msg(msg_type::Row, row);
+    bytes += 5 + row.ByteSize();
+
+    row.Clear();
+    row.add_field(std::string(1000, 'x'));
+    row.add_field("bar");
+    srv.snd_msg(msg_type::Row, row);
+    bytes += 5 + row.ByteSize();
+
+    Mysqlx::Resultset::FetchDone done;
+    srv.snd_msg(msg_type::FetchDone, done);
+    bytes += 5 + done.ByteSize();
+
+    Mysqlx::Sql::StmtExecuteOk ok;
+    srv.snd_msg(msg_type::StmtExecuteOk, ok);
+    bytes += 5 + ok.ByteSize();
+
+    Mdata_handler mdh;
+    proto.rcv_MetaData(mdh).wait();
+
+    Row_counter rc;
+    proto.rcv_Rows(rc).wait();
+
+    Stmt_handler sh;
+    proto.rcv_StmtReply(sh).wait();
+
+    proto.get_stats(stats);
+
+    EXPECT_EQ(1U, stats.msgs_sent);
+    EXPECT_EQ(5U + checker.m_msg->ByteSize(), stats.bytes_sent);
+    EXPECT_EQ(6U, stats.msgs_received);
+    EXPECT_EQ(bytes, stats.bytes_received);
+    EXPECT_EQ(1U, stats.round_trips);
+    EXPECT_EQ(2U, stats.rows);
+    EXPECT_EQ(4U, stats.fields);
+    EXPECT_EQ(1U, stats.rd_buf_reallocs);
+    EXPECT_EQ(0U, stats.wr_buf_reallocs);
+
+    uint64_t count = 0;
+    for (unsigned kind = 0; kind < stats_cmd::COUNT; ++kind)
+      for (unsigned i = 0; i < Protocol_stats::latency_buckets; ++i)
+      {
+        if (stats_cmd::SQL == kind)
+          count += stats.latency[kind][i];
+        else
+          EXPECT_EQ(0U, stats.latency[kind][i]);
+      }
+
+    EXPECT_EQ(1U, count);
+  }
+  CATCH_TEST_GENERIC;
+}
+
+
+// -------------------------------------------------------------------------
+
+/*
+  Check that messages are correctly exchanged when compression is enabled
+  on both sides, for each compression algorithm supported by this build.
+  Large result-set rows are compressed one by one while small client
+  messages are combined into a single compressed frame. Both direct reads
+  and reads through small read-ahead buffer are tested.
+*/
+
+TEST(Protocol_mysqlx_msg, compression)
+{
+  typedef Test_server<1024*1024> Server;
+  using protocol::mysqlx::compression_type;
+  using protocol::mysqlx::compression_supported;
+  using protocol::mysqlx::compression_name;
+
+  const compression_type::value types[] = {
+    compression_type::DEFLATE,
+    compression_type::LZ4,
+    compression_type::ZSTD
+  };
+
+  const unsigned row_count = 100;
+  const std::string field(2000, 'x');
+  const string stmt(std::string(3000, ' ') + "SELECT 1");
+
+  TRY_TEST_GENERIC
+  {
+    for (compression_type::value type : types)
+    for (size_t ra_size : { (size_t)16, (size_t)(64*1024) })
+    {
+      if (!compression_supported(type))
+      {
+        cout <<"== Compression " <<compression_name(type)
+             <<" not supported" <<endl;
+        continue;
+      }
+
+      cout <<"== Compression " <<compression_name(type)
+           <<", read-ahead buffer: " <<ra_size <<endl;
+
+      scoped_ptr<Server> srv(new Server());
+      Protocol proto(srv->get_connection());
+
+      srv->set_compression(type, 64);
+      proto.set_compression(type, 64, 3);
+      proto.set_rd_ahead_size(ra_size);
+
+      Mysqlx::Resultset::ColumnMetaData md;
+      md.set_type(Mysqlx::Resultset::ColumnMetaData::BYTES);
+      md.set_name("col");
+      srv->snd_msg(msg_type::ColumnMetaData, md);
+
+      Mysqlx::Resultset::Row row;
+      row.add_field(field);
+
+      for (unsigned r = 0; r < row_count; ++r)
+        srv->snd_msg(msg_type::Row, row);
+
+      Mysqlx::Resultset::FetchDone done;
+      srv->snd_msg(msg_type::FetchDone, done);
+
+      Mysqlx::Sql::StmtExecuteOk ok;
+      srv->snd_msg(msg_type::StmtExecuteOk, ok);
+
+      Mdata_handler mdh;
+      proto.rcv_MetaData(mdh).wait();
+
+      Row_counter rc;
+      proto.rcv_Rows(rc).wait();
+
+      Stmt_handler sh;
+      proto.rcv_StmtReply(sh).wait();
+
+      EXPECT_EQ(row_count, rc.m_rows);
+      EXPECT_EQ(row_count * field.size(), rc.m_bytes);
+
+      // Three client messages are combined into one compressed frame.
+
+      srv->reset();
+      proto.snd_StmtExecute("sql", stmt, NULL).wait();
+      proto.snd_CursorFetch(1, 2).wait();
+      proto.snd_StmtExecute("sql", stmt, NULL).wait();
+
+      Prepare_checker checker;
+
+      srv->rcv_msg(checker);
+      EXPECT_EQ(msg_type::cli_StmtExecute, checker.m_type);
+      srv->rcv_msg(checker);
+      EXPECT_EQ(msg_type::cli_CursorFetch, checker.m_type);
+      srv->rcv_msg(checker);
+      ASSERT_EQ(msg_type::cli_StmtExecute, checker.m_type);
+      EXPECT_EQ(stmt.length(),
+        static_cast<Mysqlx::Sql::StmtExecute&>(*checker.m_msg).stmt().size());
+    }
+
+    cout <<"== Compressed frame seen by server without compression" <<endl;
+
+    for (compression_type::value type : types)
+    {
+      if (!compression_supported(type))
+        continue;
+
+      Test_server<16*1024> srv;
+      Protocol proto(srv.get_connection());
+
+      proto.set_compression(type, 64);
+      proto.snd_StmtExecute("sql", stmt, NULL).wait();
+
+      Prepare_checker checker;
+      srv.rcv_msg(checker);
+
+      ASSERT_EQ(msg_type::cli_Compression, checker.m_type);
+      Mysqlx::Connection::Compression &cmp
+        = static_cast<Mysqlx::Connection::Compression&>(*checker.m_msg);
+      EXPECT_LT(stmt.length(), cmp.uncompressed_size());
+      EXPECT_GT(stmt.length() / 10, cmp.payload().size());
+    }
+
+    cout <<"== Done!" <<endl;
+  }
+  CATCH_TEST_GENERIC;
+}
+
+
+// -------------------------------------------------------------------------
+
+/*
+  Check that CRUD command sent using Cmd_cache is the same as the command
+  built from scratch. When the cache is filled, only values of named
+  parameters are serialized. Cache is not used if parameter names change
+  or if the command is being prepared.
+*/
+
+struct Cached_find : public protocol::mysqlx::Find_spec
+{
+  protocol::mysqlx::Db_obj m_obj;
+  const Expression *m_expr;
 
+  Cached_find(const protocol::mysqlx::Db_obj &obj, const Expression *expr)
+    : m_obj(obj), m_expr(expr)
+  {}
+
+  const Db_obj& obj() const { return m_obj; }
+  const Expression* select() const { return m_expr; }
+  const Order_by* order() const { return NULL; }
+  const Limit* limit() const { return NULL; }
+  const Projection* project() const { return NULL; }
+  const Expr_list* group_by() const { return NULL; }
+  const Expression* having() const { return NULL; }
+  Lock_mode_value locking() const { return Lock_mode_value::NONE; }
+};
+
+
+TEST(Protocol_mysqlx_msg, cmd_cache)
+{
+  using namespace proto::expr;
+  using protocol::mysqlx::Cmd_cache;
+  using protocol::mysqlx::DOCUMENT;
+
+  TRY_TEST_GENERIC
+  {
+    Test_server<4096> srv;
+    Protocol proto(srv.get_connection());
+    Prepare_checker checker;
+    Cmd_cache cache;
+
+    Op crit("&&",
+      Op(">", Field("a"), Parameter("lo")),
+      Op("<", Field("a"), Parameter("hi"))
+    );
+    Cached_find find(Db_obj("coll", "db"), &crit);
+
+    // Serialized Find command sent without using the cache.
+
+    auto full_find = [&](const Args_map &args) -> std::string
+    {
+      proto.snd_Find(DOCUMENT, find, &args).wait();
+      srv.rcv_msg(checker);
+      EXPECT_EQ(msg_type::cli_CrudFind, checker.m_type);
+      return checker.m_msg->SerializeAsString();
+    };
+
+    auto cached_find = [&](const Args_map &args) -> std::string
+    {
+      proto.snd_Find(DOCUMENT, find, &args, &cache).wait();
+      srv.rcv_msg(checker);
+      EXPECT_EQ(msg_type::cli_CrudFind, checker.m_type);
+      return checker.m_msg->SerializeAsString();
+    };
+
+    for (int64_t i = 0; i < 3; ++i)
+    {
+      cout <<"== Execution " <<i <<endl;
+
+      Args_map args;
+      args.add("hi", Param_Number(i + 10));
+      args.add("lo", Param_Number(i));
+
+      EXPECT_EQ(full_find(args), cached_find(args));
+      EXPECT_FALSE(cache.empty());
+
+      Mysqlx::Crud::Find &msg
+        = static_cast<Mysqlx::Crud::Find&>(*checker.m_msg);
+      ASSERT_EQ(2, msg.args_size());
+      EXPECT_EQ(i + 10, msg.args(0).v_signed_int());
+      EXPECT_EQ(i, msg.args(1).v_signed_int());
+      EXPECT_EQ("coll", msg.collection().name());
+    }
+
+    cout <<"== Different parameters" <<endl;
+
+    {
+      Args_map args;
+      args.add("hi", Param_Number((int64_t)7));
+      args.add("lo", Param_Number((int64_t)1));
+      args.add("x", Param_Number((int64_t)3));
+
+      EXPECT_EQ(full_find(args), cached_find(args));
+      EXPECT_EQ(3, static_cast<Mysqlx::Crud::Find&>(*checker.m_msg).args_size());
+
+      Args_map args1;
+      args1.add("hi", Param_Number((int64_t)7));
+      args1.add("lo", Param_Number((int64_t)1));
+
+      EXPECT_EQ(full_find(args1), cached_find(args1));
+      EXPECT_EQ(full_find(args1), cached_find(args1));
+    }
+
+    cout <<"== Cache not used when preparing" <<endl;
+
+    {
+      Args_map args;
+      args.add("hi", Param_Number((int64_t)7));
+      args.add("lo", Param_Number((int64_t)1));
+
+      proto.set_prepare_id(1);
+      proto.snd_Find(DOCUMENT, find, &args, &cache).wait();
+      srv.rcv_msg(checker);
+      ASSERT_EQ(msg_type::cli_PreparePrepare, checker.m_type);
+      Mysqlx::Prepare::Prepare &prep
+        = static_cast<Mysqlx::Prepare::Prepare&>(*checker.m_msg);
+      EXPECT_EQ(0, prep.stmt().find().args_size());
+
+      EXPECT_EQ(full_find(args), cached_find(args));
+    }
+
+    cout <<"== Done!" <<endl;
+  }
+  CATCH_TEST_GENERIC;
+}
+
+
+}}  // cdk::test
@@ -592,6 +592,11 @@ public:
   {
     rcv_start<Rcv_op>(prc).wait();
   }
+
+  void snd_msg(msg_type_t type, Message &msg)
+  {
+    snd_start(msg, type).wait();
+  }
 };
 
 
@@ -615,6 +620,7 @@ template <class C>
 class Test_stream : public Protocol::Stream
 {
   typedef typename C::Read_op  Rd_op;
+  typedef typename C::Read_some_op  Rd_some_op;
   typedef typename C::Write_op Wr_op;
 
   C &m_conn;
@@ -627,6 +633,9 @@ public:
   Op* read(const buffers &buf)
   { return new Rd_op(m_conn, buf); }
 
+  Op* read_some(const buffers &buf)
+  { return new Rd_some_op(m_conn, buf); }
+
   Op* write(const buffers &buf)
   { return new Wr_op(m_conn, buf); }
 };
@@ -30,6 +30,7 @@
 #include <list>
 
 #include "impl.h"
+#include <json_parser.h>
 
 using namespace mysqlx;
 using namespace uuid;
@@ -37,17 +38,27 @@ using namespace uuid;
 // --------------------------------------------------------------------
 
 
-void mysqlx::GUID::generate()
+static void set_guid(mysqlx::GUID &guid, const uuid_type &uuid)
 {
   static const char *hex_digit = "0123456789ABCDEF";
-  uuid_type uuid;
-  generate_uuid(uuid);
+  char buf[2*sizeof(uuid_type) + 1];
 
-  for (unsigned i = 0; i < sizeof(uuid) && 2*i < sizeof(m_data); ++i)
+  for (unsigned i = 0; i < sizeof(uuid); ++i)
   {
-    m_data[2*i] = hex_digit[uuid[i] >> 4];
-    m_data[2 * i + 1] = hex_digit[uuid[i] % 16];
+    buf[2*i] = hex_digit[uuid[i] >> 4];
+    buf[2 * i + 1] = hex_digit[uuid[i] % 16];
   }
+  buf[2*sizeof(uuid_type)] = '\0';
+
+  guid = buf;
+}
+
+
+void mysqlx::GUID::generate()
+{
+  uuid_type uuid;
+  generate_uuid(uuid);
+  set_guid(*this, uuid);
 }
 
 
@@ -62,9 +73,10 @@ void mysqlx::GUID::generate()
   Internal implementation for collection CRUD add operation.
 
   Implementation object stores list of JSON strings describing documents
-  to be added and passed with `add_json` method. It presents this list
-  of documents via cdk::Doc_source interface. See method `process` for
-  details.
+  to be added and passed with `add_json` method. The strings are stored
+  in UTF-8 encoding, in which they are sent to the server. The object
+  presents this list of documents via cdk::Doc_source interface. See method
+  `process` for details.
 
   Overriden method Op_base::send_command() sends the collection add
   command to the CDK session.
@@ -73,36 +85,66 @@ void mysqlx::GUID::generate()
 class Op_collection_add
   : public Op_base< internal::Collection_add_impl>
   , public cdk::Doc_source
-  , public cdk::JSON::Processor
+  , public parser::JSON_utf8_parser::Field_processor
   , public cdk::JSON::Processor::Any_prc
   , public cdk::JSON::Processor::Any_prc::Scalar_prc
 {
   typedef cdk::string string;
 
   Table_ref    m_coll;
-  std::vector<string> m_json;
+  std::vector<std::string> m_json;
   mysqlx::GUID  m_id;
   std::vector<mysqlx::GUID> m_id_list;
-  bool  m_generated_id;
   unsigned m_pos;
+  unsigned m_end = 0;
+
+  /*
+    Document ids are generated in batches of up to UUID_BATCH ids, which
+    are stored in m_uuids. Member m_uuid_pos is the position of the next
+    unused id and m_uuid_end is the end of the current batch.
+  */
+
+  enum { UUID_BATCH = 64 };
+  uuid_type m_uuids[UUID_BATCH];
+  unsigned m_uuid_pos = 0;
+  unsigned m_uuid_end = 0;
+
+  void generate_id()
+  {
+    if (m_uuid_pos >= m_uuid_end)
+    {
+      // Note: documents after m_pos might need generated ids.
+      m_uuid_end = std::min<unsigned>(UUID_BATCH, m_end - m_pos + 1);
+      m_uuid_pos = 0;
+      mysqlx::generate_uuids(m_uuids, m_uuid_end);
+    }
+    set_guid(m_id, m_uuids[m_uuid_pos++]);
+  }
   bool m_upsert = false;
 
 
   Op_collection_add(Collection &coll, bool upsert = false)
     : Op_base(coll)
     , m_coll(coll)
-    , m_generated_id(true)
     , m_pos(0)
     , m_upsert(upsert)
   {}
 
   Executable_impl* clone() const override
   {
-    return new Op_collection_add(*this);
+    auto op = new Op_collection_add(*this);
+    // Unused ids can not be shared with the copy.
+    op->m_uuid_pos = op->m_uuid_end = 0;
+    return op;
   }
 
 
   void add_json(const mysqlx::string &json) override
+  {
+    m_json.emplace_back(json);  // note: conversion to utf-8
+  }
+
+  void add_json(const std::string &json) override
   {
     m_json.push_back(json);
   }
@@ -115,11 +157,21 @@ class Op_collection_add
     if (m_json.empty())
       return NULL;
 
-    // Issue coll_add statement where documents are described by list
-    // of expressions defined by this instance.
+    // Issue coll_add statements where documents are described by list
+    // of expressions defined by this instance. Large lists are sent
+    // in several chunks.
 
-    return new cdk::Reply(get_cdk_session()
-                          .coll_add(m_coll, *this, NULL, m_upsert));
+    return send_chunks(
+      m_json.size(),
+      [this](size_t pos) { return m_json[pos].size(); },
+      [this](size_t begin, size_t end)
+      {
+        m_pos = unsigned(begin);
+        m_end = unsigned(end);
+        return new_reply(get_cdk_session()
+                         .coll_add(m_coll, *this, NULL, m_upsert));
+      }
+    );
   }
 
 
@@ -133,7 +185,7 @@ class Op_collection_add
 
   bool next() override
   {
-    if (m_pos >= m_json.size())
+    if (m_pos >= m_end)
       return false;
     ++m_pos;
     return true;
@@ -142,29 +194,44 @@ class Op_collection_add
   void process(cdk::Expression::Processor &ep) const override;
 
 
-  // JSON::Processor
+  // JSON_utf8_parser::Field_processor
 
-  void doc_begin() override {}
-  void doc_end() override {}
+  /*
+    Position and length of the value of the first top-level '_id' field
+    in the current document (m_id_len is 0 if there is no such field),
+    and number of top-level fields.
+  */
 
+  size_t m_id_pos;
+  size_t m_id_len;
+  size_t m_field_count;
 
-  cdk::JSON::Processor::Any_prc*
-  key_val(const string &key) override
+  void field(const string &key, size_t pos, size_t len) override
   {
-    // look only at key '_id'
-    if (key != string("_id"))
-      return NULL;
-    // process '_id' value
-    m_generated_id= false;
-    return this;
+    ++m_field_count;
+
+    if (0 == m_id_len && key == L"_id")
+    {
+      m_id_pos = pos;
+      m_id_len = len;
+    }
   }
 
-  // JSON::Processor::Any_prc
+  // JSON::Processor::Any_prc (used to decode '_id' value)
 
   cdk::JSON::Processor::Any_prc::List_prc*
-  arr() override { assert(false); return NULL; }
+  arr() override
+  {
+    using mysqlx::throw_error;
+    THROW("Document id must be a string");
+  }
+
   cdk::JSON::Processor::Any_prc::Doc_prc*
-  doc() override { assert(false); return NULL; }
+  doc() override
+  {
+    using mysqlx::throw_error;
+    THROW("Document id must be a string");
+  }
 
   cdk::JSON::Processor::Any_prc::Scalar_prc*
   scalar() override
@@ -232,90 +299,73 @@ CollectionAdd::CollectionAdd(Collection &coll)
 
 
 /*
-  Class describing elements of expression:
-
-    JSON_INSERT(<json>, '$._id', <id>)
+  Expression describing single document to be inserted.
 
-  where <json> and <id> are given as constructor parameters.
+  The document is always sent as a JSON literal. Its top-level fields are
+  scanned, without decoding their values, to see if it has '_id' field.
+  If a document has no id, a generated one is appended as the last field
+  of the document. If '_id' key is repeated in a document, only its first
+  occurrence is taken into account.
 */
 
-class Insert_id
-  : public cdk::api::Table_ref
-  , public cdk::Expr_list
-{
-  typedef cdk::string string;
-
-  const std::string m_json;
-  const std::string &m_id;
-
-  Insert_id(const string &json, const std::string &id)
-    : m_json(json)  // note: conversion to utf-8
-    , m_id(id)
-  {}
-
-
-  // Table_ref (function name)
-
-  const cdk::api::Schema_ref* schema() const { return NULL; }
-  const string name() const { return L"JSON_INSERT"; }
-
-
-  // Expr_list (arguments)
+// Trivial Format_info for JSON documents sent as raw bytes.
 
-  using cdk::Expr_list::Processor;
-
-  void process(Processor &lp) const
+struct Json_format
+  : public cdk::Format_info
+{
+  bool for_type(cdk::Type_info ti) const override
   {
-    lp.list_begin();   // FIXME
-    lp.list_el()->scalar()->val()->str(m_json);
-    lp.list_el()->scalar()->val()->str(L"$._id");
-    lp.list_el()->scalar()->val()->str(m_id);
-    lp.list_end();
+    return cdk::TYPE_DOCUMENT == ti;
   }
-
-  friend Op_collection_add;
+  void get_info(cdk::Format<cdk::TYPE_DOCUMENT>&) const override {}
+  using cdk::Format_info::get_info;
 };
 
 
-/*
-  Expression describing single document to be inserted.
-
-  If document id was generated, then expression is a call of
-  JSON_INSERT() function that adds generated id. Otherwise it
-  is plain JSON string of the document.
-
-  TODO:
-  - Append '_id' field at the end of document, instead of using
-    JSON_INSERT() (should be more efficient). If duplicate key is
-    found in a document string, only the first occurence is taken
-    into account.
-*/
-
 void Op_collection_add::process(cdk::Expression::Processor &ep) const
 {
   assert(m_pos > 0);  // this method should be called after calling next()
 
-  const string &json = m_json.at(m_pos-1);
+  const std::string &json = m_json.at(m_pos-1);
   auto self = const_cast<Op_collection_add*>(this);
 
-  // Parse JSON string to find _id if defined.
-  // TODO: Avoid parsing (if inserted document id is returned by server).
+  self->m_id_len = 0;
+  self->m_field_count = 0;
+  parser::JSON_utf8_parser(cdk::bytes(json)).scan_fields(*self);
 
-  cdk::Codec<cdk::TYPE_DOCUMENT> codec;
-  self->m_generated_id = true;
-  codec.from_bytes(cdk::bytes(json), *self);
+  Json_format fmt;
 
-  if (m_generated_id)
+  if (m_id_len)
   {
-    self->m_id.generate();
-    std::string id(m_id);
-    Insert_id expr(json, id);
-    expr.process(*ep.scalar()->call(expr));
+    // Decode id value (this also checks that it is a string).
+
+    cdk::bytes val((cdk::byte*)json.data() + m_id_pos, m_id_len);
+    parser::JSON_utf8_parser(val).process_any(*self);
+
+    ep.scalar()->val()->value(cdk::TYPE_DOCUMENT, fmt, cdk::bytes(json));
   }
   else
   {
-    // TODO: ep.val(TYPE_DOCUMENT, json_format, cdk::bytes())
-    ep.scalar()->val()->str(json);
+    self->generate_id();
+
+    /*
+      Insert the generated id before the closing '}' of the document,
+      skipping trailing white-space and 0x00 bytes accepted by the parser.
+    */
+
+    size_t end = json.size();
+    while (end > 0 && '}' != json[end-1])
+      --end;
+    assert(end > 0);
+
+    std::string doc;
+    doc.reserve(json.size() + 48);
+    doc.append(json, 0, end-1);
+    doc.append(m_field_count ? ",\"_id\":\"" : "\"_id\":\"");
+    doc.append(std::string(m_id));
+    doc.append("\"}");
+
+    ep.scalar()->val()->value(cdk::TYPE_DOCUMENT, fmt, cdk::bytes(doc));
   }
 
   //Save added "_id" to the list
@@ -370,7 +420,7 @@ class Op_collection_remove
   cdk::Reply* send_command() override
   {
     return
-      new cdk::Reply(get_cdk_session().coll_remove(
+      mk_reply(get_cdk_session().coll_remove(
                             m_coll,
                             get_where(),
                             get_order_by(),
@@ -446,7 +496,7 @@ class Op_collection_find
   cdk::Reply* send_command() override
   {
     return
-      new cdk::Reply(get_cdk_session().coll_find(
+      mk_reply(get_cdk_session().coll_find(
                           m_coll,
                           NULL,           // view spec
                           get_where(),
@@ -457,7 +507,7 @@ class Op_collection_find
                           get_limit(),
                           get_params(),
                           get_locking()
-                    ));
+                    ), true);
   }
 
   friend mysqlx::CollectionFind;
@@ -571,7 +621,7 @@ class Op_collection_modify
       return NULL;
 
     return
-      new cdk::Reply(get_cdk_session().coll_update(
+      mk_reply(get_cdk_session().coll_update(
                        m_coll,
                        get_where(),
                        *this,
@@ -585,12 +635,14 @@ class Op_collection_modify
                      const Field &field,
                      internal::ExprValue &&val) override
   {
+    set_modified();
     m_update.emplace_back(op, field, std::move(val));
   }
 
   void add_operation(Field_Op::Operation op,
                      const Field &field) override
   {
+    set_modified();
     m_update.emplace_back(op, field);
   }
 
@@ -57,9 +57,10 @@ void Value::print(ostream &out) const
   case DOUBLE: out << m_val._double_v; return;
   case FLOAT: out << m_val._float_v; return;
   case BOOL: out << (m_val._bool_v ? "true" : "false"); return;
-  case STRING: out << (std::string)m_str; return;
+  case STRING: out << get<std::string>(); return;
   case DOCUMENT: out << m_doc; return;
   case RAW: out << "<" << m_raw.size() << " raw bytes>"; return;
+  case DECIMAL: out << m_utf8; return;
   // TODO: print array contnets
   case ARRAY: out << "<array with " << elementCount() << " element(s)>"; return;
   default:  out << "<unknown value>"; return;
@@ -67,6 +68,140 @@ void Value::print(ostream &out) const
 }
 
 
+// Decimal
+// -------
+
+
+Decimal::Decimal(const std::string &str)
+{
+  size_t pos = 0;
+
+  if (pos < str.length() && ('-' == str[pos] || '+' == str[pos]))
+    pos++;
+
+  size_t int_begin = pos;
+  while (pos < str.length() && isdigit((unsigned char)str[pos]))
+    pos++;
+  size_t int_end = pos;
+
+  size_t frac_digits = 0;
+
+  if (pos < str.length() && '.' == str[pos])
+  {
+    pos++;
+    while (pos < str.length() && isdigit((unsigned char)str[pos]))
+    {
+      pos++;
+      frac_digits++;
+    }
+  }
+
+  if (pos != str.length() || (int_begin == int_end && 0 == frac_digits))
+    throw_error("Invalid decimal number");
+
+  if ('-' == str[0])
+    m_str.push_back('-');
+
+  // Strip leading zeros of the integral part, as done for values decoded
+  // from the server, so that equal decimals have equal string forms.
+
+  while (int_end - int_begin > 1 && '0' == str[int_begin])
+    int_begin++;
+
+  if (int_begin == int_end)
+    m_str.push_back('0');
+
+  m_str.append(str, int_begin, std::string::npos);
+
+  // Drop trailing '.' without fractional digits.
+
+  if (0 == frac_digits && '.' == m_str.back())
+    m_str.pop_back();
+}
+
+
+Decimal::Decimal(int64_t unscaled, unsigned scale)
+{
+  // Note: negating in unsigned arithmetic avoids overflow for INT64_MIN.
+
+  uint64_t val = unscaled < 0 ? 0 - (uint64_t)unscaled : (uint64_t)unscaled;
+  std::string digits = std::to_string(val);
+
+  if (digits.length() <= scale)
+    digits.insert(0, scale - digits.length() + 1, '0');
+
+  if (unscaled < 0)
+    m_str.push_back('-');
+
+  m_str.append(digits, 0, digits.length() - scale);
+
+  if (scale > 0)
+  {
+    m_str.push_back('.');
+    m_str.append(digits, digits.length() - scale, std::string::npos);
+  }
+}
+
+
+unsigned Decimal::scale() const
+{
+  size_t point = m_str.find('.');
+  return std::string::npos == point ? 0
+         : (unsigned)(m_str.length() - point - 1);
+}
+
+
+bool Decimal::getUnscaled(int64_t &unscaled) const
+{
+  bool negative = ('-' == m_str[0]);
+  const uint64_t max_val = (uint64_t)std::numeric_limits<int64_t>::max()
+                           + (negative ? 1 : 0);
+  uint64_t val = 0;
+
+  for (char c : m_str)
+  {
+    if (!isdigit((unsigned char)c))
+      continue;
+    unsigned digit = (unsigned)(c - '0');
+    if (val > (max_val - digit) / 10)
+      return false;
+    val = 10 * val + digit;
+  }
+
+  unscaled = negative ? (int64_t)(0 - val) : (int64_t)val;
+  return true;
+}
+
+
+Decimal::operator double() const
+{
+  static const double pow10[] = {
+    1e0, 1e1, 1e2, 1e3, 1e4, 1e5, 1e6, 1e7, 1e8, 1e9, 1e10, 1e11,
+    1e12, 1e13, 1e14, 1e15, 1e16, 1e17, 1e18, 1e19, 1e20, 1e21, 1e22
+  };
+
+  /*
+    If both the unscaled value and 10^scale are exact doubles, single
+    division gives correctly rounded result. Otherwise parse the text
+    (using "C" locale, where decimal point is '.').
+  */
+
+  int64_t unscaled;
+  unsigned sc = scale();
+  const int64_t max_exact = (int64_t)1 << 53;
+
+  if (sc < sizeof(pow10)/sizeof(double) && getUnscaled(unscaled)
+      && unscaled <= max_exact && unscaled >= -max_exact)
+    return (double)unscaled / pow10[sc];
+
+  std::istringstream in(m_str);
+  in.imbue(std::locale::classic());
+  double val;
+  in >> val;
+  return val;
+}
+
+
 // DbDoc implementation
 // --------------------
 
@@ -120,6 +255,30 @@ void DbDoc::print(std::ostream &out) const
   CATCH_AND_WRAP
 }
 
+
+size_t DbDoc::Impl::get_size_hint() const
+{
+  // Braces plus quotes, colon and comma for each field.
+
+  size_t size = 2;
+  for (const auto &fld : m_map)
+    size += ((const string&)fld.first).length() + 4
+            + Value::Access::get_size_hint(fld.second);
+  return size;
+}
+
+
+size_t Value::Access::get_json_size_hint(const Value &val)
+{
+  if (Value::DOCUMENT == val.m_type)
+    return val.m_doc.m_impl ? val.m_doc.m_impl->get_size_hint() : 2;
+
+  size_t size = 2;
+  for (const Value &el : *val.m_arr)
+    size += 1 + get_size_hint(el);
+  return size;
+}
+
 // JSON document
 // -------------
 
@@ -248,7 +407,7 @@ public:
     void null() { m_arr->emplace_back(Value()); }
     void str(const cdk::string &val)
     {
-      m_arr->emplace_back(Value(val));
+      m_arr->emplace_back(Value(mysqlx::string(val)));
     }
     void num(uint64_t val) { m_arr->emplace_back(val); }
     void num(int64_t val) { m_arr->emplace_back(val); }
@@ -311,7 +470,7 @@ public:
   void null() { m_map.emplace(m_key, Value()); }
   void str(const cdk::string &val)
   {
-    m_map.emplace(m_key, Value(val));
+    m_map.emplace(m_key, Value(mysqlx::string(val)));
   }
   void num(uint64_t val)  { m_map.emplace(m_key, val); }
   void num(int64_t val)   { m_map.emplace(m_key, val); }
@@ -322,14 +481,108 @@ public:
 };
 
 
+/*
+  Build index of top-level document fields. Field values are not decoded
+  at this point - their JSON text is only scanned to find where it ends.
+*/
+
+void DbDoc::Impl::JSONDoc::index()
+{
+  if (m_indexed)
+    return;
+
+  struct : public parser::JSON_utf8_parser::Field_processor
+  {
+    Index *m_index;
+
+    void field(const cdk::string &key, size_t pos, size_t len)
+    {
+      // Note: If a key is repeated, the first occurrence is used.
+      m_index->emplace(mysqlx::string(key), Span(pos, len));
+    }
+  }
+  prc;
+
+  prc.m_index = &m_index;
+
+  cdk::bytes data(m_json);
+  parser::JSON_utf8_parser parser(data);
+  parser.scan_fields(prc);
+
+  m_indexed = true;
+}
+
+
+/*
+  Decode value of the given field, if not done yet, and store it in
+  m_map. Note that inserting to std::map does not invalidate references
+  to values stored in it.
+*/
+
+const Value&
+DbDoc::Impl::JSONDoc::decode(const Field &fld, const Span &span)
+{
+  auto it = m_map.find(fld);
+
+  if (it != m_map.end())
+    return it->second;
+
+  std::string json(m_json, span.first, span.second);
+
+  /*
+    String without escape sequences is stored in the value as is, in UTF-8
+    encoding. Note that the JSON text was already validated by index().
+  */
+
+  char quote = json[0];
+
+  if (('"' == quote || '\'' == quote)
+      && std::string::npos == json.find('\\'))
+  {
+    Value val(json.substr(1, json.size() - 2));
+    return m_map.emplace(fld, std::move(val)).first->second;
+  }
+
+  // Sub-documents are parsed lazily, the same as this document.
+
+  Value val = '{' == json[0] ? Value::Access::mk_doc(json)
+                             : Value::Access::mk_from_json(json);
+
+  return m_map.emplace(fld, std::move(val)).first->second;
+}
+
+
+bool DbDoc::Impl::JSONDoc::has_field(const Field &fld)
+{
+  index();
+  return m_index.end() != m_index.find(fld);
+}
+
+
+const Value& DbDoc::Impl::JSONDoc::get(const Field &fld) const
+{
+  JSONDoc *self = const_cast<JSONDoc*>(this);
+
+  self->index();
+  return self->decode(fld, m_index.at(fld));
+}
+
+
+/*
+  Decode all fields of the document, so that they can be iterated
+  over using m_map.
+*/
+
 void DbDoc::Impl::JSONDoc::prepare()
 {
   if (m_parsed)
     return;
 
-  cdk::Codec<cdk::TYPE_DOCUMENT> codec;
-  Builder bld(*this);
-  codec.from_bytes(cdk::bytes(m_json), bld);
+  index();
+
+  for (const auto &fld : m_index)
+    decode(fld.first, fld.second);
+
   m_parsed = true;
 }
 
@@ -340,16 +593,10 @@ void DbDoc::Impl::JSONDoc::prepare()
 
 Value Value::Access::mk_from_json(const std::string &json)
 {
-  typedef parser::Any_parser<
-    parser::JSON_scalar_parser,
-    cdk::JSON_processor
-  > Parser;
-
   // Create parser for the JSON string.
 
-  parser::Tokenizer toks(json);
-  auto first = toks.begin();
-  Parser parser(first, toks.end());
+  cdk::bytes data(json);
+  parser::JSON_utf8_parser parser(data);
 
   /*
     Define builder which acts as JSON value processor and
@@ -406,7 +653,7 @@ Value Value::Access::mk_from_json(const std::string &json)
 
   Value val;
   builder.m_val = &val;
-  parser.process(builder);
+  parser.process_any(builder);
 
   return std::move(val);
 }
@@ -33,10 +33,18 @@
 #include <mysql/cdk.h>
 #include <mysql/cdk/converters.h>
 #include <expr_parser.h>
+#include <expr_cache.h>
 #include <map>
+#include <unordered_map>
 #include <memory>
+#include <exception>
 #include <stack>
+#include <deque>
 #include <list>
+#include <mutex>
+#include <condition_variable>
+#include <chrono>
+#include <atomic>
 
 #include "../global.h"
 #include "result_impl.h"
@@ -53,12 +61,40 @@ struct Value::Access
     return cdk::bytes(val.m_raw.begin(), val.m_raw.end());
   }
 
+  /*
+    Check if string value is stored in UTF-8 encoding and, if so, get
+    the bytes of the UTF-8 string.
+  */
+
+  static bool is_utf8(const Value &val)
+  {
+    return Value::STRING == val.m_type && !val.m_utf8.empty();
+  }
+
+  static cdk::bytes get_utf8(const Value &val)
+  {
+    return cdk::bytes(val.m_utf8);
+  }
+
+  /*
+    Create DECIMAL value from its text form, which is assumed to be valid
+    (as produced by Codec<TYPE_FLOAT>::decimal_to_string()).
+  */
+
+  static Value mk_decimal(std::string &&str)
+  {
+    Value val;
+    val.m_type = Value::DECIMAL;
+    val.m_utf8 = std::move(str);
+    return val;
+  }
+
   /*
     Build document value from a JSON string which is
     assumed to describe a document.
   */
 
-  static Value mk_doc(const string &json)
+  static Value mk_doc(const std::string &json)
   {
     Value ret;
     ret.m_type = Value::DOCUMENT;
@@ -73,6 +109,28 @@ struct Value::Access
   */
 
   static Value mk_from_json(const std::string &json);
+
+  /*
+    Estimate of the number of bytes needed to send given value to
+    the server.
+  */
+
+  static size_t get_size_hint(const Value &val)
+  {
+    switch (val.m_type)
+    {
+    case Value::STRING: return val.m_str.size() + val.m_utf8.size();
+    case Value::DECIMAL: return val.m_utf8.size();
+    case Value::RAW:    return val.m_raw.size();
+    case Value::DOCUMENT:
+    case Value::ARRAY:  return get_json_size_hint(val);
+    default:            return 8;
+    }
+  }
+
+  // Estimate of the length of JSON description of a document or an array.
+
+  static size_t get_json_size_hint(const Value &val);
 };
 
 
@@ -187,8 +245,7 @@ public:
     if (m_is_expr)
     {
       assert(Value::STRING == m_value.getType());
-      parser::Expression_parser expr(m_parser_mode,
-        (mysqlx::string)m_value);
+      parser::Cached_expr expr(m_parser_mode, (mysqlx::string)m_value);
       expr.process(prc);
       return;
     }
@@ -260,22 +317,38 @@ public:
         vprc->yesno(static_cast<bool>(m_value));
         break;
       case Value::STRING:
-        vprc->str(static_cast<mysqlx::string>(m_value));
+        // UTF-8 strings are sent without converting to wide string.
+        if (Value::Access::is_utf8(m_value))
+          vprc->value(cdk::TYPE_STRING,
+                      static_cast<const cdk::Format_info&>(*this),
+                      Value::Access::get_utf8(m_value));
+        else
+          vprc->str(static_cast<mysqlx::string>(m_value));
         break;
       case Value::RAW:
         vprc->value(cdk::TYPE_BYTES,
                     static_cast<const cdk::Format_info&>(*this),
                     Value::Access::get_bytes(m_value));
         break;
+      case Value::DECIMAL:
+        // Decimal is sent as string which server converts without loss.
+        vprc->value(cdk::TYPE_STRING,
+                    static_cast<const cdk::Format_info&>(*this),
+                    Value::Access::get_utf8(m_value));
+        break;
       default:
         THROW("Unexpected value type");
     }
   }
 
-  // Trivial Format_info for raw byte values
+  // Trivial Format_info for raw byte values and UTF-8 strings
 
   bool for_type(cdk::Type_info) const override { return true; }
   void get_info(cdk::Format<cdk::TYPE_BYTES>&) const override {}
+  void get_info(cdk::Format<cdk::TYPE_STRING> &fmt) const override
+  {
+    cdk::Format<cdk::TYPE_STRING>::Access::set_cs(fmt, cdk::Charset::utf8);
+  }
   using cdk::Format_info::get_info;
 
 };
@@ -340,18 +413,22 @@ class DbDoc::Impl
 
   virtual void prepare() {}
 
+  // Estimate of the length of JSON description of the document.
+
+  virtual size_t get_size_hint() const;
+
   // Data storage
 
   typedef std::map<Field, Value> Map;
   Map m_map;
 
-  bool has_field(const Field &fld)
+  virtual bool has_field(const Field &fld)
   {
     prepare();
     return m_map.end() != m_map.find(fld);
   }
 
-  const Value& get(const Field &fld) const
+  virtual const Value& get(const Field &fld) const
   {
     const_cast<Impl*>(this)->prepare();
     return m_map.at(fld);
@@ -379,27 +456,64 @@ class DbDoc::Impl
 /*
   DbDoc::Impl specialization which takes document data from
   a JSON string.
+
+  The document is not parsed up-front. On first access to a field, the
+  JSON string is scanned to build a hash index which maps top-level keys
+  to positions of their values in the string. A value is decoded (and
+  stored in m_map) only when its field is requested. Values which are
+  documents are again JSONDoc instances, so they are parsed on demand in
+  the same way.
+
+  Iterating over document fields decodes all of them (see prepare()).
 */
 
 class DbDoc::Impl::JSONDoc
   : public DbDoc::Impl
 {
   std::string m_json;
+  bool m_indexed;
   bool m_parsed;
 
+  struct Field_hash
+  {
+    size_t operator()(const Field &fld) const
+    {
+      return std::hash<std::wstring>()((const string&)fld);
+    }
+  };
+
+  // Position and length of field value within m_json.
+
+  typedef std::pair<size_t, size_t>  Span;
+  typedef std::unordered_map<Field, Span, Field_hash>  Index;
+
+  Index m_index;
+
+  void index();
+  const Value& decode(const Field&, const Span&);
+
 public:
 
   JSONDoc(const std::string &json)
     : m_json(json)
+    , m_indexed(false)
     , m_parsed(false)
   {}
 
+  bool has_field(const Field &fld);
+  const Value& get(const Field &fld) const;
+
   void prepare();
 
   void print(std::ostream &out) const
   {
     out << m_json;
   }
+
+  size_t get_size_hint() const
+  {
+    return m_json.size();
+  }
 };
 
 
@@ -409,6 +523,13 @@ public:
   Internal implementation for Session objects.
 */
 
+/*
+  Maximal number of chunks of an insert that are sent to the server before
+  waiting for the reply to the first of them.
+*/
+
+#define INSERT_CHUNKS_IN_FLIGHT  16
+
 struct internal::Session_detail::Impl
 {
   using Result_impl = internal::Result_detail::Impl;
@@ -417,7 +538,58 @@ struct internal::Session_detail::Impl
   cdk::Session          m_sess;
   cdk::string           m_default_db;
 
-  Result_impl *m_current_result = nullptr;
+  /*
+    Results registered with the session, in the order in which their
+    commands were sent. Normally there is at most one such result. If
+    pipelining is enabled (m_pipeline_depth > 1), up to m_pipeline_depth
+    commands can be sent before earlier results are consumed. Results
+    of these commands are read in order, and when a later result is used,
+    the ones registered before it cache their data first.
+  */
+
+  std::deque<Result_impl*> m_results;
+  unsigned m_pipeline_depth = 1;
+
+  /*
+    If not 0, statements which return rows are executed using server-side
+    cursors which fetch this many rows at a time.
+  */
+
+  cdk::row_count_t m_fetch_size = 0;
+
+  /*
+    Limits on the size of chunks in which large inserts are sent to
+    the server, in bytes and in rows (0 means no limit). See
+    Op_base::send_chunks(). By default there are no limits and each insert
+    is sent as a single statement, so that it is atomic.
+  */
+
+  uint64_t m_chunk_bytes = 0;
+  uint64_t m_chunk_rows = 0;
+
+  /*
+    Operation executed asynchronously whose reply was not consumed yet
+    (see Executable::executeAsync()). Before another command is sent, such
+    operation is completed and creates its result which is registered with
+    the session as usual. This way the result can cache its data before
+    the next command is sent.
+  */
+
+  struct Pending_op
+  {
+    virtual void complete() = 0;
+  };
+
+  Pending_op *m_pending_op = nullptr;
+
+  void complete_pending_op()
+  {
+    if (!m_pending_op)
+      return;
+    Pending_op *op = m_pending_op;
+    m_pending_op = nullptr;
+    op->complete();
+  }
 
   Impl(cdk::ds::Multi_source &ms)
     : m_sess(ms)
@@ -437,8 +609,113 @@ struct internal::Session_detail::Impl
     register_result(nullptr);
   }
 
+  static std::shared_ptr<Impl> create(SessionSettings &settings);
+
+  /*
+    Generation of the session, incremented each time it is reset before
+    being returned to a pool. Reset releases all prepared statements, so
+    an operation which prepared its statement in an earlier generation must
+    neither use nor deallocate it (see Op_base::m_stmt_gen). The counter is
+    atomic because such operation can check it in a different thread than
+    the one to which the session was given by the pool.
+  */
+
+  std::atomic<unsigned> m_generation{ 0 };
+
+  /*
+    Bring session to a clean state before it is returned to a pool: results
+    of earlier commands cache their data, session state on the server is
+    reset (see cdk::mysqlx::Session::reset()) and session settings are
+    reset to defaults. If session was created with a default schema, it is
+    made the current schema again.
+  */
+
+  void reset()
+  {
+    complete_pending_op();
+    register_result(nullptr);
+    ++m_generation;
+    m_sess.reset();
+
+    if (!m_default_db.empty())
+    {
+      std::string query = "USE `";
+      for (char c : std::string(m_default_db))
+      {
+        query.push_back(c);
+        if ('`' == c)
+          query.push_back(c);
+      }
+      query.push_back('`');
+
+      cdk::Reply r(m_sess.sql(query));
+      r.wait();
+      if (0 < r.entry_count())
+        r.get_error().rethrow();
+    }
+
+    m_fetch_size = 0;
+    m_pipeline_depth = 1;
+    m_chunk_bytes = 0;
+    m_chunk_rows = 0;
+  }
+
   void register_result(Result_impl *result);
   void deregister_result(Result_impl *result);
+  void activate_result(Result_impl *result);
+
+  /*
+    Called before sending a new command. If pipelining is enabled, makes
+    room for the command in the pipeline and returns true. Otherwise returns
+    false and the caller should de-register current results as usual.
+  */
+
+  bool pipeline_cmd();
+};
+
+
+/*
+  Internal implementation for Client objects: a pool of sessions.
+
+  Idle sessions are stored in m_idle, the most recently returned one
+  at the front. Member m_in_use counts sessions taken from the pool and not
+  returned yet, including these which are being created. Sessions are
+  created and destroyed without holding the mutex.
+*/
+
+struct internal::Client_detail::Impl
+{
+  using Session_impl = internal::Session_detail::Impl;
+  using clock = std::chrono::steady_clock;
+
+  struct Idle_sess
+  {
+    std::shared_ptr<Session_impl> m_sess;
+    clock::time_point m_since;
+  };
+
+  SessionSettings m_settings;
+  PoolSettings    m_pool;
+
+  std::deque<Idle_sess> m_idle;
+  unsigned m_in_use = 0;
+  bool     m_closed = false;
+
+  std::mutex m_mutex;
+  std::condition_variable m_released;
+
+  Impl(const SessionSettings &settings, const PoolSettings &pool)
+    : m_settings(settings)
+    , m_pool(pool)
+  {}
+
+  std::shared_ptr<Session_impl> get_session();
+  void release(std::shared_ptr<Session_impl> sess);
+  void close();
+
+private:
+
+  void evict(std::vector<std::shared_ptr<Session_impl>> &dropped);
 };
 
 
@@ -453,6 +730,13 @@ struct Session::Access
   {
     sess.prepare_for_cmd();
   }
+
+  using Impl = Session::Impl;
+
+  static std::shared_ptr<Impl> get_impl(Session &sess)
+  {
+    return sess.m_impl;
+  }
 };
 
 
@@ -460,6 +744,18 @@ struct internal::Result_base::Access
 {
   static Result_base mk_empty() { return Result_base(); }
 
+  /*
+    Add statistics of the chunks of an insert that were sent before
+    the one whose reply is held by the result (see Op_base::send_chunks()).
+  */
+
+  static void add_chunk_stats(Result_base &res,
+                              cdk::row_count_t affected_rows,
+                              cdk::row_count_t auto_increment)
+  {
+    res.get_impl().add_chunk_stats(affected_rows, auto_increment);
+  }
+
   template <typename A>
   static Result_base mk(mysqlx::Session *sess, A a)
   {
@@ -534,6 +830,7 @@ class Op_base
   : public Impl
   , public cdk::Limit
   , public cdk::Param_source
+  , public Session::Access::Impl::Pending_op
 {
 protected:
 
@@ -571,10 +868,18 @@ protected:
     , m_offset     (other.m_offset    )
     , m_has_offset (other.m_has_offset)
     , m_map        (other.m_map       )
+    , m_prepare    (other.m_prepare   )
   {}
 
   virtual ~Op_base()
-  {}
+  {
+    try {
+      release_pending();
+      set_modified();
+    }
+    catch (...)
+    {}
+  }
 
   cdk::Session& get_cdk_session()
   {
@@ -582,6 +887,314 @@ protected:
     return Session::Access::get_cdk_session(*m_sess);
   }
 
+
+  /*
+    Server-side prepared statements
+    -------------------------------
+
+    When the same operation is executed for the second time without being
+    modified in between, it is prepared on the server and from then on
+    executed by sending only the values of its parameters. If m_prepare
+    is true, the operation is prepared already on its first execution.
+
+    Any change of the operation (such as setting different limit or binding
+    a new named parameter) calls set_modified() which releases the prepared
+    statement, if any. Prepared statement is also released when operation
+    is destroyed. Copies of the operation do not share the prepared
+    statement.
+
+    Note: We keep weak pointer to the session implementation in which
+    the statement was prepared, so that it is not used after the session
+    is gone, and the generation of that session. If the session was reset
+    in the meantime (returned to a pool and possibly given to a different
+    user), the prepared statement was released by the reset and is not
+    touched any more.
+
+    Operations which return rows pass `rows` flag to mk_reply(). If fetch
+    size is set for the session, such operations are always prepared and
+    their results are read using a server-side cursor.
+
+    If the operation is not prepared (for example, because the server does
+    not support prepared statements), its command is sent using m_cmd_cache
+    so that on re-execution only values of its parameters are serialized.
+    The cache is cleared together with the prepared statement.
+  */
+
+  bool m_prepare = false;
+  unsigned m_exec_count = 0;
+  cdk::Session::stmt_id_t m_stmt_id = 0;
+  std::weak_ptr<Session::Access::Impl> m_stmt_sess;
+  unsigned m_stmt_gen = 0;
+  cdk::Session::Cmd_cache m_cmd_cache;
+
+  void set_modified()
+  {
+    m_exec_count = 0;
+    m_cmd_cache.clear();
+    release_stmt();
+  }
+
+  /*
+    Deallocate prepared statement, if any, unless it was already released
+    by a reset of its session.
+  */
+
+  void release_stmt()
+  {
+    if (!m_stmt_id)
+      return;
+
+    auto sess = m_stmt_sess.lock();
+    if (sess && m_stmt_gen == sess->m_generation)
+      sess->m_sess.deallocate(m_stmt_id);
+
+    m_stmt_id = 0;
+    m_stmt_sess.reset();
+  }
+
+  /*
+    Create reply for the command that was set up in the CDK session
+    with one of its methods, executing it as a prepared statement if
+    appropriate. Implementations of send_command() should use this method
+    for commands that can be prepared.
+  */
+
+  template <class Init>
+  cdk::Reply* mk_reply(Init &init, bool rows = false)
+  {
+    cdk::Session &sess = get_cdk_session();
+    cdk::row_count_t fetch_size
+      = rows ? Session::Access::get_impl(*m_sess)->m_fetch_size : 0;
+
+    /*
+      Statement prepared in a different session, or before the session was
+      reset, can not be used.
+    */
+
+    if (m_stmt_id)
+    {
+      auto stmt_sess = m_stmt_sess.lock();
+      if (stmt_sess != Session::Access::get_impl(*m_sess)
+          || m_stmt_gen != stmt_sess->m_generation)
+        release_stmt();
+    }
+
+    if (m_stmt_id)
+      sess.use_prepared(m_stmt_id);
+    else if (m_prepare || 0 < m_exec_count || 0 < fetch_size)
+    {
+      // Preparing statement completes replies to earlier commands.
+
+      if (m_pipelined)
+      {
+        m_pipelined = false;
+        Session::Access::prepare_for_cmd(*m_sess);
+      }
+
+      m_stmt_id = sess.prepare();
+      if (m_stmt_id)
+      {
+        m_stmt_sess = Session::Access::get_impl(*m_sess);
+        m_stmt_gen = Session::Access::get_impl(*m_sess)->m_generation;
+      }
+    }
+
+    if (m_stmt_id && 0 < fetch_size)
+      sess.use_cursor(fetch_size);
+
+    if (!m_stmt_id)
+      sess.use_cmd_cache(m_cmd_cache);
+
+    m_exec_count++;
+    return new_reply(init);
+  }
+
+  /*
+    Create reply for the command that was set up in the CDK session. If
+    the command is pipelined (see init()), but CDK session can not pipeline
+    it, results of earlier commands are de-registered first, as usual.
+  */
+
+  template <class Init>
+  cdk::Reply* new_reply(Init &init)
+  {
+    if (m_chunking)
+      return new_chunk_reply(init);
+
+    if (m_pipelined && !get_cdk_session().pipeline())
+    {
+      m_pipelined = false;
+      Session::Access::prepare_for_cmd(*m_sess);
+    }
+    return new cdk::Reply(init);
+  }
+
+
+  /*
+    Sending inserts in chunks
+    -------------------------
+
+    If limits are set in the session settings (see Session_detail::Impl),
+    insert of many items (documents or rows) is split into chunks whose
+    size does not exceed these limits.
+    This bounds the size of a single message and the memory needed to
+    build it. Method send_chunks() computes chunk boundaries using given
+    function which returns (estimated) size of the item at given position.
+    Then it calls `send_chunk(begin, end)` for consecutive chunks. This
+    function should send insert of items in range [begin, end) and return
+    reply created with new_reply().
+
+    Chunks are pipelined: up to INSERT_CHUNKS_IN_FLIGHT of them are sent
+    before the reply to the oldest one is read. Replies to all chunks but
+    the last one are consumed here and their statistics are accumulated,
+    to be added to the final result (see get_result()). The reply to
+    the last chunk is returned.
+
+    If server reports error for one of the chunks, chunks after it are not
+    sent (but the ones already sent are executed) and the reply with
+    the error is returned instead.
+  */
+
+  bool m_chunking = false;
+  bool m_chunk_sync = false;
+  std::deque<std::unique_ptr<cdk::Reply>> m_chunks;
+  std::unique_ptr<cdk::Reply> m_chunk_error;
+  cdk::row_count_t m_chunk_affected_rows = 0;
+  cdk::row_count_t m_chunk_auto_increment = 0;
+
+  template <class Size, class Send>
+  cdk::Reply* send_chunks(size_t count, Size item_size, Send send_chunk)
+  {
+    auto sess = Session::Access::get_impl(*m_sess);
+    std::vector<size_t> ends;
+    size_t bytes = 0;
+    size_t rows = 0;
+
+    for (size_t pos = 0; pos < count; ++pos)
+    {
+      size_t size = item_size(pos);
+
+      if (0 < rows &&
+          ((sess->m_chunk_rows && rows >= sess->m_chunk_rows) ||
+           (sess->m_chunk_bytes && bytes + size > sess->m_chunk_bytes)))
+      {
+        ends.push_back(pos);
+        bytes = 0;
+        rows = 0;
+      }
+
+      bytes += size;
+      ++rows;
+    }
+
+    ends.push_back(count);
+
+    m_chunk_affected_rows = 0;
+    m_chunk_auto_increment = 0;
+
+    if (1 == ends.size())
+      return send_chunk(0, count);
+
+    /*
+      Replies to earlier pipelined commands are consumed before the replies
+      to chunks are read.
+    */
+
+    if (m_pipelined)
+    {
+      m_pipelined = false;
+      Session::Access::prepare_for_cmd(*m_sess);
+    }
+
+    m_chunking = true;
+
+    try {
+      size_t begin = 0;
+
+      for (size_t end : ends)
+      {
+        if (!complete_chunks(INSERT_CHUNKS_IN_FLIGHT - 1))
+          break;
+
+        m_chunk_sync = false;
+        m_chunks.emplace_back(send_chunk(begin, end));
+        begin = end;
+
+        // Chunk that was not pipelined is sent only when its reply is read.
+
+        if (m_chunk_sync && end < count && !complete_chunks(0))
+          break;
+      }
+
+      m_chunking = false;
+
+      if (complete_chunks(1) && !m_chunks.empty())
+      {
+        cdk::Reply *last = m_chunks.back().release();
+        m_chunks.clear();
+        return last;
+      }
+
+      complete_chunks(0);
+      return m_chunk_error.release();
+    }
+    catch (...)
+    {
+      m_chunking = false;
+      m_chunks.clear();
+      m_chunk_error.reset();
+      throw;
+    }
+  }
+
+  /*
+    Read replies to chunks until at most `left` of them are pending.
+    Returns false if server reported error for one of the chunks. The first
+    such reply is kept in m_chunk_error.
+  */
+
+  bool complete_chunks(size_t left)
+  {
+    while (m_chunks.size() > left)
+    {
+      std::unique_ptr<cdk::Reply> reply = std::move(m_chunks.front());
+      m_chunks.pop_front();
+      reply->wait();
+
+      if (0 < reply->entry_count())
+      {
+        if (!m_chunk_error)
+          m_chunk_error = std::move(reply);
+        continue;
+      }
+
+      if (m_chunk_error)
+        continue;
+
+      m_chunk_affected_rows += reply->affected_rows();
+      if (!m_chunk_auto_increment)
+        m_chunk_auto_increment = reply->last_insert_id();
+    }
+
+    return !m_chunk_error;
+  }
+
+  template <class Init>
+  cdk::Reply* new_chunk_reply(Init &init)
+  {
+    /*
+      If the chunk can not be pipelined, replies to earlier chunks must
+      be read first, as creating the reply would discard them.
+    */
+
+    if (!get_cdk_session().pipeline())
+    {
+      complete_chunks(0);
+      m_chunk_sync = true;
+    }
+    return new cdk::Reply(init);
+  }
+
   /*
     TODO: Currently send_command() allocates new cdk::Reply object on heap
     and then passes it to result object which takes ownership. Avoid dynamic
@@ -613,12 +1226,14 @@ protected:
 
   void set_limit(unsigned lm)
   {
+    set_modified();
     m_has_limit = true;
     m_limit = lm;
   }
 
   void set_offset(unsigned offset)
   {
+    set_modified();
     m_has_offset = true;
     m_offset = offset;
   }
@@ -632,6 +1247,7 @@ protected:
 
   void set_locking(internal::Lock_mode::value locking)
   {
+    set_modified();
     m_locking = locking;
   }
 
@@ -662,6 +1278,14 @@ protected:
     {
       el.first->second = std::move(val);
     }
+    else
+    {
+      /*
+        New parameter changes positions of placeholders in the command sent
+        to the server.
+      */
+      set_modified();
+    }
   }
 
   /*
@@ -677,6 +1301,7 @@ protected:
 
   void clear_params()
   {
+    set_modified();
     m_map.clear();
   }
 
@@ -690,6 +1315,7 @@ protected:
 
   bool m_inited = false;
   bool m_completed = false;
+  bool m_pipelined = false;
 
   /*
     Initialize statement execution (if not already done) by sending command
@@ -708,37 +1334,131 @@ protected:
     /*
       Prepare session for sending a new command. This gives session a chance
       to do necessary cleanups, such as consuming pending reply to a previous
-      command.
+      command. If pipelining is enabled, the command is sent without
+      consuming earlier replies and its reply is read later, when
+      the result is used.
     */
-    Session::Access::prepare_for_cmd(*m_sess);
+
+    m_pipelined = Session::Access::get_impl(*m_sess)->pipeline_cmd();
+    if (!m_pipelined)
+      Session::Access::prepare_for_cmd(*m_sess);
     m_reply.reset(send_command());
+
+    auto sess = Session::Access::get_impl(*m_sess);
+    sess->m_pending_op = this;
+    m_pending_sess = sess;
+  }
+
+  /*
+    If this operation is registered as the pending one in the session,
+    remove it from there.
+  */
+
+  std::weak_ptr<Session::Access::Impl> m_pending_sess;
+
+  void release_pending()
+  {
+    auto sess = m_pending_sess.lock();
+    if (sess && this == sess->m_pending_op)
+      sess->m_pending_op = nullptr;
+    m_pending_sess.reset();
+  }
+
+  /*
+    Called by the session before sending another command (see
+    Session_detail::Impl::m_pending_op). The result, or the error reported
+    by the server, is stored here until it is requested with get_result().
+  */
+
+  std::unique_ptr<internal::Result_base> m_async_res;
+  std::exception_ptr m_async_error;
+
+  void complete() override
+  {
+    m_pending_sess.reset();
+
+    try {
+      m_async_res.reset(new internal::Result_base(wait()));
+    }
+    catch (...)
+    {
+      m_async_error = std::current_exception();
+      m_reply.reset();
+      m_inited = false;
+      m_completed = false;
+    }
+  }
+
+  bool has_async_result() const
+  {
+    return m_async_res || m_async_error;
   }
 
   bool is_completed()
   {
-    if (m_completed)
+    if (m_completed || has_async_result())
       return true;
 
     init();
-    m_completed = (!m_reply) || m_reply->is_completed();
+    m_completed = (!m_reply) || m_pipelined || m_reply->is_completed();
     return m_completed;
   }
 
   /*
     Drive statement execution operation. First call init() to initialize it
     if it was not done before. Then wait for the reply object to become ready.
+
+    Note: This is used only for asynchronous execution (see
+    Executable::executeAsync()), which is not supported for sessions over
+    TLS connections: reads and writes on such connection block, which would
+    block the thread that drives the operations.
   */
 
   void cont()
   {
-    if (m_completed)
+    if (m_completed || has_async_result())
       return;
+    if (!m_inited && get_cdk_session().is_tls())
+      THROW("Asynchronous execution is not supported for sessions"
+            " using TLS connections");
     init();
-    if (m_reply)
+    if (m_reply && !m_pipelined)
     {
       m_reply->cont();
       if (0 < m_reply->entry_count())
+      {
+        release_pending();
         m_reply->get_error().rethrow();
+      }
+    }
+  }
+
+  /*
+    Return socket on which the operation waits (see Executable_impl).
+  */
+
+  int get_socket(bool &write)
+  {
+    write = false;
+
+    if (m_completed || has_async_result() || !m_reply)
+      return -1;
+
+    const cdk::api::Event_info *info = m_reply->waits_for();
+
+    if (!info)
+      return -1;
+
+    switch (info->type())
+    {
+    case cdk::api::Event_info::SOCKET_WR:
+      write = true;
+      // fall through
+    case cdk::api::Event_info::SOCKET_RD:
+      return (int)static_cast<const cdk::api::Socket_event_info*>(info)
+                  ->get_fd();
+    default:
+      return -1;
     }
   }
 
@@ -748,12 +1468,18 @@ protected:
 
   internal::Result_base wait()
   {
+    if (has_async_result())
+      return get_result();
+
     init();
-    if (m_reply)
+    if (m_reply && !m_pipelined)
     {
       m_reply->wait();
       if (0 < m_reply->entry_count())
+      {
+        release_pending();
         m_reply->get_error().rethrow();
+      }
     }
     return get_result();
   }
@@ -764,9 +1490,25 @@ protected:
 
   internal::Result_base get_result()
   {
+    if (m_async_error)
+    {
+      std::exception_ptr error = m_async_error;
+      m_async_error = nullptr;
+      std::rethrow_exception(error);
+    }
+
+    if (m_async_res)
+    {
+      internal::Result_base res(std::move(*m_async_res));
+      m_async_res.reset();
+      return res;
+    }
+
     if (!is_completed())
       THROW("Attempt to get result of incomplete operation");
 
+    release_pending();
+
     /*
       Server reply to the command is now passed to the result instance.
       We reset m_inited and m_completed flag so that upon next execution the
@@ -781,7 +1523,18 @@ protected:
       object.
     */
 
-    return mk_result(m_reply.release());
+    internal::Result_base res = mk_result(m_reply.release());
+
+    if (m_chunk_affected_rows || m_chunk_auto_increment)
+    {
+      internal::Result_base::Access::add_chunk_stats(
+        res, m_chunk_affected_rows, m_chunk_auto_increment
+      );
+      m_chunk_affected_rows = 0;
+      m_chunk_auto_increment = 0;
+    }
+
+    return res;
   }
 
 
@@ -848,6 +1601,7 @@ class Op_sort
 
   void add_sort(const mysqlx::string &sort)
   {
+    this->set_modified();
     m_order.push_back(sort);
   }
 
@@ -880,8 +1634,10 @@ private:
     for (cdk::string el : m_order)
     {
 
-      parser::Order_parser order_parser(PM, el);
-      order_parser.process_if(prc.list_el());
+      parser::Cached_expr order_expr(PM, el);
+      auto prc_el = prc.list_el();
+      if (prc_el)
+        order_expr.process(*prc_el);
 
     }
 
@@ -915,6 +1671,7 @@ class Op_having
 
   void set_having(const mysqlx::string &having)
   {
+    this->set_modified();
     m_having = having;
   }
 
@@ -941,8 +1698,8 @@ private:
 
   void process(cdk::Expression::  Processor& prc) const
   {
-    parser::Expression_parser expr_parser(PM, m_having);
-    expr_parser.process(prc);
+    parser::Cached_expr expr(PM, m_having);
+    expr.process(prc);
   }
 };
 
@@ -972,6 +1729,7 @@ class Op_group_by
 
   void add_group_by(const mysqlx::string &group_by)
   {
+    this->set_modified();
     m_group_by.push_back(group_by);
   }
 
@@ -1000,8 +1758,10 @@ private:
 
     for (cdk::string el : m_group_by)
     {
-      parser::Expression_parser expr_parser(PM, el);
-      expr_parser.process_if(prc.list_el());
+      parser::Cached_expr expr(PM, el);
+      auto prc_el = prc.list_el();
+      if (prc_el)
+        expr.process(*prc_el);
     }
 
     prc.list_end();
@@ -1051,11 +1811,13 @@ public:
 
   void set_proj(const mysqlx::string& doc)
   {
+    this->set_modified();
     m_doc_proj = doc;
   }
 
   void add_proj(const mysqlx::string& field)
   {
+    this->set_modified();
     m_projections.push_back(field);
   }
 
@@ -1103,9 +1865,9 @@ private:
 
       eprc.m_prc = &prc;
 
-      parser::Expression_parser parser(parser::Parser_mode::DOCUMENT, m_doc_proj);
+      parser::Cached_expr expr(parser::Parser_mode::DOCUMENT, m_doc_proj);
 
-      parser.process(eprc);
+      expr.process(eprc);
 
       return;
     }
@@ -1114,8 +1876,8 @@ private:
 
     for (cdk::string field : m_projections)
     {
-      parser::Projection_parser expr_parser(PM, field);
-      expr_parser.process(prc);
+      parser::Cached_expr expr(PM, field);
+      expr.process(prc);
     }
 
     prc.doc_end();
@@ -1129,10 +1891,10 @@ private:
     for (cdk::string el : m_projections)
     {
 
-      parser::Projection_parser order_parser(PM, el);
+      parser::Cached_expr expr(PM, el);
       auto prc_el = prc.list_el();
       if (prc_el)
-        order_parser.process(*prc_el);
+        expr.process(*prc_el);
 
     }
 
@@ -1164,7 +1926,7 @@ class Op_select : public Base
 protected:
 
   mysqlx::string m_where_expr;
-  std::unique_ptr<parser::Expression_parser> m_expr;
+  std::unique_ptr<parser::Cached_expr> m_expr;
 
   template <class X,
             typename std::enable_if<
@@ -1179,15 +1941,16 @@ protected:
     , m_where_expr(other.m_where_expr)
   {
     if (!m_where_expr.empty())
-      m_expr.reset(new parser::Expression_parser(PM, m_where_expr));
+      m_expr.reset(new parser::Cached_expr(PM, m_where_expr));
   }
 
 public:
 
   void add_where(const mysqlx::string &expr)
   {
+    this->set_modified();
     m_where_expr = expr;
-    m_expr.reset(new parser::Expression_parser(PM, m_where_expr));
+    m_expr.reset(new parser::Cached_expr(PM, m_where_expr));
   }
 
   cdk::Expression* get_where() const
@@ -361,8 +361,9 @@ static const Value convert(cdk::bytes, Format_descr<T>&);
 
 
 /*
-  Implementation for a single Row instance. It holds a copy of row
-  raw data and a shared pointer to row set meta-data.
+  Implementation for a single Row instance. It holds a shared pointer
+  to the row set which stores raw row data, position of the row in that
+  set and a shared pointer to row set meta-data.
 
   Using meta-data information, it can decode raw bytes of each
   field into appropriate Value.
@@ -373,25 +374,64 @@ class internal::Row_detail::Impl
 public:
 
   Impl() {}
-  Impl(const Row_data&, const std::shared_ptr<Meta_data>&);
+  Impl(const std::shared_ptr<Row_set>&, row_count_t,
+       const std::shared_ptr<Meta_data>&);
 
 private:
 
-  Row_data m_data;
+  std::shared_ptr<Row_set> m_data;
+  row_count_t m_row = 0;
   std::shared_ptr<Meta_data> m_mdata;
   std::map<col_count_t, Value> m_vals;
   col_count_t m_col_count = 0;
 
   void clear()
   {
-    m_data.clear();
+    m_data.reset();
     m_vals.clear();
     m_mdata.reset();
   }
 
+  /*
+    Get raw bytes of a field.
+    @throws std::out_of_range if the field is NULL or does not exist.
+  */
+
+  cdk::bytes get_raw(col_count_t pos) const
+  {
+    if (!m_data)
+      throw std::out_of_range("Row: no such field");
+    return m_data->get(m_row, pos);
+  }
+
+  /*
+    Variant of get_raw() which returns false if the field is NULL.
+  */
+
+  bool get_raw(col_count_t pos, cdk::bytes &data) const
+  {
+    if (!m_data)
+      throw std::out_of_range("Row: no such field");
+    return m_data->get(m_row, pos, data);
+  }
+
   bytes get_bytes(col_count_t pos) const
   {
-    return mysqlx::bytes::Access::mk(m_data.at(pos).data());
+    return mysqlx::bytes::Access::mk(get_raw(pos));
+  }
+
+  /*
+    Return value of a field stored in m_vals, if any. This is the case
+    for rows created by user, fields set by user and fields that were
+    already converted to Value by Row::get().
+  */
+
+  const Value* get_val(col_count_t pos) const
+  {
+    if (m_vals.empty())
+      return nullptr;
+    auto it = m_vals.find(pos);
+    return m_vals.end() == it ? nullptr : &it->second;
   }
 
   /*
@@ -406,7 +446,7 @@ private:
 
     m_vals.emplace(
       pos,
-      convert(m_data.at(pos).data(), fi.get<T>())
+      convert(get_raw(pos), fi.get<T>())
     );
 
     return m_vals.at(pos);
@@ -420,13 +460,14 @@ private:
 };
 
 
-// Note: row data is copied
+// Note: row data is not copied - it is shared with the result
 
 internal::Row_detail::Impl::Impl(
-  const Row_data &data,
+  const std::shared_ptr<Row_set> &data,
+  row_count_t row,
   const std::shared_ptr<Meta_data> &mdata
 )
-  : m_data(data), m_mdata(mdata)
+  : m_data(data), m_row(row), m_mdata(mdata)
 {}
 
 
@@ -581,6 +622,308 @@ void Row::clear()
 }
 
 
+/*
+  Typed access to row fields
+  --------------------------
+
+  Methods Row_detail::get_field() decode field values directly from raw
+  bytes stored in the row set, using codecs stored in the meta-data. Unlike
+  Row::get(), they do not create Value objects and do not store them in
+  m_vals. If a value of the field is stored in m_vals, it is used instead.
+*/
+
+
+bool Row::isNull(col_count_t pos) const
+{
+  try {
+    const Impl &impl = get_impl();
+    const Value *val = impl.get_val(pos);
+    if (val)
+      return val->isNull();
+    cdk::bytes raw;
+    return !impl.get_raw(pos, raw);
+  }
+  catch (const std::out_of_range&)
+  {
+    throw;
+  }
+  CATCH_AND_WRAP
+}
+
+
+bool internal::Row_detail::get_field(col_count_t pos, int64_t &val) const
+{
+  const Impl &impl = get_impl();
+  const Value *v = impl.get_val(pos);
+
+  if (v)
+  {
+    if (v->isNull())
+      return false;
+    val = (int64_t)*v;
+    return true;
+  }
+
+  cdk::bytes raw;
+  if (!impl.get_raw(pos, raw))
+    return false;
+
+  const Format_info &fi = impl.m_mdata->get_format(pos);
+
+  if (cdk::TYPE_INTEGER != fi.m_type)
+    THROW("Can not convert to integer value");
+
+  auto &fd = fi.get<cdk::TYPE_INTEGER>();
+
+  if (fd.m_format.is_unsigned())
+  {
+    uint64_t uval;
+    fd.m_codec.from_bytes(raw, uval);
+    if (uval > (uint64_t)std::numeric_limits<int64_t>::max())
+      THROW("Numeric conversion overflow");
+    val = (int64_t)uval;
+  }
+  else
+    fd.m_codec.from_bytes(raw, val);
+
+  return true;
+}
+
+
+bool internal::Row_detail::get_field(col_count_t pos, uint64_t &val) const
+{
+  const Impl &impl = get_impl();
+  const Value *v = impl.get_val(pos);
+
+  if (v)
+  {
+    if (v->isNull())
+      return false;
+    val = (uint64_t)*v;
+    return true;
+  }
+
+  cdk::bytes raw;
+  if (!impl.get_raw(pos, raw))
+    return false;
+
+  const Format_info &fi = impl.m_mdata->get_format(pos);
+
+  if (cdk::TYPE_INTEGER != fi.m_type)
+    THROW("Can not convert to integer value");
+
+  auto &fd = fi.get<cdk::TYPE_INTEGER>();
+
+  if (fd.m_format.is_unsigned())
+    fd.m_codec.from_bytes(raw, val);
+  else
+  {
+    int64_t ival;
+    fd.m_codec.from_bytes(raw, ival);
+    if (0 > ival)
+      THROW("Converting negative integer to unsigned value");
+    val = (uint64_t)ival;
+  }
+
+  return true;
+}
+
+
+bool internal::Row_detail::get_field(col_count_t pos, double &val) const
+{
+  const Impl &impl = get_impl();
+  const Value *v = impl.get_val(pos);
+
+  if (v)
+  {
+    if (v->isNull())
+      return false;
+    val = (double)*v;
+    return true;
+  }
+
+  cdk::bytes raw;
+  if (!impl.get_raw(pos, raw))
+    return false;
+
+  const Format_info &fi = impl.m_mdata->get_format(pos);
+
+  switch (fi.m_type)
+  {
+  case cdk::TYPE_FLOAT:
+    fi.get<cdk::TYPE_FLOAT>().m_codec.from_bytes(raw, val);
+    return true;
+
+  case cdk::TYPE_INTEGER:
+    {
+      auto &fd = fi.get<cdk::TYPE_INTEGER>();
+      if (fd.m_format.is_unsigned())
+      {
+        uint64_t uval;
+        fd.m_codec.from_bytes(raw, uval);
+        val = (double)uval;
+      }
+      else
+      {
+        int64_t ival;
+        fd.m_codec.from_bytes(raw, ival);
+        val = (double)ival;
+      }
+    }
+    return true;
+
+  default:
+    THROW("Value can not be converted to double");
+  }
+}
+
+
+bool internal::Row_detail::get_field(col_count_t pos, Decimal &val) const
+{
+  const Impl &impl = get_impl();
+  const Value *v = impl.get_val(pos);
+
+  if (v)
+  {
+    if (v->isNull())
+      return false;
+    val = (Decimal)*v;
+    return true;
+  }
+
+  cdk::bytes raw;
+  if (!impl.get_raw(pos, raw))
+    return false;
+
+  const Format_info &fi = impl.m_mdata->get_format(pos);
+
+  if (cdk::TYPE_FLOAT != fi.m_type
+      || cdk::Format<cdk::TYPE_FLOAT>::DECIMAL
+         != fi.get<cdk::TYPE_FLOAT>().m_format.type())
+    THROW("Value can not be converted to decimal");
+
+  auto &codec = fi.get<cdk::TYPE_FLOAT>().m_codec;
+  char buf[cdk::Codec<cdk::TYPE_FLOAT>::decimal_str_size];
+  size_t len = codec.decimal_to_string(raw, buf, sizeof(buf));
+
+  if (len > sizeof(buf))
+  {
+    std::string str(len, '\0');
+    codec.decimal_to_string(raw, &str[0], len);
+    val = Decimal(str);
+  }
+  else
+    val = Decimal(std::string(buf, len));
+
+  return true;
+}
+
+
+/*
+  Note: Strings and raw bytes returned by the protocol have extra 0x00
+  byte at the end, which is removed.
+*/
+
+bool internal::Row_detail::get_field(col_count_t pos, bytes &val) const
+{
+  const Impl &impl = get_impl();
+  const Value *v = impl.get_val(pos);
+
+  if (v)
+  {
+    switch (v->getType())
+    {
+    case Value::VNULL:
+      return false;
+    case Value::RAW:
+      val = v->getRawBytes();
+      return true;
+    case Value::STRING:
+      if (Value::Access::is_utf8(*v))
+      {
+        cdk::bytes data = Value::Access::get_utf8(*v);
+        val = bytes(data.begin(), data.end());
+        return true;
+      }
+      // fall through
+    default:
+      THROW("Value can not be accessed as raw bytes");
+    }
+  }
+
+  cdk::bytes raw;
+  if (!impl.get_raw(pos, raw))
+    return false;
+
+  switch (impl.m_mdata->get_type(pos))
+  {
+  case cdk::TYPE_STRING:
+  case cdk::TYPE_BYTES:
+  case cdk::TYPE_DOCUMENT:
+    if (0 < raw.size() && 0x00 == *(raw.end() - 1))
+      raw = cdk::bytes(raw.begin(), raw.end() - 1);
+    break;
+  default:
+    break;
+  }
+
+  val = bytes(raw.begin(), raw.end());
+  return true;
+}
+
+
+bool internal::Row_detail::get_field(col_count_t pos, std::string &val) const
+{
+  const Impl &impl = get_impl();
+  const Value *v = impl.get_val(pos);
+
+  if (v)
+  {
+    if (v->isNull())
+      return false;
+    val = v->get<std::string>();
+    return true;
+  }
+
+  cdk::bytes raw;
+  if (!impl.get_raw(pos, raw))
+    return false;
+
+  const Format_info &fi = impl.m_mdata->get_format(pos);
+
+  if (0 < raw.size() && 0x00 == *(raw.end() - 1))
+    raw = cdk::bytes(raw.begin(), raw.end() - 1);
+
+  switch (fi.m_type)
+  {
+  case cdk::TYPE_STRING:
+    {
+      auto &fd = fi.get<cdk::TYPE_STRING>();
+      cdk::Charset::value cs = fd.m_format.charset();
+
+      if (cdk::Charset::utf8 == cs || cdk::Charset::utf8mb4 == cs
+          || fd.m_format.is_set())
+      {
+        val.assign(raw.begin(), raw.end());
+        return true;
+      }
+
+      cdk::string str;
+      fd.m_codec.from_bytes(raw, str);
+      val = str;
+    }
+    return true;
+
+  case cdk::TYPE_DOCUMENT:
+    val.assign(raw.begin(), raw.end());
+    return true;
+
+  default:
+    THROW("Value can not be converted to string");
+  }
+}
+
+
 /*
   Conversions of raw value representation to Value objects.
 */
@@ -604,10 +947,17 @@ convert(
   if (fd.m_format.is_set())
     return Value(bytes(raw.begin(), raw.end()));
 
+  // UTF-8 strings are stored in the value without decoding them.
+
+  cdk::Charset::value cs = fd.m_format.charset();
+
+  if (cdk::Charset::utf8 == cs || cdk::Charset::utf8mb4 == cs)
+    return Value(std::string(raw.begin(), raw.end()));
+
   auto &codec = fd.m_codec;
   cdk::string str;
   codec.from_bytes(raw, str);
-  return Value(std::move(str));
+  return Value(mysqlx::string(std::move(str)));
 }
 
 
@@ -643,7 +993,18 @@ convert(
 {
   auto &fmt = fd.m_format;
 
-  // Note: DECIMAL format not yet supported by CDK
+  if (fmt.DECIMAL == fmt.type())
+  {
+    std::string str(cdk::Codec<cdk::TYPE_FLOAT>::decimal_str_size, '\0');
+    size_t len = fd.m_codec.decimal_to_string(data, &str[0], str.size());
+    if (len > str.size())
+    {
+      str.resize(len);
+      fd.m_codec.decimal_to_string(data, &str[0], str.size());
+    }
+    str.resize(len);
+    return Value::Access::mk_decimal(std::move(str));
+  }
 
   if (fmt.FLOAT == fmt.type())
   {
@@ -699,7 +1060,7 @@ convert(
 */
 
 
-void internal::Result_detail::Impl::init()
+void internal::Result_detail::Impl::init(bool first)
 {
   /*
     Note: This method is called also when moving to a next rset in a multi-result
@@ -710,19 +1071,32 @@ void internal::Result_detail::Impl::init()
   delete m_cursor;
   m_cursor = nullptr;
 
+  assert(m_sess);
+  m_pending = first && m_reply && 1 < m_sess->m_pipeline_depth;
+
   /*
     Registering this result with session will de-register currently registered
     result (if any) and give it a chance to cache pending data.
   */
 
-  assert(m_sess);
   m_sess->register_result(this);
 
   clear_cache();
 
-  if (!m_reply)
+  if (!m_reply || m_pending)
     return;
 
+  load();
+}
+
+
+/*
+  Wait for the reply and, if it has a result set, create a cursor
+  for reading it.
+*/
+
+void internal::Result_detail::Impl::load()
+{
   m_reply->wait();
 
   if (m_reply->entry_count() > 0)
@@ -732,6 +1106,7 @@ void internal::Result_detail::Impl::init()
   {
     m_cursor_closed = false;
     m_cursor = new cdk::Cursor(*m_reply);
+    m_cursor->set_fetch_size(m_fetch_size);
     m_cursor->wait();
     // copy meta-data information from cursor
     m_mdata = std::make_shared<Meta_data>(*m_cursor);
@@ -739,11 +1114,47 @@ void internal::Result_detail::Impl::init()
 }
 
 
+/*
+  Called before the result is used. If its reply was not read yet,
+  results registered before this one cache their data and then the reply
+  is loaded. Server error reported for a pipelined statement is thrown
+  here, on first use of the result.
+*/
+
+void internal::Result_detail::Impl::check_pending()
+{
+  if (m_pending)
+  {
+    m_pending = false;
+    m_check_error = true;
+    m_sess->activate_result(this);
+    load();
+  }
+
+  if (!m_check_error)
+    return;
+
+  m_check_error = false;
+
+  if (m_reply && 0 < m_reply->entry_count())
+    m_reply->get_error().rethrow();
+}
+
+
 internal::Result_detail::Impl::~Impl()
 {
   try {
     if (m_sess)
+    {
+      /*
+        Deleting a reply which was not read yet discards replies before
+        it -- give the corresponding results a chance to cache their data.
+      */
+
+      if (m_pending)
+        m_sess->activate_result(this);
       m_sess->deregister_result(this);
+    }
   }
   catch (...)
   {}
@@ -756,45 +1167,108 @@ internal::Result_detail::Impl::~Impl()
 
 void internal::Result_detail::Impl::deregister()
 {
+  if (m_pending)
+  {
+    m_pending = false;
+    m_check_error = true;
+    load();
+  }
+
   // cache remaining rows
   // TODO: handle multi rsets...
   count();
+
+  if (!m_reply || 0 < m_reply->entry_count())
+    return;
+
+  // Save warnings and statistics before session moves to the next reply.
+
+  try {
+    load_warnings();
+
+    if (m_all_warnings)
+    {
+      m_affected_rows = m_reply->affected_rows();
+      m_auto_increment = m_reply->last_insert_id();
+      m_has_stats = true;
+    }
+  }
+  catch (...)
+  {}
 }
 
 
-const Row_data* internal::Result_detail::Impl::get_row()
+/*
+  Maximal number of rows stored in a row set which is shared with Row
+  instances. When this limit is reached, a new row set is started so that
+  a single Row instance kept by user does not hold data of all rows read
+  after it.
+*/
+
+#define ROW_SET_SHARED_MAX 1024
+
+
+bool internal::Result_detail::Impl::next_row()
 {
   if (m_cache)
   {
-    if (m_row_cache_size == 0)
-      return nullptr;
+    if (m_next_row >= m_rows->row_count())
+      return false;
 
-    m_row = m_row_cache.front();
-    m_row_cache.pop_front();
-    m_row_cache_size--;
-    return &m_row;
+    m_row = m_next_row++;
+    return true;
   }
 
   if (!m_cursor)
     THROW("Attempt to read row from empty result");
 
   if (m_cursor_closed)
-    return NULL;
+    return false;
+
+  /*
+    If previous rows are not used by any Row instance, their storage is
+    re-used for the next row. Otherwise the next row is appended to
+    the same row set, unless it has grown too big (appending does not move
+    data of the rows already stored there).
+  */
+
+  if (m_rows && 1 == m_rows.use_count())
+    m_rows->clear();
+  else if (!m_rows || m_rows->row_count() >= ROW_SET_SHARED_MAX)
+    m_rows = std::make_shared<Row_set>(m_cursor->col_count());
+
+  if (!read_row())
+    return false;
+
+  m_row = m_rows->row_count() - 1;
+  return true;
+}
+
+
+/*
+  Read next row from the cursor and append it to m_rows. Returns false
+  if there are no more rows.
+*/
+
+bool internal::Result_detail::Impl::read_row()
+{
+  if (m_cursor_closed)
+    return false;
 
   /*
     TODO: Row cache for better I/O performance (read several rows at once)
   */
   if (m_cursor->get_row(*this))
-    return &m_row;
+    return true;
 
   /*
-    Cleanup after reading all rows. Note
+    Cleanup after reading all rows.
   */
 
   m_cursor->close();
   m_cursor_closed = true;
 
-  return NULL;
+  return false;
 }
 
 
@@ -807,32 +1281,20 @@ auto internal::Result_detail::Impl::count() -> row_count_t
 
   if (!m_cache)
   {
-    auto it = m_row_cache.before_begin();
+    /*
+      Read all remaining rows into a new row set (rows read previously
+      can be still used by Row instances).
+    */
 
-    for(const Row_data *row = get_row(); row != nullptr; row = get_row())
-    {
-      ++m_row_cache_size;
-      it = m_row_cache.insert_after(it, *row);
-    }
+    m_rows = std::make_shared<Row_set>(m_cursor->col_count());
+    m_next_row = 0;
+
+    while (read_row())
+    {}
   }
 
   m_cache = true;
-  return m_row_cache_size;
-}
-
-
-size_t internal::Result_detail::Impl::field_begin(col_count_t pos, size_t size)
-{
-  m_row.insert(std::pair<col_count_t, Buffer>(pos, Buffer()));
-  // FIX
-  return size;
-}
-
-size_t internal::Result_detail::Impl::field_data(col_count_t pos, bytes data)
-{
-  m_row[(unsigned)pos].append(mysqlx::bytes::Access::mk(data));
-  // FIX
-  return data.size();
+  return m_rows->row_count() - m_next_row;
 }
 
 
@@ -968,6 +1430,7 @@ auto internal::Result_detail::get_impl() -> Impl&
 {
   if (!m_impl)
     THROW("Invalid result set");
+  m_impl->check_pending();
   return *m_impl;
 }
 
@@ -979,6 +1442,18 @@ void internal::Result_detail::check_result() const
 }
 
 
+void internal::Result_detail::set_fetch_size(uint64_t rows)
+{
+  Impl &impl = get_impl();
+
+  // Remember the size for cursors of the following result sets
+
+  impl.m_fetch_size = rows;
+  if (impl.m_cursor)
+    impl.m_cursor->set_fetch_size(rows);
+}
+
+
 void internal::Result_detail::iterator_start()
 {
   m_wpos = 0;
@@ -1102,13 +1577,13 @@ Row internal::Row_result_detail::get_row()
 {
   Impl &impl = get_impl();
 
-  const Row_data *row = impl.get_row();
-
-  if (!row)
+  if (!impl.next_row())
     return Row();
 
   return internal::Row_detail(
-    std::make_shared<internal::Row_detail::Impl>(*row, impl.m_mdata)
+    std::make_shared<internal::Row_detail::Impl>(
+      impl.m_rows, impl.m_row, impl.m_mdata
+    )
   );
 }
 
@@ -1181,13 +1656,13 @@ uint64_t mysqlx::SqlResult::getAutoIncrementValue()
 
 DbDoc internal::Doc_result_detail::get_doc()
 {
-  const Row_data *row = get_impl().get_row();
+  Impl &impl = get_impl();
 
-  if (!row)
+  if (!impl.next_row())
     return DbDoc();
 
   // @todo Avoid copying of document string.
-  cdk::foundation::bytes data = row->at(0).data();
+  cdk::foundation::bytes data = impl.get_field(0);
   return DbDoc(std::string(data.begin(),data.end()-1));
 }
 
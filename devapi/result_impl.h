@@ -38,26 +38,193 @@ namespace mysqlx {
 using cdk::foundation::variant;
 
 /*
-  Convenience wrapper around std container that is used
-  to store incoming raw bytes sequence.
+  Storage for raw data of rows read from a cursor.
+
+  Bytes of all fields of all rows are stored in arena blocks. For each row
+  there is an array of Field entries, one per column, which point at field
+  data inside a block (or mark the field as NULL). Blocks are allocated
+  with fixed size and never re-allocated, so that data of rows already
+  stored does not move when new rows are added -- Row instances and values
+  taken from them can refer to it directly. A field which does not fit
+  into the remaining space of the current block is stored in a new block,
+  which is made big enough for it. When row set is cleared, its blocks are
+  re-used for storing new rows, so storing a row does not require any
+  allocations once the blocks have been allocated.
+
+  Row instances refer to rows stored in a Row_set which they share with
+  the result object, instead of keeping their own copy of row data.
 */
 
-class Buffer
+class Row_set
 {
-  std::vector<byte> m_impl;
+  struct Field
+  {
+    byte  *m_data;
+    size_t m_len;
+  };
+
+  static const size_t NULL_FIELD = (size_t)-1;
+
+  enum { BLOCK_SIZE = 16 * 1024 };
+
+  struct Block
+  {
+    std::unique_ptr<byte[]> m_data;
+    size_t m_size;
+  };
+
+  col_count_t        m_col_count;
+  row_count_t        m_row_count = 0;
+  std::vector<Block> m_blocks;
+  size_t             m_block = 0;  // current block
+  size_t             m_used = 0;   // bytes used in the current block
+  std::vector<Field> m_fields;
+
+  Field& last_field(col_count_t pos)
+  {
+    assert(0 < m_row_count && pos < m_col_count);
+    return m_fields[(size_t)(m_row_count - 1)*m_col_count + pos];
+  }
+
+  /*
+    Make sure that there is space for given number of bytes in the current
+    block, moving to the next block if needed. Blocks that are too small
+    are replaced by new ones.
+  */
+
+  void reserve(size_t size)
+  {
+    if (m_block < m_blocks.size() && m_used + size <= m_blocks[m_block].m_size)
+      return;
+
+    if (m_block < m_blocks.size())
+      m_block++;
+    m_used = 0;
+
+    if (m_block < m_blocks.size() && size <= m_blocks[m_block].m_size)
+      return;
+
+    size_t block_size = BLOCK_SIZE;
+    if (size > block_size)
+      block_size = size;
+    Block block{ std::unique_ptr<byte[]>(new byte[block_size]), block_size };
+
+    if (m_block < m_blocks.size())
+      m_blocks[m_block] = std::move(block);
+    else
+      m_blocks.push_back(std::move(block));
+  }
 
 public:
 
-  void append(bytes data)
+  Row_set(col_count_t col_count)
+    : m_col_count(col_count)
+  {}
+
+  col_count_t col_count() const { return m_col_count; }
+  row_count_t row_count() const { return m_row_count; }
+
+  /*
+    Note: clearing keeps allocated memory for storing new rows. It can be
+    done only if rows are not referred to from elsewhere.
+  */
+
+  void clear()
   {
-    m_impl.insert(m_impl.end(), data.begin(), data.end());
+    m_row_count = 0;
+    m_block = 0;
+    m_used = 0;
+    m_fields.clear();
   }
 
-  size_t size() const { return m_impl.size(); }
+  /*
+    Methods used to store new row. Fields of the new row are NULL until
+    their data is added with field_begin() and field_data(). Data of a field
+    must be added before data of the next field. The size passed to
+    field_begin() is the expected size of field data, used to reserve space
+    for it.
+  */
 
-  cdk::bytes data() const
+  void add_row()
   {
-    return cdk::bytes((byte*)m_impl.data(), m_impl.size());
+    m_fields.resize(m_fields.size() + m_col_count, Field{ NULL, NULL_FIELD });
+    m_row_count++;
+  }
+
+  void field_begin(col_count_t pos, size_t size)
+  {
+    if (pos >= m_col_count)
+      return;
+    reserve(size);
+    Field &f = last_field(pos);
+    f.m_data = m_blocks[m_block].m_data.get() + m_used;
+    f.m_len = 0;
+  }
+
+  void field_data(col_count_t pos, cdk::bytes data)
+  {
+    if (pos >= m_col_count)
+      return;
+
+    Field &f = last_field(pos);
+
+    /*
+      If there is more data than expected and it does not fit into
+      the current block, the field is moved to a new block.
+    */
+
+    if (m_used + data.size() > m_blocks[m_block].m_size)
+    {
+      byte *prev = f.m_data;
+      reserve(f.m_len + data.size());
+      f.m_data = m_blocks[m_block].m_data.get() + m_used;
+      if (f.m_len)
+        memcpy(f.m_data, prev, f.m_len);
+      m_used += f.m_len;
+    }
+
+    if (data.size())
+      memcpy(f.m_data + f.m_len, data.begin(), data.size());
+    f.m_len += data.size();
+    m_used += data.size();
+  }
+
+  /*
+    Return raw bytes of a field in given row. Similar to std::map::at(),
+    throws std::out_of_range if the field is NULL or there is no such column.
+  */
+
+  cdk::bytes get(row_count_t row, col_count_t pos) const
+  {
+    if (row >= m_row_count || pos >= m_col_count)
+      throw std::out_of_range("Row_set: no such field");
+
+    const Field &f = m_fields[(size_t)row*m_col_count + pos];
+
+    if (NULL_FIELD == f.m_len)
+      throw std::out_of_range("Row_set: NULL field");
+
+    return cdk::bytes(f.m_data, f.m_len);
+  }
+
+  /*
+    Variant of get() which does not throw errors for NULL fields. Returns
+    false if the field is NULL, otherwise sets `data` to raw bytes of
+    the field.
+  */
+
+  bool get(row_count_t row, col_count_t pos, cdk::bytes &data) const
+  {
+    if (row >= m_row_count || pos >= m_col_count)
+      throw std::out_of_range("Row_set: no such field");
+
+    const Field &f = m_fields[(size_t)row*m_col_count + pos];
+
+    if (NULL_FIELD == f.m_len)
+      return false;
+
+    data = cdk::bytes(f.m_data, f.m_len);
+    return true;
   }
 };
 
@@ -338,7 +505,10 @@ struct Meta_data
 
   const Format_info& get_format(cdk::col_count_t pos) const
   {
-    return  *get_column(pos);
+    // Note: m_formats gives fast access without map look-up.
+    if (pos < m_formats.size() && m_formats[pos])
+      return *m_formats[pos];
+    return *at(pos);
   }
 
   cdk::Type_info get_type(cdk::col_count_t pos) const
@@ -354,6 +524,14 @@ struct Meta_data
 private:
 
   cdk::col_count_t  m_col_count = 0;
+  std::vector<const Format_info*> m_formats;
+
+  void add_format(cdk::col_count_t pos, const Format_info *fi)
+  {
+    if (pos >= m_formats.size())
+      m_formats.resize(pos + 1, nullptr);
+    m_formats[pos] = fi;
+  }
 
   /*
     Add to this Meta_data instance information about column
@@ -370,6 +548,7 @@ private:
     col->store_info(ci);
 
     emplace(pos, Col_impl_ptr(col));
+    add_format(pos, col);
   }
 
   /*
@@ -384,20 +563,13 @@ private:
     col->store_info(ci);
 
     emplace(pos, Col_impl_ptr(col));
+    add_format(pos, col);
   }
 
   friend internal::Result_detail::Access::Impl;
 };
 
 
-/*
-  Data structure used to hold raw row data. It holds a Buffer with
-  raw bytes for each non-null field of a row.
-*/
-
-typedef std::map<col_count_t, Buffer> Row_data;
-
-
 /*
   Internal implementation for Result objects.
 */
@@ -418,38 +590,93 @@ struct internal::Result_detail::Impl
   Session_impl_ptr  m_sess;
   cdk::Reply  *m_reply = NULL;
   cdk::Cursor *m_cursor = NULL;
-  Row_data     m_row;
   // Note: meta-data is shared with Row instances
   std::shared_ptr<Meta_data>  m_mdata;
   std::vector<GUID>           m_guid;
   bool                        m_cursor_closed = false;
+  cdk::row_count_t            m_fetch_size = 0;
 
-  std::forward_list<Row_data> m_row_cache;
-  row_count_t m_row_cache_size = 0;
+  /*
+    Rows read from the cursor are stored in m_rows and m_row is the position
+    of the current row there. If all remaining rows were read into m_rows
+    (m_cache is true), m_next_row is the position of the next row to be
+    returned from the cache.
+  */
+
+  std::shared_ptr<Row_set> m_rows;
+  row_count_t m_row = 0;
+  row_count_t m_next_row = 0;
   bool m_cache = false;
 
+  /*
+    If pipelining is enabled in the session, the reply is not read when
+    the result is created. Flag m_pending is true until it is read, which
+    happens when the result is used for the first time (see check_pending())
+    or when a later result is used (see deregister()). Server error is
+    reported on first use after reading the reply (m_check_error is set).
+  */
+
+  bool m_pending = false;
+  bool m_check_error = false;
+
+  /*
+    Statement statistics saved in deregister(), as they are not available
+    from the reply after session moves on to a next reply.
+  */
+
+  bool m_has_stats = false;
+  cdk::row_count_t m_affected_rows = 0;
+  cdk::row_count_t m_auto_increment = 0;
+
+  /*
+    Statistics of earlier chunks of an insert which was sent in several
+    chunks (see Op_base::send_chunks()). The reply held by this result is
+    the reply to the last chunk. Auto increment value is the one generated
+    for the first chunk.
+  */
+
+  cdk::row_count_t m_chunk_affected_rows = 0;
+  cdk::row_count_t m_chunk_auto_increment = 0;
+
+  void add_chunk_stats(cdk::row_count_t affected_rows,
+                       cdk::row_count_t auto_increment)
+  {
+    m_chunk_affected_rows += affected_rows;
+    if (!m_chunk_auto_increment)
+      m_chunk_auto_increment = auto_increment;
+  }
+
 
   Impl(const Session_impl_ptr &sess, cdk::Reply *r)
     :  m_sess(sess), m_reply(r)
   {
-    init();
+    init(true);
   }
 
   Impl(const Session_impl_ptr &sess, cdk::Reply *r, const std::vector<GUID> &guids)
     : m_sess(sess), m_reply(r), m_guid(guids)
   {
-    init();
+    init(true);
   }
 
   virtual ~Impl();
 
-  void init();
+  /*
+    Register the result with the session and load the reply (see load()).
+    The `first` flag is true when called from the constructor -- then
+    loading of the reply can be postponed (see m_pending).
+  */
+
+  void init(bool first = false);
+  void load();
+  void check_pending();
 
 
   void clear_cache()
   {
-    m_row_cache.clear();
-    m_row_cache_size = 0;
+    m_rows.reset();
+    m_row = 0;
+    m_next_row = 0;
     m_cache = false;
   }
 
@@ -503,13 +730,25 @@ struct internal::Result_detail::Impl
   }
 
   /*
-    Read next row from the cursor. Returns NULL if there are no
-    more rows. Throws exeption if this result has no data.
+    Move to the next row of the result, which is then available in m_rows
+    at position m_row. Returns false if there are no more rows. Throws
+    exeption if this result has no data.
   */
 
-  const Row_data *get_row();
+  bool next_row();
   row_count_t count();
 
+  cdk::bytes get_field(col_count_t pos) const
+  {
+    return m_rows->get(m_row, pos);
+  }
+
+private:
+
+  bool read_row();
+
+public:
+
   col_count_t get_col_count() const
   {
     if (!m_cursor)
@@ -528,13 +767,18 @@ struct internal::Result_detail::Impl
   {
     if (!m_reply)
       THROW("Attempt to get affected rows count on empty result");
-    return m_reply->affected_rows();
+    return m_chunk_affected_rows
+      + (m_has_stats ? m_affected_rows : m_reply->affected_rows());
   }
 
   cdk::row_count_t get_auto_increment() const
   {
     if (!m_reply)
       THROW("Attempt to get auto increment value on empty result");
+    if (m_chunk_auto_increment)
+      return m_chunk_auto_increment;
+    if (m_has_stats)
+      return m_auto_increment;
     return m_reply->last_insert_id();
   }
 
@@ -560,15 +804,26 @@ struct internal::Result_detail::Impl
 
   bool row_begin(row_count_t)
   {
-    m_row.clear();
+    m_rows->add_row();
     return true;
   }
   void row_end(row_count_t) {}
 
-  size_t field_begin(col_count_t pos, size_t);
+  size_t field_begin(col_count_t pos, size_t size)
+  {
+    m_rows->field_begin(pos, size);
+    return size;
+  }
+
   void   field_end(col_count_t) {}
   void   field_null(col_count_t) {}
-  size_t field_data(col_count_t pos, bytes);
+
+  size_t field_data(col_count_t pos, bytes data)
+  {
+    m_rows->field_data(pos, data);
+    return data.size();
+  }
+
   void   end_of_data() {}
 
   friend internal::Row_result_detail;
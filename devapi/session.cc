@@ -29,6 +29,7 @@
 #include <iostream>
 #include <sstream>
 #include <list>
+#include <algorithm>
 
 #include "impl.h"
 
@@ -219,6 +220,41 @@ cdk::ds::mysqlx::Protocol_options::auth_method_t get_auth_method(const std::stri
 }
 
 
+cdk::ds::mysqlx::Protocol_options::compression_mode_t
+get_compression_mode(CompressionMode mode)
+{
+  switch (mode)
+  {
+  case CompressionMode::PREFERRED:
+    return cdk::ds::mysqlx::Protocol_options::COMPRESSION_PREFERRED;
+  case CompressionMode::REQUIRED:
+    return cdk::ds::mysqlx::Protocol_options::COMPRESSION_REQUIRED;
+  default:
+    return cdk::ds::mysqlx::Protocol_options::COMPRESSION_DISABLED;
+  }
+}
+
+
+cdk::ds::mysqlx::Protocol_options::compression_mode_t
+get_compression_mode(const std::string &name)
+{
+#define map_compression(x) { #x, CompressionMode::x },
+  static std::map<std::string, CompressionMode>
+    compression_modes{ COMPRESSION_MODES(map_compression) };
+
+  try {
+    return get_compression_mode(compression_modes.at(name));
+  }
+  catch (const std::out_of_range&)
+  {
+    std::string msg = "Invalid compression value: " + std::string(name);
+    throw_error(msg.c_str());
+    // Quiet compiler warnings
+    return cdk::ds::mysqlx::Protocol_options::COMPRESSION_DISABLED;
+  }
+}
+
+
 struct Host_sources : public cdk::ds::Multi_source
 {
 
@@ -454,6 +490,13 @@ struct URI_parser
       std::transform(val.begin(), val.end(), auth.begin(), ::toupper);
 
       set_auth_method(get_auth_method(auth));
+    } else if (lc_key == "compression")
+    {
+      std::string mode;
+      mode.resize(val.size());
+      std::transform(val.begin(), val.end(), mode.begin(), ::toupper);
+
+      set_compression(get_compression_mode(mode));
     } else
     {
       std::stringstream err;
@@ -474,321 +517,343 @@ struct URI_parser
 Session::Session(SessionSettings settings)
 {
   try {
+    m_impl = Impl::create(settings);
+  }
+  CATCH_AND_WRAP
+}
 
-    /*
-      If URI option is specified, get settings from the connetion string.
-      TODO: Allow further modifying of URI settings by individual options.
-    */
 
-    if (settings.has_option(SessionOption::URI))
-    {
-      URI_parser parser(
-            settings.find(SessionOption::URI).get<string>()
-          );
+/*
+  Create session implementation, connecting to one of the hosts specified
+  by the settings.
+*/
 
-      m_impl = std::make_shared<Impl>(parser.get_data_source());
-      return;
-    }
+std::shared_ptr<internal::Session_detail::Impl>
+internal::Session_detail::Impl::create(SessionSettings &settings)
+{
+  /*
+    If URI option is specified, get settings from the connetion string.
+    TODO: Allow further modifying of URI settings by individual options.
+  */
 
-    /*
-      Parse common options that apply to all hosts in a multi-host setting.
-    */
+  if (settings.has_option(SessionOption::URI))
+  {
+    URI_parser parser(
+          settings.find(SessionOption::URI).get<string>()
+        );
 
-    std::string pwd_str;
-    bool has_pwd = false;
-    bool has_ssl = false;
+    return std::make_shared<Impl>(parser.get_data_source());
+  }
+
+  /*
+    Parse common options that apply to all hosts in a multi-host setting.
+  */
+
+  std::string pwd_str;
+  bool has_pwd = false;
+  bool has_ssl = false;
 
 #ifdef WITH_SSL
-    TLS_Options opt_ssl = TLS_Options::SSL_MODE::REQUIRED;
+  TLS_Options opt_ssl = TLS_Options::SSL_MODE::REQUIRED;
 #endif // WITH_SSL
 
-    if (settings.has_option(SessionOption::PWD) &&
-        settings.find(SessionOption::PWD).isNull() == false)
-    {
-      has_pwd = true;
-      pwd_str = settings.find(SessionOption::PWD).get<string>();
-    }
+  if (settings.has_option(SessionOption::PWD) &&
+      settings.find(SessionOption::PWD).isNull() == false)
+  {
+    has_pwd = true;
+    pwd_str = settings.find(SessionOption::PWD).get<string>();
+  }
 
-    string user;
-    string database;
-    bool   has_db = false;
+  string user;
+  string database;
+  bool   has_db = false;
 
-    if (settings.has_option(SessionOption::USER))
-    {
-      user = settings.find(SessionOption::USER);
-    }
-    else
-    {
-      throw Error("User not defined!");
-    }
+  if (settings.has_option(SessionOption::USER))
+  {
+    user = settings.find(SessionOption::USER);
+  }
+  else
+  {
+    throw Error("User not defined!");
+  }
 
-    if (settings.has_option(SessionOption::DB))
-    {
-      has_db = true;
-      database = settings.find(SessionOption::DB).get<string>();
-    }
+  if (settings.has_option(SessionOption::DB))
+  {
+    has_db = true;
+    database = settings.find(SessionOption::DB).get<string>();
+  }
 
-    AuthMethod auth_method = AuthMethod::MYSQL41;  // avoid compiler warning
-    bool       has_auth = settings.has_option(SessionOption::AUTH);
+  AuthMethod auth_method = AuthMethod::MYSQL41;  // avoid compiler warning
+  bool       has_auth = settings.has_option(SessionOption::AUTH);
 
-    if (has_auth)
-    {
-      auth_method =
-        AuthMethod(settings.find(SessionOption::AUTH).get<unsigned>());
-    }
+  if (has_auth)
+  {
+    auth_method =
+      AuthMethod(settings.find(SessionOption::AUTH).get<unsigned>());
+  }
 
 
-    /*
-      Set common cdk session options based what was found above.
-    */
+  CompressionMode compression = CompressionMode::DISABLED;
 
-    auto set_common_options
-      = [&has_db, &database,&has_auth,&auth_method]
-        (cdk::ds::mysqlx::Options &opt, bool secure)
-    {
-      if (has_db)
-        opt.set_database(database);
+  if (settings.has_option(SessionOption::COMPRESSION))
+  {
+    compression = CompressionMode(
+      settings.find(SessionOption::COMPRESSION).get<unsigned>()
+    );
+  }
 
-      if (has_auth)
-      {
-        switch(auth_method)
-        {
-        case AuthMethod::PLAIN:
-          opt.set_auth_method(cdk::ds::mysqlx::Options::PLAIN);
-        break;
-        case AuthMethod::MYSQL41:
-          opt.set_auth_method(cdk::ds::mysqlx::Options::MYSQL41);
-        break;
-        case AuthMethod::EXTERNAL:
-          opt.set_auth_method(cdk::ds::mysqlx::Options::EXTERNAL);
-        break;
-        }
-      }
-      else
+
+  /*
+    Set common cdk session options based what was found above.
+  */
+
+  auto set_common_options
+    = [&has_db, &database,&has_auth,&auth_method,&compression]
+      (cdk::ds::mysqlx::Options &opt, bool secure)
+  {
+    if (has_db)
+      opt.set_database(database);
+
+    opt.set_compression(get_compression_mode(compression));
+
+    if (has_auth)
+    {
+      switch(auth_method)
       {
-        opt.set_auth_method(secure ? cdk::ds::mysqlx::Options::PLAIN
-                                   : cdk::ds::mysqlx::Options::MYSQL41);
+      case AuthMethod::PLAIN:
+        opt.set_auth_method(cdk::ds::mysqlx::Options::PLAIN);
+      break;
+      case AuthMethod::MYSQL41:
+        opt.set_auth_method(cdk::ds::mysqlx::Options::MYSQL41);
+      break;
+      case AuthMethod::EXTERNAL:
+        opt.set_auth_method(cdk::ds::mysqlx::Options::EXTERNAL);
+      break;
       }
+    }
+    else
+    {
+      opt.set_auth_method(secure ? cdk::ds::mysqlx::Options::PLAIN
+                                 : cdk::ds::mysqlx::Options::MYSQL41);
+    }
 
-    };
+  };
 
 
-    if (settings.has_option(SessionOption::SSL_MODE) ||
-        settings.has_option(SessionOption::SSL_CA))
-    {
-      has_ssl = true;
+  if (settings.has_option(SessionOption::SSL_MODE) ||
+      settings.has_option(SessionOption::SSL_CA))
+  {
+    has_ssl = true;
 #ifdef WITH_SSL
 
-      if (settings.has_option(SessionOption::SSL_CA))
-      {
-        opt_ssl.set_ca(settings.find(SessionOption::SSL_CA).get<string>());
-        if (!settings.has_option(SessionOption::SSL_MODE))
-          set_ssl_mode(opt_ssl, SSLMode::VERIFY_CA);
-      }
+    if (settings.has_option(SessionOption::SSL_CA))
+    {
+      opt_ssl.set_ca(settings.find(SessionOption::SSL_CA).get<string>());
+      if (!settings.has_option(SessionOption::SSL_MODE))
+        set_ssl_mode(opt_ssl, SSLMode::VERIFY_CA);
+    }
 
-      if (settings.has_option(SessionOption::SSL_MODE))
+    if (settings.has_option(SessionOption::SSL_MODE))
+    {
+      SSLMode m
+        = SSLMode(settings.find(SessionOption::SSL_MODE).get<unsigned>());
+
+      switch (m)
       {
-        SSLMode m
-          = SSLMode(settings.find(SessionOption::SSL_MODE).get<unsigned>());
+      case SSLMode::VERIFY_CA:
+      case SSLMode::VERIFY_IDENTITY:
 
-        switch (m)
+        if (!settings.has_option(SessionOption::SSL_CA))
         {
-        case SSLMode::VERIFY_CA:
-        case SSLMode::VERIFY_IDENTITY:
-
-          if (!settings.has_option(SessionOption::SSL_CA))
-          {
-            std::string msg = "SSL mode ";
-            msg += internal::Settings_traits::get_mode_name(m);
-            msg += " requires ssl-ca setting";
-            throw_error(msg.c_str());
-          }
-
-        default:
-          break;
+          std::string msg = "SSL mode ";
+          msg += internal::Settings_traits::get_mode_name(m);
+          msg += " requires ssl-ca setting";
+          throw_error(msg.c_str());
         }
 
-        set_ssl_mode(opt_ssl, m);
+      default:
+        break;
       }
+
+      set_ssl_mode(opt_ssl, m);
+    }
 #else
-      throw_error(
-            "Can not create TLS session - this connector is built"
-            " without TLS support."
-            );
+    throw_error(
+          "Can not create TLS session - this connector is built"
+          " without TLS support."
+          );
 #endif
-    }
+  }
 
-    /*
-      Go through the list of options and build data sources list.
-    */
+  /*
+    Go through the list of options and build data sources list.
+  */
 
-    Host_sources source;
+  Host_sources source;
 
-    std::string host = "localhost";
-    std::string socket;
-    unsigned port = DEFAULT_MYSQLX_PORT;
-    unsigned priority = 0;
+  std::string host = "localhost";
+  std::string socket;
+  unsigned port = DEFAULT_MYSQLX_PORT;
+  unsigned priority = 0;
 
-    auto it = settings.begin();
+  auto it = settings.begin();
 
-    bool initialized = false;
-    bool add = false;
+  bool initialized = false;
+  bool add = false;
 
-    //HOST can be skipped only on single host scenarios
-    bool singlehost = false;
-    bool socket_only = true;
+  //HOST can be skipped only on single host scenarios
+  bool singlehost = false;
+  bool socket_only = true;
 
-    /*
-      Check for PORT and PRIORITY settings and if present,
-      store values in port and priority variables.
-    */
+  /*
+    Check for PORT and PRIORITY settings and if present,
+    store values in port and priority variables.
+  */
 
-    auto port_prio
-      = [&it, &settings, &port, &priority](bool with_port)
+  auto port_prio
+    = [&it, &settings, &port, &priority](bool with_port)
+  {
+    if (with_port &&
+        it != settings.end() &&
+        it->first ==SessionOption::PORT)
     {
-      if (with_port &&
-          it != settings.end() &&
-          it->first ==SessionOption::PORT)
-      {
-        port = it->second;
-        if (port > 65535U)
-          throw_error("Port value out of range");
-        ++it;
-      }
-
-      if (it != settings.end() && it->first == SessionOption::PRIORITY)
-      {
-        priority = static_cast<unsigned>(it->second);
+      port = it->second;
+      if (port > 65535U)
+        throw_error("Port value out of range");
+      ++it;
+    }
 
-        if (priority > max_priority)
-          throw_error("Priority should be a value between 0 and 100");
+    if (it != settings.end() && it->first == SessionOption::PRIORITY)
+    {
+      priority = static_cast<unsigned>(it->second);
 
-        ++priority;
+      if (priority > max_priority)
+        throw_error("Priority should be a value between 0 and 100");
 
-        if (priority > 65535U)
-          throw_error("Priority value out of range");
-      }
-      else
-      {
-        --it;
-      }
-    };
+      ++priority;
 
-    do
+      if (priority > 65535U)
+        throw_error("Priority value out of range");
+    }
+    else
     {
+      --it;
+    }
+  };
+
+  do
+  {
 #ifndef _WIN32
-      if (it != settings.end() && it->first ==SessionOption::SOCKET)
-      {
-        if (singlehost)
-          throw Error("On multiple hosts, HOST option can't be skipped.");
+    if (it != settings.end() && it->first ==SessionOption::SOCKET)
+    {
+      if (singlehost)
+        throw Error("On multiple hosts, HOST option can't be skipped.");
 
-        add = true;
-        priority = 0;
+      add = true;
+      priority = 0;
 
-        socket = it->second.get<string>();
+      socket = it->second.get<string>();
 
-        ++it;
+      ++it;
 
-        port_prio(false);
+      port_prio(false);
 
-      }else
+    }else
 #endif //_WIN32
 
-      if (it != settings.end() && it->first ==SessionOption::HOST)
-      {
-        if (singlehost)
-          throw Error("On multiple hosts, HOST option can't be skipped.");
+    if (it != settings.end() && it->first ==SessionOption::HOST)
+    {
+      if (singlehost)
+        throw Error("On multiple hosts, HOST option can't be skipped.");
 
-        add = true;
-        port = DEFAULT_MYSQLX_PORT;
-        priority = 0;
+      add = true;
+      port = DEFAULT_MYSQLX_PORT;
+      priority = 0;
 
-        host = it->second.get<string>();
+      host = it->second.get<string>();
 
-        if (host.empty())
-          throw Error("Empty host.");
+      if (host.empty())
+        throw Error("Empty host.");
 
-        ++it;
+      ++it;
 
-        port_prio(true);
+      port_prio(true);
 
-      }
-      else if (it->first ==SessionOption::PORT)
+    }
+    else if (it->first ==SessionOption::PORT)
+    {
+      if (!initialized)
       {
-        if (!initialized)
-        {
-          add = true;
-          singlehost = true;
-          port_prio(true);
-        }
-        else
-        {
-          throw Error("Incorrect settings order! Passed Port without previously passing HOST");
-        }
-
+        add = true;
+        singlehost = true;
+        port_prio(true);
       }
-      else if (it->first ==SessionOption::PRIORITY)
+      else
       {
-        throw Error("Incorrect settings order! Passed Priority without previously passing HOST");
+        throw Error("Incorrect settings order! Passed Port without previously passing HOST");
       }
 
-      ++it;
+    }
+    else if (it->first ==SessionOption::PRIORITY)
+    {
+      throw Error("Incorrect settings order! Passed Priority without previously passing HOST");
+    }
+
+    ++it;
 
-      if (add || (it == settings.end() && !initialized))
+    if (add || (it == settings.end() && !initialized))
+    {
+      if (socket.empty())
       {
-        if (socket.empty())
-        {
-          socket_only = false;
+        socket_only = false;
 
-          cdk::ds::TCPIP::Options opt(user, has_pwd ? &pwd_str : NULL );
+        cdk::ds::TCPIP::Options opt(user, has_pwd ? &pwd_str : NULL );
 
-          bool is_secure = false;
+        bool is_secure = false;
 #ifdef WITH_SSL
-          opt.set_tls(opt_ssl);
-          is_secure = cdk::ds::TCPIP::Options::TLS_options::SSL_MODE::DISABLED
-                      != opt_ssl.ssl_mode();
+        opt.set_tls(opt_ssl);
+        is_secure = cdk::ds::TCPIP::Options::TLS_options::SSL_MODE::DISABLED
+                    != opt_ssl.ssl_mode();
 #endif
 
-          set_common_options(opt, is_secure);
+        set_common_options(opt, is_secure);
 
-          source.add(cdk::ds::TCPIP( host, static_cast<unsigned short>(port)),
-                      opt,
-                      static_cast<unsigned short>(priority));
-        }
+        source.add(cdk::ds::TCPIP( host, static_cast<unsigned short>(port)),
+                    opt,
+                    static_cast<unsigned short>(priority));
+      }
 #ifndef _WIN32
-        else
-        {
-          cdk::ds::Unix_socket::Options opt(user, has_pwd ? &pwd_str : NULL );
+      else
+      {
+        cdk::ds::Unix_socket::Options opt(user, has_pwd ? &pwd_str : NULL );
 
-          set_common_options(opt, true);
+        set_common_options(opt, true);
 
-          source.add(cdk::ds::Unix_socket(socket),
-                      opt,
-                      static_cast<unsigned short>(priority));
+        source.add(cdk::ds::Unix_socket(socket),
+                    opt,
+                    static_cast<unsigned short>(priority));
 
-          socket.clear();
-        }
+        socket.clear();
+      }
 #endif //_WIN32
 
-        initialized = true;
+      initialized = true;
 
-        if (it == settings.end())
-          break;
-
-        add = false;
-      }
+      if (it == settings.end())
+        break;
 
-    } while (it != settings.end());
+      add = false;
+    }
 
-    if (socket_only && has_ssl)
-      throw Error("TLS connections over Unix domain socket are not supported");
+  } while (it != settings.end());
 
-    m_impl = std::make_shared<Impl>(source);
+  if (socket_only && has_ssl)
+    throw Error("TLS connections over Unix domain socket are not supported");
 
-  }
-  CATCH_AND_WRAP
+  return std::make_shared<Impl>(source);
 }
 
+
 Session::Session(Session* master)
 {
   assert(master);
@@ -797,18 +862,74 @@ Session::Session(Session* master)
 }
 
 
+/*
+  Registering a new result de-registers results registered before it,
+  which gives them a chance to cache pending data. If the new result is
+  for a pipelined command, earlier results stay registered -- they are
+  de-registered only when the new result is used (see activate_result()).
+
+  Registering a result that is already registered (when moving to its
+  next rset) activates it.
+*/
+
 void internal::Session_detail::Impl::register_result(Result_impl *result)
 {
-  if (m_current_result && m_current_result != result)
-    m_current_result->deregister();
+  if (result && m_results.end()
+      != std::find(m_results.begin(), m_results.end(), result))
+  {
+    activate_result(result);
+    return;
+  }
 
-  m_current_result = result;
+  if (!result || !result->m_pending)
+    activate_result(nullptr);
+
+  if (result)
+    m_results.push_back(result);
 }
 
 void internal::Session_detail::Impl::deregister_result(Result_impl *result)
 {
-  if (m_current_result == result)
-    m_current_result = NULL;
+  auto it = std::find(m_results.begin(), m_results.end(), result);
+  if (it != m_results.end())
+    m_results.erase(it);
+}
+
+/*
+  De-register all results registered before the given one so that it
+  becomes the first one. If result is NULL or not registered, all
+  results are de-registered.
+*/
+
+void internal::Session_detail::Impl::activate_result(Result_impl *result)
+{
+  if (result && m_results.end()
+      == std::find(m_results.begin(), m_results.end(), result))
+    result = nullptr;
+
+  while (!m_results.empty() && m_results.front() != result)
+  {
+    Result_impl *prev = m_results.front();
+    m_results.pop_front();
+    prev->deregister();
+  }
+}
+
+bool internal::Session_detail::Impl::pipeline_cmd()
+{
+  if (m_pipeline_depth < 2)
+    return false;
+
+  complete_pending_op();
+
+  while (m_results.size() >= m_pipeline_depth)
+  {
+    Result_impl *prev = m_results.front();
+    m_results.pop_front();
+    prev->deregister();
+  }
+
+  return true;
 }
 
 
@@ -824,12 +945,75 @@ cdk::Session& internal::Session_detail::get_cdk_session()
 void internal::Session_detail::prepare_for_cmd()
 {
   assert(m_impl);
+  m_impl->complete_pending_op();
   m_impl->register_result(nullptr);
 }
 
 
+void internal::Session_detail::set_fetch_size(uint64_t rows)
+{
+  get_impl().m_fetch_size = rows;
+}
+
+
+void internal::Session_detail::set_pipeline_depth(unsigned depth)
+{
+  get_impl().m_pipeline_depth = depth;
+}
+
+
+void internal::Session_detail::set_insert_chunk_size(
+  uint64_t bytes, uint64_t rows
+)
+{
+  get_impl().m_chunk_bytes = bytes;
+  get_impl().m_chunk_rows = rows;
+}
+
+
+void internal::Session_detail::get_statistics(SessionStatistics &stats) const
+{
+  if (!m_impl)
+    throw Error("Session closed");
+
+  static_assert(
+    SessionStatistics::COMMAND_TYPES == cdk::protocol::mysqlx::stats_cmd::COUNT
+    && SessionStatistics::LATENCY_BUCKETS
+       == cdk::protocol::mysqlx::Protocol_stats::latency_buckets,
+    "SessionStatistics does not match CDK statistics"
+  );
+
+  cdk::Session::Stats cs;
+  m_impl->m_sess.get_stats(cs);
+
+  stats.bytesSent = cs.bytes_sent;
+  stats.bytesReceived = cs.bytes_received;
+  stats.messagesSent = cs.msgs_sent;
+  stats.messagesReceived = cs.msgs_received;
+  stats.roundTrips = cs.round_trips;
+  stats.rowsDecoded = cs.rows;
+  stats.fieldsDecoded = cs.fields;
+  stats.readBufferReallocs = cs.rd_buf_reallocs;
+  stats.writeBufferReallocs = cs.wr_buf_reallocs;
+  stats.readWaitTime = std::chrono::nanoseconds(cs.rd_wait_ns);
+  stats.commands = cs.commands;
+  stats.pipelinedCommands = cs.pipelined;
+  stats.preparedStatements = cs.prepares;
+  stats.preparedExecutions = cs.prepared_execs;
+  stats.cursorFetches = cs.cursor_fetches;
+  stats.serverErrors = cs.errors;
+
+  for (unsigned type = 0; type < SessionStatistics::COMMAND_TYPES; ++type)
+    for (unsigned i = 0; i < SessionStatistics::LATENCY_BUCKETS; ++i)
+      stats.latency[type][i] = cs.latency[type][i];
+}
+
+
 void internal::Session_detail::close()
 {
+  if (m_impl)
+    m_impl->complete_pending_op();
+
   if (m_parent_session)
   {
     m_parent_session->remove_child(this);
@@ -844,6 +1028,15 @@ void internal::Session_detail::close()
       sess->parent_close_notify();
     }
 
+    // Session taken from a pool is returned there instead of closing it.
+
+    if (m_pool)
+    {
+      std::shared_ptr<Client_detail::Impl> pool = std::move(m_pool);
+      pool->release(std::move(m_impl));
+      return;
+    }
+
     get_cdk_session().rollback();
   }
 
@@ -851,6 +1044,182 @@ void internal::Session_detail::close()
 }
 
 
+// ---------------------------------------------------------------------
+/*
+  Session pool.
+*/
+
+
+Client::Client(SessionSettings settings, const PoolSettings &pool)
+{
+  try {
+    if (0 == pool.maxSize)
+      throw Error("Session pool size must be greater than 0");
+    m_impl = std::make_shared<Impl>(settings, pool);
+  }
+  CATCH_AND_WRAP
+}
+
+
+void internal::Client_detail::close()
+{
+  if (!m_impl)
+    return;
+  m_impl->close();
+  m_impl.reset();
+}
+
+
+Session::Session(Client &client)
+{
+  try {
+    if (!client.m_impl)
+      throw Error("Session pool is closed");
+    m_impl = client.m_impl->get_session();
+    m_pool = client.m_impl;
+  }
+  CATCH_AND_WRAP
+}
+
+
+/*
+  Take a session from the pool. Idle sessions which are too old or
+  broken are discarded. If there is no idle session that can be used,
+  a new one is created, unless the pool is full. In that case we wait
+  until a session is returned to the pool.
+
+  Note: Sessions in `dropped` are destroyed after the mutex is released
+  (lock is declared after it).
+*/
+
+std::shared_ptr<internal::Session_detail::Impl>
+internal::Client_detail::Impl::get_session()
+{
+  std::vector<std::shared_ptr<Session_impl>> dropped;
+  std::unique_lock<std::mutex> lock(m_mutex);
+  clock::time_point deadline = clock::now() + m_pool.queueTimeout;
+
+  for (;;)
+  {
+    if (m_closed)
+      throw Error("Session pool is closed");
+
+    evict(dropped);
+
+    while (!m_idle.empty())
+    {
+      std::shared_ptr<Session_impl> sess = std::move(m_idle.front().m_sess);
+      m_idle.pop_front();
+
+      if (sess->m_sess.check_idle())
+      {
+        ++m_in_use;
+        return sess;
+      }
+
+      dropped.push_back(std::move(sess));
+    }
+
+    if (m_in_use < m_pool.maxSize)
+      break;
+
+    if (0 == m_pool.queueTimeout.count())
+      m_released.wait(lock);
+    else if (std::cv_status::timeout == m_released.wait_until(lock, deadline))
+      throw Error("Timeout while waiting for a session from the pool");
+  }
+
+  ++m_in_use;
+  lock.unlock();
+
+  try {
+    SessionSettings settings(m_settings);
+    return Session_impl::create(settings);
+  }
+  catch (...)
+  {
+    lock.lock();
+    --m_in_use;
+    m_released.notify_one();
+    throw;
+  }
+}
+
+
+/*
+  Return session to the pool. The session is kept as an idle one only if
+  it could be reset and there is room for it. Otherwise it is closed.
+
+  Results which outlive the session share its implementation and use it
+  until they are destroyed (for example, to discard remaining rows). Such
+  session can not be given to another owner, so it is dropped instead and
+  closed when the last of these results is gone.
+*/
+
+void internal::Client_detail::Impl::release(std::shared_ptr<Session_impl> sess)
+{
+  bool keep = false;
+
+  try {
+    sess->reset();
+    keep = 1 == sess.use_count() && sess->m_sess.check_idle();
+  }
+  catch (...)
+  {}
+
+  std::vector<std::shared_ptr<Session_impl>> dropped;
+
+  {
+    std::lock_guard<std::mutex> lock(m_mutex);
+
+    --m_in_use;
+
+    if (keep && !m_closed && m_idle.size() < m_pool.maxIdle)
+      m_idle.push_front({ std::move(sess), clock::now() });
+
+    evict(dropped);
+  }
+
+  m_released.notify_one();
+}
+
+
+void internal::Client_detail::Impl::close()
+{
+  std::deque<Idle_sess> idle;
+
+  {
+    std::lock_guard<std::mutex> lock(m_mutex);
+    m_closed = true;
+    idle.swap(m_idle);
+  }
+
+  m_released.notify_all();
+}
+
+
+/*
+  Move idle sessions which were not used for longer than maxIdleTime
+  to `dropped`. The oldest idle sessions are at the back of m_idle.
+*/
+
+void internal::Client_detail::Impl::evict(
+  std::vector<std::shared_ptr<Session_impl>> &dropped
+)
+{
+  if (0 == m_pool.maxIdleTime.count())
+    return;
+
+  clock::time_point limit = clock::now() - m_pool.maxIdleTime;
+
+  while (!m_idle.empty() && m_idle.back().m_since < limit)
+  {
+    dropped.push_back(std::move(m_idle.back().m_sess));
+    m_idle.pop_back();
+  }
+}
+
+
 
 // ---------------------------------------------------------------------
 /*
@@ -1639,9 +2008,18 @@ struct Op_sql : public Op_base<internal::Bind_impl>
 
   typedef std::list<Value> param_list_t;
 
-  Op_sql(Session &sess, const string &query)
+  /*
+    If statement is prepared with Session::prepare(), values bound after
+    its execution replace the ones used previously.
+  */
+
+  bool m_rebind = false;
+
+  Op_sql(Session &sess, const string &query, bool prepare = false)
     : Op_base(sess), m_query(query)
-  {}
+  {
+    m_prepare = prepare;
+  }
 
   struct
     : public cdk::Any_list
@@ -1680,13 +2058,23 @@ struct Op_sql : public Op_base<internal::Bind_impl>
           sprc->yesno(static_cast<bool>(val));
           break;
         case Value::STRING:
-          sprc->str(static_cast<mysqlx::string>(val));
+          if (Value::Access::is_utf8(val))
+            sprc->value(cdk::TYPE_STRING,
+              static_cast<const cdk::Format_info&>(*this),
+              Value::Access::get_utf8(val));
+          else
+            sprc->str(static_cast<mysqlx::string>(val));
           break;
         case Value::RAW:
           sprc->value(cdk::TYPE_BYTES,
             static_cast<const cdk::Format_info&>(*this),
             Value::Access::get_bytes(val));
           break;
+        case Value::DECIMAL:
+          sprc->value(cdk::TYPE_STRING,
+            static_cast<const cdk::Format_info&>(*this),
+            Value::Access::get_utf8(val));
+          break;
         default:
           THROW("Unexpected value type");
         }
@@ -1695,16 +2083,25 @@ struct Op_sql : public Op_base<internal::Bind_impl>
       prc.list_end();
     }
 
-    // Trivial Format_info for raw byte values
+    // Trivial Format_info for raw byte values and UTF-8 strings
 
     bool for_type(cdk::Type_info) const override { return true; }
     void get_info(cdk::Format<cdk::TYPE_BYTES>&) const override {}
+    void get_info(cdk::Format<cdk::TYPE_STRING> &fmt) const override
+    {
+      cdk::Format<cdk::TYPE_STRING>::Access::set_cs(fmt, cdk::Charset::utf8);
+    }
     using cdk::Format_info::get_info;
   }
   m_params;
 
   void add_param(Value val) override
   {
+    if (m_rebind)
+    {
+      m_params.m_values.clear();
+      m_rebind = false;
+    }
     m_params.m_values.emplace_back(std::move(val));
   }
 
@@ -1721,12 +2118,15 @@ struct Op_sql : public Op_base<internal::Bind_impl>
 
   cdk::Reply* send_command() override
   {
-    return new cdk::Reply(
+    cdk::Reply *reply = mk_reply(
       get_cdk_session().sql(
         m_query,
         m_params.m_values.empty() ? NULL : &m_params
-      )
+      ),
+      true
     );
+    m_rebind = m_prepare;
+    return reply;
   }
 };
 
@@ -1740,6 +2140,17 @@ internal::SQL_statement::SQL_statement(mysqlx::Session *sess, const string &quer
 }
 
 
+internal::SQL_statement::SQL_statement(mysqlx::Session *sess,
+                                       const string &query,
+                                       bool prepare)
+{
+  try {
+    reset(new Op_sql(*sess, query, prepare));
+  }
+  CATCH_AND_WRAP
+}
+
+
 // ---------------------------------------------------------------------
 
 
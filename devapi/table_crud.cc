@@ -110,6 +110,8 @@ private:
   // Executable
 
   bool m_started;
+  Row_list::const_iterator m_chunk_begin;
+  Row_list::const_iterator m_chunk_end;
 
   cdk::Reply* send_command() override
   {
@@ -118,16 +120,40 @@ private:
     if (m_rows.empty())
       return NULL;
 
-    // Prepare iterators to make a pass through m_rows list.
-    m_started = false;
-    m_row_end = m_rows.end();
+    /*
+      Large lists of rows are sent in several chunks. Both callbacks are
+      called for consecutive positions in the list, so they can walk it
+      with iterators.
+    */
 
-    return new cdk::Reply(
-      get_cdk_session().table_insert(m_table,
-                                     *this,
-                                     m_cols.empty() ? nullptr : this,
-                                     nullptr)
-                         );
+    Row_list::const_iterator size_it = m_rows.cbegin();
+    m_chunk_end = m_rows.cbegin();
+
+    return send_chunks(
+      (size_t)std::distance(m_rows.cbegin(), m_rows.cend()),
+      [&size_it](size_t)
+      {
+        const Row &row = *(size_it++);
+        size_t size = 0;
+        for (col_count_t pos = 0; pos < row.colCount(); ++pos)
+          size += Value::Access::get_size_hint(row[pos]);
+        return size;
+      },
+      [this](size_t begin, size_t end)
+      {
+        // Prepare iterators to make a pass through the chunk of m_rows.
+        m_started = false;
+        m_chunk_begin = m_chunk_end;
+        std::advance(m_chunk_end, end - begin);
+
+        return new_reply(
+          get_cdk_session().table_insert(m_table,
+                                         *this,
+                                         m_cols.empty() ? nullptr : this,
+                                         nullptr)
+        );
+      }
+    );
   }
 
 
@@ -136,12 +162,12 @@ private:
   bool next() override
   {
     if (!m_started)
-      m_cur_row = m_rows.cbegin();
+      m_cur_row = m_chunk_begin;
     else
       ++m_cur_row;
 
     m_started = true;
-    return m_cur_row != m_row_end;
+    return m_cur_row != m_chunk_end;
   }
 
 
@@ -217,7 +243,7 @@ class Op_table_select
   cdk::Reply* send_command() override
   {
     return
-        new cdk::Reply(get_cdk_session().table_select(
+        mk_reply(get_cdk_session().table_select(
                           m_table,
                           m_view,           // view spec
                           get_where(),
@@ -228,11 +254,12 @@ class Op_table_select
                           get_limit(),
                           get_params(),
                           get_locking()
-                       ));
+                       ), true);
   }
 
   void set_view(const cdk::View_spec *view)
   {
+    set_modified();
     m_view = view;
   }
 
@@ -310,6 +337,7 @@ class Op_table_update
 
   void add_set(const mysqlx::string &field, internal::ExprValue &&val) override
   {
+    set_modified();
     m_set_values[field] = std::move(val);
   }
 
@@ -318,7 +346,7 @@ class Op_table_update
     m_set_it = m_set_values.end();
 
     return
-        new cdk::Reply(get_cdk_session().table_update(
+        mk_reply(get_cdk_session().table_update(
                         m_table,
                         get_where(),
                         *this,
@@ -436,7 +464,7 @@ class Op_table_remove
   cdk::Reply* send_command() override
   {
     return
-        new cdk::Reply(get_cdk_session().table_delete(
+        mk_reply(get_cdk_session().table_delete(
                           m_table,
                           get_where(),
                           get_order_by(),
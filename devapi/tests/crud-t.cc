@@ -1625,6 +1625,24 @@ TEST_F(Crud, buffered)
 
     EXPECT_EQ(0, rows_empty.size());
 
+    /*
+      Row data is shared with the result - check that rows keep their
+      data while other rows are read.
+    */
+
+    res = tbl.select("doc->$.age AS age")
+             .orderBy("doc->$.age")
+             .execute();
+
+    Row first = res.fetchOne();
+    Row row_i;
+    int count = 1;
+
+    while ((row_i = res.fetchOne()))
+      EXPECT_EQ(count++, static_cast<int>(row_i[0]));
+
+    EXPECT_EQ(10000, count);
+    EXPECT_EQ(0, static_cast<int>(first[0]));
   }
 
 
@@ -1835,6 +1853,37 @@ TEST_F(Crud, doc_id)
 
   EXPECT_THROW(coll.add("{\"_id\": 127 }").execute(), Error);
   EXPECT_THROW(coll.add("{\"_id\": 12.7 }").execute(), Error);
+  EXPECT_THROW(coll.add("{\"_id\": null }").execute(), Error);
+  EXPECT_THROW(coll.add("{\"_id\": {\"a\": 1} }").execute(), Error);
+  EXPECT_THROW(coll.add("{\"_id\": [\"a\"] }").execute(), Error);
+
+  coll.remove("true").execute();
+
+  cout << "Adding documents with and without ids..." << endl;
+
+  Result res = coll
+    .add("{}")
+    .add(" { \"name\": \"foo\", \"sub\": {\"_id\": \"inner\"} } \n")
+    .add("{ \"name\": \"bar\","
+         "  \"_id\": \"ABCDEFGHIJKLMNOPQRTSUVWXYZ012345\" }")
+    .execute();
+
+  std::vector<mysqlx::GUID> ids = res.getDocumentIds();
+  EXPECT_EQ(3U, ids.size());
+  EXPECT_EQ(string("ABCDEFGHIJKLMNOPQRTSUVWXYZ012345"), string(ids[2]));
+
+  // Generated ids are appended to documents.
+
+  for (unsigned pos = 0; pos < 2; ++pos)
+  {
+    DbDoc doc = coll.find("_id = :id").bind("id", string(ids[pos]))
+                    .execute().fetchOne();
+    EXPECT_TRUE(doc);
+    EXPECT_EQ(string(ids[pos]), doc["_id"].get<string>());
+  }
+
+  DbDoc doc = coll.find("name = 'foo'").execute().fetchOne();
+  EXPECT_EQ(string("inner"), doc["sub"]["_id"].get<string>());
 }
 
 
@@ -2311,3 +2360,84 @@ TEST_F(Crud, add_or_replace)
 
 }
 
+
+
+TEST_F(Crud, insert_chunks)
+{
+  SKIP_IF_NO_XPLUGIN;
+
+  mysqlx::Session &sess = get_sess();
+
+  Schema sch = getSchema("test");
+  Collection coll = sch.createCollection("coll", true);
+  coll.remove("true").execute();
+
+  // Send at most 3 documents per chunk.
+
+  sess.setInsertChunkSize(0, 3);
+
+  cout << "Adding documents in chunks..." << endl;
+
+  {
+    auto add = coll.add("{\"_id\":\"id0\", \"num\": 0}");
+    for (int i = 1; i < 10; ++i)
+      add.add(DbDoc("{\"num\": " + std::to_string(i) + "}"));
+
+    Result res = add.execute();
+
+    EXPECT_EQ(10U, res.getAffectedItemsCount());
+
+    std::vector<mysqlx::GUID> ids = res.getDocumentIds();
+    EXPECT_EQ(10U, ids.size());
+    EXPECT_EQ(string("id0"), string(ids[0]));
+
+    EXPECT_EQ(10U, coll.count());
+    EXPECT_EQ(1U, coll.find("_id = :id").bind("id", string(ids[9]))
+                      .execute().count());
+  }
+
+  cout << "Chunk with duplicate key..." << endl;
+
+  {
+    auto add = coll.add("{\"num\": 10}");
+    for (int i = 11; i < 16; ++i)
+      add.add(DbDoc("{\"num\": " + std::to_string(i) + "}"));
+    for (int i = 0; i < 3; ++i)
+      add.add("{\"_id\":\"id0\"}");
+
+    EXPECT_THROW(add.execute(), Error);
+
+    // Chunks before the failing one were executed.
+
+    EXPECT_EQ(16U, coll.count());
+  }
+
+  cout << "Inserting rows in chunks..." << endl;
+
+  sql("DROP TABLE IF EXISTS test.insert_chunks");
+  sql("CREATE TABLE test.insert_chunks(id INT AUTO_INCREMENT PRIMARY KEY,"
+      " name VARCHAR(32))");
+
+  Table tbl = sch.getTable("insert_chunks");
+
+  // Each row has a 10 byte name, so chunks are limited to 4 rows.
+
+  sess.setInsertChunkSize(4*10);
+
+  {
+    auto insert = tbl.insert("name");
+    for (int i = 0; i < 20; ++i)
+      insert.values("row_" + std::to_string(100000 + i));
+
+    SessionStatistics before = sess.getStatistics();
+    Result res = insert.execute();
+    SessionStatistics after = sess.getStatistics();
+
+    EXPECT_EQ(before.commands + 5, after.commands);
+    EXPECT_EQ(20U, res.getAffectedItemsCount());
+    EXPECT_EQ(1U, res.getAutoIncrementValue());
+    EXPECT_EQ(20U, tbl.count());
+  }
+
+  sql("DROP TABLE IF EXISTS test.insert_chunks");
+}
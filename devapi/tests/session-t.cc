@@ -23,7 +23,10 @@
 */
 
 #include <test.h>
+#include <mock_server.h>
 #include <iostream>
+#include <thread>
+#include <algorithm>
 
 
 using std::cout;
@@ -281,6 +284,584 @@ TEST_F(Sess, trx)
   cout << "Done!" << endl;
 }
 
+TEST_F(Sess, prepare)
+{
+  SKIP_IF_NO_XPLUGIN;
+
+  Collection coll = get_sess().getSchema("test").createCollection("c", true);
+  coll.remove("true").execute();
+  coll.add("{\"foo\": 1}").add("{\"foo\": 2}").add("{\"foo\": 3}")
+      .execute();
+
+  /*
+    Statement prepared explicitly. Values bound after execution replace
+    the previous ones.
+  */
+
+  SqlStatement stmt = get_sess().prepare("SELECT ? + 1");
+
+  for (int i = 0; i < 3; ++i)
+  {
+    RowResult res = stmt.bind(i).execute();
+    EXPECT_EQ(i + 1, (int)res.fetchOne()[0]);
+  }
+
+  /*
+    Find operation is prepared when executed for the second time and
+    again after it is modified.
+  */
+
+  CollectionFind find = coll.find("foo >= :min").bind("min", 2);
+
+  for (int i = 0; i < 3; ++i)
+    EXPECT_EQ(2U, find.execute().count());
+
+  find.limit(1);
+
+  for (int i = 0; i < 3; ++i)
+    EXPECT_EQ(1U, find.execute().count());
+
+  find.bind("min", 3);
+  EXPECT_EQ(1U, find.execute().count());
+
+  cout << "Done!" << endl;
+}
+
+
+/*
+  Check which messages are sent when an operation is executed repeatedly.
+  The test runs against the mock server, which logs types of received
+  messages, so that it does not need a real server. The first execution
+  sends the operation as usual, the second one prepares it and executes
+  the prepared statement and later executions send only Execute message.
+  After the operation is modified, the prepared statement is deallocated
+  and the operation is sent as usual again.
+*/
+
+TEST(Sess_mock, prepare)
+{
+  // Client message types, see Mysqlx.ClientMessages in mysqlx.proto.
+
+  enum { FIND = 17, PREPARE = 40, EXECUTE = 41, DEALLOCATE = 42 };
+  typedef std::vector<unsigned> Msgs;
+
+  mysqlx::test::Mock_server srv;
+
+  Session sess(
+    SessionOption::HOST, "127.0.0.1",
+    SessionOption::PORT, srv.port(),
+    SessionOption::USER, "test",
+    SessionOption::SSL_MODE, SSLMode::DISABLED
+  );
+
+  // Mock server returns as many documents as given by collection name.
+
+  Collection coll = sess.getSchema("test").getCollection("rows=2");
+  CollectionFind find = coll.find("a > :v").bind("v", 1);
+
+  srv.set_log(true);
+
+  EXPECT_EQ(2U, find.execute().count());
+  EXPECT_EQ(Msgs({ FIND }), srv.take_log());
+
+  EXPECT_EQ(2U, find.execute().count());
+  EXPECT_EQ(Msgs({ PREPARE, EXECUTE }), srv.take_log());
+
+  for (int i = 0; i < 2; ++i)
+  {
+    EXPECT_EQ(2U, find.execute().count());
+    EXPECT_EQ(Msgs({ EXECUTE }), srv.take_log());
+  }
+
+  // New parameter value does not require preparing the statement again.
+
+  find.bind("v", 2);
+  EXPECT_EQ(2U, find.execute().count());
+  EXPECT_EQ(Msgs({ EXECUTE }), srv.take_log());
+
+  find.limit(1);
+  EXPECT_EQ(2U, find.execute().count());
+  EXPECT_EQ(Msgs({ DEALLOCATE, FIND }), srv.take_log());
+
+  EXPECT_EQ(2U, find.execute().count());
+  EXPECT_EQ(Msgs({ PREPARE, EXECUTE }), srv.take_log());
+
+  cout << "Done!" << endl;
+}
+
+
+/*
+  Check that session returned to a pool is reset on the server and that
+  a statement prepared before that is not touched any more. Otherwise
+  the next user of the session would be affected.
+*/
+
+TEST(Sess_mock, pool_reset)
+{
+  // Client message types, see Mysqlx.ClientMessages in mysqlx.proto.
+
+  enum {
+    AUTH_START = 4, SESS_RESET = 6, STMT_EXECUTE = 12,
+    EXPECT_OPEN = 24, EXPECT_CLOSE = 25
+  };
+  typedef std::vector<unsigned> Msgs;
+
+  mysqlx::test::Mock_server srv;
+
+  SessionSettings settings(
+    SessionOption::HOST, "127.0.0.1",
+    SessionOption::PORT, srv.port(),
+    SessionOption::USER, "test",
+    SessionOption::SSL_MODE, SSLMode::DISABLED
+  );
+
+  PoolSettings pool;
+  pool.maxSize = 1;
+
+  Client client(settings, pool);
+
+  mysqlx::Session sess1(client);
+  CollectionFind find
+    = sess1.getSchema("test").getCollection("rows=2").find();
+
+  find.execute();
+  find.execute();
+
+  srv.set_log(true);
+  sess1.close();
+
+  // The first reset checks if server supports keeping session open.
+
+  EXPECT_EQ(Msgs({ EXPECT_OPEN, EXPECT_CLOSE, SESS_RESET }), srv.take_log());
+
+  mysqlx::Session sess2(client);
+
+  // Prepared statement was released by the reset, no Deallocate is sent.
+
+  find.limit(1);
+  sess2.sql("rows=1").execute();
+  EXPECT_EQ(Msgs({ STMT_EXECUTE }), srv.take_log());
+
+  sess2.close();
+  EXPECT_EQ(Msgs({ SESS_RESET }), srv.take_log());
+
+  // Session still used by a result is not given to another owner.
+
+  {
+    mysqlx::Session sess3(client);
+    RowResult res = sess3.sql("rows=2").execute();
+    sess3.close();
+    srv.take_log();
+
+    mysqlx::Session sess4(client);
+    Msgs log = srv.take_log();
+    EXPECT_NE(log.end(), std::find(log.begin(), log.end(), AUTH_START));
+
+    sess4.sql("rows=1").execute();
+    EXPECT_EQ(2U, res.count());
+  }
+
+  cout << "Done!" << endl;
+}
+
+
+/*
+  Check that document values count with the length of their JSON when
+  inserted rows are split into chunks of limited size.
+*/
+
+TEST(Sess_mock, insert_chunks)
+{
+  enum { CRUD_INSERT = 18 };
+
+  mysqlx::test::Mock_server srv;
+
+  mysqlx::Session sess(
+    SessionOption::HOST, "127.0.0.1",
+    SessionOption::PORT, srv.port(),
+    SessionOption::USER, "test",
+    SessionOption::SSL_MODE, SSLMode::DISABLED
+  );
+
+  Table tbl = sess.getSchema("test").getTable("docs");
+
+  // JSON of each document has 98 bytes, so that only 2 fit in a chunk.
+
+  DbDoc doc("{\"name\": \"" + std::string(86, 'x') + "\"}");
+  sess.setInsertChunkSize(250);
+
+  auto insert = tbl.insert("doc");
+  for (int i = 0; i < 10; ++i)
+    insert.values(doc);
+
+  srv.set_log(true);
+  EXPECT_EQ(10U, insert.execute().getAffectedItemsCount());
+
+  std::vector<unsigned> log = srv.take_log();
+  EXPECT_EQ(5, std::count(log.begin(), log.end(), (unsigned)CRUD_INSERT));
+
+  cout << "Done!" << endl;
+}
+
+
+/*
+  Check that data of a row kept by user does not move or change when
+  further rows are fetched from the result, so that bytes returned by
+  Row::getBytes() remain valid.
+*/
+
+TEST(Sess_mock, row_data)
+{
+  mysqlx::test::Mock_server srv;
+
+  Session sess(
+    SessionOption::HOST, "127.0.0.1",
+    SessionOption::PORT, srv.port(),
+    SessionOption::USER, "test",
+    SessionOption::SSL_MODE, SSLMode::DISABLED
+  );
+
+  RowResult res
+    = sess.sql("rows=2000 cols=2 type=string,blob size=100").execute();
+
+  Row first = res.fetchOne();
+  bytes data = first.getBytes(1);
+  std::string copy(data.begin(), data.end());
+
+  EXPECT_FALSE(copy.empty());
+
+  for (int i = 0; i < 1999; ++i)
+  {
+    Row row = res.fetchOne();
+    ASSERT_FALSE(row.isNull());
+    EXPECT_EQ(copy.size(), row.getBytes(1).size());
+  }
+
+  EXPECT_TRUE(res.fetchOne().isNull());
+
+  EXPECT_EQ(data.begin(), first.getBytes(1).begin());
+  EXPECT_EQ(copy, std::string(data.begin(), data.end()));
+
+  cout << "Done!" << endl;
+}
+
+
+/*
+  Check that operation executed asynchronously reports the socket on which
+  it waits for the reply. Mock server holds the reply so that the operation
+  must wait for it.
+*/
+
+TEST(Sess_mock, async)
+{
+  mysqlx::test::Mock_server srv;
+
+  Session sess(
+    SessionOption::HOST, "127.0.0.1",
+    SessionOption::PORT, srv.port(),
+    SessionOption::USER, "test",
+    SessionOption::SSL_MODE, SSLMode::DISABLED
+  );
+
+  srv.hold(true);
+
+  AsyncResult<SqlResult> op = sess.sql("rows=3").executeAsync();
+
+  for (int i = 0; i < 3; ++i)
+  {
+    EXPECT_FALSE(op.isReady());
+    EXPECT_LE(0, op.getSocket());
+    EXPECT_FALSE(op.waitsForWrite());
+  }
+
+  srv.hold(false);
+
+  while (!op.isReady())
+  {}
+
+  EXPECT_EQ(-1, op.getSocket());
+  EXPECT_EQ(3U, op.get().count());
+
+  cout << "Done!" << endl;
+}
+
+
+TEST_F(Sess, fetch_size)
+{
+  SKIP_IF_NO_XPLUGIN;
+
+  Collection coll = get_sess().getSchema("test").createCollection("c", true);
+  coll.remove("true").execute();
+
+  for (int i = 0; i < 10; ++i)
+    coll.add(DbDoc("{\"foo\": " + std::to_string(i) + "}")).execute();
+
+  get_sess().setFetchSize(3);
+
+  // Rows are fetched from server-side cursor in batches of 3 and then 4.
+
+  DocResult docs = coll.find().sort("foo").execute();
+  int expected = 0;
+
+  for (DbDoc doc : docs)
+  {
+    EXPECT_EQ(expected, (int)doc["foo"]);
+    if (++expected == 4)
+      docs.setFetchSize(4);
+  }
+  EXPECT_EQ(10, expected);
+
+  // Result which is not fully consumed closes its cursor.
+
+  {
+    RowResult res = get_sess().sql("SELECT 1 UNION SELECT 2 UNION SELECT 3"
+                                   " UNION SELECT 4").execute();
+    EXPECT_EQ(1, (int)res.fetchOne()[0]);
+  }
+
+  SqlResult res = get_sess().sql("SELECT 7").execute();
+  EXPECT_EQ(7, (int)res.fetchOne()[0]);
+
+  get_sess().setFetchSize(0);
+  EXPECT_EQ(10U, coll.find().execute().count());
+
+  cout << "Done!" << endl;
+}
+
+
+TEST_F(Sess, pipeline)
+{
+  SKIP_IF_NO_XPLUGIN;
+
+  Collection coll = get_sess().getSchema("test").createCollection("c", true);
+  coll.remove("true").execute();
+
+  get_sess().setPipelineDepth(4);
+
+  // Statements are sent without waiting for replies to earlier ones.
+
+  Result add = coll.add("{\"foo\": 1}", "{\"foo\": 2}").execute();
+  SqlResult res1 = get_sess().sql("SELECT 1").execute();
+  SqlResult res2 = get_sess().sql("SELECT 2 UNION SELECT 3").execute();
+  DocResult docs = coll.find().sort("foo").execute();
+
+  // Using a later result caches the earlier ones.
+
+  EXPECT_EQ(2U, docs.count());
+  EXPECT_EQ(2, (int)res2.fetchOne()[0]);
+  EXPECT_EQ(3, (int)res2.fetchOne()[0]);
+  EXPECT_EQ(1, (int)res1.fetchOne()[0]);
+  EXPECT_EQ(2U, add.getAffectedItemsCount());
+
+  // Error is reported when result is used.
+
+  SqlResult err = get_sess().sql("SELECT * FROM no_such_table").execute();
+  SqlResult res3 = get_sess().sql("SELECT 3").execute();
+
+  EXPECT_EQ(3, (int)res3.fetchOne()[0]);
+  EXPECT_THROW(err.fetchOne(), Error);
+
+  // More statements than pipeline depth.
+
+  std::vector<SqlResult> results;
+  for (int i = 0; i < 10; ++i)
+    results.emplace_back(
+      get_sess().sql("SELECT " + std::to_string(i)).execute()
+    );
+
+  for (int i = 9; i >= 0; --i)
+    EXPECT_EQ(i, (int)results[i].fetchOne()[0]);
+
+  get_sess().setPipelineDepth(1);
+  EXPECT_EQ(2U, coll.find().execute().count());
+
+  cout << "Done!" << endl;
+}
+
+
+TEST_F(Sess, statistics)
+{
+  SKIP_IF_NO_XPLUGIN;
+
+  using Cmd = SessionStatistics::CommandType;
+
+  SessionStatistics before = get_sess().getStatistics();
+
+  RowResult res = get_sess().sql("SELECT 1, 'a' UNION SELECT 2, 'b'").execute();
+  EXPECT_EQ(2U, res.count());
+  EXPECT_THROW(get_sess().sql("SELECT * FROM no_such_table").execute(), Error);
+
+  SessionStatistics stats = get_sess().getStatistics();
+
+  EXPECT_EQ(before.commands + 2, stats.commands);
+  EXPECT_EQ(before.serverErrors + 1, stats.serverErrors);
+  EXPECT_EQ(before.rowsDecoded + 2, stats.rowsDecoded);
+  EXPECT_EQ(before.fieldsDecoded + 4, stats.fieldsDecoded);
+  EXPECT_LT(before.bytesSent, stats.bytesSent);
+  EXPECT_LT(before.bytesReceived, stats.bytesReceived);
+  EXPECT_LE(before.roundTrips + 2, stats.roundTrips);
+  EXPECT_LE(before.readWaitTime, stats.readWaitTime);
+
+  uint64_t count = 0;
+  const uint64_t *hist = stats.getLatencyHistogram(Cmd::SQL);
+  const uint64_t *hist_before = before.getLatencyHistogram(Cmd::SQL);
+
+  for (unsigned i = 0; i < SessionStatistics::LATENCY_BUCKETS; ++i)
+    count += hist[i] - hist_before[i];
+
+  EXPECT_EQ(2U, count);
+
+  cout << "Done!" << endl;
+}
+
+
+TEST_F(Sess, async)
+{
+  SKIP_IF_NO_XPLUGIN;
+
+  Collection coll = get_sess().getSchema("test").createCollection("c", true);
+  coll.remove("true").execute();
+  coll.add("{\"foo\": 1}", "{\"foo\": 2}").execute();
+
+  // Drive the operation until its result is ready.
+
+  SqlStatement stmt = get_sess().sql("SELECT ?");
+  AsyncResult<SqlResult> op = stmt.bind(7).executeAsync();
+
+  while (!op.isReady())
+  {}
+
+  EXPECT_EQ(-1, op.getSocket());
+  EXPECT_EQ(7, (int)op.get().fetchOne()[0]);
+  EXPECT_FALSE(op.valid());
+
+  // Modifying the statement does not affect pending execution.
+
+  op = stmt.bind(8).executeAsync();
+  AsyncResult<SqlResult> op1 = stmt.bind(9).executeAsync();
+
+  EXPECT_EQ(9, (int)op1.get().fetchOne()[0]);
+  EXPECT_EQ(8, (int)op.get().fetchOne()[0]);
+
+  // New statement completes pending operation which caches its rows.
+
+  AsyncResult<DocResult> find = coll.find().sort("foo").executeAsync();
+  SqlResult res = get_sess().sql("SELECT 3").execute();
+
+  EXPECT_EQ(3, (int)res.fetchOne()[0]);
+  EXPECT_EQ(2U, find.get().count());
+
+  // Server error is reported by get().
+
+  AsyncResult<SqlResult> err
+    = get_sess().sql("SELECT * FROM no_such_table").executeAsync();
+  EXPECT_THROW(err.get(), Error);
+
+  err = get_sess().sql("SELECT * FROM no_such_table").executeAsync();
+  get_sess().sql("SELECT 1").execute();
+  EXPECT_THROW(err.get(), Error);
+
+  // Asynchronous execution is not supported over TLS connections.
+
+  mysqlx::Session tls_sess(
+    SessionOption::PORT, get_port(),
+    SessionOption::USER, get_user(),
+    SessionOption::PWD, get_password(),
+    SessionOption::SSL_MODE, SSLMode::REQUIRED
+  );
+
+  EXPECT_THROW(tls_sess.sql("SELECT 1").executeAsync(), Error);
+
+  cout << "Done!" << endl;
+}
+
+
+TEST_F(Sess, pool)
+{
+  SKIP_IF_NO_XPLUGIN;
+
+  SessionSettings settings(
+    SessionOption::PORT, get_port(),
+    SessionOption::USER, get_user(),
+    SessionOption::PWD, get_password(),
+    SessionOption::SSL_MODE, SSLMode::DISABLED
+  );
+
+  PoolSettings pool;
+  pool.maxSize = 2;
+  pool.queueTimeout = std::chrono::milliseconds(100);
+
+  Client client(settings, pool);
+
+  // Returned session is re-used.
+
+  uint64_t id;
+
+  {
+    mysqlx::Session sess(client);
+    id = sess.sql("SELECT CONNECTION_ID()").execute()
+             .fetchOne()[0].get<uint64_t>();
+  }
+
+  {
+    mysqlx::Session sess(client);
+    EXPECT_EQ(id, sess.sql("SELECT CONNECTION_ID()").execute()
+                      .fetchOne()[0].get<uint64_t>());
+
+    // Open transaction is rolled back when session is returned.
+
+    sess.sql("CREATE TABLE IF NOT EXISTS test.pool (c INT)").execute();
+    sess.startTransaction();
+    sess.sql("INSERT INTO test.pool VALUES (1)").execute();
+  }
+
+  {
+    mysqlx::Session sess1(client);
+    mysqlx::Session sess2(client);
+
+    EXPECT_EQ(0U, sess1.sql("SELECT * FROM test.pool").execute().count());
+
+    // Pool is full.
+
+    EXPECT_THROW(mysqlx::Session sess3(client), Error);
+
+    // Unread rows are cached when session is returned.
+
+    SqlResult res = sess2.sql("SELECT 1 UNION SELECT 2").execute();
+    sess2.close();
+
+    EXPECT_EQ(2U, res.count());
+
+    mysqlx::Session sess3(client);
+    EXPECT_EQ(7, (int)sess3.sql("SELECT 7").execute().fetchOne()[0]);
+  }
+
+  // Idle sessions are closed after maxIdleTime.
+
+  pool.maxIdleTime = std::chrono::milliseconds(10);
+  Client client1(settings, pool);
+
+  {
+    mysqlx::Session sess(client1);
+    id = sess.sql("SELECT CONNECTION_ID()").execute()
+             .fetchOne()[0].get<uint64_t>();
+  }
+
+  std::this_thread::sleep_for(std::chrono::milliseconds(50));
+
+  {
+    mysqlx::Session sess(client1);
+    EXPECT_NE(id, sess.sql("SELECT CONNECTION_ID()").execute()
+                      .fetchOne()[0].get<uint64_t>());
+  }
+
+  client.close();
+  EXPECT_THROW(mysqlx::Session sess(client), Error);
+
+  cout << "Done!" << endl;
+}
+
+
 TEST_F(Sess, auth_method)
 {
 
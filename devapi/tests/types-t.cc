@@ -280,18 +280,18 @@ TEST_F(Types, basic)
     }
 
     EXPECT_EQ(Value::INT64, row[0].getType());
-    EXPECT_EQ(Value::RAW, row[1].getType());
+    EXPECT_EQ(Value::DECIMAL, row[1].getType());
     EXPECT_EQ(Value::FLOAT, row[2].getType());
     EXPECT_EQ(Value::DOUBLE, row[3].getType());
     EXPECT_EQ(Value::STRING, row[4].getType());
 
     EXPECT_EQ(data_int[i], (int)row[0]);
-    // TODO: chekc decimal value
+    // Column c1 is DECIMAL(10,0) so values get rounded.
+    EXPECT_EQ(Decimal(i == 0 ? "3" : "-3"), (Decimal)row[1]);
     EXPECT_EQ(data_float[i], (float)row[2]);
     EXPECT_EQ(data_double[i], (double)row[3]);
     EXPECT_EQ(data_string[i], (string)row[4]);
 
-    EXPECT_GT(row[1].getRawBytes().size(), 1);
     EXPECT_EQ(data_string[i].length(), string(row[4]).length());
   }
 
@@ -461,6 +461,34 @@ TEST_F(Types, string)
   */
 
   EXPECT_THROW((string)row[2], Error);
+
+  cout << "UTF-8 strings..." << endl;
+
+  /*
+    Strings given as std::string are UTF-8 encoded and are sent without
+    conversions. String values read from utf8 columns can be obtained in
+    UTF-8 encoding without conversions.
+  */
+
+  std::string utf8 = str1;
+
+  sql("DELETE FROM test.types");
+  types.insert("c1").values(utf8).execute();
+
+  row = types.select("c1").execute().fetchOne();
+
+  EXPECT_EQ(utf8, row[0].get<std::string>());
+  EXPECT_EQ(str1, (string)row[0]);
+
+  Value val(utf8);
+  EXPECT_EQ(Value::STRING, val.getType());
+  EXPECT_EQ(str1, (string)val);
+  EXPECT_EQ(utf8, Value(str1).get<std::string>());
+
+  DbDoc doc("{\"plain\": \"" + utf8 + "\", \"esc\": \"a\\tb\"}");
+  EXPECT_EQ(utf8, doc["plain"].get<std::string>());
+  EXPECT_EQ(str1, (string)doc["plain"]);
+  EXPECT_EQ(std::string("a\tb"), doc["esc"].get<std::string>());
 }
 
 
@@ -622,6 +650,70 @@ TEST_F(Types, json)
 }
 
 
+/*
+  Check documents created from JSON strings, whose fields are decoded
+  only when accessed. This test does not need a server.
+*/
+
+TEST_F(Types, json_doc)
+{
+  DbDoc doc(
+    "{"
+    "  \"str\": \"foo \\\"bar\\\"\","
+    "  \"num\": -7, \"flt\": 1.5, \"yes\": true, \"nil\": null,"
+    "  \"arr\": [1, \"two\", {\"three\": 3}, [4]],"
+    "  \"sub\": { \"day\": 20, \"month\": \"Apr\","
+    "           \"sub\": { \"deep\": [\"x\"] } },"
+    "  \"num\": 8"
+    "}"
+  );
+
+  EXPECT_TRUE(doc.hasField("num"));
+  EXPECT_FALSE(doc.hasField("no_such_field"));
+  EXPECT_THROW(doc["no_such_field"], std::out_of_range);
+
+  // Repeated key: the first occurrence is used.
+
+  EXPECT_EQ(-7, (int)doc["num"]);
+  EXPECT_EQ(string("foo \"bar\""), (string)doc["str"]);
+  EXPECT_EQ(1.5, (double)doc["flt"]);
+  EXPECT_TRUE((bool)doc["yes"]);
+  EXPECT_EQ(Value::VNULL, doc["nil"].getType());
+
+  const Value &arr = doc["arr"];
+  EXPECT_EQ(Value::ARRAY, arr.getType());
+  EXPECT_EQ(4U, arr.elementCount());
+  EXPECT_EQ(string("two"), (string)arr[1]);
+  EXPECT_EQ(3, (int)arr[2]["three"]);
+  EXPECT_EQ(4, (int)arr[3][0]);
+
+  // Reference to a decoded value stays valid when other fields are decoded.
+
+  const Value &sub = doc["sub"];
+  EXPECT_EQ(Value::DOCUMENT, sub.getType());
+  EXPECT_EQ(20, (int)sub["day"]);
+  EXPECT_EQ(string("Apr"), (string)doc["sub"]["month"]);
+  EXPECT_EQ(string("x"), (string)sub["sub"]["deep"][0]);
+  EXPECT_EQ(20, (int)sub["day"]);
+
+  // Iteration visits all fields once, in key order.
+
+  std::vector<string> keys;
+  for (Field fld : doc)
+    keys.push_back(fld);
+
+  std::vector<string> expected = {
+    "arr", "flt", "nil", "num", "str", "sub", "yes"
+  };
+  EXPECT_EQ(expected, keys);
+
+  // Errors in the JSON text are reported on first access.
+
+  DbDoc bad("{ \"a\": 1, \"b\": [1, 2 }");
+  EXPECT_THROW(bad.hasField("a"), Error);
+}
+
+
 TEST_F(Types, datetime)
 {
   SKIP_IF_NO_XPLUGIN;
@@ -829,3 +921,105 @@ TEST_F(Types, int64_conversion)
   EXPECT_ANY_THROW(int_v = value);
 
 }
+
+
+TEST_F(Types, typed_get)
+{
+  SKIP_IF_NO_XPLUGIN;
+
+  cout << "Preparing test.typed_get..." << endl;
+
+  sql("DROP TABLE IF EXISTS test.typed_get");
+  sql(
+    "CREATE TABLE test.typed_get("
+    "  c0 INT,"
+    "  c1 BIGINT UNSIGNED,"
+    "  c2 DOUBLE,"
+    "  c3 FLOAT,"
+    "  c4 DECIMAL(10,3),"
+    "  c5 VARCHAR(32),"
+    "  c6 VARBINARY(32),"
+    "  c7 JSON"
+    ")");
+
+  Table types = getSchema("test").getTable("typed_get");
+
+  types.insert()
+    .values(-7, 18446744073709551615ULL, 3.25, 1.5, 12.125,
+             "żółw", bytes((byte*)"a\0b", 3), "{\"a\": 1}")
+    .values(nullvalue, nullvalue, nullvalue, nullvalue, nullvalue,
+             nullvalue, nullvalue, nullvalue)
+    .execute();
+
+  cout << "Table prepared, querying it..." << endl;
+
+  RowResult res = types.select().execute();
+
+  Row row = res.fetchOne();
+
+  EXPECT_EQ(-7, row.get<int64_t>(0));
+  EXPECT_EQ(-7, row.get<int>(0));
+  EXPECT_EQ(-7.0, row.get<double>(0));
+  EXPECT_THROW(row.get<uint64_t>(0), Error);
+  EXPECT_THROW(row.get<unsigned>(0), Error);
+
+  EXPECT_EQ(std::numeric_limits<uint64_t>::max(), row.get<uint64_t>(1));
+  EXPECT_THROW(row.get<int64_t>(1), Error);
+
+  EXPECT_EQ(3.25, row.get<double>(2));
+  EXPECT_EQ(1.5, row.get<float>(3));
+  EXPECT_EQ(12.125, row.get<double>(4));
+  EXPECT_EQ(Decimal("12.125"), row.get<Decimal>(4));
+  EXPECT_EQ(Value::DECIMAL, row[4].getType());
+  EXPECT_EQ(row[4].get<Decimal>(), row.get<Decimal>(4));
+  EXPECT_THROW(row.get<int64_t>(2), Error);
+
+  EXPECT_EQ(std::string("żółw"), row.get<std::string>(5));
+  EXPECT_EQ(row[5].get<string>(), row.get<string>(5));
+  EXPECT_THROW(row.get<double>(5), Error);
+
+  bytes data = row.get<bytes>(6);
+  EXPECT_EQ(3U, data.size());
+  EXPECT_EQ(std::string("a\0b", 3), std::string(data.begin(), data.end()));
+
+  EXPECT_EQ(std::string("{\"a\": 1}"), row.get<std::string>(7));
+
+  // Values obtained with get<T>() agree with the ones from Row::get().
+
+  EXPECT_EQ((int64_t)row[0], row.get<int64_t>(0));
+  EXPECT_EQ(row[5].get<std::string>(), row.get<std::string>(5));
+
+  EXPECT_FALSE(row.isNull(0));
+  EXPECT_THROW(row.get<int64_t>(8), std::out_of_range);
+
+  row = res.fetchOne();
+
+  for (col_count_t pos = 0; pos < 8; ++pos)
+    EXPECT_TRUE(row.isNull(pos));
+
+  EXPECT_THROW(row.get<int64_t>(0), Error);
+  EXPECT_THROW(row.get<std::string>(5), Error);
+
+  // Exact decimal values
+
+  {
+    Decimal d("-0012.50");
+    EXPECT_EQ(std::string("-12.50"), d.str());
+    EXPECT_EQ(2U, d.scale());
+
+    int64_t unscaled;
+    EXPECT_TRUE(d.getUnscaled(unscaled));
+    EXPECT_EQ(-1250, unscaled);
+    EXPECT_EQ(d, Decimal(-1250, 2));
+    EXPECT_EQ(-12.5, (double)d);
+
+    EXPECT_THROW(Decimal("1.2.3"), Error);
+    EXPECT_THROW(Decimal("1e3"), Error);
+  }
+
+  // Fields set by user
+
+  Row row1(7, "foo");
+  EXPECT_EQ(7, row1.get<int>(0));
+  EXPECT_EQ(std::string("foo"), row1.get<std::string>(1));
+}
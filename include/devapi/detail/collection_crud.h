@@ -47,6 +47,10 @@ namespace internal {
     */
 
     virtual void add_json(const string&) = 0;
+
+    // Add document given as UTF-8 encoded JSON string.
+
+    virtual void add_json(const std::string&) = 0;
   };
 
 
@@ -90,6 +94,25 @@ namespace internal {
       impl->add_json(json);
     }
 
+    // JSON strings given as std::string or char* are assumed to be UTF-8.
+
+    static void process_one(Impl *impl, const std::string &json)
+    {
+      impl->add_json(json);
+    }
+
+    static void process_one(Impl *impl, const char *json)
+    {
+      if (!json)
+        throw_error("Invalid document");
+      impl->add_json(std::string(json));
+    }
+
+    static void process_one(Impl *impl, const wchar_t *json)
+    {
+      impl->add_json(string(json));
+    }
+
     static void process_one(Impl *impl, const DbDoc &doc)
     {
       // TODO: Do it better when we support sending structured
@@ -251,6 +251,8 @@ protected:
 
   void check_result() const;
 
+  void set_fetch_size(uint64_t rows);
+
 
   // warning iterator implementation
 
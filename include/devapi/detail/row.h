@@ -35,6 +35,11 @@
 #include "../document.h"
 
 #include <memory>
+#include <limits>
+
+#if __cplusplus >= 201703L
+#include <string_view>
+#endif
 
 
 namespace mysqlx {
@@ -80,6 +85,89 @@ protected:
 
   static void process_one(std::pair<Impl*,col_count_t>*, const Value &val);
 
+  /*
+    Typed access to row fields (see Row::get<T>()). Values of fields of
+    a row fetched from the server are decoded directly from raw bytes,
+    without creating Value objects. These methods return false if the field
+    is NULL and throw error if it can not be converted to the requested
+    type.
+
+    Bytes and string views returned for fields of a row fetched from
+    the server point to the row data and are valid as long as the row
+    exists and the field is not changed (row data stored in the result does
+    not move when further rows are read, see Row_set).
+  */
+
+  bool get_field(col_count_t pos, int64_t&) const;
+  bool get_field(col_count_t pos, uint64_t&) const;
+  bool get_field(col_count_t pos, double&) const;
+  bool get_field(col_count_t pos, bytes&) const;
+  bool get_field(col_count_t pos, std::string&) const;
+  bool get_field(col_count_t pos, Decimal&) const;
+
+  bool get_field(col_count_t pos, int32_t &val) const
+  {
+    int64_t v;
+    if (!get_field(pos, v))
+      return false;
+    if (v > std::numeric_limits<int32_t>::max()
+        || v < std::numeric_limits<int32_t>::min())
+      throw_error("Numeric conversion overflow");
+    val = (int32_t)v;
+    return true;
+  }
+
+  bool get_field(col_count_t pos, uint32_t &val) const
+  {
+    uint64_t v;
+    if (!get_field(pos, v))
+      return false;
+    if (v > std::numeric_limits<uint32_t>::max())
+      throw_error("Numeric conversion overflow");
+    val = (uint32_t)v;
+    return true;
+  }
+
+  bool get_field(col_count_t pos, float &val) const
+  {
+    double v;
+    if (!get_field(pos, v))
+      return false;
+    val = (float)v;
+    return true;
+  }
+
+  bool get_field(col_count_t pos, bool &val) const
+  {
+    int64_t v;
+    if (!get_field(pos, v))
+      return false;
+    val = (0 != v);
+    return true;
+  }
+
+  bool get_field(col_count_t pos, string &val) const
+  {
+    std::string utf8;
+    if (!get_field(pos, utf8))
+      return false;
+    val = utf8;
+    return true;
+  }
+
+#if __cplusplus >= 201703L
+
+  bool get_field(col_count_t pos, std::string_view &val) const
+  {
+    bytes data;
+    if (!get_field(pos, data))
+      return false;
+    val = std::string_view((const char*)data.begin(), data.size());
+    return true;
+  }
+
+#endif
+
   friend Row_result_detail;
   friend Args_prc;
 };
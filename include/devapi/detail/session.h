@@ -17,6 +17,7 @@ class Session;
 class Schema;
 class Table;
 class Collection;
+struct SessionStatistics;
 
 namespace internal {
 
@@ -90,6 +91,7 @@ public:
     : public Bind_placeholders< SQL_statement_cmd >
   {
     SQL_statement(Session *, const string &query);
+    SQL_statement(Session *, const string &query, bool prepare);
 
     SQL_statement(SQL_statement_cmd &other)
     {
@@ -103,6 +105,38 @@ public:
   };
 
 
+  /*
+    Note: Pool implementation is shared with sessions taken from the pool,
+    so that they can be returned to it even if client object was deleted
+    in the meantime.
+  */
+
+  struct PUBLIC_API Client_detail
+  {
+  protected:
+
+    struct INTERNAL Impl;
+    std::shared_ptr<Impl>  m_impl;
+
+    Client_detail() {}
+
+    virtual ~Client_detail()
+    {
+      try {
+        if (m_impl)
+          close();
+      }
+      catch (...) {}
+    }
+
+    void close();
+
+    /// @cond IGNORED
+    friend Session_detail;
+    /// @endcond
+  };
+
+
   struct PUBLIC_API Session_detail
   {
   protected:
@@ -120,6 +154,13 @@ public:
     Session_detail *m_parent_session = NULL;
     std::set<Session_detail*>  m_child_sessions;
 
+    /*
+      If session was taken from a pool, closing it returns its
+      implementation to the pool.
+    */
+
+    std::shared_ptr<Client_detail::Impl>  m_pool;
+
     Session_detail() {}
 
     virtual ~Session_detail()
@@ -168,8 +209,32 @@ public:
     */
     void prepare_for_cmd();
 
+    /*
+      Set number of rows fetched in one batch from server-side cursors
+      used by statements executed in this session (0 disables cursors).
+    */
+    void set_fetch_size(uint64_t rows);
+
+    /*
+      Set how many statements can be sent to the server before replies
+      to earlier ones are consumed (1 disables pipelining).
+    */
+    void set_pipeline_depth(unsigned depth);
+
+    /*
+      Set limits on the size of chunks in which large inserts are sent
+      to the server (0 means no limit).
+    */
+    void set_insert_chunk_size(uint64_t bytes, uint64_t rows);
+
+    /*
+      Store current statistics of the session.
+    */
+    void get_statistics(SessionStatistics&) const;
+
     /// @cond IGNORED
     friend Result_detail::Impl;
+    friend Client_detail::Impl;
     /// @endcond
   };
 
@@ -22,6 +22,7 @@ class Settings_detail
   using Options    = typename Traits::Options;
   using SSLMode    = typename Traits::SSLMode;
   using AuthMethod = typename Traits::AuthMethod;
+  using CompressionMode = typename Traits::CompressionMode;
 
 protected:
 
@@ -44,7 +45,8 @@ protected:
 
 #define OPT_VAL_TYPE(X) \
   X(SSL_MODE,SSLMode) \
-  X(AUTH,AuthMethod)
+  X(AUTH,AuthMethod) \
+  X(COMPRESSION,CompressionMode)
 
 #define CHECK_OPT(Opt,Type) \
   if (opt == Options::Opt) \
@@ -91,6 +93,13 @@ protected:
     return unsigned(m);
   }
 
+  static Value opt_val(Options opt, CompressionMode m)
+  {
+    if (opt != Options::COMPRESSION)
+      throw Error("SessionSettings::CompressionMode value can only be used on COMPRESSION setting.");
+    return unsigned(m);
+  }
+
 
 
   /*
@@ -221,6 +221,88 @@ public:
 };
 
 
+// Decimal class
+// =============
+
+/**
+  Exact decimal number, such as a value of a DECIMAL column.
+
+  The number is stored in its decimal text form "[-]ddd[.ddd]", with '.'
+  as the decimal point, so that no digits are lost. It can be obtained as
+  an integer `unscaled` such that the number is equal to
+  `unscaled / 10^scale()`, or converted to double, which in general is
+  not exact.
+
+  @ingroup devapi_res
+*/
+
+class PUBLIC_API Decimal : public internal::Printable
+{
+  DLL_WARNINGS_PUSH
+  std::string m_str;
+  DLL_WARNINGS_POP
+
+  struct Trusted {};
+
+  // Used internally for text known to be a valid decimal number.
+
+  Decimal(const std::string &str, Trusted)
+    : m_str(str)
+  {}
+
+  Decimal(std::string &&str, Trusted)
+    : m_str(std::move(str))
+  {}
+
+public:
+
+  Decimal() : m_str("0")
+  {}
+
+  /**
+    Create decimal number from its text form. Throws error if the string
+    is not a decimal number "[+|-]ddd[.ddd]".
+  */
+
+  explicit Decimal(const std::string&);
+  explicit Decimal(const char *str) : Decimal(std::string(str ? str : ""))
+  {}
+
+  /// Create decimal number equal to `unscaled / 10^scale`.
+
+  Decimal(int64_t unscaled, unsigned scale);
+
+  /// Number of digits after the decimal point.
+
+  unsigned scale() const;
+
+  /**
+    Get the number as integer `unscaled` such that the number is equal to
+    `unscaled / 10^scale()`. Returns false if the value does not fit into
+    int64_t.
+  */
+
+  bool getUnscaled(int64_t &unscaled) const;
+
+  /// Decimal text form of the number.
+
+  const std::string& str() const { return m_str; }
+
+  operator std::string() const { return m_str; }
+
+  /// Conversion to double, which can lose precision.
+
+  operator double() const;
+
+  bool operator==(const Decimal &other) const { return m_str == other.m_str; }
+  bool operator!=(const Decimal &other) const { return m_str != other.m_str; }
+
+  void print(std::ostream &out) const { out << m_str; }
+
+  friend Value;
+};
+
+
 // Value class
 // ===========
 
@@ -244,6 +326,9 @@ public:
   the copy. The only exception is RAW Value, which does not store the
   bytes it describes - it only stores pointers describing a region of memory.
 
+  Values of DECIMAL columns are stored as exact `Decimal` numbers. They can
+  be converted to `Decimal` or, with possible loss of precision, to double.
+
   @ingroup devapi_res
 */
 
@@ -269,6 +354,7 @@ public:
     DOCUMENT,   ///< Document
     RAW,        ///< Raw bytes
     ARRAY,      ///< Array of values
+    DECIMAL,    ///< Exact decimal number
   };
 
   typedef std::vector<Value>::iterator iterator;
@@ -281,7 +367,15 @@ public:
   Value(std::nullptr_t); ///< Constructs Null value.
   Value(const string&);
   Value(string&&);
-  Value(const char *str) : Value(string(str)) {}
+
+  /**
+    Constructs string value from UTF-8 encoded string. The string is stored
+    in UTF-8 encoding and converted to wide string only if needed.
+  */
+
+  Value(const std::string&);
+  Value(std::string&&);
+  Value(const char *str);
   Value(const wchar_t *str) : Value(string(str)) {}
   Value(const bytes&);
   Value(int64_t);
@@ -290,6 +384,7 @@ public:
   Value(double);
   Value(bool);
   Value(const DbDoc& doc);
+  Value(const Decimal&);
 
   Value(const std::initializer_list<Value> &list)
     : m_type(ARRAY)
@@ -402,6 +497,7 @@ public:
   operator string() const;
   operator const bytes&() const;
   operator DbDoc() const;
+  operator Decimal() const;
 
   template<typename T>
   T get() const { return static_cast<T>(*this); }
@@ -507,9 +603,16 @@ protected:
 
   DbDoc  m_doc;
 
+  /*
+    String value is stored either as wide string in m_str or as UTF-8
+    encoded string in m_utf8, depending on how it was created. The other
+    member is empty. Text of DECIMAL value is stored in m_utf8.
+  */
+
   DLL_WARNINGS_PUSH
   bytes  m_raw;
   string m_str;
+  std::string m_utf8;
   std::shared_ptr<Array>  m_arr;
   DLL_WARNINGS_POP
 
@@ -534,7 +637,11 @@ Value& Value::operator=(Value &&other)
 
   switch (m_type)
   {
-  case STRING: m_str = std::move(other.m_str); break;
+  case STRING:
+    m_str = std::move(other.m_str);
+    m_utf8 = std::move(other.m_utf8);
+    break;
+  case DECIMAL: m_utf8 = std::move(other.m_utf8); break;
   case DOCUMENT: m_doc = std::move(other.m_doc); break;
   case RAW: m_raw = std::move(other.m_raw); break;
   case ARRAY: m_arr = std::move(other.m_arr); break;
@@ -715,6 +822,8 @@ Value::operator float() const
   case INT64:  return 1.0F*m_val._int64_v;
   case UINT64: return 1.0F*m_val._uint64_v;
   case FLOAT:  return m_val._float_v;
+  case DECIMAL:
+    return (float)static_cast<double>(Decimal(m_utf8, Decimal::Trusted()));
   default:
     throw Error("Value can not be converted to float");
   }
@@ -735,6 +844,8 @@ Value::operator double() const
   case UINT64: return 1.0*m_val._uint64_v;
   case FLOAT:  return m_val._float_v;
   case DOUBLE: return m_val._double_v;
+  case DECIMAL:
+    return static_cast<double>(Decimal(m_utf8, Decimal::Trusted()));
   default:
     throw Error("Value can not be converted to double");
   }
@@ -776,13 +887,47 @@ inline Value::Value(string &&val) : m_type(STRING)
   m_str = std::move(val);
 }
 
+inline Value::Value(const std::string &val) : m_type(STRING)
+{
+  m_utf8 = val;
+}
+
+inline Value::Value(std::string &&val) : m_type(STRING)
+{
+  m_utf8 = std::move(val);
+}
+
+inline Value::Value(const char *str) : m_type(STRING)
+{
+  if (str)
+    m_utf8 = str;
+}
+
 inline
 Value::operator string() const
 {
   check_type(STRING);
+  if (!m_utf8.empty())
+    return string(m_utf8);
   return m_str;
 }
 
+/**
+  Get string value in UTF-8 encoding. If the value was created from
+  UTF-8 string (as it is the case for string values returned by
+  the server) no conversion is needed.
+*/
+
+template<>
+inline
+std::string Value::get<std::string>() const
+{
+  check_type(STRING);
+  if (!m_str.empty())
+    return std::string(m_str);
+  return m_utf8;
+}
+
 
 inline Value::Value(const bytes &data) : m_type(RAW)
 {
@@ -804,6 +949,19 @@ Value::operator DbDoc() const
 }
 
 
+inline Value::Value(const Decimal &val) : m_type(DECIMAL)
+{
+  m_utf8 = val.m_str;
+}
+
+inline
+Value::operator Decimal() const
+{
+  check_type(DECIMAL);
+  return Decimal(m_utf8, Decimal::Trusted());
+}
+
+
 inline
 bool Value::hasField(const Field &fld) const
 {
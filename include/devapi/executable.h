@@ -68,6 +68,27 @@ struct Executable_impl
 {
   virtual Result_base execute() = 0;
 
+  /*
+    Asynchronous execution (see AsyncResult).
+
+    Method cont() sends the operation to the server, if not done yet, and
+    then makes progress without blocking. When is_completed() returns true,
+    the result can be obtained with get_result(). Method wait() blocks until
+    the operation is completed and returns its result.
+
+    Method get_socket() returns the socket on which the operation waits,
+    setting `write` to true if it waits for the socket to become writable
+    and to false if it waits for it to become readable. It returns -1 if
+    the operation does not wait for a socket and cont() should be called
+    right away.
+  */
+
+  virtual void cont() = 0;
+  virtual bool is_completed() = 0;
+  virtual Result_base get_result() = 0;
+  virtual Result_base wait() = 0;
+  virtual int get_socket(bool &write) = 0;
+
   virtual Executable_impl *clone() const = 0;
 
   virtual ~Executable_impl() {}
@@ -76,6 +97,141 @@ struct Executable_impl
 }  // internal
 
 
+/**
+  Result of an operation executed asynchronously.
+
+  An `AsyncResult` object is returned by `executeAsync()` method of an
+  executable operation. The operation is sent to the server but the
+  call does not wait for the server reply. Method `get()` waits for the
+  reply and returns the result.
+
+  Instead of blocking in `get()`, the operation can be driven from an
+  application event loop: method `isReady()` makes progress without blocking
+  and returns true once the result is available. If it returns false,
+  `getSocket()` tells which socket the operation waits for and
+  `waitsForWrite()` whether it waits for it to become writable (otherwise
+  it waits for data to read). This way a single thread can drive
+  operations in many sessions at once, for example:
+
+  ~~~~~~
+    std::vector<AsyncResult<SqlResult>> ops;
+    ...
+    for (auto &op : ops)
+    {
+      if (op.isReady())
+        process(op.get());
+      else
+        register_in_event_loop(op.getSocket(), op.waitsForWrite());
+    }
+  ~~~~~~
+
+  If `getSocket()` returns -1, the operation does not wait for socket
+  events (for example, when data is already buffered) and `isReady()`
+  should be called again.
+
+  Note: Asynchronous execution is not supported for sessions which use
+  TLS connections (reads and writes on such connection block) --
+  `executeAsync()` throws error for them. Use SSLMode::DISABLED, or
+  a Unix domain socket connection, for sessions driven this way.
+
+  Note: Operations in one session are executed in order. Starting a new
+  operation in the same session first completes the previous one.
+*/
+
+template <class Res>
+class AsyncResult
+{
+  std::shared_ptr<internal::Executable_impl> m_impl;
+
+  AsyncResult(std::shared_ptr<internal::Executable_impl> impl)
+    : m_impl(std::move(impl))
+  {}
+
+  internal::Executable_impl* get_impl() const
+  {
+    if (!m_impl)
+      throw Error("Attempt to use invalid asynchronous result");
+    return m_impl.get();
+  }
+
+  template <class R, class O> friend class Executable;
+
+public:
+
+  AsyncResult() = default;
+
+  /**
+    Make progress without blocking and return true if the result
+    is available.
+  */
+
+  bool isReady()
+  {
+    try {
+      internal::Executable_impl *impl = get_impl();
+      if (!impl->is_completed())
+        impl->cont();
+      return impl->is_completed();
+    }
+    CATCH_AND_WRAP
+  }
+
+  /**
+    Return socket on which the operation waits or -1 if it does not wait
+    for a socket.
+  */
+
+  int getSocket() const
+  {
+    try {
+      bool write;
+      return get_impl()->get_socket(write);
+    }
+    CATCH_AND_WRAP
+  }
+
+  /**
+    Return true if the operation waits for the socket to become writable
+    and false if it waits for data to read.
+  */
+
+  bool waitsForWrite() const
+  {
+    try {
+      bool write = false;
+      get_impl()->get_socket(write);
+      return write;
+    }
+    CATCH_AND_WRAP
+  }
+
+  /**
+    Wait until the operation is completed and return its result. The
+    result can be obtained only once.
+  */
+
+  Res get()
+  {
+    try {
+      internal::Executable_impl *impl = get_impl();
+      internal::Result_base res = impl->is_completed() ?
+                                  impl->get_result() : impl->wait();
+      m_impl.reset();
+      return Res(std::move(res));
+    }
+    CATCH_AND_WRAP
+  }
+
+  /// Check if this object refers to an operation whose result was not
+  /// obtained yet.
+
+  bool valid() const
+  {
+    return (bool)m_impl;
+  }
+};
+
+
 
 /**
   Represents an operation that can be executed.
@@ -178,6 +334,30 @@ public:
     CATCH_AND_WRAP
   }
 
+  /**
+    Send given operation to the server for execution without waiting
+    for the reply. The result is obtained from the returned `AsyncResult`
+    object (which can also be used to drive the execution from an event
+    loop).
+
+    The operation can be modified and executed again while the
+    asynchronous execution is in progress -- it does not affect
+    the result of the earlier execution.
+
+    Throws error if the session uses TLS connection (see `AsyncResult`).
+  */
+
+  AsyncResult<Res> executeAsync()
+  {
+    try {
+      check_if_valid();
+      std::shared_ptr<Impl> impl(m_impl->clone());
+      impl->cont();
+      return AsyncResult<Res>(std::move(impl));
+    }
+    CATCH_AND_WRAP
+  }
+
   struct Access;
   friend Access;
 };
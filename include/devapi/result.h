@@ -62,6 +62,7 @@ class DbDoc;
 class DocResult;
 
 template <class Res, class Op> class Executable;
+template <class Res> class AsyncResult;
 
 
 namespace internal {
@@ -249,6 +250,8 @@ private:
 
   template <class Res, class Op>
   friend class Executable;
+  template <class Res>
+  friend class AsyncResult;
 };
 
 
@@ -498,6 +501,21 @@ public:
 
   uint64_t count();
 
+  /**
+    Change number of rows fetched from the server in one batch.
+
+    This has effect only if result is read using a server-side cursor (see
+    `Session::setFetchSize()`) and applies to batches fetched after this call.
+  */
+
+  void setFetchSize(uint64_t rows)
+  {
+    try {
+      set_fetch_size(rows);
+    }
+    CATCH_AND_WRAP
+  }
+
   /*
    Iterate over rows (range-for support).
 
@@ -526,6 +544,8 @@ public:
 
   template <class Res, class Op>
   friend class Executable;
+  template <class Res>
+  friend class AsyncResult;
   friend SqlResult;
   friend DocResult;
 };
@@ -613,6 +633,8 @@ private:
 
   template <class Res, class Op>
   friend class Executable;
+  template <class Res>
+  friend class AsyncResult;
 };
 
 
@@ -691,6 +713,21 @@ public:
     return Doc_result_detail::count();
   }
 
+  /**
+    Change number of documents fetched from the server in one batch.
+
+    This has effect only if result is read using a server-side cursor (see
+    `Session::setFetchSize()`) and applies to batches fetched after this call.
+  */
+
+  void setFetchSize(uint64_t rows)
+  {
+    try {
+      set_fetch_size(rows);
+    }
+    CATCH_AND_WRAP
+  }
+
   /*
    Iterate over documents (range-for support).
 
@@ -718,6 +755,8 @@ private:
   friend DbDoc;
   template <class Res,class Op>
   friend class Executable;
+  template <class Res>
+  friend class AsyncResult;
 };
 
 
@@ -108,6 +108,51 @@ public:
   Value& get(col_count_t pos);
 
 
+  /**
+    Get value of row field at position `pos` converted to type `T`.
+
+    Supported types are: `int64_t`, `uint64_t`, `int32_t`, `uint32_t`,
+    `bool`, `double`, `float`, `Decimal`, `std::string`, `string`, `bytes`
+    and, when compiling with C++17, `std::string_view`. Strings are returned
+    in UTF-8 encoding. For `bytes` and `std::string_view` no data is copied
+    - the returned value points to row data and is valid as long as this
+    row (or its copy) exists and the field is not changed with set(). Data
+    of the row does not move when further rows are fetched from the result.
+
+    For rows fetched from the server, the value is decoded directly from
+    the raw bytes received from the server. This avoids creating and caching
+    `Value` objects, which makes it the fastest way of reading row fields.
+
+    @throws Error if the field is NULL or can not be converted to type `T`.
+    @throws out_of_range if given field does not exist in the row.
+  */
+
+  template <typename T>
+  T get(col_count_t pos) const
+  {
+    T val;
+    try {
+      if (get_field(pos, val))
+        return val;
+    }
+    catch (const out_of_range&)
+    {
+      throw;
+    }
+    CATCH_AND_WRAP
+    throw_error("Attempt to get value of NULL field");
+    return val;
+  }
+
+  /**
+    Check if row field at position `pos` is NULL.
+
+    @throws out_of_range if given field does not exist in the row.
+  */
+
+  bool isNull(col_count_t pos) const;
+
+
   /**
     Set value of row field at position `pos`.
 
@@ -63,6 +63,9 @@ namespace mysqlx {
   /*! path to a PEM file specifying trusted root certificates*/               \
   x(SSL_CA)                                                                   \
   x(AUTH)          /*!< authentication method, PLAIN, MYSQL41, etc.*/         \
+  /*! define `CompressionMode` used to negotiate compression of protocol
+      messages with the server */                                             \
+  x(COMPRESSION)                                                              \
   ADD_SOCKET(x) \
   END_LIST
 
@@ -207,6 +210,54 @@ std::string AuthMethodName(AuthMethod m)
 /// @endcond
 
 
+#define COMPRESSION_MODES(x)\
+  x(DISABLED)     /*!< Do not compress protocol messages. This is the default
+                       if `COMPRESSION` is not specified. */ \
+  x(PREFERRED)    /*!< Compress messages if server supports one of the
+                       compression algorithms supported by the connector,
+                       otherwise use uncompressed connection. */ \
+  x(REQUIRED)     /*!< Like `PREFERRED`, but the connection attempt fails if
+                       compression can not be negotiated. */ \
+  END_LIST
+
+#define COMPRESSION_ENUM(x) x,
+
+/**
+  Modes to be used with `COMPRESSION` option.
+
+  Compression reduces amount of data sent over the network at the cost
+  of CPU time spent on compressing and uncompressing messages. Small
+  messages are always sent uncompressed.
+*/
+
+enum_class CompressionMode
+{
+  COMPRESSION_MODES(COMPRESSION_ENUM)
+};
+
+
+/// @cond DISABLED
+
+inline
+std::string CompressionModeName(CompressionMode m)
+{
+#define COMPRESSION_NAME(x) case CompressionMode::x: return #x;
+
+  switch(m)
+  {
+    COMPRESSION_MODES(COMPRESSION_NAME)
+    default:
+    {
+      std::ostringstream buf;
+      buf << "<UKNOWN (" << unsigned(m) << ")>" << std::ends;
+      return buf.str();
+    }
+  };
+}
+
+/// @endcond
+
+
 namespace internal {
 
 /*
@@ -219,6 +270,7 @@ struct Settings_traits
   using Options    = mysqlx::SessionOption;
   using SSLMode    = mysqlx::SSLMode;
   using AuthMethod = mysqlx::AuthMethod;
+  using CompressionMode = mysqlx::CompressionMode;
 
   static std::string get_mode_name(SSLMode mode)
   {
@@ -346,6 +398,7 @@ public:
 
     - `ssl-mode` : define `SSLMode` option to be used
     - `ssl-ca=`path : path to a PEM file specifying trusted root certificates
+    - `compression` : define `CompressionMode` option to be used
   */
 
   SessionSettings(const string &uri)
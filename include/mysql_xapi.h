@@ -605,6 +605,81 @@ PUBLIC_API void mysqlx_session_close(mysqlx_session_t *session);
 
 PUBLIC_API int mysqlx_session_valid(mysqlx_session_t *sess);
 
+
+/**
+  Types of commands for which `mysqlx_session_stats()` reports latency
+  histograms.
+*/
+
+typedef enum mysqlx_stats_cmd_enum
+{
+  MYSQLX_STATS_CMD_SQL = 0,   /**< SQL statements */
+  MYSQLX_STATS_CMD_FIND,      /**< Find and select operations */
+  MYSQLX_STATS_CMD_INSERT,    /**< Add and insert operations */
+  MYSQLX_STATS_CMD_UPDATE,    /**< Modify and update operations */
+  MYSQLX_STATS_CMD_REMOVE,    /**< Remove and delete operations */
+  MYSQLX_STATS_CMD_PREPARE,   /**< Preparing and releasing statements */
+  MYSQLX_STATS_CMD_EXECUTE,   /**< Executing prepared statements */
+  MYSQLX_STATS_CMD_CURSOR,    /**< Cursor open, fetch and close */
+  MYSQLX_STATS_CMD_SESSION,   /**< Authentication, session reset and close */
+  MYSQLX_STATS_CMD_OTHER,     /**< Expectations and view DDL */
+  MYSQLX_STATS_CMD_COUNT      /**< Number of command types */
+}
+mysqlx_stats_cmd_t;
+
+#define MYSQLX_STATS_LATENCY_BUCKETS 24
+
+/**
+  Session statistics filled by `mysqlx_session_stats()`.
+
+  Counters start from zero when the session is created and are never reset.
+  Latency of a command is the time from sending it until the end of
+  the reply. Element `latency[T][i]` counts commands of type T whose latency
+  was below 1us (i = 0) or between 2^(i-1)us and 2^i us (i > 0). The last
+  bucket counts all longer latencies.
+*/
+
+typedef struct mysqlx_session_stats_struct
+{
+  uint64_t bytes_sent;
+  uint64_t bytes_received;
+  uint64_t msgs_sent;
+  uint64_t msgs_received;
+  uint64_t round_trips;       /**< waits for server after sending data */
+  uint64_t rows;              /**< result rows decoded */
+  uint64_t fields;            /**< fields of decoded rows */
+  uint64_t rd_buf_reallocs;   /**< reallocations of input buffer */
+  uint64_t wr_buf_reallocs;   /**< reallocations of output buffer */
+  uint64_t rd_wait_ns;        /**< time spent waiting for server data */
+  uint64_t commands;          /**< commands executed */
+  uint64_t pipelined;         /**< commands sent without waiting for replies */
+  uint64_t prepares;          /**< statements prepared on the server */
+  uint64_t prepared_execs;    /**< commands executed as prepared statements */
+  uint64_t cursor_fetches;    /**< row batches requested from cursors */
+  uint64_t errors;            /**< errors reported by the server */
+  uint64_t latency[MYSQLX_STATS_CMD_COUNT][MYSQLX_STATS_LATENCY_BUCKETS];
+}
+mysqlx_session_stats_t;
+
+
+/**
+  Get current statistics of the session.
+
+  Collecting statistics does not take any locks, so this function can be
+  called from a thread other than the one which uses the session.
+
+  @param sess  session handle
+  @param[out] stats  structure which is filled with the statistics
+
+  @return `RESULT_OK` - on success; `RESULT_ERROR` - on error. The error
+          details can be obtained using `mysqlx_error()` function
+
+  @ingroup xapi_sess
+*/
+
+PUBLIC_API int
+mysqlx_session_stats(mysqlx_session_t *sess, mysqlx_session_stats_t *stats);
+
 /**
   Get a list of schemas.
 
@@ -0,0 +1,1116 @@
+/*
+ * Copyright (c) 2015, 2016, Oracle and/or its affiliates. All rights reserved.
+ *
+ * The MySQL Connector/C++ is licensed under the terms of the GPLv2
+ * <http://www.gnu.org/licenses/old-licenses/gpl-2.0.html>, like most
+ * MySQL Connectors. There are special exceptions to the terms and
+ * conditions of the GPLv2 as it is applied to this software, see the
+ * FLOSS License Exception
+ * <http://www.mysql.com/about/legal/licensing/foss-exception.html>.
+ *
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published
+ * by the Free Software Foundation; version 2 of the License.
+ *
+ * This program is distributed in the hope that it will be useful, but
+ * WITHOUT ANY WARRANTY; without even the implied warranty of MERCHANTABILITY
+ * or FITNESS FOR A PARTICULAR PURPOSE. See the GNU General Public License
+ * for more details.
+ *
+ * You should have received a copy of the GNU General Public License along
+ * with this program; if not, write to the Free Software Foundation, Inc.,
+ * 51 Franklin St, Fifth Floor, Boston, MA 02110-1301  USA
+ */
+
+/*
+  Implementation of the mock X Protocol server
+  ============================================
+
+  Messages are encoded and decoded directly in protobuf wire format (see
+  Pb_reader and the put_*() functions below) so that the server does not
+  depend on CDK or generated protobuf code and does not share any state
+  with the client library that is being measured.
+*/
+
+#include "mock_server.h"
+
+#include <stdexcept>
+#include <cstring>
+#include <algorithm>
+
+#ifdef _WIN32
+#include <winsock2.h>
+#include <ws2tcpip.h>
+#pragma comment(lib,"ws2_32")
+typedef SOCKET socket_t;
+#define poll WSAPoll
+#define close_socket closesocket
+#define SHUT_RDWR SD_BOTH
+#else
+#include <sys/socket.h>
+#include <sys/un.h>
+#include <netinet/in.h>
+#include <netinet/tcp.h>
+#include <arpa/inet.h>
+#include <poll.h>
+#include <unistd.h>
+typedef int socket_t;
+#define INVALID_SOCKET (-1)
+#define close_socket ::close
+#endif
+
+
+namespace mysqlx {
+namespace test {
+
+namespace {
+
+/*
+  Message type ids (see Mysqlx.ClientMessages and Mysqlx.ServerMessages
+  in mysqlx.proto).
+*/
+
+struct Client_msg
+{
+  enum value {
+    CAPABILITIES_GET = 1,
+    CAPABILITIES_SET = 2,
+    CON_CLOSE = 3,
+    AUTH_START = 4,
+    AUTH_CONTINUE = 5,
+    SESS_RESET = 6,
+    SESS_CLOSE = 7,
+    STMT_EXECUTE = 12,
+    CRUD_FIND = 17,
+    CRUD_INSERT = 18,
+    CRUD_UPDATE = 19,
+    CRUD_DELETE = 20,
+    EXPECT_OPEN = 24,
+    EXPECT_CLOSE = 25,
+    PREPARE = 40,
+    PREPARE_EXECUTE = 41,
+    PREPARE_DEALLOCATE = 42,
+  };
+};
+
+struct Server_msg
+{
+  enum value {
+    OK = 0,
+    ERROR = 1,
+    CAPABILITIES = 2,
+    AUTH_CONTINUE = 3,
+    AUTH_OK = 4,
+    NOTICE = 11,
+    COLUMN_META_DATA = 12,
+    ROW = 13,
+    FETCH_DONE = 14,
+    STMT_EXECUTE_OK = 17,
+  };
+};
+
+
+/*
+  Encoding messages
+  -----------------
+*/
+
+enum wire_type { VARINT = 0, FIXED64 = 1, LENGTH = 2, FIXED32 = 5 };
+
+void put_varint(std::string &out, uint64_t val)
+{
+  while (val >= 0x80)
+  {
+    out.push_back(char(val | 0x80));
+    val >>= 7;
+  }
+  out.push_back(char(val));
+}
+
+void put_uint(std::string &out, unsigned field, uint64_t val)
+{
+  put_varint(out, (field << 3) | VARINT);
+  put_varint(out, val);
+}
+
+void put_bytes(std::string &out, unsigned field, const std::string &data)
+{
+  put_varint(out, (field << 3) | LENGTH);
+  put_varint(out, data.size());
+  out.append(data);
+}
+
+/*
+  Append message frame: 4 byte length of the rest of the frame, message
+  type and the encoded message.
+*/
+
+void put_frame(std::string &out, unsigned type, const std::string &msg)
+{
+  uint32_t len = (uint32_t)msg.size() + 1;
+  for (unsigned i = 0; i < 4; ++i)
+    out.push_back(char(len >> 8*i));
+  out.push_back(char(type));
+  out.append(msg);
+}
+
+void put_error(std::string &out, unsigned code, const std::string &msg)
+{
+  std::string err;
+  put_uint(err, 1, 0);        // severity: ERROR
+  put_uint(err, 2, code);
+  put_bytes(err, 3, msg);
+  put_bytes(err, 4, "HY000");
+  put_frame(out, Server_msg::ERROR, err);
+}
+
+/*
+  SessionStateChanged notice with ROWS_AFFECTED parameter followed
+  by StmtExecuteOk.
+*/
+
+void put_rows_affected(std::string &out, uint64_t rows)
+{
+  std::string scalar;
+  put_uint(scalar, 1, 2);     // V_UINT
+  put_uint(scalar, 3, rows);
+
+  std::string change;
+  put_uint(change, 1, 4);     // ROWS_AFFECTED
+  put_bytes(change, 2, scalar);
+
+  std::string notice;
+  put_uint(notice, 1, 3);     // SESSION_STATE_CHANGED
+  put_uint(notice, 2, 2);     // LOCAL
+  put_bytes(notice, 3, change);
+
+  put_frame(out, Server_msg::NOTICE, notice);
+  put_frame(out, Server_msg::STMT_EXECUTE_OK, std::string());
+}
+
+
+/*
+  Decoding messages
+  -----------------
+
+  Method next() moves to the next field of the message. After that
+  m_field is the field number and either m_val holds value of a varint
+  field or m_data, m_size describe contents of a length delimited field.
+*/
+
+class Pb_reader
+{
+  const char *m_pos;
+  const char *m_end;
+
+  uint64_t varint()
+  {
+    uint64_t val = 0;
+    for (unsigned shift = 0; shift < 64; shift += 7)
+    {
+      if (m_pos >= m_end)
+        break;
+      uint8_t b = (uint8_t)*m_pos++;
+      val |= uint64_t(b & 0x7F) << shift;
+      if (!(b & 0x80))
+        return val;
+    }
+    throw std::runtime_error("Invalid message");
+  }
+
+  void skip(uint64_t len)
+  {
+    if (len > (uint64_t)(m_end - m_pos))
+      throw std::runtime_error("Invalid message");
+    m_pos += len;
+  }
+
+public:
+
+  unsigned     m_field;
+  uint64_t     m_val;
+  const char  *m_data;
+  size_t       m_size;
+
+  Pb_reader(const char *data, size_t size)
+    : m_pos(data), m_end(data + size)
+    , m_field(0), m_val(0), m_data(NULL), m_size(0)
+  {}
+
+  Pb_reader(const std::string &msg)
+    : Pb_reader(msg.data(), msg.size())
+  {}
+
+  bool next()
+  {
+    if (m_pos >= m_end)
+      return false;
+
+    uint64_t tag = varint();
+    m_field = unsigned(tag >> 3);
+
+    switch (tag & 7)
+    {
+    case VARINT:  m_val = varint(); break;
+    case FIXED64: skip(8); break;
+    case FIXED32: skip(4); break;
+    case LENGTH:
+      m_size = (size_t)varint();
+      m_data = m_pos;
+      skip(m_size);
+      break;
+    default:
+      throw std::runtime_error("Invalid message");
+    }
+
+    return true;
+  }
+
+  std::string str() const
+  {
+    return std::string(m_data, m_size);
+  }
+
+  Pb_reader sub() const
+  {
+    return Pb_reader(m_data, m_size);
+  }
+};
+
+
+/*
+  Result set specifications
+  -------------------------
+*/
+
+struct Spec
+{
+  enum Type { INT, UINT, DOUBLE, DECIMAL, STRING, BLOB, JSON };
+
+  uint64_t           m_rows;
+  unsigned           m_cols;
+  size_t             m_size;
+  std::vector<Type>  m_types;
+
+  Spec() : m_rows(0), m_cols(1), m_size(16)
+  {}
+
+  Type type(unsigned col) const
+  {
+    return m_types.empty() ? INT : m_types[col % m_types.size()];
+  }
+
+  // Returns false if the string does not contain "rows=" setting.
+
+  bool parse(const std::string &spec);
+};
+
+
+bool Spec::parse(const std::string &spec)
+{
+  static const char *type_names[] = {
+    "int", "uint", "double", "decimal", "string", "blob", "json"
+  };
+
+  bool has_rows = false;
+  size_t pos = 0;
+
+  while (pos < spec.size())
+  {
+    size_t end = spec.find(' ', pos);
+    if (std::string::npos == end)
+      end = spec.size();
+
+    std::string item = spec.substr(pos, end - pos);
+    pos = end + 1;
+
+    size_t eq = item.find('=');
+    if (std::string::npos == eq)
+      continue;
+
+    std::string key = item.substr(0, eq);
+    std::string val = item.substr(eq + 1);
+
+    if ("rows" == key)
+    {
+      m_rows = std::stoull(val);
+      has_rows = true;
+    }
+    else if ("cols" == key)
+      m_cols = (unsigned)std::stoul(val);
+    else if ("size" == key)
+      m_size = (size_t)std::stoull(val);
+    else if ("type" == key)
+    {
+      m_types.clear();
+      size_t tpos = 0;
+      while (tpos <= val.size())
+      {
+        size_t tend = val.find(',', tpos);
+        if (std::string::npos == tend)
+          tend = val.size();
+        std::string name = val.substr(tpos, tend - tpos);
+        tpos = tend + 1;
+
+        unsigned t = 0;
+        while (t < sizeof(type_names)/sizeof(type_names[0])
+               && name != type_names[t])
+          ++t;
+        if (t >= sizeof(type_names)/sizeof(type_names[0]))
+          throw std::runtime_error("Unknown column type: " + name);
+        m_types.push_back(Type(t));
+      }
+    }
+  }
+
+  return has_rows;
+}
+
+
+void put_column(std::string &out, const std::string &name,
+                Spec::Type type, size_t size)
+{
+  unsigned pb_type = 7;       // BYTES
+  unsigned collation = 0;
+  unsigned frac = 0;
+  unsigned content = 0;
+  size_t   length = size;
+
+  switch (type)
+  {
+  case Spec::INT:     pb_type = 1; length = 20; break;
+  case Spec::UINT:    pb_type = 2; length = 20; break;
+  case Spec::DOUBLE:  pb_type = 5; length = 22; break;
+  case Spec::DECIMAL: pb_type = 18; length = 22; frac = 2; break;
+  case Spec::STRING:  collation = 33; break;    // utf8_general_ci
+  case Spec::BLOB:    collation = 63; break;    // binary
+  case Spec::JSON:    collation = 63; content = 2; break;
+  }
+
+  std::string md;
+  put_uint(md, 1, pb_type);
+  put_bytes(md, 2, name);
+  put_bytes(md, 3, name);
+  put_bytes(md, 4, "bench");
+  put_bytes(md, 5, "bench");
+  put_bytes(md, 6, "bench");
+  put_bytes(md, 7, "def");
+  if (collation)
+    put_uint(md, 8, collation);
+  if (frac)
+    put_uint(md, 9, frac);
+  put_uint(md, 10, length);
+  if (content)
+    put_uint(md, 12, content);
+
+  put_frame(out, Server_msg::COLUMN_META_DATA, md);
+}
+
+
+std::string mk_string(uint64_t row, unsigned col, size_t size)
+{
+  std::string str(size, 'a');
+  for (size_t i = 0; i < size; ++i)
+    str[i] = char('a' + (row + col + i) % 26);
+  return str;
+}
+
+
+/*
+  Encode value of the given type into the field of a Row message.
+*/
+
+void put_value(std::string &out, Spec::Type type,
+               uint64_t row, unsigned col, size_t size)
+{
+  switch (type)
+  {
+  case Spec::INT:
+  {
+    int64_t val = int64_t(row*31 + col);
+    if (row % 2)
+      val = -val;
+    put_varint(out, (uint64_t(val) << 1) ^ uint64_t(val >> 63));  // zigzag
+    return;
+  }
+
+  case Spec::UINT:
+    put_varint(out, row*7 + col);
+    return;
+
+  case Spec::DOUBLE:
+  {
+    double val = row*1.25 + col;
+    uint64_t bits;
+    memcpy(&bits, &val, sizeof(bits));
+    for (unsigned i = 0; i < 8; ++i)
+      out.push_back(char(bits >> 8*i));
+    return;
+  }
+
+  case Spec::DECIMAL:
+  {
+    // Scale 2, packed digits followed by positive sign nibble.
+
+    std::string digits = std::to_string(row*100 + col);
+    if (digits.size() < 3)
+      digits.insert(0, 3 - digits.size(), '0');
+    digits.push_back(char('0' + 0xC));
+    if (digits.size() % 2)
+      digits.push_back('0');
+
+    out.push_back(2);
+    for (size_t i = 0; i < digits.size(); i += 2)
+      out.push_back(char(((digits[i] - '0') << 4) | (digits[i+1] - '0')));
+    return;
+  }
+
+  case Spec::STRING:
+    out.append(mk_string(row, col, size));
+    break;
+
+  case Spec::BLOB:
+    for (size_t i = 0; i < size; ++i)
+      out.push_back(char(row + col + i));
+    break;
+
+  case Spec::JSON:
+    out.append("{\"id\": ").append(std::to_string(row))
+       .append(", \"name\": \"").append(mk_string(row, col, size))
+       .append("\"}");
+    break;
+  }
+
+  out.push_back('\0');  // string values are terminated by 0x00
+}
+
+
+std::string mk_doc(uint64_t row, unsigned fields, size_t size)
+{
+  std::string id = std::to_string(row);
+  std::string doc = "{\"_id\": \"";
+  doc.append(32 - id.size(), '0').append(id).append("\"");
+
+  for (unsigned f = 0; f < fields; ++f)
+  {
+    doc.append(", \"f").append(std::to_string(f)).append("\": ");
+
+    switch (f % 5)
+    {
+    case 0: doc.append(std::to_string(row*31 + f)); break;
+    case 1: doc.append("\"").append(mk_string(row, f, size)).append("\"");
+            break;
+    case 2: doc.append(std::to_string(row)).append(".5"); break;
+    case 3: doc.append("[").append(std::to_string(row))
+               .append(", ").append(std::to_string(f)).append(", true]");
+            break;
+    case 4: doc.append("{\"a\": ").append(std::to_string(row))
+               .append(", \"b\": \"x\"}");
+            break;
+    }
+  }
+
+  return doc.append("}");
+}
+
+
+void put_rset(std::string &out, const Spec &spec)
+{
+  for (unsigned col = 0; col < spec.m_cols; ++col)
+    put_column(out, "c" + std::to_string(col), spec.type(col), spec.m_size);
+
+  std::string row;
+  std::string field;
+
+  for (uint64_t r = 0; r < spec.m_rows; ++r)
+  {
+    row.clear();
+    for (unsigned col = 0; col < spec.m_cols; ++col)
+    {
+      field.clear();
+      put_value(field, spec.type(col), r, col, spec.m_size);
+      put_bytes(row, 1, field);
+    }
+    put_frame(out, Server_msg::ROW, row);
+  }
+
+  put_frame(out, Server_msg::FETCH_DONE, std::string());
+  put_frame(out, Server_msg::STMT_EXECUTE_OK, std::string());
+}
+
+
+void put_docs(std::string &out, const Spec &spec)
+{
+  put_column(out, "doc", Spec::JSON, 0);
+
+  std::string row;
+  std::string field;
+
+  for (uint64_t r = 0; r < spec.m_rows; ++r)
+  {
+    field = mk_doc(r, spec.m_cols, spec.m_size);
+    field.push_back('\0');
+    row.clear();
+    put_bytes(row, 1, field);
+    put_frame(out, Server_msg::ROW, row);
+  }
+
+  put_frame(out, Server_msg::FETCH_DONE, std::string());
+  put_frame(out, Server_msg::STMT_EXECUTE_OK, std::string());
+}
+
+
+void set_nodelay(socket_t sock)
+{
+  int flag = 1;
+  setsockopt(sock, IPPROTO_TCP, TCP_NODELAY, (const char*)&flag,
+             sizeof(flag));
+}
+
+}  // anonymous namespace
+
+
+/*
+  Connection
+  ----------
+*/
+
+class Mock_server::Connection
+{
+  Mock_server &m_srv;
+  socket_t     m_sock;
+
+  char         m_buf[64*1024];
+  size_t       m_pos;
+  size_t       m_end;
+
+  std::string  m_msg;
+  std::string  m_out;
+
+  // Prepared statements: type of the statement and its spec or row count.
+
+  struct Stmt
+  {
+    unsigned     m_type;
+    std::string  m_spec;
+    uint64_t     m_rows;
+  };
+
+  std::map<uint64_t, Stmt> m_stmts;
+
+public:
+
+  Connection(Mock_server &srv, socket_t sock)
+    : m_srv(srv), m_sock(sock), m_pos(0), m_end(0)
+  {}
+
+  void run()
+  {
+    unsigned type;
+
+    while (read_msg(type))
+    {
+      if (m_srv.m_log_on)
+      {
+        std::lock_guard<std::mutex> guard(m_srv.m_lock);
+        m_srv.m_log.push_back(type);
+      }
+
+      bool more = process(type);
+
+      if (m_srv.m_hold)
+      {
+        std::unique_lock<std::mutex> lock(m_srv.m_lock);
+        m_srv.m_released.wait(lock, [this]{ return !m_srv.m_hold; });
+      }
+
+      flush();
+      if (!more)
+        break;
+    }
+  }
+
+private:
+
+  bool read(char *data, size_t len)
+  {
+    while (len > 0)
+    {
+      if (m_pos >= m_end)
+      {
+        int got = (int)recv(m_sock, m_buf, sizeof(m_buf), 0);
+        if (got <= 0)
+          return false;
+        m_pos = 0;
+        m_end = (size_t)got;
+      }
+
+      size_t chunk = std::min(len, m_end - m_pos);
+      memcpy(data, m_buf + m_pos, chunk);
+      m_pos += chunk;
+      data += chunk;
+      len -= chunk;
+    }
+    return true;
+  }
+
+  bool read_msg(unsigned &type)
+  {
+    unsigned char hdr[5];
+    if (!read((char*)hdr, sizeof(hdr)))
+      return false;
+
+    uint32_t len = hdr[0] | hdr[1] << 8 | hdr[2] << 16 | uint32_t(hdr[3]) << 24;
+    if (0 == len)
+      return false;
+
+    type = hdr[4];
+    m_msg.resize(len - 1);
+    return m_msg.empty() || read(&m_msg[0], m_msg.size());
+  }
+
+  void flush()
+  {
+    const char *data = m_out.data();
+    size_t left = m_out.size();
+
+    while (left > 0)
+    {
+      int sent = (int)send(m_sock, data, (int)std::min<size_t>(left, 1 << 30), 0);
+      if (sent <= 0)
+        break;
+      data += sent;
+      left -= (size_t)sent;
+    }
+
+    m_out.clear();
+  }
+
+  void ok()
+  {
+    put_frame(m_out, Server_msg::OK, std::string());
+  }
+
+  bool process(unsigned type);
+
+  void execute(unsigned type, const std::string &spec, uint64_t rows);
+
+  // Decode statement kept in Prepare or OneOfMessage.
+
+  Stmt get_stmt(unsigned type, Pb_reader msg);
+};
+
+
+bool Mock_server::Connection::process(unsigned type)
+{
+  switch (type)
+  {
+  case Client_msg::CAPABILITIES_GET:
+    put_frame(m_out, Server_msg::CAPABILITIES, std::string());
+    return true;
+
+  case Client_msg::CAPABILITIES_SET:
+    put_error(m_out, 5002, "Capability not supported");
+    return true;
+
+  case Client_msg::AUTH_START:
+  {
+    Pb_reader msg(m_msg);
+    std::string mech;
+    while (msg.next())
+      if (1 == msg.m_field)
+        mech = msg.str();
+
+    if ("PLAIN" == mech || "EXTERNAL" == mech)
+    {
+      put_frame(m_out, Server_msg::AUTH_OK, std::string());
+      return true;
+    }
+
+    std::string salt;
+    put_bytes(salt, 1, "0123456789abcdefghij");
+    put_frame(m_out, Server_msg::AUTH_CONTINUE, salt);
+    return true;
+  }
+
+  case Client_msg::AUTH_CONTINUE:
+    put_frame(m_out, Server_msg::AUTH_OK, std::string());
+    return true;
+
+  case Client_msg::SESS_RESET:
+  case Client_msg::SESS_CLOSE:
+    m_stmts.clear();
+    ok();
+    return true;
+
+  case Client_msg::CON_CLOSE:
+    ok();
+    return false;
+
+  case Client_msg::EXPECT_OPEN:
+  case Client_msg::EXPECT_CLOSE:
+    ok();
+    return true;
+
+  case Client_msg::STMT_EXECUTE:
+  case Client_msg::CRUD_FIND:
+  case Client_msg::CRUD_INSERT:
+  case Client_msg::CRUD_UPDATE:
+  case Client_msg::CRUD_DELETE:
+  {
+    Stmt stmt = get_stmt(type, Pb_reader(m_msg));
+    execute(stmt.m_type, stmt.m_spec, stmt.m_rows);
+    return true;
+  }
+
+  case Client_msg::PREPARE:
+  {
+    static const unsigned types[] = {
+      Client_msg::CRUD_FIND, Client_msg::CRUD_INSERT,
+      Client_msg::CRUD_UPDATE, 0, Client_msg::CRUD_DELETE,
+      Client_msg::STMT_EXECUTE
+    };
+
+    Pb_reader msg(m_msg);
+    uint64_t id = 0;
+    Stmt stmt = { 0, std::string(), 0 };
+
+    while (msg.next())
+    {
+      if (1 == msg.m_field)
+        id = msg.m_val;
+      if (2 != msg.m_field)
+        continue;
+
+      // OneOfMessage: type followed by one of the statement messages.
+
+      Pb_reader one_of = msg.sub();
+      while (one_of.next())
+      {
+        if (1 == one_of.m_field && one_of.m_val < 6)
+          stmt.m_type = types[one_of.m_val];
+        else if (2 <= one_of.m_field && one_of.m_field <= 6)
+          stmt = get_stmt(stmt.m_type, one_of.sub());
+      }
+    }
+
+    m_stmts[id] = stmt;
+    ok();
+    return true;
+  }
+
+  case Client_msg::PREPARE_EXECUTE:
+  {
+    Pb_reader msg(m_msg);
+    uint64_t id = 0;
+    while (msg.next())
+      if (1 == msg.m_field)
+        id = msg.m_val;
+
+    auto it = m_stmts.find(id);
+    if (it == m_stmts.end())
+    {
+      put_error(m_out, 5110, "Statement with the given id not found");
+      return true;
+    }
+
+    execute(it->second.m_type, it->second.m_spec, it->second.m_rows);
+    return true;
+  }
+
+  case Client_msg::PREPARE_DEALLOCATE:
+  {
+    Pb_reader msg(m_msg);
+    while (msg.next())
+      if (1 == msg.m_field)
+        m_stmts.erase(msg.m_val);
+    ok();
+    return true;
+  }
+
+  default:
+    put_error(m_out, 1047, "Unexpected message received");
+    return true;
+  }
+}
+
+
+Mock_server::Connection::Stmt
+Mock_server::Connection::get_stmt(unsigned type, Pb_reader msg)
+{
+  Stmt stmt = { type, std::string(), 0 };
+
+  while (msg.next())
+  {
+    switch (type)
+    {
+    case Client_msg::STMT_EXECUTE:
+      if (1 == msg.m_field)
+        stmt.m_spec = msg.str();
+      break;
+
+    case Client_msg::CRUD_FIND:
+    case Client_msg::CRUD_UPDATE:
+      if (2 == msg.m_field)
+      {
+        Pb_reader coll = msg.sub();
+        while (coll.next())
+          if (1 == coll.m_field)
+            stmt.m_spec = coll.str();
+      }
+      break;
+
+    case Client_msg::CRUD_INSERT:
+      if (4 == msg.m_field)
+        stmt.m_rows++;
+      break;
+    }
+  }
+
+  return stmt;
+}
+
+
+void Mock_server::Connection::execute(unsigned type, const std::string &spec,
+                                      uint64_t rows)
+{
+  switch (type)
+  {
+  case Client_msg::STMT_EXECUTE:
+  case Client_msg::CRUD_FIND:
+  {
+    Reply_ptr reply = m_srv.get_reply(Client_msg::CRUD_FIND == type, spec);
+    if (reply)
+      m_out.append(*reply);
+    else
+      put_frame(m_out, Server_msg::STMT_EXECUTE_OK, std::string());
+    return;
+  }
+
+  case Client_msg::CRUD_INSERT:
+    put_rows_affected(m_out, rows);
+    return;
+
+  case Client_msg::CRUD_UPDATE:
+  case Client_msg::CRUD_DELETE:
+    put_rows_affected(m_out, 1);
+    return;
+
+  default:
+    put_error(m_out, 1047, "Unexpected message received");
+  }
+}
+
+
+/*
+  Server
+  ------
+*/
+
+Mock_server::Reply_ptr
+Mock_server::get_reply(bool docs, const std::string &spec_str)
+{
+  std::string key = (docs ? "D:" : "S:") + spec_str;
+
+  std::lock_guard<std::mutex> guard(m_lock);
+
+  auto it = m_replies.find(key);
+  if (it != m_replies.end())
+    return it->second;
+
+  Spec spec;
+  if (docs)
+    spec.m_cols = 4;
+
+  if (!spec.parse(spec_str) && !docs)
+    return Reply_ptr();
+
+  std::shared_ptr<std::string> reply = std::make_shared<std::string>();
+  if (docs)
+    put_docs(*reply, spec);
+  else
+    put_rset(*reply, spec);
+
+  m_replies[key] = reply;
+  return reply;
+}
+
+
+std::vector<unsigned> Mock_server::take_log()
+{
+  std::vector<unsigned> log;
+  std::lock_guard<std::mutex> guard(m_lock);
+  log.swap(m_log);
+  return log;
+}
+
+
+void Mock_server::hold(bool on)
+{
+  std::lock_guard<std::mutex> guard(m_lock);
+  m_hold = on;
+  if (!on)
+    m_released.notify_all();
+}
+
+
+Mock_server::Mock_server(unsigned short port)
+  : m_listener(INVALID_SOCKET), m_port(port), m_stopping(false)
+  , m_log_on(false), m_hold(false)
+{
+  listen(AF_INET);
+}
+
+
+#ifndef _WIN32
+
+Mock_server::Mock_server(const std::string &path)
+  : m_listener(INVALID_SOCKET), m_port(0), m_path(path), m_stopping(false)
+  , m_log_on(false), m_hold(false)
+{
+  listen(AF_UNIX);
+}
+
+#endif
+
+
+void Mock_server::listen(int family)
+{
+#ifdef _WIN32
+  WSADATA wsa;
+  WSAStartup(MAKEWORD(2, 2), &wsa);
+#endif
+
+  socket_t sock = socket(family, SOCK_STREAM, 0);
+  if (INVALID_SOCKET == sock)
+    throw std::runtime_error("Could not create server socket");
+
+  int rc;
+
+#ifndef _WIN32
+  if (AF_UNIX == family)
+  {
+    sockaddr_un addr;
+    memset(&addr, 0, sizeof(addr));
+    addr.sun_family = AF_UNIX;
+    if (m_path.size() >= sizeof(addr.sun_path))
+      throw std::runtime_error("Socket path too long: " + m_path);
+    strcpy(addr.sun_path, m_path.c_str());
+    unlink(m_path.c_str());
+    rc = bind(sock, (sockaddr*)&addr, sizeof(addr));
+  }
+  else
+#endif
+  {
+    int flag = 1;
+    setsockopt(sock, SOL_SOCKET, SO_REUSEADDR, (const char*)&flag,
+               sizeof(flag));
+
+    sockaddr_in addr;
+    memset(&addr, 0, sizeof(addr));
+    addr.sin_family = AF_INET;
+    addr.sin_addr.s_addr = htonl(INADDR_LOOPBACK);
+    addr.sin_port = htons(m_port);
+    rc = bind(sock, (sockaddr*)&addr, sizeof(addr));
+
+    if (0 == rc)
+    {
+      socklen_t len = sizeof(addr);
+      getsockname(sock, (sockaddr*)&addr, &len);
+      m_port = ntohs(addr.sin_port);
+    }
+  }
+
+  if (0 != rc || 0 != ::listen(sock, 128))
+  {
+    close_socket(sock);
+    throw std::runtime_error("Could not listen for connections");
+  }
+
+  m_listener = (intptr_t)sock;
+  m_acceptor = std::thread(&Mock_server::accept_loop, this);
+}
+
+
+Mock_server::~Mock_server()
+{
+  stop();
+}
+
+
+void Mock_server::accept_loop()
+{
+  pollfd pfd;
+  pfd.fd = (socket_t)m_listener;
+  pfd.events = POLLIN;
+
+  while (!m_stopping)
+  {
+    pfd.revents = 0;
+    if (poll(&pfd, 1, 100) <= 0)
+      continue;
+
+    socket_t sock = accept((socket_t)m_listener, NULL, NULL);
+    if (INVALID_SOCKET == sock)
+      continue;
+
+    if (m_path.empty())
+      set_nodelay(sock);
+
+    {
+      std::lock_guard<std::mutex> guard(m_lock);
+      m_conns.push_back((intptr_t)sock);
+    }
+
+    std::thread(&Mock_server::serve, this, (intptr_t)sock).detach();
+  }
+}
+
+
+void Mock_server::serve(intptr_t sock)
+{
+  try {
+    std::unique_ptr<Connection> conn(new Connection(*this, (socket_t)sock));
+    conn->run();
+  }
+  catch (...)
+  {}
+
+  close_socket((socket_t)sock);
+
+  std::lock_guard<std::mutex> guard(m_lock);
+  for (auto it = m_conns.begin(); it != m_conns.end(); ++it)
+    if (*it == sock)
+    {
+      m_conns.erase(it);
+      break;
+    }
+  m_done.notify_all();
+}
+
+
+void Mock_server::stop()
+{
+  if (m_stopping.exchange(true))
+    return;
+
+  if (m_acceptor.joinable())
+    m_acceptor.join();
+  close_socket((socket_t)m_listener);
+
+#ifndef _WIN32
+  if (!m_path.empty())
+    unlink(m_path.c_str());
+#endif
+
+  // Wake up connection threads blocked in recv() and wait for them.
+
+  std::unique_lock<std::mutex> lock(m_lock);
+  m_hold = false;
+  m_released.notify_all();
+  for (intptr_t sock : m_conns)
+    shutdown((socket_t)sock, SHUT_RDWR);
+  m_done.wait(lock, [this]{ return m_conns.empty(); });
+}
+
+}}  // mysqlx::test
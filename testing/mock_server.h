@@ -0,0 +1,156 @@
+/*
+ * Copyright (c) 2015, 2016, Oracle and/or its affiliates. All rights reserved.
+ *
+ * The MySQL Connector/C++ is licensed under the terms of the GPLv2
+ * <http://www.gnu.org/licenses/old-licenses/gpl-2.0.html>, like most
+ * MySQL Connectors. There are special exceptions to the terms and
+ * conditions of the GPLv2 as it is applied to this software, see the
+ * FLOSS License Exception
+ * <http://www.mysql.com/about/legal/licensing/foss-exception.html>.
+ *
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published
+ * by the Free Software Foundation; version 2 of the License.
+ *
+ * This program is distributed in the hope that it will be useful, but
+ * WITHOUT ANY WARRANTY; without even the implied warranty of MERCHANTABILITY
+ * or FITNESS FOR A PARTICULAR PURPOSE. See the GNU General Public License
+ * for more details.
+ *
+ * You should have received a copy of the GNU General Public License along
+ * with this program; if not, write to the Free Software Foundation, Inc.,
+ * 51 Franklin St, Fifth Floor, Boston, MA 02110-1301  USA
+ */
+
+#ifndef MYSQLX_TESTING_MOCK_SERVER_H
+#define MYSQLX_TESTING_MOCK_SERVER_H
+
+#include <string>
+#include <vector>
+#include <map>
+#include <memory>
+#include <mutex>
+#include <condition_variable>
+#include <thread>
+#include <atomic>
+#include <stdint.h>
+
+
+namespace mysqlx {
+namespace test {
+
+/*
+  Mock X Protocol server
+  ======================
+
+  Server which accepts connections on a loopback TCP port or a Unix domain
+  socket and answers X Protocol messages without doing any real work, so
+  that benchmarks measure only the client side and unit tests can run
+  without a real server. Each connection is served by a separate thread.
+
+  Any user and password are accepted (with MYSQL41 or PLAIN authentication).
+  Capabilities, such as TLS or compression, can not be set -- server replies
+  with error as a server which does not support them. Expectation blocks
+  always succeed.
+
+  Result sets are described by a specification string, which is a list of
+  space separated "key=value" settings:
+
+  rows=N       - number of rows (or documents) in the result,
+  cols=N       - number of columns (or fields of a document),
+  type=T,...   - types of the columns, used in turn if there are more
+                 columns than types; T is one of: int, uint, double,
+                 decimal, string, blob, json,
+  size=N       - length of string, blob and json values.
+
+  SQL statements which are specifications (contain "rows=" setting) return
+  the described result set. Other statements return empty OK reply. Find
+  operations on a collection whose name is a specification return that
+  many JSON documents with the given number of fields. Insert, update and
+  delete operations report the number of rows sent (or 1) as affected.
+
+  Statements can be prepared and then executed as usual. Server-side
+  cursors are not supported.
+
+  Encoded replies are cached by specification string and shared by all
+  connections, so that each result set is built only once.
+*/
+
+class Mock_server
+{
+public:
+
+  /*
+    Start server listening on the given loopback TCP port. If port is 0,
+    a free port is chosen (see port()).
+  */
+
+  explicit Mock_server(unsigned short port = 0);
+
+#ifndef _WIN32
+  explicit Mock_server(const std::string &socket_path);
+#endif
+
+  ~Mock_server();
+
+  unsigned short port() const { return m_port; }
+  const std::string& socket_path() const { return m_path; }
+
+  // Stop accepting connections and wait for open connections to end.
+
+  void stop();
+
+  // Encoded reply to the statement (Find operation) with given spec.
+
+  typedef std::shared_ptr<const std::string> Reply_ptr;
+
+  Reply_ptr get_reply(bool docs, const std::string &spec);
+
+  /*
+    Log of types of client messages received by all connections. Messages
+    are logged only after set_log(true), so that benchmarks do not pay for
+    it. Method take_log() returns types of messages received since its
+    previous call, in the order of arrival.
+  */
+
+  void set_log(bool on) { m_log_on = on; }
+  std::vector<unsigned> take_log();
+
+  /*
+    After hold(true) connections do not send replies to received messages
+    until hold(false) is called, so that tests can observe client operations
+    waiting for a reply.
+  */
+
+  void hold(bool on);
+
+private:
+
+  intptr_t          m_listener;
+  unsigned short    m_port;
+  std::string       m_path;
+  std::thread       m_acceptor;
+  std::atomic<bool> m_stopping;
+
+  std::mutex              m_lock;
+  std::condition_variable m_done;
+  std::vector<intptr_t>   m_conns;
+
+  std::map<std::string, Reply_ptr> m_replies;
+
+  std::atomic<bool>     m_log_on;
+  std::vector<unsigned> m_log;
+
+  std::atomic<bool>       m_hold;
+  std::condition_variable m_released;
+
+  void listen(int family);
+  void accept_loop();
+  void serve(intptr_t sock);
+
+  class Connection;
+};
+
+}}  // mysqlx::test
+
+#endif
@@ -970,8 +970,10 @@ void Group_by_list::process(cdk::Expr_list::Processor& prc) const
   for (group_by_list_type::const_iterator it = m_group_by_list.begin();
     it != m_group_by_list.end(); ++it)
   {
-    parser::Expression_parser expr_parser(m_parser_mode, *it);
-    expr_parser.process_if(prc.list_el());
+    parser::Cached_expr expr(m_parser_mode, *it);
+    cdk::Expression::Processor *prc_el = prc.list_el();
+    if (prc_el)
+      expr.process(*prc_el);
   }
   prc.list_end();
 }
@@ -1658,6 +1658,45 @@ mysqlx_session_valid(mysqlx_session_t *sess)
   SAFE_EXCEPTION_END(sess, 0)
 }
 
+int STDCALL
+mysqlx_session_stats(mysqlx_session_t *sess, mysqlx_session_stats_t *stats)
+{
+  SAFE_EXCEPTION_BEGIN(sess, RESULT_ERROR)
+  OUT_BUF_CHECK(stats, sess, MYSQLX_ERROR_OUTPUT_BUFFER_NULL, RESULT_ERROR)
+
+  static_assert(
+    (unsigned)MYSQLX_STATS_CMD_COUNT
+       == (unsigned)cdk::protocol::mysqlx::stats_cmd::COUNT
+    && MYSQLX_STATS_LATENCY_BUCKETS
+       == cdk::protocol::mysqlx::Protocol_stats::latency_buckets,
+    "mysqlx_session_stats_t does not match CDK statistics"
+  );
+
+  cdk::Session::Stats cs;
+  sess->get_session().get_stats(cs);
+
+  stats->bytes_sent = cs.bytes_sent;
+  stats->bytes_received = cs.bytes_received;
+  stats->msgs_sent = cs.msgs_sent;
+  stats->msgs_received = cs.msgs_received;
+  stats->round_trips = cs.round_trips;
+  stats->rows = cs.rows;
+  stats->fields = cs.fields;
+  stats->rd_buf_reallocs = cs.rd_buf_reallocs;
+  stats->wr_buf_reallocs = cs.wr_buf_reallocs;
+  stats->rd_wait_ns = cs.rd_wait_ns;
+  stats->commands = cs.commands;
+  stats->pipelined = cs.pipelined;
+  stats->prepares = cs.prepares;
+  stats->prepared_execs = cs.prepared_execs;
+  stats->cursor_fetches = cs.cursor_fetches;
+  stats->errors = cs.errors;
+  memcpy(stats->latency, cs.latency, sizeof(stats->latency));
+
+  return RESULT_OK;
+  SAFE_EXCEPTION_END(sess, RESULT_ERROR)
+}
+
 mysqlx_session_options_t * STDCALL
 mysqlx_session_options_new()
 {
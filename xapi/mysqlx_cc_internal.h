@@ -32,6 +32,7 @@
 #include <bitset>
 #include <cstdarg>
 #include <expr_parser.h>
+#include <expr_cache.h>
 #include <uri_parser.h>
 #include <mysql/cdk/converters.h>
 #include "../global.h"
@@ -307,8 +308,8 @@ class Order_by : public cdk::Order_by
 
     void process(cdk::Expression::Processor &prc) const
     {
-      Expression_parser parser(m_mode, m_expr);
-      parser.process(prc);
+      parser::Cached_expr expr(m_mode, m_expr);
+      expr.process(prc);
     }
 
 